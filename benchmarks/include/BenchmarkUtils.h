@@ -0,0 +1,46 @@
+#pragma once
+
+#include <core/Common.h>
+#include <util/Timer.h>
+
+#include <iostream>
+
+/**
+ * @return number of heap allocations since the start of the program, counted
+ * by the replaced global operator new
+ */
+uint64 GetHeapAllocationCount();
+
+/**
+ * @param iterations number of times to call the function
+ * @param function the code to measure
+ * @return the average millis a single call of the function takes
+ */
+template <typename Function>
+float MeasureAverageMilli(uint32 iterations, const Function& function)
+{
+  bge::Timer timer;
+  for (uint32 i = 0; i < iterations; ++i)
+  {
+    function();
+  }
+  return timer.GetElapsedMilli() / iterations;
+}
+
+/**
+ * Prints the timings of a baseline and an optimized version of the same work
+ * @param name what was measured
+ * @param baselineName label of the baseline timing
+ * @param baselineMilli average millis of the baseline
+ * @param optimizedName label of the optimized timing
+ * @param optimizedMilli average millis of the optimized version
+ */
+inline void PrintComparison(const char* name, const char* baselineName,
+                            float baselineMilli, const char* optimizedName,
+                            float optimizedMilli)
+{
+  std::cout << name << "\t" << baselineName << ": " << baselineMilli << " ms\t"
+            << optimizedName << ": " << optimizedMilli
+            << " ms\tspeedup: " << baselineMilli / optimizedMilli << "x"
+            << std::endl;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+/**
+ * Measures the cost of push/pop on the owner thread of a work stealing queue
+ * while 0..N thieves are stealing from it. Compares the lock-free queue
+ * against the mutex guarded one.
+ */
+void RunWorkStealingQueueBenchmark();
+
+/**
+ * Measures the time between Scheduler::Run and the start of a task for
+ * batches of empty tasks which are run while the workers are idle.
+ */
+void RunTaskLatencyBenchmark();
+
+/**
+ * Spawns over 100k tasks per frame through ParralelFor and checks that every
+ * element was processed exactly once, which fails if the task allocator hands
+ * out tasks which are still in flight.
+ */
+void RunTaskPoolStressTest();
+
+/**
+ * Compares the serial transform loop of DynamicMeshSystem against the
+ * ParallelFor version the system uses.
+ */
+void RunParallelTransformsBenchmark();
+
+/**
+ * Compares serial loops against ParallelTransformReduce (AABB union) and
+ * ParallelExclusiveScan (prefix sum) and checks that the results match.
+ */
+void RunParallelReduceBenchmark();
+
+/**
+ * Compares fixed count splitters against the lazy and the profiled splitter
+ * on a small and a large array.
+ */
+void RunSplitterBenchmark();
+
+/**
+ * Simulates a pile of 8000 spheres with 1..N threads, prints the frame time
+ * per thread count and checks that every run ends in the same transforms.
+ */
+void RunPhysicsScalingBenchmark();
+
+/**
+ * Simulates sphere piles from 1k to 100k spheres (as far as nudge supports)
+ * and prints the frame time and how far the physics storage grew.
+ */
+void RunPhysicsCapacityBenchmark();
+
+/**
+ * Looks up 8000 bodies per frame through an unordered_map and through the
+ * physics device's EntityIndex, and compares a transform sync with a lookup
+ * per body against the linear copy RigidBodySystem uses.
+ */
+void RunEntityLookupBenchmark();
+
+/**
+ * Settles a layer of 8000 spheres created through RigidBodySystem, compares
+ * the per body GetBodyTransform + ToMatrix sync against the bulk export of
+ * PhysicsDevice::ExportBodyMatrices, which skips sleeping bodies.
+ */
+void RunBodyMatrixExportBenchmark();
+
+/**
+ * Adds, iterates, looks up and removes 10k, 100k and 1M components with
+ * ComponentStorage and with the unordered_map + vectors it replaced.
+ */
+void RunComponentStorageBenchmark();
+
+/**
+ * Destroys half of 100k mesh entities and half of 8k rigid bodies in a single
+ * frame, one component at a time against the batched EntitiesDestroyedEvent
+ * handlers.
+ */
+void RunEntityDestructionBenchmark();
+
+/**
+ * Integrates the positions of 100k and 1M entities, looking their components
+ * up per entity in a storage per component against the archetype queries
+ * ForEach and ParallelForEach.
+ */
+void RunArchetypeIterationBenchmark();
+
+/**
+ * Creates and destroys 1M entities 5 times, with the deque based manager with
+ * 8 bit generations it replaced, one at a time and with the batch APIs. Also
+ * counts stale handles which look alive again after many reuses.
+ */
+void RunEntityChurnBenchmark();
+
+/**
+ * Creates 10k and 100k entities with two components, then adds a component to
+ * half of them and destroys the rest, immediately against recording the
+ * changes into command buffers from parallel tasks and playing them back.
+ */
+void RunCommandBufferBenchmark();
+
+/**
+ * Ticks 20 synthetic game systems in two layers, serially on the calling
+ * thread against declaring their access and running them on the job graph of
+ * the game world, with 1 to N threads.
+ */
+void RunGameWorldScheduleBenchmark();
+
+/**
+ * Dispatches 1M random input events to 16 listeners of 4 event types, fanned
+ * out to every listener through a std::function dispatcher against
+ * publishing them on an EventBus and queueing them for a batched delivery.
+ */
+void RunEventDispatchBenchmark();
+
+/**
+ * Simulates 2000 spheres and processes their transforms in parallel tasks
+ * every frame, with the temporary data in std::vectors against the frame
+ * allocators. Counts the heap allocations of the steady state frames, which
+ * must be 0 with the frame allocators. With the null render device it also
+ * counts the heap allocations of World::Update and World::Render on a small
+ * scene, which must be 0 once the frames are steady and destroy no entities.
+ */
+void RunFrameAllocatorBenchmark();
+
+/**
+ * Submits 100k draws over 16 shaders to the null render device, uploading
+ * the camera per shader and the model matrix per draw by uniform name against
+ * a camera uniform buffer and uniform ids. Needs BGE_NULL_RENDER_DEVICE.
+ */
+void RunUniformUploadBenchmark();
+
+/**
+ * Culls 10k, 100k and 1M randomly placed boxes against a camera frustum with
+ * a scalar test of one box at a time against the FrustumCuller, which tests
+ * SoA bounds with SIMD and culls large sets in parallel tasks.
+ */
+void RunFrustumCullingBenchmark();
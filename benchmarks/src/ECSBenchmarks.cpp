@@ -0,0 +1,1009 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <ecs/ArchetypeManager.h>
+#include <ecs/ComponentStorage.h>
+#include <ecs/EntityCommandBuffer.h>
+#include <ecs/EntityManager.h>
+#include <ecs/GameWorld.h>
+#include <events/ECSEvents.h>
+#include <math/Vec.h>
+#include <physics/RigidBodySystem.h>
+#include <rendering/DynamicMeshSystem.h>
+#include <rendering/StaticMeshSystem.h>
+#include <scheduler/ParallelFor.h>
+#include <util/RandomNumberGenerator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Component counts of the storage benchmark
+constexpr uint32 c_StorageCounts[] = {10000u, 100000u, 1000000u};
+// Number of times the components are iterated per measurement
+constexpr uint32 c_StorageIterations = 10u;
+// Number of mesh entities of the destruction benchmark, half get destroyed
+constexpr uint32 c_DestroyMeshCount = 100000u;
+// Number of rigid bodies of the destruction benchmark, half get destroyed
+constexpr uint32 c_DestroyBodyCount = 8000u;
+// Entity counts of the archetype iteration benchmark
+constexpr uint32 c_ArchetypeCounts[] = {100000u, 1000000u};
+// Every n-th entity of the archetype benchmark also has a Mass component
+constexpr uint32 c_MassEntityStride = 4u;
+// Number of iterations per measurement of the archetype benchmark
+constexpr uint32 c_ArchetypeIterations = 10u;
+// Number of entities created and destroyed per round of the churn benchmark
+constexpr uint32 c_ChurnEntityCount = 1000000u;
+// Number of rounds of the churn benchmark
+constexpr uint32 c_ChurnRoundCount = 5u;
+// Number of entities and rounds of the generation wrap check, with 1024 free
+// indices held back every index is reused 2 out of 3 rounds, so the rounds
+// wrap an 8 bit generation a few times
+constexpr uint32 c_WrapEntityCount = 2048u;
+constexpr uint32 c_WrapRoundCount = 1000u;
+// Entity counts of the command buffer benchmark
+constexpr uint32 c_CommandEntityCounts[] = {10000u, 100000u};
+// Entities a task of the command buffer benchmark records commands for
+constexpr uint32 c_CommandGrainSize = 1024u;
+// Number of rounds of the command buffer benchmark, the buffers keep their
+// memory between rounds like they do between frames
+constexpr uint32 c_CommandRoundCount = 5u;
+// Number of synthetic systems of the schedule benchmark, the first half writes
+// its own slot of values, the second half also reads 2 slots of the first half
+constexpr uint32 c_SyntheticSystemCount = 20u;
+constexpr uint32 c_SyntheticLayerSize = c_SyntheticSystemCount / 2u;
+// Number of values a synthetic system updates per tick
+constexpr uint32 c_SyntheticValueCount = 20000u;
+// Number of ticks per thread count of the schedule benchmark
+constexpr uint32 c_SyntheticTickCount = 50u;
+// Run at least this many threads, so determinism is checked on small machines
+constexpr uint32 c_MinScheduleThreadCount = 4u;
+// Number of times each destruction is repeated, a single one is too short to
+// time reliably
+constexpr uint32 c_DestroyRoundCount = 10u;
+
+// Components of the archetype benchmark
+struct Position
+{
+  bge::Vec3f m_Value;
+};
+struct Velocity
+{
+  bge::Vec3f m_Value;
+};
+struct Mass
+{
+  float m_Value;
+};
+
+/**
+ * The storage the systems used before ComponentStorage, parallel vectors and a
+ * map of entity ids to their index
+ */
+struct MapStorage
+{
+  std::unordered_map<uint32, uint32> m_EntityToComponentId;
+  std::vector<bge::Entity> m_Entities;
+  std::vector<bge::Vec3f> m_Positions;
+  std::vector<bge::Vec3f> m_Velocities;
+
+  void Add(bge::Entity entity, const bge::Vec3f& position,
+           const bge::Vec3f& velocity)
+  {
+    m_EntityToComponentId[entity.GetId()] = m_Entities.size();
+    m_Entities.push_back(entity);
+    m_Positions.push_back(position);
+    m_Velocities.push_back(velocity);
+  }
+
+  void Remove(bge::Entity entity)
+  {
+    const uint32 index = m_EntityToComponentId[entity.GetId()];
+    const bge::Entity lastEntity = m_Entities.back();
+
+    m_Entities[index] = lastEntity;
+    m_Positions[index] = m_Positions.back();
+    m_Velocities[index] = m_Velocities.back();
+
+    m_Entities.pop_back();
+    m_Positions.pop_back();
+    m_Velocities.pop_back();
+
+    m_EntityToComponentId[lastEntity.GetId()] = index;
+    m_EntityToComponentId.erase(entity.GetId());
+  }
+};
+
+/**
+ * Adds, iterates and removes count components with both storages
+ */
+static void CompareStorages(uint32 count)
+{
+  bge::RandomNumberGenerator rng;
+
+  // Entity 0 is the null entity
+  std::vector<bge::Entity> entities;
+  entities.reserve(count);
+  for (uint32 i = 0; i < count; ++i)
+  {
+    entities.emplace_back(i + 1, 0);
+  }
+
+  // Removal order, so the swaps touch random indices
+  std::vector<bge::Entity> shuffled = entities;
+  for (uint32 i = count - 1; i > 0; --i)
+  {
+    std::swap(shuffled[i], shuffled[rng.GenRandInt(0u, i)]);
+  }
+
+  const bge::Vec3f position(0.0f);
+  const bge::Vec3f velocity(1.0f, 2.0f, 3.0f);
+  const float deltaTime = 1.0f / 60.0f;
+
+  MapStorage mapStorage;
+  bge::ComponentStorage<bge::Vec3f, bge::Vec3f> storage;
+
+  const float mapAddMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : entities)
+    {
+      mapStorage.Add(entity, position, velocity);
+    }
+  });
+  const float storageAddMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : entities)
+    {
+      storage.Add(entity, position, velocity);
+    }
+  });
+
+  // Both iterate the same dense arrays, the storage has to match the vectors
+  const float mapIterateMilli =
+      MeasureAverageMilli(c_StorageIterations, [&]() {
+        for (size_t i = 0; i < mapStorage.m_Positions.size(); ++i)
+        {
+          mapStorage.m_Positions[i] += mapStorage.m_Velocities[i] * deltaTime;
+        }
+      });
+  const float storageIterateMilli =
+      MeasureAverageMilli(c_StorageIterations, [&]() {
+        std::vector<bge::Vec3f>& positions = storage.GetColumn<0>();
+        const std::vector<bge::Vec3f>& velocities = storage.GetColumn<1>();
+
+        for (size_t i = 0; i < positions.size(); ++i)
+        {
+          positions[i] += velocities[i] * deltaTime;
+        }
+      });
+
+  // Random access by entity, eg. gameplay code changing single components
+  float mapSum = 0.0f;
+  float storageSum = 0.0f;
+  const float mapLookupMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : shuffled)
+    {
+      const uint32 index = mapStorage.m_EntityToComponentId[entity.GetId()];
+      mapSum += mapStorage.m_Positions[index][0];
+    }
+  });
+  const float storageLookupMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : shuffled)
+    {
+      storageSum += storage.Get<0>(entity)[0];
+    }
+  });
+
+  // The batch versions, which fill the columns after adding the entities.
+  // Measured before the map frees its nodes, which makes the next large
+  // allocation consolidate them in glibc's malloc.
+  bge::ComponentStorage<bge::Vec3f, bge::Vec3f> batchStorage;
+
+  const float batchAddMilli = MeasureAverageMilli(1u, [&]() {
+    const uint32 first = batchStorage.AddBatch(entities.data(), count);
+
+    std::fill(batchStorage.GetColumn<0>().begin() + first,
+              batchStorage.GetColumn<0>().end(), position);
+    std::fill(batchStorage.GetColumn<1>().begin() + first,
+              batchStorage.GetColumn<1>().end(), velocity);
+  });
+
+  const float mapRemoveMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : shuffled)
+    {
+      mapStorage.Remove(entity);
+    }
+  });
+  const float storageRemoveMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& entity : shuffled)
+    {
+      storage.Remove(entity);
+    }
+  });
+
+  const float batchRemoveMilli = MeasureAverageMilli(1u, [&]() {
+    batchStorage.RemoveBatch(shuffled.data(), count);
+  });
+
+  std::cout << "Components: " << count << std::endl;
+  PrintComparison("\tadd", "unordered_map", mapAddMilli, "ComponentStorage",
+                  storageAddMilli);
+  PrintComparison("\titerate", "unordered_map", mapIterateMilli,
+                  "ComponentStorage", storageIterateMilli);
+  PrintComparison("\tlookup", "unordered_map", mapLookupMilli,
+                  "ComponentStorage", storageLookupMilli);
+  PrintComparison("\tremove", "unordered_map", mapRemoveMilli,
+                  "ComponentStorage", storageRemoveMilli);
+  PrintComparison("\tbatch add", "unordered_map", mapAddMilli,
+                  "ComponentStorage", batchAddMilli);
+  PrintComparison("\tbatch remove", "unordered_map", mapRemoveMilli,
+                  "ComponentStorage", batchRemoveMilli);
+
+  if (mapSum != storageSum || storage.GetCount() != 0 ||
+      batchStorage.GetCount() != 0)
+  {
+    std::cout << "ERROR: the storages hold different components" << std::endl;
+  }
+}
+
+void RunComponentStorageBenchmark()
+{
+  for (uint32 count : c_StorageCounts)
+  {
+    CompareStorages(count);
+  }
+}
+
+/**
+ * @return a random half of the entities, in random order
+ */
+static std::vector<bge::Entity>
+PickHalf(std::vector<bge::Entity> entities, bge::RandomNumberGenerator& rng)
+{
+  for (uint32 i = static_cast<uint32>(entities.size()) - 1; i > 0; --i)
+  {
+    std::swap(entities[i], entities[rng.GenRandInt(0u, i)]);
+  }
+
+  entities.erase(entities.begin() + entities.size() / 2, entities.end());
+  return entities;
+}
+
+/**
+ * Destroys half of the entities of both mesh systems in one frame
+ * @param batch true to send the destroyed event, false to destroy the
+ * components one by one
+ * @return the millis the destruction took
+ */
+static float DestroyMeshEntities(bool batch)
+{
+  bge::RandomNumberGenerator rng;
+  bge::EntityManager entityManager;
+  bge::StaticMeshSystem staticMeshes;
+  bge::DynamicMeshSystem dynamicMeshes;
+
+  std::vector<bge::Entity> entities;
+  entities.reserve(c_DestroyMeshCount);
+
+  for (uint32 i = 0; i < c_DestroyMeshCount; ++i)
+  {
+    entities.push_back(entityManager.CreateEntity());
+    staticMeshes.AddComponent(entities.back(), bge::StaticMeshData());
+    dynamicMeshes.AddComponent(entities.back(), bge::DynamicMeshData());
+  }
+
+  const std::vector<bge::Entity> destroyed = PickHalf(entities, rng);
+  bge::EntitiesDestroyedEvent event(destroyed);
+
+  const float milli = MeasureAverageMilli(1u, [&]() {
+    if (batch)
+    {
+      staticMeshes.OnEvent(event);
+      dynamicMeshes.OnEvent(event);
+      return;
+    }
+
+    for (auto&& entity : destroyed)
+    {
+      staticMeshes.DestroyComponent(entity);
+      dynamicMeshes.DestroyComponent(entity);
+    }
+  });
+
+  return milli;
+}
+
+/**
+ * Destroys half of the rigid bodies in one frame
+ * @param batch true to send the destroyed event, false to destroy the
+ * bodies one by one
+ * @return the millis the destruction took
+ */
+static float DestroyBodyEntities(bool batch)
+{
+  bge::RandomNumberGenerator rng;
+  bge::EntityManager entityManager;
+  bge::RigidBodySystem bodySystem;
+
+  std::vector<bge::Entity> entities;
+  entities.reserve(c_DestroyBodyCount);
+
+  // A different radius per body, to check the system's scales stay in the
+  // order of the device's bodies
+  for (uint32 i = 0; i < c_DestroyBodyCount; ++i)
+  {
+    entities.push_back(entityManager.CreateEntity());
+    bodySystem.AddSphereBodyComponent(entities.back(), 1.0f,
+                                      1.0f + i * 0.001f);
+  }
+
+  const std::vector<bge::Entity> destroyed = PickHalf(entities, rng);
+  bge::EntitiesDestroyedEvent event(destroyed);
+
+  const float milli = MeasureAverageMilli(1u, [&]() {
+    if (batch)
+    {
+      bodySystem.OnEvent(event);
+      return;
+    }
+
+    for (auto&& entity : destroyed)
+    {
+      bodySystem.DestroyRigidBody(entity);
+    }
+  });
+
+  // The scale of an exported matrix comes from the system, the radius from
+  // the device
+  bodySystem.UpdateTransforms();
+
+  const bge::EntityIndex& bodyIndex = bge::PhysicsDevice::GetBodyIndex();
+  const std::vector<bge::Mat4f>& matrices = bodySystem.GetBodyMatrices();
+
+  for (uint32 i = 0; i < bodyIndex.GetCount(); ++i)
+  {
+    const float radius =
+        bge::PhysicsDevice::GetSphereColliderRadius(bodyIndex.GetEntity(i));
+
+    if (std::abs(matrices[i].m_Elements[0] - radius) > 1e-4f)
+    {
+      std::cout << "ERROR: the rigid bodies are out of order with the physics "
+                   "bodies"
+                << std::endl;
+      break;
+    }
+  }
+
+  // Clean up the device for the other benchmarks
+  for (auto&& entity : entities)
+  {
+    if (bodySystem.HasRigidBody(entity))
+    {
+      bodySystem.DestroyRigidBody(entity);
+    }
+  }
+
+  return milli;
+}
+
+/**
+ * @param destroy the destruction to repeat with fresh entities
+ * @param batch passed to destroy
+ * @return the average millis of a destruction
+ */
+static float MeasureDestruction(float (*destroy)(bool), bool batch)
+{
+  float milli = 0.0f;
+  for (uint32 i = 0; i < c_DestroyRoundCount; ++i)
+  {
+    milli += destroy(batch);
+  }
+
+  return milli / c_DestroyRoundCount;
+}
+
+void RunEntityDestructionBenchmark()
+{
+  PrintComparison("destroy 50k of 100k mesh entities", "one by one",
+                  MeasureDestruction(DestroyMeshEntities, false), "batch",
+                  MeasureDestruction(DestroyMeshEntities, true));
+  PrintComparison("destroy 4k of 8k rigid bodies", "one by one",
+                  MeasureDestruction(DestroyBodyEntities, false), "batch",
+                  MeasureDestruction(DestroyBodyEntities, true));
+}
+
+/**
+ * Integrates count positions, kept in a storage per component the way the
+ * systems keep them, in archetypes and in archetypes on the scheduler
+ */
+static void CompareArchetypeIteration(uint32 count)
+{
+  const float deltaTime = 1.0f / 60.0f;
+
+  bge::EntityManager entityManager;
+  std::vector<bge::Entity> entities;
+  entities.reserve(count);
+
+  bge::ComponentStorage<Position> positions;
+  bge::ComponentStorage<Velocity> velocities;
+  bge::ArchetypeManager archetypes;
+
+  // Small positions, so the integration stays exact enough to compare
+  for (uint32 i = 0; i < count; ++i)
+  {
+    entities.push_back(entityManager.CreateEntity());
+
+    const Position position{bge::Vec3f(static_cast<float>(i % 1024u))};
+    const Velocity velocity{bge::Vec3f(1.0f, 2.0f, 3.0f)};
+
+    positions.Add(entities.back(), position);
+
+    if (i % c_MassEntityStride == 0)
+    {
+      archetypes.AddComponents(entities.back(), position, velocity, Mass{1.0f});
+    }
+    else
+    {
+      archetypes.AddComponents(entities.back(), position, velocity);
+    }
+  }
+
+  // Systems add and remove their components at different times, so their
+  // storages end up in different orders
+  bge::RandomNumberGenerator rng;
+  for (auto&& entity : PickHalf(entities, rng))
+  {
+    velocities.Add(entity, Velocity{bge::Vec3f(1.0f, 2.0f, 3.0f)});
+  }
+  for (auto&& entity : entities)
+  {
+    if (!velocities.Contains(entity))
+    {
+      velocities.Add(entity, Velocity{bge::Vec3f(1.0f, 2.0f, 3.0f)});
+    }
+  }
+
+  // Gameplay code which looks every component of its entities up by entity
+  const float lookupMilli = MeasureAverageMilli(c_ArchetypeIterations, [&]() {
+    for (auto&& entity : entities)
+    {
+      positions.Get<0>(entity).m_Value +=
+          velocities.Get<0>(entity).m_Value * deltaTime;
+    }
+  });
+
+  const float forEachMilli = MeasureAverageMilli(c_ArchetypeIterations, [&]() {
+    archetypes.ForEach<Position, Velocity>(
+        [=](bge::Entity, Position& position, const Velocity& velocity) {
+          position.m_Value += velocity.m_Value * deltaTime;
+        });
+  });
+
+  const float parallelMilli = MeasureAverageMilli(c_ArchetypeIterations, [&]() {
+    archetypes.ParallelForEach<Position, Velocity>(
+        [=](bge::Entity, Position& position, const Velocity& velocity) {
+          position.m_Value += velocity.m_Value * deltaTime;
+        });
+  });
+
+  std::cout << "Entities: " << count << " in "
+            << archetypes.GetArchetypeCount() << " archetypes" << std::endl;
+  PrintComparison("\tForEach", "per entity lookup", lookupMilli,
+                  "ForEach<Position, Velocity>", forEachMilli);
+  PrintComparison("\tParallelForEach", "per entity lookup", lookupMilli,
+                  "ParallelForEach<Position, Velocity>", parallelMilli);
+
+  // The archetypes ran twice as many iterations
+  uint32 mismatches = 0;
+  for (auto&& entity : entities)
+  {
+    const bge::Vec3f expected =
+        positions.Get<0>(entity).m_Value +
+        velocities.Get<0>(entity).m_Value * (deltaTime * c_ArchetypeIterations);
+    const bge::Vec3f actual =
+        archetypes.GetComponent<Position>(entity)->m_Value;
+
+    mismatches += std::abs(expected[0] - actual[0]) > 1e-2f ? 1 : 0;
+  }
+
+  if (mismatches != 0)
+  {
+    std::cout << "ERROR: " << mismatches
+              << " archetype positions differ from the storage" << std::endl;
+  }
+}
+
+void RunArchetypeIterationBenchmark()
+{
+  for (uint32 count : c_ArchetypeCounts)
+  {
+    CompareArchetypeIteration(count);
+  }
+}
+
+/**
+ * The entity manager before the batch APIs, 8 bit generations and a deque as
+ * the free list
+ */
+class DequeEntityManager
+{
+public:
+  DequeEntityManager() { m_EntityVersion.push_back(0u); }
+
+  bge::Entity CreateEntity()
+  {
+    uint32 index = 0;
+
+    if (m_FreeList.size() > bge::c_DefaultMinFreeEntityIndices)
+    {
+      index = m_FreeList.front();
+      m_FreeList.pop_front();
+    }
+    else
+    {
+      m_EntityVersion.push_back(0u);
+      index = static_cast<uint32>(m_EntityVersion.size()) - 1;
+    }
+
+    return bge::Entity(index, m_EntityVersion[index]);
+  }
+
+  void DestroyEntity(bge::Entity entity)
+  {
+    ++m_EntityVersion[entity.GetId()];
+    m_FreeList.push_back(entity.GetId());
+  }
+
+  bool IsAlive(bge::Entity entity) const
+  {
+    return m_EntityVersion[entity.GetId()] == entity.GetGeneration();
+  }
+
+private:
+  std::vector<uint8> m_EntityVersion;
+  std::deque<uint32> m_FreeList;
+};
+
+/**
+ * Creates and destroys count entities per round, one at a time
+ * @return the millis all rounds took
+ */
+template <typename Manager>
+static float ChurnOneByOne(Manager& manager, uint32 count, uint32 rounds,
+                           std::vector<bge::Entity>& entities)
+{
+  return MeasureAverageMilli(1u, [&]() {
+    for (uint32 round = 0; round < rounds; ++round)
+    {
+      entities.clear();
+      for (uint32 i = 0; i < count; ++i)
+      {
+        entities.push_back(manager.CreateEntity());
+      }
+      for (auto&& entity : entities)
+      {
+        manager.DestroyEntity(entity);
+      }
+    }
+  });
+}
+
+/**
+ * @return number of the handles which a manager considers alive
+ */
+template <typename Manager>
+static uint32 CountAlive(const Manager& manager,
+                         const std::vector<bge::Entity>& entities)
+{
+  uint32 count = 0;
+  for (auto&& entity : entities)
+  {
+    count += manager.IsAlive(entity) ? 1 : 0;
+  }
+
+  return count;
+}
+
+/**
+ * Churns entities and checks after every creation round whether handles of
+ * the first round, all destroyed, look alive again because the generations
+ * of their indices went around
+ * @return number of times a stale handle looked alive
+ */
+template <typename Manager> static uint32 CountStaleAlive()
+{
+  Manager manager;
+  std::vector<bge::Entity> first;
+  std::vector<bge::Entity> entities;
+  uint32 staleAlive = 0;
+
+  for (uint32 round = 0; round < c_WrapRoundCount; ++round)
+  {
+    entities.clear();
+    for (uint32 i = 0; i < c_WrapEntityCount; ++i)
+    {
+      entities.push_back(manager.CreateEntity());
+    }
+
+    if (round == 0)
+    {
+      first = entities;
+    }
+    else
+    {
+      staleAlive += CountAlive(manager, first);
+    }
+
+    for (auto&& entity : entities)
+    {
+      manager.DestroyEntity(entity);
+    }
+  }
+
+  return staleAlive;
+}
+
+void RunEntityChurnBenchmark()
+{
+  std::vector<bge::Entity> entities(c_ChurnEntityCount, bge::Entity(0, 0));
+
+  DequeEntityManager dequeManager;
+  bge::EntityManager oneByOneManager;
+  bge::EntityManager batchManager;
+
+  const float dequeMilli = ChurnOneByOne(dequeManager, c_ChurnEntityCount,
+                                         c_ChurnRoundCount, entities);
+  const float oneByOneMilli = ChurnOneByOne(
+      oneByOneManager, c_ChurnEntityCount, c_ChurnRoundCount, entities);
+
+  entities.resize(c_ChurnEntityCount, bge::Entity(0, 0));
+  const float batchMilli = MeasureAverageMilli(1u, [&]() {
+    for (uint32 round = 0; round < c_ChurnRoundCount; ++round)
+    {
+      batchManager.CreateEntities(c_ChurnEntityCount, entities.data());
+      batchManager.DestroyEntities(entities.data(), c_ChurnEntityCount);
+    }
+  });
+
+  std::cout << "Create and destroy " << c_ChurnEntityCount << " entities "
+            << c_ChurnRoundCount << " times" << std::endl;
+  PrintComparison("\tone by one", "deque, 8 bit generations", dequeMilli,
+                  "EntityManager", oneByOneMilli);
+  PrintComparison("\tbatch", "deque, 8 bit generations", dequeMilli,
+                  "EntityManager", batchMilli);
+
+  std::cout << "\tstale handles which looked alive during "
+            << c_WrapRoundCount << " rounds of " << c_WrapEntityCount
+            << " entities: deque, 8 bit generations: "
+            << CountStaleAlive<DequeEntityManager>()
+            << "\tEntityManager: " << CountStaleAlive<bge::EntityManager>()
+            << std::endl;
+}
+
+/**
+ * The state a frame of structural changes leaves behind, to compare the
+ * immediate changes with the recorded ones
+ */
+struct StructuralState
+{
+  uint32 m_EntityCount; ///< entities with components
+  uint32 m_MassCount;   ///< entities with a Mass
+  double m_PositionSum; ///< sum of the x positions, exact
+};
+
+static StructuralState GetStructuralState(bge::ArchetypeManager& archetypes)
+{
+  StructuralState state{archetypes.GetEntityCount(), 0u, 0.0};
+
+  archetypes.ForEach<Mass>(
+      [&](bge::Entity, const Mass&) { ++state.m_MassCount; });
+  archetypes.ForEach<Position>([&](bge::Entity, const Position& position) {
+    state.m_PositionSum += position.m_Value[0];
+  });
+
+  return state;
+}
+
+/**
+ * Collects every entity which has a Position
+ */
+static void CollectEntities(bge::ArchetypeManager& archetypes,
+                            std::vector<bge::Entity>& entities)
+{
+  entities.clear();
+  archetypes.ForEach<Position>(
+      [&](bge::Entity entity, const Position&) { entities.push_back(entity); });
+}
+
+/**
+ * Removes and destroys every entity which has a Position
+ */
+static void ClearEntities(bge::EntityManager& entityManager,
+                          bge::ArchetypeManager& archetypes,
+                          std::vector<bge::Entity>& entities)
+{
+  CollectEntities(archetypes, entities);
+
+  for (auto&& entity : entities)
+  {
+    archetypes.RemoveEntity(entity);
+    entityManager.DestroyEntity(entity);
+  }
+}
+
+/**
+ * Every round creates count entities with a Position and a Velocity, then
+ * gives the ones with an even position a Mass and destroys the rest, with
+ * the components added one at a time the way gameplay code adds them. Once
+ * immediately on a single thread and once recorded into command buffers by
+ * parallel tasks and played back.
+ */
+static void CompareCommandPlayback(uint32 count)
+{
+  bge::EntityManager immediateEntities;
+  bge::ArchetypeManager immediateArchetypes;
+
+  bge::EntityManager entityManager;
+  bge::ArchetypeManager archetypes;
+  bge::EntityCommandQueue commands;
+  commands.Init();
+
+  std::vector<bge::Entity> entities(count, bge::Entity(0u, 0u));
+  std::vector<bge::Entity> destroyed;
+
+  float immediateCreateMilli = 0.0f;
+  float immediateChangeMilli = 0.0f;
+  float recordCreateMilli = 0.0f;
+  float recordChangeMilli = 0.0f;
+  float playbackCreateMilli = 0.0f;
+  float playbackChangeMilli = 0.0f;
+
+  StructuralState expected{};
+  StructuralState actual{};
+
+  for (uint32 round = 0; round < c_CommandRoundCount; ++round)
+  {
+    immediateCreateMilli += MeasureAverageMilli(1u, [&]() {
+      for (uint32 i = 0; i < count; ++i)
+      {
+        entities[i] = immediateEntities.CreateEntity();
+        immediateArchetypes.AddComponents(
+            entities[i], Position{bge::Vec3f(static_cast<float>(i % 1024u))});
+        immediateArchetypes.AddComponents(entities[i],
+                                          Velocity{bge::Vec3f(1.0f)});
+      }
+    });
+
+    immediateChangeMilli += MeasureAverageMilli(1u, [&]() {
+      for (uint32 i = 0; i < count; ++i)
+      {
+        if (i % 2 == 0)
+        {
+          immediateArchetypes.AddComponents(entities[i], Mass{1.0f});
+        }
+        else
+        {
+          immediateArchetypes.RemoveEntity(entities[i]);
+          immediateEntities.DestroyEntity(entities[i]);
+        }
+      }
+    });
+
+    recordCreateMilli += MeasureAverageMilli(1u, [&]() {
+      bge::ParallelFor(0u, count, c_CommandGrainSize, [&](uint32 i) {
+        bge::EntityCommandBuffer& buffer = commands.GetBuffer();
+        const bge::Entity entity = buffer.CreateEntity();
+        buffer.AddComponent(
+            entity, Position{bge::Vec3f(static_cast<float>(i % 1024u))});
+        buffer.AddComponent(entity, Velocity{bge::Vec3f(1.0f)});
+      });
+    });
+    playbackCreateMilli += MeasureAverageMilli(1u, [&]() {
+      commands.Playback(entityManager, archetypes, destroyed);
+    });
+
+    // The tasks record in any order, so the entities are collected from the
+    // archetypes and picked by their position
+    CollectEntities(archetypes, entities);
+
+    recordChangeMilli += MeasureAverageMilli(1u, [&]() {
+      bge::ParallelFor(0u, count, c_CommandGrainSize, [&](uint32 i) {
+        bge::EntityCommandBuffer& buffer = commands.GetBuffer();
+        const Position* position =
+            archetypes.GetComponent<Position>(entities[i]);
+
+        if (static_cast<uint32>(position->m_Value[0]) % 2 == 0)
+        {
+          buffer.AddComponent(entities[i], Mass{1.0f});
+        }
+        else
+        {
+          buffer.DestroyEntity(entities[i]);
+        }
+      });
+    });
+    playbackChangeMilli += MeasureAverageMilli(1u, [&]() {
+      destroyed.clear();
+      commands.Playback(entityManager, archetypes, destroyed);
+      archetypes.RemoveEntities(destroyed);
+    });
+
+    expected = GetStructuralState(immediateArchetypes);
+    actual = GetStructuralState(archetypes);
+
+    ClearEntities(immediateEntities, immediateArchetypes, entities);
+    ClearEntities(entityManager, archetypes, entities);
+    entities.resize(count, bge::Entity(0u, 0u));
+  }
+
+  std::cout << "Entities: " << count << ", archetypes: immediate "
+            << immediateArchetypes.GetArchetypeCount() << ", played back "
+            << archetypes.GetArchetypeCount() << std::endl;
+  PrintComparison("\tcreate with 2 components", "immediate",
+                  immediateCreateMilli / c_CommandRoundCount,
+                  "record + playback",
+                  (recordCreateMilli + playbackCreateMilli) /
+                      c_CommandRoundCount);
+  std::cout << "\t\trecord: " << recordCreateMilli / c_CommandRoundCount
+            << " ms\tplayback: " << playbackCreateMilli / c_CommandRoundCount
+            << " ms" << std::endl;
+  PrintComparison("\tadd a component or destroy", "immediate",
+                  immediateChangeMilli / c_CommandRoundCount,
+                  "record + playback",
+                  (recordChangeMilli + playbackChangeMilli) /
+                      c_CommandRoundCount);
+  std::cout << "\t\trecord: " << recordChangeMilli / c_CommandRoundCount
+            << " ms\tplayback: " << playbackChangeMilli / c_CommandRoundCount
+            << " ms" << std::endl;
+
+  if (expected.m_EntityCount != actual.m_EntityCount ||
+      expected.m_MassCount != actual.m_MassCount ||
+      expected.m_PositionSum != actual.m_PositionSum ||
+      destroyed.size() != count / 2)
+  {
+    std::cout << "ERROR: the played back commands differ from the immediate "
+                 "changes"
+              << std::endl;
+  }
+}
+
+void RunCommandBufferBenchmark()
+{
+  for (uint32 count : c_CommandEntityCounts)
+  {
+    CompareCommandPlayback(count);
+  }
+}
+
+/**
+ * Resource tag of a slot of values of the schedule benchmark
+ */
+template <uint32 Slot> struct SyntheticSlot
+{
+};
+
+/**
+ * A game system updating the values of its slot, which ticks on the job graph
+ * when it declares its access and on the calling thread otherwise
+ */
+template <uint32 Index, bool Declared>
+class SyntheticSystem : public bge::GameSystem
+{
+public:
+  explicit SyntheticSystem(std::vector<float>* slots)
+      : m_Slots(slots)
+  {
+    if (!Declared)
+    {
+      return;
+    }
+
+    DeclareWrites<SyntheticSlot<Index>>();
+    if (Index >= c_SyntheticLayerSize)
+    {
+      DeclareReads<SyntheticSlot<Index % c_SyntheticLayerSize>,
+                   SyntheticSlot<(Index + 1) % c_SyntheticLayerSize>>();
+    }
+  }
+
+  void Tick(float deltaSeconds) override
+  {
+    float* values = m_Slots[Index].data();
+    const float* first = m_Slots[Index % c_SyntheticLayerSize].data();
+    const float* second = m_Slots[(Index + 1) % c_SyntheticLayerSize].data();
+    const bool hasInputs = Index >= c_SyntheticLayerSize;
+
+    for (uint32 i = 0; i < c_SyntheticValueCount; ++i)
+    {
+      const float input = hasInputs ? first[i] + second[i] : 1.0f;
+      values[i] = std::sqrt(values[i] * values[i] + input) * 0.5f +
+                  std::sin(values[i] * deltaSeconds);
+    }
+  }
+
+private:
+  std::vector<float>* m_Slots; ///< the values of all slots
+};
+
+/**
+ * Add a synthetic system for each index to a game world
+ */
+template <bool Declared, uint32... Indices>
+static void AddSyntheticSystems(bge::GameWorld& world,
+                                std::vector<float>* slots,
+                                std::integer_sequence<uint32, Indices...>)
+{
+  (void)std::initializer_list<int>{
+      (world.AddGameSystem(
+           std::make_unique<SyntheticSystem<Indices, Declared>>(slots)),
+       0)...};
+}
+
+/**
+ * Tick the synthetic systems of a game world
+ * @param declared whether the systems declare their access
+ * @param slots receives the values of the systems
+ * @return the average millis of a tick
+ */
+static float TickSyntheticSystems(bool declared,
+                                  std::vector<std::vector<float>>& slots)
+{
+  slots.assign(c_SyntheticSystemCount,
+               std::vector<float>(c_SyntheticValueCount, 1.0f));
+
+  bge::GameWorld world;
+  const auto indices =
+      std::make_integer_sequence<uint32, c_SyntheticSystemCount>();
+  if (declared)
+  {
+    AddSyntheticSystems<true>(world, slots.data(), indices);
+  }
+  else
+  {
+    AddSyntheticSystems<false>(world, slots.data(), indices);
+  }
+
+  // The first tick builds the schedule
+  world.Tick(0.04f);
+
+  return MeasureAverageMilli(c_SyntheticTickCount,
+                             [&world]() { world.Tick(0.04f); });
+}
+
+void RunGameWorldScheduleBenchmark()
+{
+  const uint32 maxThreadCount =
+      std::max(std::thread::hardware_concurrency(), c_MinScheduleThreadCount);
+
+  std::vector<std::vector<float>> serialSlots;
+  std::vector<std::vector<float>> scheduledSlots;
+
+  // Restart the scheduler with 0..N-1 workers besides the main thread
+  bge::Scheduler::Shutdown();
+
+  for (uint32 threadCount = 1; threadCount <= maxThreadCount; ++threadCount)
+  {
+    bge::Scheduler::Initialize(threadCount - 1);
+
+    const float serialMilli = TickSyntheticSystems(false, serialSlots);
+    const float scheduledMilli = TickSyntheticSystems(true, scheduledSlots);
+
+    bge::Scheduler::Shutdown();
+
+    std::cout << "threads: " << threadCount << "\t";
+    PrintComparison("tick", "serial", serialMilli, "scheduled",
+                    scheduledMilli);
+
+    if (serialSlots != scheduledSlots)
+    {
+      std::cout << "ERROR: the scheduled systems with " << threadCount
+                << " threads differ from the serial ones" << std::endl;
+    }
+  }
+
+  bge::Scheduler::Initialize();
+}
@@ -0,0 +1,238 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <events/EventBus.h>
+#include <events/KeyEvents.h>
+#include <events/MouseEvents.h>
+#include <util/RandomNumberGenerator.h>
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Number of events dispatched per measurement
+constexpr uint32 c_DispatchEventCount = 1000000u;
+// Number of listeners, each is interested in one of the event types
+constexpr uint32 c_EventListenerCount = 16u;
+// Number of event types the listeners are interested in
+constexpr uint32 c_ListenedEventTypeCount = 4u;
+
+/**
+ * The dispatcher the engine used before the EventBus, wrapping every handler
+ * in a std::function
+ */
+class StdFunctionDispatcher
+{
+public:
+  explicit StdFunctionDispatcher(bge::Event& event)
+      : m_Event(event)
+  {
+  }
+
+  template <typename T> bool Dispatch(std::function<bool(T&)> func)
+  {
+    if (m_Event.GetEventType() == T::GetStaticType())
+    {
+      m_Event.m_Handled = func(static_cast<T&>(m_Event));
+      return true;
+    }
+    return false;
+  }
+
+private:
+  bge::Event& m_Event;
+};
+
+/**
+ * A listener handling one event type, it sums what it receives so the
+ * dispatch methods can be compared
+ */
+class EventListener
+{
+public:
+  explicit EventListener(uint32 listenedType)
+      : m_ListenedType(listenedType)
+      , m_Sum(0.0)
+  {
+  }
+
+  /**
+   * Receives every event like the game systems used to, and dispatches the
+   * one it's interested in through a std::function of a std::bind
+   */
+  virtual void OnEvent(bge::Event& event)
+  {
+    StdFunctionDispatcher dispatcher(event);
+
+    switch (m_ListenedType)
+    {
+    case 0:
+      dispatcher.Dispatch<bge::KeyPressedEvent>(std::bind(
+          &EventListener::OnKeyPressed, this, std::placeholders::_1));
+      break;
+    case 1:
+      dispatcher.Dispatch<bge::KeyReleasedEvent>(std::bind(
+          &EventListener::OnKeyReleased, this, std::placeholders::_1));
+      break;
+    case 2:
+      dispatcher.Dispatch<bge::MouseMovedEvent>(std::bind(
+          &EventListener::OnMouseMoved, this, std::placeholders::_1));
+      break;
+    default:
+      dispatcher.Dispatch<bge::MouseScrolledEvent>(std::bind(
+          &EventListener::OnMouseScrolled, this, std::placeholders::_1));
+      break;
+    }
+  }
+
+  /**
+   * Subscribe the handler of the listened event type to a bus
+   */
+  void Subscribe(bge::EventBus& bus)
+  {
+    switch (m_ListenedType)
+    {
+    case 0:
+      bus.Subscribe<BGE_EVENT_HANDLER(EventListener::OnKeyPressed)>(this);
+      break;
+    case 1:
+      bus.Subscribe<BGE_EVENT_HANDLER(EventListener::OnKeyReleased)>(this);
+      break;
+    case 2:
+      bus.Subscribe<BGE_EVENT_HANDLER(EventListener::OnMouseMoved)>(this);
+      break;
+    default:
+      bus.Subscribe<BGE_EVENT_HANDLER(EventListener::OnMouseScrolled)>(this);
+      break;
+    }
+  }
+
+  FORCEINLINE double GetSum() const { return m_Sum; }
+  FORCEINLINE void ResetSum() { m_Sum = 0.0; }
+
+private:
+  bool OnKeyPressed(bge::KeyPressedEvent& event)
+  {
+    m_Sum += static_cast<double>(event.GetKeyCode());
+    return false;
+  }
+  bool OnKeyReleased(bge::KeyReleasedEvent& event)
+  {
+    m_Sum -= static_cast<double>(event.GetKeyCode());
+    return false;
+  }
+  bool OnMouseMoved(bge::MouseMovedEvent& event)
+  {
+    m_Sum += event.GetX() - event.GetY();
+    return false;
+  }
+  bool OnMouseScrolled(bge::MouseScrolledEvent& event)
+  {
+    m_Sum += event.GetYOffset();
+    return false;
+  }
+
+  uint32 m_ListenedType; ///< which of the event types the listener handles
+  double m_Sum;          ///< sum of the received events
+};
+
+/**
+ * @return the summed sums of the listeners, and resets them
+ */
+static double
+CollectSums(std::vector<std::unique_ptr<EventListener>>& listeners)
+{
+  double sum = 0.0;
+  for (auto&& listener : listeners)
+  {
+    sum += listener->GetSum();
+    listener->ResetSum();
+  }
+  return sum;
+}
+
+void RunEventDispatchBenchmark()
+{
+  // Random input events, the kinds a frame of heavy input broadcasts
+  bge::RandomNumberGenerator rng;
+  std::vector<std::unique_ptr<bge::Event>> events;
+  events.reserve(c_DispatchEventCount);
+
+  for (uint32 i = 0; i < c_DispatchEventCount; ++i)
+  {
+    const bge::KeyCode key =
+        static_cast<bge::KeyCode>(rng.GenRandInt(1u, 40u));
+
+    switch (rng.GenRandInt(0u, c_ListenedEventTypeCount - 1u))
+    {
+    case 0:
+      events.push_back(std::make_unique<bge::KeyPressedEvent>(key, 0));
+      break;
+    case 1:
+      events.push_back(std::make_unique<bge::KeyReleasedEvent>(key));
+      break;
+    case 2:
+      events.push_back(std::make_unique<bge::MouseMovedEvent>(
+          rng.GenRandReal(0.0f, 1920.0f), rng.GenRandReal(0.0f, 1080.0f)));
+      break;
+    default:
+      events.push_back(std::make_unique<bge::MouseScrolledEvent>(
+          0.0f, rng.GenRandReal(-1.0f, 1.0f)));
+      break;
+    }
+  }
+
+  std::vector<std::unique_ptr<EventListener>> listeners;
+  bge::EventBus bus;
+  for (uint32 i = 0; i < c_EventListenerCount; ++i)
+  {
+    listeners.push_back(
+        std::make_unique<EventListener>(i % c_ListenedEventTypeCount));
+    listeners.back()->Subscribe(bus);
+  }
+
+  // Every listener receives every event through a virtual call
+  const float fanOutMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& event : events)
+    {
+      for (auto&& listener : listeners)
+      {
+        listener->OnEvent(*event);
+      }
+    }
+  });
+  const double fanOutSum = CollectSums(listeners);
+
+  const float publishMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& event : events)
+    {
+      bus.Publish(*event);
+    }
+  });
+  const double publishSum = CollectSums(listeners);
+
+  // Queue the events of a frame and deliver them in a batch per type
+  const float queuedMilli = MeasureAverageMilli(1u, [&]() {
+    for (auto&& event : events)
+    {
+      bus.Enqueue(*event);
+    }
+    bus.DeliverQueued();
+  });
+  const double queuedSum = CollectSums(listeners);
+
+  std::cout << c_DispatchEventCount << " events, " << c_EventListenerCount
+            << " listeners" << std::endl;
+  PrintComparison("\tpublish", "fan-out", fanOutMilli, "bus", publishMilli);
+  PrintComparison("\tqueued", "fan-out", fanOutMilli, "bus", queuedMilli);
+
+  // A listener receives a single type, so grouping the queued events by type
+  // doesn't change the order of the events it sums
+  if (fanOutSum != publishSum || fanOutSum != queuedSum)
+  {
+    std::cout << "ERROR: the listeners received different events, fan-out: "
+              << fanOutSum << " publish: " << publishSum
+              << " queued: " << queuedSum << std::endl;
+  }
+}
@@ -0,0 +1,38 @@
+#include "BenchmarkUtils.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every heap allocation of the benchmarks goes through these replacements of
+// the global operator new and delete, so they can be counted
+
+/// number of heap allocations since the start of the program
+static std::atomic<uint64> s_HeapAllocationCount(0u);
+
+uint64 GetHeapAllocationCount()
+{
+  return s_HeapAllocationCount.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+  s_HeapAllocationCount.fetch_add(1u, std::memory_order_relaxed);
+
+  void* memory = std::malloc(size > 0 ? size : 1);
+  if (!memory)
+  {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+void* operator new[](size_t size) { return operator new(size); }
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t size) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t size) noexcept
+{
+  std::free(memory);
+}
@@ -0,0 +1,430 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <ecs/EntityManager.h>
+#include <ecs/World.h>
+#include <events/PhysicsEvents.h>
+#include <math/Vec.h>
+#include <memory/FrameAllocator.h>
+#include <physics/PhysicsDevice.h>
+#include <rendering/RenderDevice.h>
+#include <scheduler/ParallelFor.h>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Number of spheres of the frame allocator benchmark
+constexpr uint32 c_FrameSphereCount = 2000u;
+// Number of spheres along each side of the grid they're dropped in
+constexpr uint32 c_FrameGridSize = 20u;
+// Number of frames before the measured ones, the frame allocators grow to
+// their steady state size in the first ones
+constexpr uint32 c_WarmUpFrameCount = 10u;
+// Number of measured frames
+constexpr uint32 c_MeasuredFrameCount = 100u;
+// Number of spheres a task of a frame processes
+constexpr uint32 c_FrameTaskGrainSize = 64u;
+
+/**
+ * Heap allocations and timings of the measured frames
+ */
+struct FrameMeasurement
+{
+  float m_FrameMilli;           ///< average millis of a frame
+  float m_SimulateMilli;        ///< average millis of a simulation
+  uint64 m_FrameAllocations;    ///< heap allocations of the frames
+  uint64 m_SimulateAllocations; ///< heap allocations of the simulations
+  double m_Checksum;            ///< sum of the results of the frames
+};
+
+/**
+ * The temporary data of a frame in std::vectors, the exports of the
+ * collider transforms used to return a new std::vector every frame
+ */
+struct HeapFrameMemory
+{
+  template <typename T> static std::vector<T> CreateVector()
+  {
+    return std::vector<T>();
+  }
+  template <typename T> static std::vector<T> CreateDoubleBufferedVector()
+  {
+    return std::vector<T>();
+  }
+  template <typename Vector>
+  static std::vector<bge::Mat4f> Export(const Vector& matrices)
+  {
+    return std::vector<bge::Mat4f>(matrices.begin(), matrices.end());
+  }
+};
+
+/**
+ * The temporary data of a frame in the memory of the frame allocators
+ */
+struct LinearFrameMemory
+{
+  template <typename T> static bge::LinearVector<T> CreateVector()
+  {
+    return bge::FrameAllocator::CreateVector<T>();
+  }
+  template <typename T>
+  static bge::LinearVector<T> CreateDoubleBufferedVector()
+  {
+    return bge::FrameAllocator::CreateDoubleBufferedVector<T>();
+  }
+  template <typename Vector> static Vector Export(Vector matrices)
+  {
+    return matrices;
+  }
+};
+
+/**
+ * Simulates a pile of spheres and processes the sphere transforms like a
+ * frame of the engine would: exports the collider transforms, works on them
+ * in parallel tasks which need temporary arrays, and keeps the positions for
+ * the next frame to compare against
+ * @return heap allocations and timings of the frames after the warm up
+ */
+template <typename Memory> static FrameMeasurement SimulateFrames()
+{
+  bge::EntityManager entityManager;
+  std::vector<bge::Entity> entities;
+
+  entities.push_back(entityManager.CreateEntity());
+  bge::PhysicsDevice::MakeBoxCollider(entities.back(), bge::Vec3f(0.0f),
+                                      bge::Quatf(),
+                                      bge::Vec3f(40.0f, 1.0f, 40.0f));
+
+  for (uint32 i = 0; i < c_FrameSphereCount; ++i)
+  {
+    const uint32 x = i % c_FrameGridSize;
+    const uint32 y = i / (c_FrameGridSize * c_FrameGridSize);
+    const uint32 z = (i / c_FrameGridSize) % c_FrameGridSize;
+
+    entities.push_back(entityManager.CreateEntity());
+    bge::PhysicsDevice::CreateSphere(entities.back(), 1.0f, 0.5f);
+    bge::PhysicsDevice::SetBodyPosition(
+        entities.back(),
+        bge::Vec3f(x * 1.1f - 11.0f, 2.0f + y * 1.1f, z * 1.1f - 11.0f));
+  }
+
+  const uint32 taskCount =
+      (c_FrameSphereCount + c_FrameTaskGrainSize - 1) / c_FrameTaskGrainSize;
+  std::vector<double> taskResults(taskCount);
+
+  auto previous = Memory::template CreateDoubleBufferedVector<bge::Vec3f>();
+  FrameMeasurement measurement = {};
+
+  bge::Timer timer;
+  for (uint32 frame = 0; frame < c_WarmUpFrameCount + c_MeasuredFrameCount;
+       ++frame)
+  {
+    if (frame == c_WarmUpFrameCount)
+    {
+      measurement = FrameMeasurement{};
+      timer.Renew();
+    }
+
+    bge::FrameAllocator::NextFrame();
+
+    const uint64 simulateStart = GetHeapAllocationCount();
+    bge::Timer simulateTimer;
+    bge::PhysicsDevice::Simulate();
+    measurement.m_SimulateMilli += simulateTimer.GetElapsedMilli();
+
+    const uint64 frameStart = GetHeapAllocationCount();
+    measurement.m_SimulateAllocations += frameStart - simulateStart;
+
+    const auto spheres =
+        Memory::Export(bge::PhysicsDevice::GetAllSphereColliderTransforms());
+    const auto boxes =
+        Memory::Export(bge::PhysicsDevice::GetAllBoxColliderTransforms());
+
+    // Every task gathers the height of its spheres above the floor
+    bge::ParallelFor(0u, taskCount, 1u, [&](uint32 task) {
+      const uint32 begin = task * c_FrameTaskGrainSize;
+      const uint32 end = std::min(begin + c_FrameTaskGrainSize,
+                                  static_cast<uint32>(spheres.size()));
+
+      auto heights = Memory::template CreateVector<float>();
+      for (uint32 i = begin; i < end; ++i)
+      {
+        heights.push_back(spheres[i][13] - boxes[0][13]);
+      }
+
+      double sum = 0.0;
+      for (float height : heights)
+      {
+        sum += height;
+      }
+      taskResults[task] = sum;
+    });
+
+    auto positions = Memory::template CreateDoubleBufferedVector<bge::Vec3f>();
+    positions.reserve(spheres.size());
+    for (auto&& sphere : spheres)
+    {
+      positions.emplace_back(sphere[12], sphere[13], sphere[14]);
+    }
+
+    // Distance moved since the last frame, whose positions are still valid
+    double moved = 0.0;
+    for (size_t i = 0; i < previous.size() && i < positions.size(); ++i)
+    {
+      moved += positions[i].Distance(previous[i]);
+    }
+    previous = std::move(positions);
+
+    measurement.m_FrameAllocations += GetHeapAllocationCount() - frameStart;
+
+    measurement.m_Checksum += moved;
+    for (double result : taskResults)
+    {
+      measurement.m_Checksum += result;
+    }
+  }
+
+  measurement.m_FrameMilli = timer.GetElapsedMilli() / c_MeasuredFrameCount;
+  measurement.m_SimulateMilli /= c_MeasuredFrameCount;
+
+  for (uint32 i = c_FrameSphereCount; i > 0; --i)
+  {
+    bge::PhysicsDevice::DestroySphere(entities[i]);
+  }
+  bge::PhysicsDevice::DestroyBoxCollider(entities[0]);
+  bge::PhysicsDevice::Simulate();
+
+  return measurement;
+}
+
+#if defined BGE_NULL_RENDER_DEVICE
+
+// Number of rendered spheres of the world frames
+constexpr uint32 c_WorldSphereCount = 200u;
+// Number of spheres along each side of the grid of the world frames
+constexpr uint32 c_WorldGridSize = 10u;
+// Number of world frames before the measured ones, the spheres settle on the
+// floor and the buffers of the world grow to their steady state size
+constexpr uint32 c_WorldWarmUpFrameCount = 50u;
+// Seconds of a world update, the fixed update step of the application
+constexpr float c_WorldUpdateSeconds = 0.04f;
+
+/**
+ * Component the frame system adds to and removes from a sphere
+ */
+struct FrameToggle
+{
+  uint32 m_Frame; ///< the tick the component was added in
+};
+
+/**
+ * A game system receiving the collision events of the world, which records a
+ * structural change every tick so the frames go through the event bus and
+ * the command playback
+ */
+class FrameSystem : public bge::GameSystem
+{
+public:
+  explicit FrameSystem(bge::Entity entity)
+      : m_Entity(entity)
+  {
+    DeclareWrites<>();
+    SubscribeEvent<BGE_EVENT_HANDLER(FrameSystem::OnCollisionEvent)>();
+  }
+
+  void Tick(float) override
+  {
+    if (m_Ticks % 2u == 0u)
+    {
+      GetCommandBuffer().AddComponent(m_Entity, FrameToggle{m_Ticks});
+    }
+    else
+    {
+      GetCommandBuffer().RemoveComponent<FrameToggle>(m_Entity);
+    }
+    ++m_Ticks;
+  }
+
+  bool OnCollisionEvent(bge::EntitiesCollidedEvent& event)
+  {
+    m_ContactCount += event.GetCollidedBodies().GetCount();
+    return false;
+  }
+
+  FORCEINLINE uint64 GetContactCount() const { return m_ContactCount; }
+
+private:
+  bge::Entity m_Entity;      ///< the sphere the component is toggled on
+  uint32 m_Ticks = 0u;       ///< number of ticks of the system
+  uint64 m_ContactCount = 0; ///< contact pairs of the received events
+};
+
+/**
+ * Heap allocations of the measured world frames
+ */
+struct WorldFrameMeasurement
+{
+  uint64 m_UpdateAllocations; ///< heap allocations of World::Update
+  uint64 m_RenderAllocations; ///< heap allocations of World::Render
+  uint64 m_ContactCount;      ///< contact pairs the game system received
+};
+
+/**
+ * Runs frames of a world like the application does, on a pile of rendered
+ * spheres with a game system, and counts the heap allocations of the frames
+ * after the warm up. The measured frames destroy no entities, a frame which
+ * does still allocates the vector of its EntitiesDestroyedEvent.
+ * @return heap allocations of the frames after the warm up
+ */
+static WorldFrameMeasurement RunWorldFrames()
+{
+  bge::RenderDevice::Initialize();
+
+  WorldFrameMeasurement measurement = {};
+  {
+    bge::World world;
+    world.SetEventCallback(
+        [&world](bge::Event& event) { world.OnEvent(event); });
+    world.Init();
+
+    bge::RenderWorld& renderWorld = world.GetRenderWorld();
+    bge::PhysicsWorld& physicsWorld = world.GetPhysicsWorld();
+
+    renderWorld.AddCamera(bge::Vec4i32(0, 0, 1280, 720), 60.0f, 0.1f, 100.0f);
+
+    std::vector<bge::Entity> entities;
+    entities.push_back(world.CreateEntity());
+    physicsWorld.GetColliderSystem().AddBoxCollider(
+        entities.back(), bge::Vec3f(0.0f, -5.0f, -20.0f), bge::Quatf(),
+        bge::Vec3f(20.0f, 1.0f, 20.0f));
+
+    bge::DynamicMeshData meshData;
+    meshData.m_Mesh = renderWorld.LoadMesh("res/models/sphere.obj");
+    meshData.m_Material.m_Shader = renderWorld.LoadShader("res/shaders/basic");
+    meshData.m_Material.m_Textures.push_back(
+        renderWorld.LoadTexture2D("res/textures/bricks.jpg"));
+
+    for (uint32 i = 0; i < c_WorldSphereCount; ++i)
+    {
+      const uint32 x = i % c_WorldGridSize;
+      const uint32 y = i / (c_WorldGridSize * c_WorldGridSize);
+      const uint32 z = (i / c_WorldGridSize) % c_WorldGridSize;
+
+      entities.push_back(world.CreateEntity());
+      physicsWorld.GetRigidBodySystem().AddSphereBodyComponent(entities.back(),
+                                                               1.0f, 1.0f);
+      physicsWorld.GetRigidBodySystem().SetBodyPosition(
+          entities.back(), bge::Vec3f(x * 2.2f - 10.0f, -2.0f + y * 2.2f,
+                                      z * 2.2f - 30.0f));
+      renderWorld.GetDynamicMeshSystem().AddComponent(entities.back(),
+                                                      meshData);
+    }
+
+    auto system = std::make_unique<FrameSystem>(entities.back());
+    const FrameSystem& frameSystem = *system;
+    world.GetGameWorld().AddGameSystem(std::move(system));
+
+    const uint32 frameCount = c_WorldWarmUpFrameCount + c_MeasuredFrameCount;
+    for (uint32 frame = 0; frame < frameCount; ++frame)
+    {
+      if (frame == c_WorldWarmUpFrameCount)
+      {
+        measurement = WorldFrameMeasurement{};
+        measurement.m_ContactCount = frameSystem.GetContactCount();
+      }
+
+      bge::FrameAllocator::NextFrame();
+
+      const uint64 updateStart = GetHeapAllocationCount();
+      world.Update(c_WorldUpdateSeconds);
+      const uint64 renderStart = GetHeapAllocationCount();
+      world.Render(1.0f);
+
+      measurement.m_UpdateAllocations += renderStart - updateStart;
+      measurement.m_RenderAllocations += GetHeapAllocationCount() - renderStart;
+    }
+    measurement.m_ContactCount =
+        frameSystem.GetContactCount() - measurement.m_ContactCount;
+
+    // The bodies and colliders live in the physics device, which outlives
+    // the world, so the update removes them before it goes
+    world.DestroyEntities(entities.data(),
+                          static_cast<uint32>(entities.size()));
+    world.Update(c_WorldUpdateSeconds);
+  }
+
+  bge::RenderDevice::Shutdown();
+
+  return measurement;
+}
+
+#endif
+
+void RunFrameAllocatorBenchmark()
+{
+  bge::FrameAllocator::Initialize();
+
+  const FrameMeasurement heap = SimulateFrames<HeapFrameMemory>();
+  const FrameMeasurement linear = SimulateFrames<LinearFrameMemory>();
+  const bge::FrameAllocatorStats& stats = bge::FrameAllocator::GetStats();
+
+  std::cout << c_FrameSphereCount << " spheres, heap allocations per frame"
+            << std::endl;
+  std::cout << "\tsimulate: "
+            << static_cast<double>(linear.m_SimulateAllocations) /
+                   c_MeasuredFrameCount
+            << "\tstd::vector: "
+            << static_cast<double>(heap.m_FrameAllocations) /
+                   c_MeasuredFrameCount
+            << "\tframe allocator: "
+            << static_cast<double>(linear.m_FrameAllocations) /
+                   c_MeasuredFrameCount
+            << std::endl;
+  PrintComparison("frame without simulate", "std::vector",
+                  heap.m_FrameMilli - heap.m_SimulateMilli, "frame allocator",
+                  linear.m_FrameMilli - linear.m_SimulateMilli);
+  std::cout << "frame allocator bytes, last frame: " << stats.m_FrameBytes
+            << "\tpeak: " << stats.m_PeakFrameBytes
+            << "\tcapacity: " << stats.m_CapacityBytes << std::endl;
+
+  if (linear.m_FrameAllocations != 0u)
+  {
+    std::cout << "ERROR: steady state frames allocated on the heap"
+              << std::endl;
+  }
+  if (heap.m_Checksum != linear.m_Checksum)
+  {
+    std::cout << "ERROR: the frames differ, std::vector: " << heap.m_Checksum
+              << " frame allocator: " << linear.m_Checksum << std::endl;
+  }
+
+#if defined BGE_NULL_RENDER_DEVICE
+  const WorldFrameMeasurement world = RunWorldFrames();
+
+  std::cout << "world of " << c_WorldSphereCount
+            << " rendered spheres, heap allocations per frame" << std::endl;
+  std::cout << "\tupdate: "
+            << static_cast<double>(world.m_UpdateAllocations) /
+                   c_MeasuredFrameCount
+            << "\trender: "
+            << static_cast<double>(world.m_RenderAllocations) /
+                   c_MeasuredFrameCount
+            << "\tcontacts: "
+            << static_cast<double>(world.m_ContactCount) / c_MeasuredFrameCount
+            << std::endl;
+
+  if (world.m_UpdateAllocations != 0u || world.m_RenderAllocations != 0u)
+  {
+    std::cout << "ERROR: steady state world frames allocated on the heap"
+              << std::endl;
+  }
+#else
+  std::cout << "Skipped the world frames, they need the engine built with "
+               "BGE_NULL_RENDER_DEVICE"
+            << std::endl;
+#endif
+
+  bge::FrameAllocator::Shutdown();
+}
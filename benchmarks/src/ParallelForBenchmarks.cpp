@@ -0,0 +1,205 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <ecs/EntityManager.h>
+#include <math/AABB.h>
+#include <rendering/DynamicMeshSystem.h>
+#include <scheduler/ParallelAlgorithms.h>
+#include <util/RandomNumberGenerator.h>
+#include <util/Timer.h>
+
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+// Number of dynamic meshes the transform benchmark updates
+constexpr uint32 c_TransformCount = 4096u;
+// Number of elements the reduce/scan benchmarks process
+constexpr uint32 c_ReduceElementCount = 1u << 20;
+// Number of times each measured loop is repeated
+constexpr uint32 c_ParallelForIterations = 100u;
+
+// Array sizes the splitter benchmark runs on
+constexpr uint32 c_SmallSplitterCount = 1024u;
+constexpr uint32 c_LargeSplitterCount = 1u << 20;
+
+void RunParallelTransformsBenchmark()
+{
+  bge::RandomNumberGenerator rng;
+  bge::EntityManager entityManager;
+
+  // DynamicMeshSystem::UpdateTransforms
+  bge::DynamicMeshSystem meshSystem;
+  std::vector<bge::Transform> transforms;
+  transforms.reserve(c_TransformCount);
+
+  for (uint32 i = 0; i < c_TransformCount; ++i)
+  {
+    meshSystem.AddComponent(entityManager.CreateEntity(),
+                            bge::DynamicMeshData());
+
+    transforms.emplace_back(
+        bge::Vec3f(rng.GenRandReal(-15.0f, 15.0f),
+                   rng.GenRandReal(-15.0f, 15.0f),
+                   rng.GenRandReal(-15.0f, 15.0f)),
+        bge::Vec3f(1.0f),
+        bge::Quatf(bge::Vec3f(rng.GenRandReal(-3.0f, 3.0f), 0.0f, 0.0f)));
+  }
+
+  std::vector<bge::Mat4f> matrices(c_TransformCount, bge::Mat4f(1.0f));
+
+  const float serialMeshMilli =
+      MeasureAverageMilli(c_ParallelForIterations, [&]() {
+        for (size_t i = 0; i < transforms.size(); i++)
+        {
+          matrices[i] = transforms[i].ToMatrix();
+        }
+      });
+  const float parallelMeshMilli = MeasureAverageMilli(
+      c_ParallelForIterations,
+      [&]() { meshSystem.UpdateTransforms(transforms); });
+
+  PrintComparison("DynamicMeshSystem::UpdateTransforms", "serial",
+                  serialMeshMilli, "parallel", parallelMeshMilli);
+}
+
+void RunParallelReduceBenchmark()
+{
+  bge::RandomNumberGenerator rng;
+
+  std::vector<bge::Vec3f> points;
+  std::vector<uint32> counts;
+  points.reserve(c_ReduceElementCount);
+  counts.reserve(c_ReduceElementCount);
+
+  for (uint32 i = 0; i < c_ReduceElementCount; ++i)
+  {
+    points.emplace_back(rng.GenRandReal(-100.0f, 100.0f),
+                        rng.GenRandReal(-100.0f, 100.0f),
+                        rng.GenRandReal(-100.0f, 100.0f));
+    counts.push_back(rng.GenRandInt(0u, 16u));
+  }
+
+  // AABB union
+  const bge::AABB empty(bge::Vec3f(std::numeric_limits<float>::max()),
+                        bge::Vec3f(-std::numeric_limits<float>::max()));
+  bge::AABB serialBounds = empty;
+  bge::AABB parallelBounds = empty;
+
+  const float serialBoundsMilli =
+      MeasureAverageMilli(c_ParallelForIterations, [&]() {
+        serialBounds = empty;
+        for (auto&& point : points)
+        {
+          serialBounds = serialBounds.AddPoint(point);
+        }
+      });
+  const float parallelBoundsMilli =
+      MeasureAverageMilli(c_ParallelForIterations, [&]() {
+        parallelBounds = bge::ParallelTransformReduce(
+            0u, c_ReduceElementCount, 4096u, empty,
+            [&](uint32 i) { return bge::AABB(points[i], points[i]); },
+            [](const bge::AABB& a, const bge::AABB& b) {
+              return a.AddAABB(b);
+            });
+      });
+
+  PrintComparison("AABB union", "serial", serialBoundsMilli, "parallel",
+                  parallelBoundsMilli);
+
+  if (serialBounds != parallelBounds)
+  {
+    std::cout << "ERROR: parallel AABB union differs from the serial one"
+              << std::endl;
+  }
+
+  // Exclusive prefix sum, eg. for compacting arrays
+  std::vector<uint32> serialOffsets(c_ReduceElementCount);
+  std::vector<uint32> parallelOffsets(c_ReduceElementCount);
+
+  const float serialScanMilli =
+      MeasureAverageMilli(c_ParallelForIterations, [&]() {
+        uint32 offset = 0u;
+        for (uint32 i = 0; i < c_ReduceElementCount; ++i)
+        {
+          serialOffsets[i] = offset;
+          offset += counts[i];
+        }
+      });
+  const float parallelScanMilli =
+      MeasureAverageMilli(c_ParallelForIterations, [&]() {
+        bge::ParallelExclusiveScan(counts.data(), parallelOffsets.data(),
+                                   c_ReduceElementCount, 16384u, 0u,
+                                   [](uint32 a, uint32 b) { return a + b; });
+      });
+
+  PrintComparison("Exclusive prefix sum", "serial", serialScanMilli,
+                  "parallel", parallelScanMilli);
+
+  if (serialOffsets != parallelOffsets)
+  {
+    std::cout << "ERROR: parallel prefix sum differs from the serial one"
+              << std::endl;
+  }
+}
+
+/**
+ * Runs the same per-element workload with the passed splitter
+ * @return the average millis per ParallelFor call
+ */
+template <typename SplitterType>
+float MeasureSplitter(const std::vector<float>& input,
+                      std::vector<float>& output, uint32 iterations,
+                      const SplitterType& splitter)
+{
+  return MeasureAverageMilli(iterations, [&]() {
+    bge::ParallelFor(0u, static_cast<uint32>(input.size()), splitter,
+                     [&](uint32 i) {
+                       output[i] = std::sqrt(input[i]) * std::sin(input[i]);
+                     });
+  });
+}
+
+/**
+ * Prints the timings of every splitter for an array of count elements
+ */
+void CompareSplitters(uint32 count, uint32 iterations)
+{
+  bge::RandomNumberGenerator rng;
+
+  std::vector<float> input(count);
+  std::vector<float> output(count);
+  for (auto&& value : input)
+  {
+    value = rng.GenRandReal(0.0f, 100.0f);
+  }
+
+  static bge::SplitterProfile s_Profile(50.0f);
+
+  // Warm up the profile, so the measurement uses the tuned grain size
+  MeasureSplitter(input, output, iterations, bge::ProfiledSplitter(s_Profile));
+
+  std::cout << "Elements: " << count << std::endl;
+  std::cout << "\tcount 64: "
+            << MeasureSplitter(input, output, iterations,
+                               bge::CountSplitter(64u))
+            << " ms" << std::endl;
+  std::cout << "\tcount 16384: "
+            << MeasureSplitter(input, output, iterations,
+                               bge::CountSplitter(16384u))
+            << " ms" << std::endl;
+  std::cout << "\tlazy: "
+            << MeasureSplitter(input, output, iterations, bge::LazySplitter())
+            << " ms" << std::endl;
+  std::cout << "\tprofiled (50 us leaves): "
+            << MeasureSplitter(input, output, iterations,
+                               bge::ProfiledSplitter(s_Profile))
+            << " ms, grain size " << s_Profile.GetGrainSize() << std::endl;
+}
+
+void RunSplitterBenchmark()
+{
+  CompareSplitters(c_SmallSplitterCount, 1000u);
+  CompareSplitters(c_LargeSplitterCount, 20u);
+}
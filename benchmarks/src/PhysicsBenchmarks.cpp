@@ -0,0 +1,423 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <ecs/EntityManager.h>
+#include <math/Transform.h>
+#include <physics/PhysicsDevice.h>
+#include <physics/RigidBodySystem.h>
+#include <scheduler/Scheduler.h>
+#include <util/RandomNumberGenerator.h>
+#include <util/Timer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Number of spheres dropped on the floor in the scaling benchmark
+constexpr uint32 c_PhysicsSphereCount = 8000u;
+// Number of spheres along each side of the grid they start in
+constexpr uint32 c_PhysicsGridSize = 20u;
+// Number of simulated frames per thread count
+constexpr uint32 c_PhysicsFrameCount = 60u;
+// Run at least this many threads, so determinism is checked on small machines
+constexpr uint32 c_MinPhysicsThreadCount = 4u;
+// Sphere counts of the capacity benchmark, from a small scene to 100k
+constexpr uint32 c_CapacitySphereCounts[] = {1000u,  2000u,  4000u,  8000u,
+                                             16000u, 32000u, 100000u};
+// Number of simulated frames per sphere count
+constexpr uint32 c_CapacityFrameCount = 20u;
+// Number of bodies looked up per frame in the lookup benchmark
+constexpr uint32 c_LookupBodyCount = 8000u;
+// Number of frames the lookups are repeated
+constexpr uint32 c_LookupFrameCount = 200u;
+// Number of spheres along each side of the layer of the export benchmark
+constexpr uint32 c_ExportGridSize = 90u;
+// Number of frames the layer of the export benchmark settles before measuring
+constexpr uint32 c_SettleFrameCount = 300u;
+// Number of measured frames of the export benchmark
+constexpr uint32 c_ExportFrameCount = 100u;
+// Largest difference between an exported matrix and Transform::ToMatrix
+constexpr float c_MatrixTolerance = 1e-4f;
+
+/**
+ * @return number of pairs in the report with the passed state
+ */
+static uint32 CountContacts(const bge::CollidedBodies& contacts,
+                           bge::ContactState state)
+{
+  uint32 count = 0;
+  for (uint32 i = 0; i < contacts.GetCount(); ++i)
+  {
+    count += contacts.GetState(i) == state ? 1 : 0;
+  }
+
+  return count;
+}
+
+/**
+ * Drops a grid of spheres on a floor and simulates it
+ * @param sphereCount number of spheres, the floor is another collider
+ * @param frameCount number of frames to simulate
+ * @param frameMilli receives the average millis per simulated frame
+ * @param touchingCount receives the number of touching pairs after the last
+ * frame
+ * @return the transforms of all spheres after the last frame
+ */
+static std::vector<bge::Transform> SimulateSpherePile(uint32 sphereCount,
+                                                      uint32 frameCount,
+                                                      float& frameMilli,
+                                                      uint32& touchingCount)
+{
+  bge::EntityManager entityManager;
+  std::vector<bge::Entity> entities;
+  entities.reserve(sphereCount + 1);
+
+  entities.push_back(entityManager.CreateEntity());
+  bge::PhysicsDevice::MakeBoxCollider(entities.back(), bge::Vec3f(0.0f),
+                                      bge::Quatf(),
+                                      bge::Vec3f(40.0f, 1.0f, 40.0f));
+
+  for (uint32 i = 0; i < sphereCount; ++i)
+  {
+    const uint32 x = i % c_PhysicsGridSize;
+    const uint32 y = i / (c_PhysicsGridSize * c_PhysicsGridSize);
+    const uint32 z = (i / c_PhysicsGridSize) % c_PhysicsGridSize;
+
+    entities.push_back(entityManager.CreateEntity());
+    bge::PhysicsDevice::CreateSphere(entities.back(), 1.0f, 0.5f);
+
+    // Offset every other layer, so the spheres don't stack perfectly
+    const float offset = (y % 2) * 0.25f;
+    bge::PhysicsDevice::SetBodyPosition(
+        entities.back(), bge::Vec3f(x * 1.1f - 11.0f + offset, 2.0f + y * 1.1f,
+                                    z * 1.1f - 11.0f + offset));
+  }
+
+  bge::CollidedBodies contacts;
+  frameMilli = MeasureAverageMilli(frameCount, [&]() {
+    contacts = bge::PhysicsDevice::Simulate();
+  });
+
+  touchingCount = contacts.GetCount() -
+                  CountContacts(contacts, bge::ContactState::End);
+
+  std::vector<bge::Transform> transforms(sphereCount);
+  for (uint32 i = 0; i < sphereCount; ++i)
+  {
+    bge::PhysicsDevice::GetBodyTransform(entities[i + 1], transforms[i]);
+  }
+
+  // Remove everything again, newest first, and step once more so the contact
+  // cache is empty for the next run
+  for (uint32 i = sphereCount; i > 0; --i)
+  {
+    bge::PhysicsDevice::DestroySphere(entities[i]);
+  }
+  bge::PhysicsDevice::DestroyBoxCollider(entities[0]);
+  contacts = bge::PhysicsDevice::Simulate();
+
+  if (CountContacts(contacts, bge::ContactState::End) != touchingCount)
+  {
+    std::cout << "ERROR: not every contact ended after removing the bodies"
+              << std::endl;
+  }
+
+  return transforms;
+}
+
+/**
+ * @return true if both lists hold bitwise the same positions and rotations
+ */
+static bool AreTransformsEqual(const std::vector<bge::Transform>& first,
+                               const std::vector<bge::Transform>& second)
+{
+  for (size_t i = 0; i < first.size(); ++i)
+  {
+    for (uint32 j = 0; j < 3; ++j)
+    {
+      if (first[i].GetTranslation()[j] != second[i].GetTranslation()[j])
+      {
+        return false;
+      }
+    }
+
+    for (uint32 j = 0; j < 4; ++j)
+    {
+      if (first[i].GetRotation()[j] != second[i].GetRotation()[j])
+      {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+void RunPhysicsScalingBenchmark()
+{
+  const uint32 maxThreadCount =
+      std::max(std::thread::hardware_concurrency(), c_MinPhysicsThreadCount);
+
+  float serialMilli = 0.0f;
+  std::vector<bge::Transform> serialTransforms;
+
+  // Restart the scheduler with 0..N-1 workers besides the main thread
+  bge::Scheduler::Shutdown();
+
+  for (uint32 threadCount = 1; threadCount <= maxThreadCount; ++threadCount)
+  {
+    bge::Scheduler::Initialize(threadCount - 1);
+
+    float frameMilli = 0.0f;
+    uint32 touchingCount = 0;
+    const std::vector<bge::Transform> transforms =
+        SimulateSpherePile(c_PhysicsSphereCount, c_PhysicsFrameCount,
+                           frameMilli, touchingCount);
+
+    bge::Scheduler::Shutdown();
+
+    if (threadCount == 1)
+    {
+      serialMilli = frameMilli;
+      serialTransforms = transforms;
+    }
+
+    std::cout << "threads: " << threadCount << "\t" << frameMilli
+              << " ms/frame\tspeedup: " << serialMilli / frameMilli
+              << "x\ttouching pairs: " << touchingCount << std::endl;
+
+    if (!AreTransformsEqual(serialTransforms, transforms))
+    {
+      std::cout << "ERROR: the simulation with " << threadCount
+                << " threads differs from the one with 1 thread" << std::endl;
+    }
+  }
+
+  bge::Scheduler::Initialize();
+}
+
+void RunPhysicsCapacityBenchmark()
+{
+  for (uint32 sphereCount : c_CapacitySphereCounts)
+  {
+    // The floor takes a collider as well
+    if (sphereCount >= bge::c_MaxPhysicsColliderCount)
+    {
+      std::cout << "spheres: " << sphereCount
+                << "\tskipped, nudge supports up to "
+                << bge::c_MaxPhysicsColliderCount << " colliders" << std::endl;
+      continue;
+    }
+
+    float frameMilli = 0.0f;
+    uint32 touchingCount = 0;
+    SimulateSpherePile(sphereCount, c_CapacityFrameCount, frameMilli,
+                       touchingCount);
+
+    // Storage only grows, so this is the memory of the largest scene so far
+    const bge::PhysicsMemoryStats stats =
+        bge::PhysicsDevice::GetMemoryStats();
+
+    std::cout << "spheres: " << sphereCount << "\t" << frameMilli
+              << " ms/frame\tbody capacity: " << stats.m_BodyCapacity
+              << "\tcollider capacity: " << stats.m_ColliderCapacity
+              << "\tarena: " << stats.m_ArenaSize / 1024
+              << " KB\tarena peak: " << stats.m_ArenaPeakUsage / 1024 << " KB"
+              << std::endl;
+  }
+}
+
+void RunEntityLookupBenchmark()
+{
+  bge::RandomNumberGenerator rng;
+  bge::EntityManager entityManager;
+  bge::RigidBodySystem bodySystem;
+
+  std::vector<bge::Entity> entities;
+  entities.reserve(c_LookupBodyCount);
+
+  // The map the physics device used before, entity id to body index
+  std::unordered_map<uint32, uint32> entityToBody;
+
+  for (uint32 i = 0; i < c_LookupBodyCount; ++i)
+  {
+    entities.push_back(entityManager.CreateEntity());
+    bodySystem.AddSphereBodyComponent(entities.back(), 1.0f, 0.5f);
+    entityToBody[entities.back().GetId()] = i;
+  }
+
+  // Gameplay code looks up bodies in no particular order
+  for (uint32 i = c_LookupBodyCount - 1; i > 0; --i)
+  {
+    std::swap(entities[i], entities[rng.GenRandInt(0u, i)]);
+  }
+
+  const bge::EntityIndex& bodyIndex = bge::PhysicsDevice::GetBodyIndex();
+  uint64 mapSum = 0;
+  uint64 indexSum = 0;
+
+  const float mapMilli = MeasureAverageMilli(c_LookupFrameCount, [&]() {
+    for (auto&& entity : entities)
+    {
+      mapSum += entityToBody.find(entity.GetId())->second;
+    }
+  });
+  const float indexMilli = MeasureAverageMilli(c_LookupFrameCount, [&]() {
+    for (auto&& entity : entities)
+    {
+      indexSum += bodyIndex.Find(entity);
+    }
+  });
+
+  PrintComparison("8k lookups per frame", "unordered_map", mapMilli,
+                  "EntityIndex", indexMilli);
+
+  if (mapSum != indexSum)
+  {
+    std::cout << "ERROR: the index maps entities to other bodies than the map"
+              << std::endl;
+  }
+
+  // Transform sync, a lookup per body against the linear copy in body order
+  std::vector<bge::Transform> transforms(c_LookupBodyCount);
+
+  const float lookupSyncMilli =
+      MeasureAverageMilli(c_LookupFrameCount, [&]() {
+        for (uint32 i = 0; i < c_LookupBodyCount; ++i)
+        {
+          bge::PhysicsDevice::GetBodyTransform(bodyIndex.GetEntity(i),
+                                               transforms[i]);
+        }
+      });
+  const float linearSyncMilli = MeasureAverageMilli(
+      c_LookupFrameCount, [&]() {
+        bge::PhysicsDevice::GetBodyTransforms(0u, c_LookupBodyCount,
+                                              transforms.data());
+      });
+
+  PrintComparison("8k transform syncs per frame", "per entity",
+                  lookupSyncMilli, "linear", linearSyncMilli);
+
+  // Destroy in random order, which exercises the swap of every removal
+  for (auto&& entity : entities)
+  {
+    bodySystem.DestroyRigidBody(entity);
+  }
+
+  if (bodyIndex.GetCount() != 0)
+  {
+    std::cout << "ERROR: bodies are left after destroying all of them"
+              << std::endl;
+  }
+}
+
+/**
+ * Simulates frames and syncs the body matrices after each, once with a lookup
+ * and a ToMatrix per body and once with the bulk export
+ * @param name what is measured
+ * @param frameCount number of simulated frames
+ * @param scales the scale of every body
+ * @param exported the matrices of the bulk export, kept between calls
+ */
+static void MeasureMatrixSync(const char* name, uint32 frameCount,
+                              const std::vector<bge::Vec3f>& scales,
+                              std::vector<bge::Mat4f>& exported)
+{
+  const bge::EntityIndex& bodyIndex = bge::PhysicsDevice::GetBodyIndex();
+  const uint32 bodyCount = bodyIndex.GetCount();
+
+  std::vector<bge::Transform> transforms(bodyCount);
+  std::vector<bge::Mat4f> matrices(bodyCount);
+
+  float perBodyMilli = 0.0f;
+  float exportMilli = 0.0f;
+  uint32 exportedCount = 0;
+
+  for (uint32 frame = 0; frame < frameCount; ++frame)
+  {
+    bge::PhysicsDevice::Simulate();
+
+    bge::Timer timer;
+    for (uint32 i = 0; i < bodyCount; ++i)
+    {
+      bge::PhysicsDevice::GetBodyTransform(bodyIndex.GetEntity(i),
+                                           transforms[i]);
+      transforms[i].SetScale(scales[i]);
+      matrices[i] = transforms[i].ToMatrix();
+    }
+    perBodyMilli += timer.GetElapsedMilli();
+
+    // Serial as well, so both versions run on a single thread
+    timer.Renew();
+    exportedCount += bge::PhysicsDevice::ExportBodyMatrices(
+        0u, bodyCount, scales.data(), exported.data());
+    exportMilli += timer.GetElapsedMilli();
+  }
+
+  PrintComparison(name, "per body", perBodyMilli / frameCount, "bulk export",
+                  exportMilli / frameCount);
+  std::cout << "\tmoving bodies per frame: " << exportedCount / frameCount
+            << " of " << bodyCount << std::endl;
+
+  // Sleeping bodies must still have the matrix of where they fell asleep
+  float maxDifference = 0.0f;
+  for (uint32 i = 0; i < bodyCount; ++i)
+  {
+    for (uint32 j = 0; j < 16; ++j)
+    {
+      maxDifference =
+          std::max(maxDifference, std::abs(matrices[i][j] - exported[i][j]));
+    }
+  }
+
+  if (maxDifference > c_MatrixTolerance)
+  {
+    std::cout << "ERROR: exported matrices differ from Transform::ToMatrix by "
+              << maxDifference << std::endl;
+  }
+}
+
+void RunBodyMatrixExportBenchmark()
+{
+  bge::EntityManager entityManager;
+  bge::RigidBodySystem bodySystem;
+
+  const bge::Entity floor = entityManager.CreateEntity();
+  bge::PhysicsDevice::MakeBoxCollider(floor, bge::Vec3f(0.0f), bge::Quatf(),
+                                      bge::Vec3f(60.0f, 1.0f, 60.0f));
+
+  // A single layer, which comes to rest unlike the pile of the other benchmarks
+  for (uint32 i = 0; i < c_PhysicsSphereCount; ++i)
+  {
+    const uint32 x = i % c_ExportGridSize;
+    const uint32 z = i / c_ExportGridSize;
+
+    const bge::Entity entity = entityManager.CreateEntity();
+    bodySystem.AddSphereBodyComponent(entity, 1.0f, 0.5f);
+    bodySystem.SetBodyPosition(entity, bge::Vec3f(x * 1.2f - 54.0f, 2.0f,
+                                                  z * 1.2f - 54.0f));
+  }
+
+  const std::vector<bge::Vec3f> scales(c_PhysicsSphereCount, bge::Vec3f(0.5f));
+  std::vector<bge::Mat4f> exported(c_PhysicsSphereCount);
+
+  MeasureMatrixSync("8k falling bodies", c_ExportFrameCount, scales, exported);
+
+  for (uint32 i = 0; i < c_SettleFrameCount; ++i)
+  {
+    bge::PhysicsDevice::Simulate();
+  }
+
+  MeasureMatrixSync("8k resting bodies", c_ExportFrameCount, scales, exported);
+
+  const bge::EntityIndex& bodyIndex = bge::PhysicsDevice::GetBodyIndex();
+  while (bodyIndex.GetCount() > 0)
+  {
+    bodySystem.DestroyRigidBody(bodyIndex.GetEntity(bodyIndex.GetCount() - 1));
+  }
+  bge::PhysicsDevice::DestroyBoxCollider(floor);
+  bge::PhysicsDevice::Simulate();
+}
@@ -0,0 +1,322 @@
+#include "BenchmarkUtils.h"
+#include "Benchmarks.h"
+
+#include <math/Mat.h>
+#include <rendering/FrustumCuller.h>
+#include <rendering/NullRenderDevice.h>
+#include <rendering/RenderDevice.h>
+#include <util/RandomNumberGenerator.h>
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Number of draws of a measured frame
+constexpr uint32 c_UniformDrawCount = 100000u;
+// Number of shader programs the draws of a frame are spread over
+constexpr uint32 c_UniformShaderCount = 16u;
+// Number of measured frames
+constexpr uint32 c_UniformFrameCount = 20u;
+// Number of indices of a drawn mesh, a cube
+constexpr uint32 c_UniformDrawIndexCount = 36u;
+// Number of measured culls of every instance count
+constexpr uint32 c_CullFrameCount = 20u;
+// Half size of the cube the culled instances are scattered in
+constexpr float c_CullWorldHalfSize = 200.0f;
+
+/**
+ * The mesh data of a culled instance
+ */
+struct CullInstance
+{
+  bge::Mesh m_Mesh; /**< The mesh of the instance, a unit cube */
+};
+
+/**
+ * A world space bounding box, stored as AoS by the scalar culling
+ */
+struct CullBox
+{
+  bge::Vec3f m_Center;  /**< The center of the box */
+  bge::Vec3f m_Extents; /**< The half sizes of the box */
+};
+
+/**
+ * Tests every box against the 6 planes of a frustum, one box and one plane at
+ * a time
+ * @param boxes the boxes to test
+ * @param frustum the camera's frustum
+ * @param visibleInstances filled with the indices of the visible boxes
+ */
+static void CullScalar(const std::vector<CullBox>& boxes,
+                       const bge::Frustum& frustum,
+                       std::vector<uint32>& visibleInstances)
+{
+  visibleInstances.clear();
+
+  for (uint32 i = 0; i < boxes.size(); ++i)
+  {
+    const CullBox& box = boxes[i];
+
+    bool isInside = true;
+    for (uint32 j = 0; j < 6 && isInside; ++j)
+    {
+      const bge::Vec4f& plane = frustum.m_Planes[j];
+
+      const float distance =
+          plane[0] * box.m_Center[0] + plane[1] * box.m_Center[1] +
+          plane[2] * box.m_Center[2] + plane[3] +
+          std::abs(plane[0]) * box.m_Extents[0] +
+          std::abs(plane[1]) * box.m_Extents[1] +
+          std::abs(plane[2]) * box.m_Extents[2];
+      isInside = distance >= 0.0f;
+    }
+
+    if (isInside)
+    {
+      visibleInstances.push_back(i);
+    }
+  }
+}
+
+/**
+ * Culls randomly placed, rotated and scaled unit cubes against the frustum of
+ * a camera at the center of them, with the scalar AoS test against the SIMD
+ * FrustumCuller
+ * @param count the number of instances
+ */
+static void CompareCulling(uint32 count)
+{
+  bge::RandomNumberGenerator rng;
+
+  std::vector<CullInstance> instances(count);
+  std::vector<bge::Mat4f> transforms;
+  transforms.reserve(count);
+  for (CullInstance& instance : instances)
+  {
+    instance.m_Mesh.m_BoundsCenter = bge::Vec3f(0.0f);
+    instance.m_Mesh.m_BoundsExtents = bge::Vec3f(0.5f);
+
+    const bge::Vec3f position(
+        rng.GenRandReal(-c_CullWorldHalfSize, c_CullWorldHalfSize),
+        rng.GenRandReal(-c_CullWorldHalfSize, c_CullWorldHalfSize),
+        rng.GenRandReal(-c_CullWorldHalfSize, c_CullWorldHalfSize));
+    const bge::Vec3f scale(rng.GenRandReal(0.5f, 4.0f));
+    const bge::Vec3f axis =
+        bge::Vec3f(rng.GenRandReal(-1.0f, 1.0f), rng.GenRandReal(-1.0f, 1.0f),
+                   1.0f)
+            .GetNormalized();
+
+    transforms.push_back(
+        bge::GenTranslationMat(position) *
+        bge::GenRotationMat(rng.GenRandReal(0.0f, 6.28f), axis) *
+        bge::GenScalingMat(scale));
+  }
+
+  const bge::Mat4f projection =
+      bge::GenPerspectiveMat(1.05f, 16.0f / 9.0f, 0.1f, 150.0f);
+  const bge::Mat4f view =
+      bge::GenLookAtMat(bge::Vec3f(0.0f), bge::Vec3f(0.3f, 0.1f, -1.0f),
+                        bge::Vec3f(0.0f, 1.0f, 0.0f));
+  const bge::Frustum frustum = bge::ExtractFrustum(projection, view);
+
+  const auto getTransform = [&transforms](uint32 instance) {
+    return transforms[instance];
+  };
+
+  // Moved instances recompute their world boxes every frame, like dynamic
+  // meshes, the culled boxes are then the same for both
+  bge::FrustumCuller culler;
+  const float boundsMilli = MeasureAverageMilli(c_CullFrameCount, [&]() {
+    culler.Invalidate();
+    culler.UpdateBounds(instances, getTransform);
+  });
+
+  std::vector<CullBox> boxes;
+  boxes.reserve(count);
+  for (const bge::Mat4f& transform : transforms)
+  {
+    CullBox box;
+    for (uint32 row = 0; row < 3; ++row)
+    {
+      box.m_Center[row] = transform[row * 4 + 3];
+      box.m_Extents[row] = 0.5f * (std::abs(transform[row * 4 + 0]) +
+                                   std::abs(transform[row * 4 + 1]) +
+                                   std::abs(transform[row * 4 + 2]));
+    }
+    boxes.push_back(box);
+  }
+
+  std::vector<uint32> scalarVisibles;
+  const float scalarMilli = MeasureAverageMilli(c_CullFrameCount, [&]() {
+    CullScalar(boxes, frustum, scalarVisibles);
+  });
+
+  std::vector<uint32> simdVisibles;
+  const float simdMilli = MeasureAverageMilli(c_CullFrameCount, [&]() {
+    culler.Cull(frustum, simdVisibles);
+  });
+
+  std::cout << count << " instances, " << simdVisibles.size()
+            << " visible, bounds update: " << boundsMilli << " ms"
+            << std::endl;
+  PrintComparison("\tcull", "scalar AoS", scalarMilli, "SIMD SoA",
+                  simdMilli);
+
+  if (scalarVisibles != simdVisibles)
+  {
+    std::cout << "ERROR: the SIMD culling kept " << simdVisibles.size()
+              << " instances, the scalar culling " << scalarVisibles.size()
+              << std::endl;
+  }
+}
+
+#if defined BGE_NULL_RENDER_DEVICE
+
+constexpr bge::UniformId c_ModelUniform("in_Model");
+
+/**
+ * The camera uniform block of the shaders
+ */
+struct CameraUniforms
+{
+  bge::Mat4f m_Projection; /**< The camera's projection matrix */
+  bge::Mat4f m_View;       /**< The camera's view matrix */
+};
+
+/**
+ * Uniform locations by name, as the driver resolved them on every call of the
+ * string based SetUniform functions the engine used before uniform ids
+ */
+using UniformNameTable = std::unordered_map<std::string, int32>;
+
+/**
+ * Uploads a matrix like the string based API: the name is made into a string,
+ * looked up and then uploaded
+ * @return the looked up location, so the lookup isn't optimized out
+ */
+static int32 SetUniformMat4ByName(const UniformNameTable& locations,
+                                  bge::ShaderProgramHandle shader,
+                                  const std::string& name,
+                                  const bge::Mat4f& matrix)
+{
+  const int32 location = locations.find(name)->second;
+  bge::RenderDevice::SetUniformMat4(shader, bge::UniformId(name.c_str()),
+                                    matrix);
+  return location;
+}
+
+/**
+ * Prints the per-draw cost and the uniform uploads of the frames measured
+ * since the last reset of the null render device's stats
+ */
+static void PrintDrawCost(const char* name, float frameMilli)
+{
+  const bge::RenderDeviceStats& stats = bge::NullRenderDevice::GetStats();
+
+  std::cout << "\t" << name << ": " << frameMilli << " ms per frame, "
+            << frameMilli * 1000000.0f / c_UniformDrawCount << " ns per draw, "
+            << stats.m_UniformUploads / c_UniformFrameCount
+            << " uniform uploads, "
+            << stats.m_UploadedBytes / c_UniformFrameCount
+            << " uploaded bytes per frame" << std::endl;
+
+  bge::NullRenderDevice::ResetStats();
+}
+
+#endif
+
+void RunUniformUploadBenchmark()
+{
+#if defined BGE_NULL_RENDER_DEVICE
+  bge::RenderDevice::Initialize();
+
+  std::vector<bge::ShaderProgramHandle> shaders;
+  for (uint32 i = 0; i < c_UniformShaderCount; ++i)
+  {
+    shaders.push_back(bge::RenderDevice::CreateShaderProgram("unused"));
+  }
+
+  const UniformNameTable locations = {
+      {"in_Projection", 0}, {"in_View", 1}, {"in_Model", 2}};
+
+  const CameraUniforms camera = {bge::Mat4f(1.0f), bge::Mat4f(1.0f)};
+  std::vector<bge::Mat4f> transforms(c_UniformDrawCount, bge::Mat4f(1.0f));
+
+  const uint32 drawsPerShader = c_UniformDrawCount / c_UniformShaderCount;
+  bge::NullRenderDevice::ResetStats();
+
+  // Every shader bind uploads the camera, every draw its model matrix, all
+  // by name
+  int32 locationSum = 0;
+  const float nameMilli = MeasureAverageMilli(c_UniformFrameCount, [&]() {
+    for (uint32 i = 0; i < c_UniformDrawCount; ++i)
+    {
+      const bge::ShaderProgramHandle shader = shaders[i / drawsPerShader];
+
+      if (i % drawsPerShader == 0)
+      {
+        bge::RenderDevice::BindShaderProgram(shader);
+        locationSum += SetUniformMat4ByName(locations, shader, "in_Projection",
+                                            camera.m_Projection);
+        locationSum += SetUniformMat4ByName(locations, shader, "in_View",
+                                            camera.m_View);
+      }
+
+      locationSum +=
+          SetUniformMat4ByName(locations, shader, "in_Model", transforms[i]);
+      bge::RenderDevice::DrawInstanced(c_UniformDrawIndexCount, 1u);
+    }
+  });
+  PrintDrawCost("by name", nameMilli);
+
+  // The camera is uploaded once into the uniform buffer all shaders read, the
+  // model matrices by their id
+  const bge::UniformBufferHandle cameraBuffer =
+      bge::RenderDevice::CreateUniformBuffer(sizeof(CameraUniforms));
+  const float idMilli = MeasureAverageMilli(c_UniformFrameCount, [&]() {
+    bge::RenderDevice::UpdateUniformBuffer(cameraBuffer, sizeof(camera),
+                                           &camera);
+
+    for (uint32 i = 0; i < c_UniformDrawCount; ++i)
+    {
+      const bge::ShaderProgramHandle shader = shaders[i / drawsPerShader];
+
+      if (i % drawsPerShader == 0)
+      {
+        bge::RenderDevice::BindShaderProgram(shader);
+      }
+
+      bge::RenderDevice::SetUniformMat4(shader, c_ModelUniform, transforms[i]);
+      bge::RenderDevice::DrawInstanced(c_UniformDrawIndexCount, 1u);
+    }
+  });
+  PrintDrawCost("by id + camera buffer", idMilli);
+
+  std::cout << c_UniformDrawCount << " draws, " << c_UniformShaderCount
+            << " shaders (location checksum " << locationSum << ")"
+            << std::endl;
+  PrintComparison("\tper-draw uniforms", "by name", nameMilli, "by id",
+                  idMilli);
+
+  bge::RenderDevice::DestroyUniformBuffer(cameraBuffer);
+  for (bge::ShaderProgramHandle shader : shaders)
+  {
+    bge::RenderDevice::DestroyShaderProgram(shader);
+  }
+  bge::RenderDevice::Shutdown();
+#else
+  std::cout << "Skipped, the render benchmarks need the engine built with "
+               "BGE_NULL_RENDER_DEVICE"
+            << std::endl;
+#endif
+}
+
+void RunFrustumCullingBenchmark()
+{
+  CompareCulling(10000u);
+  CompareCulling(100000u);
+  CompareCulling(1000000u);
+}
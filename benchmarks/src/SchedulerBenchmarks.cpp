@@ -0,0 +1,228 @@
+#include "Benchmarks.h"
+
+#include <scheduler/ParallelFor.h>
+#include <scheduler/Scheduler.h>
+#include <scheduler/WorkStealingQueue.h>
+#include <util/Timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Number of tasks pushed before the owner starts popping
+constexpr uint32 c_QueueBatchSize = 256u;
+// Number of push/pop batches per measurement
+constexpr uint32 c_QueueBatchCount = 4096u;
+
+// Number of empty tasks run per latency batch
+constexpr uint32 c_LatencyBatchSize = 64u;
+// Number of latency batches, workers go idle between them
+constexpr uint32 c_LatencyBatchCount = 100u;
+
+// Number of elements the task pool stress test splits into tasks
+constexpr uint32 c_StressElementCount = 100000u;
+// Number of frames the task pool stress test runs
+constexpr uint32 c_StressFrameCount = 20u;
+
+// Sum and maximum of the Run -> task start latencies of the current batch
+static std::atomic_uint64_t s_TotalLatencyNanos;
+static std::atomic_uint64_t s_MaxLatencyNanos;
+
+/**
+ * The owner thread pushes batches of tasks and pops them back while
+ * thiefCount threads keep stealing from the front.
+ * @return the average nanoseconds spent per task
+ */
+template <typename Queue> float MeasureQueueContention(uint32 thiefCount)
+{
+  auto queue = std::make_unique<Queue>();
+  std::vector<bge::Task> tasks(c_QueueBatchSize);
+
+  std::atomic_bool isDone(false);
+  std::atomic_uint32_t stolenCount(0u);
+
+  std::vector<std::thread> thieves;
+  thieves.reserve(thiefCount);
+
+  for (uint32 i = 0; i < thiefCount; ++i)
+  {
+    thieves.emplace_back([&]() {
+      uint32 stolen = 0u;
+      while (!isDone.load(std::memory_order_relaxed))
+      {
+        if (queue->Steal())
+        {
+          ++stolen;
+        }
+      }
+      stolenCount += stolen;
+    });
+  }
+
+  uint32 poppedCount = 0u;
+
+  bge::Timer timer;
+  for (uint32 batch = 0; batch < c_QueueBatchCount; ++batch)
+  {
+    for (auto&& task : tasks)
+    {
+      queue->Push(&task);
+    }
+
+    while (queue->Pop())
+    {
+      ++poppedCount;
+    }
+  }
+  float elapsedMillis = timer.GetElapsedMilli();
+
+  isDone.store(true);
+  for (auto&& thief : thieves)
+  {
+    thief.join();
+  }
+
+  const uint32 totalTasks = c_QueueBatchSize * c_QueueBatchCount;
+  if (poppedCount + stolenCount != totalTasks)
+  {
+    std::cout << "ERROR: lost or duplicated tasks (" << poppedCount << " popped, "
+              << stolenCount << " stolen, " << totalTasks << " pushed)"
+              << std::endl;
+  }
+
+  return elapsedMillis * 1000000.0f / totalTasks;
+}
+
+void RunWorkStealingQueueBenchmark()
+{
+  const uint32 threadCount =
+      std::max(2u, std::thread::hardware_concurrency());
+
+  for (uint32 threads = 1; threads <= threadCount; ++threads)
+  {
+    // One of the threads is the owner, the rest are thieves
+    float lockingNanos =
+        MeasureQueueContention<bge::LockingWorkStealingQueue>(threads - 1);
+    float lockFreeNanos =
+        MeasureQueueContention<bge::WorkStealingQueue>(threads - 1);
+
+    std::cout << "Threads: " << threads << "\tmutex: " << lockingNanos
+              << " ns/task\tlock-free: " << lockFreeNanos << " ns/task"
+              << std::endl;
+  }
+}
+
+/**
+ * Records the time between Scheduler::Run and the start of the task
+ * @param taskData time point at which the task was run
+ */
+void LatencyTask(bge::Task* task, const void* taskData)
+{
+  const auto start = std::chrono::steady_clock::now();
+  const auto runTime =
+      *static_cast<const std::chrono::steady_clock::time_point*>(taskData);
+
+  const uint64 latency = static_cast<uint64>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start - runTime)
+          .count());
+
+  s_TotalLatencyNanos += latency;
+
+  uint64 maxLatency = s_MaxLatencyNanos.load();
+  while (latency > maxLatency &&
+         !s_MaxLatencyNanos.compare_exchange_weak(maxLatency, latency))
+  {
+  }
+}
+
+void RunTaskLatencyBenchmark()
+{
+  uint64 totalNanos = 0u;
+  uint64 maxNanos = 0u;
+
+  for (uint32 batch = 0; batch < c_LatencyBatchCount; ++batch)
+  {
+    // Give the workers enough time to go through their backoff and park
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    s_TotalLatencyNanos = 0u;
+    s_MaxLatencyNanos = 0u;
+
+    bge::Task* root = bge::Scheduler::CreateTask(bge::Scheduler::EmptyTask);
+
+    for (uint32 i = 0; i < c_LatencyBatchSize; ++i)
+    {
+      const auto runTime = std::chrono::steady_clock::now();
+      bge::Task* task = bge::Scheduler::CreateChildTask(
+          root, LatencyTask, &runTime, sizeof(runTime));
+      bge::Scheduler::Run(task);
+    }
+
+    bge::Scheduler::Wait(bge::Scheduler::Run(root));
+
+    totalNanos += s_TotalLatencyNanos;
+    maxNanos = std::max(maxNanos, s_MaxLatencyNanos.load());
+  }
+
+  const uint32 taskCount = c_LatencyBatchSize * c_LatencyBatchCount;
+
+  std::cout << "Tasks: " << taskCount
+            << "\tavg latency: " << totalNanos / taskCount / 1000.0f
+            << " us\tmax latency: " << maxNanos / 1000.0f << " us"
+            << std::endl;
+}
+
+/**
+ * Increments every element once
+ */
+void IncrementElements(uint32* data, uint32 count)
+{
+  for (uint32 i = 0; i < count; ++i)
+  {
+    ++data[i];
+  }
+}
+
+void RunTaskPoolStressTest()
+{
+  std::vector<uint32> elements(c_StressElementCount, 0u);
+
+  // Leaves of at most 2 elements, so every frame allocates well over
+  // c_StressElementCount tasks
+  const bge::CountSplitter splitter(2u);
+
+  float totalMillis = 0.0f;
+
+  for (uint32 frame = 0; frame < c_StressFrameCount; ++frame)
+  {
+    bge::Timer timer;
+
+    bge::Task* task = bge::ParralelFor(elements.data(), c_StressElementCount,
+                                       IncrementElements, splitter);
+    bge::Scheduler::Wait(bge::Scheduler::Run(task));
+
+    totalMillis += timer.GetElapsedMilli();
+  }
+
+  // Every element must have been incremented exactly once per frame. An
+  // overwritten task would skip or repeat some of them.
+  const uint32 corruptCount = static_cast<uint32>(
+      std::count_if(elements.begin(), elements.end(), [](uint32 element) {
+        return element != c_StressFrameCount;
+      }));
+
+  if (corruptCount > 0)
+  {
+    std::cout << "ERROR: " << corruptCount
+              << " elements were not processed once per frame" << std::endl;
+  }
+
+  std::cout << "Elements: " << c_StressElementCount
+            << "\tframes: " << c_StressFrameCount
+            << "\tavg frame: " << totalMillis / c_StressFrameCount << " ms"
+            << std::endl;
+}
@@ -0,0 +1,61 @@
+#include "Benchmarks.h"
+
+#include <logging/Log.h>
+#include <physics/PhysicsDevice.h>
+#include <scheduler/Scheduler.h>
+
+#include <cstring>
+#include <iostream>
+
+struct Benchmark
+{
+  const char* m_Name;
+  void (*m_Function)();
+};
+
+static const Benchmark s_Benchmarks[] = {
+    {"work-stealing-queue", RunWorkStealingQueueBenchmark},
+    {"task-latency", RunTaskLatencyBenchmark},
+    {"task-pool-stress", RunTaskPoolStressTest},
+    {"parallel-transforms", RunParallelTransformsBenchmark},
+    {"parallel-reduce", RunParallelReduceBenchmark},
+    {"splitters", RunSplitterBenchmark},
+    {"physics-scaling", RunPhysicsScalingBenchmark},
+    {"physics-capacity", RunPhysicsCapacityBenchmark},
+    {"physics-entity-lookup", RunEntityLookupBenchmark},
+    {"physics-matrix-export", RunBodyMatrixExportBenchmark},
+    {"component-storage", RunComponentStorageBenchmark},
+    {"entity-destruction", RunEntityDestructionBenchmark},
+    {"archetype-iteration", RunArchetypeIterationBenchmark},
+    {"entity-churn", RunEntityChurnBenchmark},
+    {"command-buffer", RunCommandBufferBenchmark},
+    {"game-world-schedule", RunGameWorldScheduleBenchmark},
+    {"event-dispatch", RunEventDispatchBenchmark},
+    {"frame-allocator", RunFrameAllocatorBenchmark},
+    {"render-uniforms", RunUniformUploadBenchmark},
+    {"frustum-culling", RunFrustumCullingBenchmark},
+};
+
+int main(int argc, char** argv)
+{
+  bge::Log::Init();
+  bge::Scheduler::Initialize();
+  bge::PhysicsDevice::Initialize();
+
+  // Optionally only run the benchmarks whose name contains the first argument
+  const char* filter = argc > 1 ? argv[1] : nullptr;
+
+  for (auto&& benchmark : s_Benchmarks)
+  {
+    if (filter && std::strstr(benchmark.m_Name, filter) == nullptr)
+    {
+      continue;
+    }
+
+    std::cout << "== " << benchmark.m_Name << " ==" << std::endl;
+    benchmark.m_Function();
+    std::cout << std::endl;
+  }
+
+  bge::Scheduler::Shutdown();
+}
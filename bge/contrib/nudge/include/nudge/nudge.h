@@ -27,10 +27,28 @@
 
 namespace nudge
 {
+// Returns memory for an allocation which doesn't fit in an arena. It is only
+// called from the thread which calls into nudge.
+typedef void* (*ArenaFallbackFunction)(void* context, uintptr_t size,
+                                       uintptr_t alignment);
+
 struct Arena
 {
   void* data;
   uintptr_t size;
+
+  // Optional, receives the smallest size left in any arena derived from this
+  // one. Negative if an allocation ran past the end of the arena.
+  intptr_t* low_water_size;
+
+  // Optional, allocations which don't fit are taken from the fallback instead
+  // of running past the end of the arena. Its memory must stay valid while
+  // any arena derived from this one is in use.
+  ArenaFallbackFunction fallback;
+  void* fallback_context;
+
+  // Set while a reservation taken from the fallback isn't committed yet.
+  void* fallback_reservation;
 };
 
 struct Transform
@@ -87,8 +105,14 @@ struct ContactData
   uint32_t capacity;
   uint32_t count;
 
+  // Holds capacity entries, like the contact arrays.
   uint32_t* sleeping_pairs;
   uint32_t sleeping_count;
+
+  // Set by collide when the contacts of the step may not fit in capacity.
+  // Nothing is written then, collide has to run again with at least this
+  // capacity.
+  uint32_t required_capacity;
 };
 
 struct ColliderData
@@ -149,10 +173,33 @@ struct ActiveBodies
 struct ContactImpulseData;
 struct ContactConstraintData;
 
+// Work over the subrange [begin, end) of a parallel loop.
+typedef void (*ParallelForFunction)(void* data, unsigned begin, unsigned end);
+
+// Lets the simulation run loops on the threads of the host application. run
+// must call function for subranges which cover [0, count) exactly once, may do
+// so concurrently from any thread and must return once all of them finished.
+// Subranges should hold at least grain_size elements. The results never depend
+// on how the loop is split, so they stay the same for any thread count.
+// A zero initialized ParallelFor runs everything on the calling thread.
+struct ParallelFor
+{
+  void (*run)(void* context, unsigned count, unsigned grain_size,
+              ParallelForFunction function, void* data);
+  void* context;
+};
+
 void collide(ActiveBodies* active_bodies, ContactData* contacts,
              BodyData bodies, ColliderData colliders,
              BodyConnections body_connections, Arena temporary);
 
+// Same as above, with the bounds, broadphase and sphere narrowphase loops
+// running on parallel_for. The contacts are identical to the serial version.
+void collide(ActiveBodies* active_bodies, ContactData* contacts,
+             BodyData bodies, ColliderData colliders,
+             BodyConnections body_connections, Arena temporary,
+             ParallelFor parallel_for);
+
 ContactImpulseData* read_cached_impulses(ContactCache contact_cache,
                                          ContactData contacts, Arena* memory);
 
@@ -166,10 +213,25 @@ setup_contact_constraints(ActiveBodies active_bodies, ContactData contacts,
 
 void apply_impulses(ContactConstraintData* data, BodyData bodies);
 
+// Groups the constraint batches into colors, where the batches of a color share
+// no dynamic body and can be solved concurrently. Reorders the batches, so it
+// must be called after setup_contact_constraints and before apply_impulses.
+void color_contact_constraints(ContactConstraintData* data, BodyData bodies,
+                               Arena* memory);
+
+// Solves the colors one after another and the batches within a color on
+// parallel_for. The results are the same for any thread count, but differ from
+// the serial version since the batches are solved in color order.
+void apply_impulses(ContactConstraintData* data, BodyData bodies,
+                    ParallelFor parallel_for);
+
 void update_cached_impulses(ContactConstraintData* data,
                             ContactImpulseData* contact_impulses);
 
 void advance(ActiveBodies active_bodies, BodyData bodies, float time_step);
+
+void advance(ActiveBodies active_bodies, BodyData bodies, float time_step,
+             ParallelFor parallel_for);
 } // namespace nudge
 
 #endif
\ No newline at end of file
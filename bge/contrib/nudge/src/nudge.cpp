@@ -50,6 +50,7 @@ namespace nudge
 {
 
 static const float allowed_penetration = 1e-3f;
+static const unsigned max_box_box_contacts = 16;
 static const float bias_factor = 2.0f;
 
 #if NUDGE_SIMDV_WIDTH == 128
@@ -1078,6 +1079,12 @@ static inline unsigned first_set_bit(unsigned x)
 static inline unsigned first_set_bit(unsigned x) { return __builtin_ctz(x); }
 #endif
 
+static inline void track_low_water_size(Arena* arena)
+{
+  if (arena->low_water_size && (intptr_t)arena->size < *arena->low_water_size)
+    *arena->low_water_size = (intptr_t)arena->size;
+}
+
 static inline void* align(Arena* arena, uintptr_t alignment)
 {
   uintptr_t data = (uintptr_t)arena->data;
@@ -1089,6 +1096,7 @@ static inline void* align(Arena* arena, uintptr_t alignment)
   arena->data = (void*)data;
   arena->size = end - data;
 
+  track_low_water_size(arena);
   assert((intptr_t)arena->size >= 0); // Out of memory.
 
   return arena->data;
@@ -1100,19 +1108,34 @@ static inline void* allocate(Arena* arena, uintptr_t size)
   arena->data = (void*)((uintptr_t)data + size);
   arena->size -= size;
 
+  track_low_water_size(arena);
   assert((intptr_t)arena->size >= 0); // Out of memory.
 
   return data;
 }
 
+static inline bool fits(const Arena* arena, uintptr_t size,
+                        uintptr_t alignment)
+{
+  uintptr_t data = (uintptr_t)arena->data;
+  uintptr_t mask = alignment - 1;
+  uintptr_t padding = ((data + mask) & ~mask) - data;
+
+  return padding <= arena->size && size <= arena->size - padding;
+}
+
 static inline void* allocate(Arena* arena, uintptr_t size, uintptr_t alignment)
 {
+  if (arena->fallback && !fits(arena, size, alignment))
+    return arena->fallback(arena->fallback_context, size, alignment);
+
   align(arena, alignment);
 
   void* data = arena->data;
   arena->data = (void*)((uintptr_t)data + size);
   arena->size -= size;
 
+  track_low_water_size(arena);
   assert((intptr_t)arena->size >= 0); // Out of memory.
 
   return data;
@@ -1133,6 +1156,13 @@ static inline T* allocate_array(Arena* arena, uintptr_t count,
 
 static inline void* reserve(Arena* arena, uintptr_t size, uintptr_t alignment)
 {
+  if (arena->fallback && !fits(arena, size, alignment))
+  {
+    arena->fallback_reservation =
+        arena->fallback(arena->fallback_context, size, alignment);
+    return arena->fallback_reservation;
+  }
+
   align(arena, alignment);
   assert(size <= arena->size); // Cannot reserve this amount.
   return arena->data;
@@ -1140,6 +1170,13 @@ static inline void* reserve(Arena* arena, uintptr_t size, uintptr_t alignment)
 
 static inline void commit(Arena* arena, uintptr_t size)
 {
+  // The reservation isn't in the arena, so the arena stays as it is.
+  if (arena->fallback_reservation)
+  {
+    arena->fallback_reservation = 0;
+    return;
+  }
+
   allocate(arena, size);
 }
 
@@ -1156,6 +1193,48 @@ static inline void commit_array(Arena* arena, uintptr_t count)
   commit(arena, sizeof(T) * count);
 }
 
+// Calls function(begin, end) for subranges of [0, count), on the threads of
+// parallel_for if it has any and the loop is larger than a single grain.
+template <class F>
+static inline void run_parallel(ParallelFor parallel_for, unsigned count,
+                                unsigned grain_size, const F& function)
+{
+  if (!count)
+    return;
+
+  if (!parallel_for.run || count <= grain_size)
+  {
+    function(0, count);
+    return;
+  }
+
+  ParallelForFunction run_range = [](void* data, unsigned begin,
+                                     unsigned end) {
+    (*static_cast<const F*>(data))(begin, end);
+  };
+
+  parallel_for.run(parallel_for.context, count, grain_size, run_range,
+                   const_cast<F*>(&function));
+}
+
+// Moves the outputs of a loop which wrote up to stride elements per iteration
+// to the front of the array, keeping the iteration order.
+// Returns the total number of elements.
+template <class T>
+static inline unsigned compact_slots(T* data, const uint32_t* slot_counts,
+                                     unsigned slot_count, unsigned stride)
+{
+  unsigned count = 0;
+
+  for (unsigned i = 0; i < slot_count; ++i)
+  {
+    memmove(data + count, data + i * stride, sizeof(T) * slot_counts[i]);
+    count += slot_counts[i];
+  }
+
+  return count;
+}
+
 static inline Rotation make_rotation(const float q[4])
 {
   Rotation r = {{q[0], q[1], q[2]}, q[3]};
@@ -3377,7 +3456,11 @@ load8(const float* data, const T* indices, simdv_float& d0, simdv_float& d1,
   simd128::transpose32(d4, d5, d6, d7);
 }
 
-template <unsigned data_stride, unsigned index_stride, class T>
+// Stores 8 floats for each of the indexed elements. With skip_static, the
+// lanes of body 0 are left out, so tasks sharing the static world body never
+// write to it at the same time.
+template <unsigned data_stride, unsigned index_stride, bool skip_static = false,
+          class T>
 NUDGE_FORCEINLINE static void
 store8(float* data, const T* indices, simdv_float d0, simdv_float d1,
        simdv_float d2, simdv_float d3, simdv_float d4, simdv_float d5,
@@ -3404,20 +3487,28 @@ store8(float* data, const T* indices, simdv_float d0, simdv_float d1,
   unsigned i2 = indices[2 * index_stride];
   unsigned i3 = indices[3 * index_stride];
 
-  simd_float::store8(data + i0 * stride_in_floats, t0);
-  simd_float::store8(data + i1 * stride_in_floats, t1);
-  simd_float::store8(data + i2 * stride_in_floats, t2);
-  simd_float::store8(data + i3 * stride_in_floats, t3);
+  if (!skip_static || i0)
+    simd_float::store8(data + i0 * stride_in_floats, t0);
+  if (!skip_static || i1)
+    simd_float::store8(data + i1 * stride_in_floats, t1);
+  if (!skip_static || i2)
+    simd_float::store8(data + i2 * stride_in_floats, t2);
+  if (!skip_static || i3)
+    simd_float::store8(data + i3 * stride_in_floats, t3);
 
   unsigned i4 = indices[4 * index_stride];
   unsigned i5 = indices[5 * index_stride];
   unsigned i6 = indices[6 * index_stride];
   unsigned i7 = indices[7 * index_stride];
 
-  simd_float::store8(data + i4 * stride_in_floats, t4);
-  simd_float::store8(data + i5 * stride_in_floats, t5);
-  simd_float::store8(data + i6 * stride_in_floats, t6);
-  simd_float::store8(data + i7 * stride_in_floats, t7);
+  if (!skip_static || i4)
+    simd_float::store8(data + i4 * stride_in_floats, t4);
+  if (!skip_static || i5)
+    simd_float::store8(data + i5 * stride_in_floats, t5);
+  if (!skip_static || i6)
+    simd_float::store8(data + i6 * stride_in_floats, t6);
+  if (!skip_static || i7)
+    simd_float::store8(data + i7 * stride_in_floats, t7);
 #else
   simd128::transpose32(d0, d1, d2, d3);
   simd128::transpose32(d4, d5, d6, d7);
@@ -3427,24 +3518,107 @@ store8(float* data, const T* indices, simdv_float d0, simdv_float d1,
   unsigned i2 = indices[2 * index_stride];
   unsigned i3 = indices[3 * index_stride];
 
-  simd_float::store4(data + i0 * stride_in_floats, d0);
-  simd_float::store4(data + i1 * stride_in_floats, d1);
-  simd_float::store4(data + i2 * stride_in_floats, d2);
-  simd_float::store4(data + i3 * stride_in_floats, d3);
+  if (!skip_static || i0)
+  {
+    simd_float::store4(data + i0 * stride_in_floats, d0);
+    simd_float::store4(data + i0 * stride_in_floats + 4, d4);
+  }
 
-  simd_float::store4(data + i0 * stride_in_floats + 4, d4);
-  simd_float::store4(data + i1 * stride_in_floats + 4, d5);
-  simd_float::store4(data + i2 * stride_in_floats + 4, d6);
-  simd_float::store4(data + i3 * stride_in_floats + 4, d7);
+  if (!skip_static || i1)
+  {
+    simd_float::store4(data + i1 * stride_in_floats, d1);
+    simd_float::store4(data + i1 * stride_in_floats + 4, d5);
+  }
+
+  if (!skip_static || i2)
+  {
+    simd_float::store4(data + i2 * stride_in_floats, d2);
+    simd_float::store4(data + i2 * stride_in_floats + 4, d6);
+  }
+
+  if (!skip_static || i3)
+  {
+    simd_float::store4(data + i3 * stride_in_floats, d3);
+    simd_float::store4(data + i3 * stride_in_floats + 4, d7);
+  }
 #endif
 }
 
+// Collides pair_count pairs which produce at most one contact each. Chunks of
+// grain_size pairs are collided in parallel, each into its own scratch range,
+// and appended to the contacts in order afterwards. The tag of a pair is only
+// kept if the pair produced a contact.
+template <class F>
+static void collide_pairs(ContactData* contacts, unsigned pair_count,
+                          unsigned grain_size, ParallelFor parallel_for,
+                          Arena temporary, const F& collide_pair)
+{
+  unsigned chunk_count = (pair_count + grain_size - 1) / grain_size;
+
+  Contact* data = allocate_array<Contact>(&temporary, pair_count, 32);
+  BodyPair* pair_bodies = allocate_array<BodyPair>(&temporary, pair_count, 32);
+  uint64_t* tags = allocate_array<uint64_t>(&temporary, pair_count, 32);
+  uint32_t* chunk_counts =
+      allocate_array<uint32_t>(&temporary, chunk_count, 32);
+
+  auto collide_chunks = [&](unsigned begin, unsigned end) {
+    for (unsigned chunk = begin; chunk < end; ++chunk)
+    {
+      unsigned first = chunk * grain_size;
+      unsigned last = first + grain_size;
+
+      if (last > pair_count)
+        last = pair_count;
+
+      unsigned count = first;
+
+      for (unsigned i = first; i < last; ++i)
+        count += collide_pair(i, data + count, pair_bodies + count,
+                              tags + count);
+
+      chunk_counts[chunk] = count - first;
+    }
+  };
+
+  run_parallel(parallel_for, chunk_count, 1, collide_chunks);
+
+  for (unsigned chunk = 0; chunk < chunk_count; ++chunk)
+  {
+    unsigned first = chunk * grain_size;
+    unsigned count = chunk_counts[chunk];
+
+    memcpy(contacts->data + contacts->count, data + first,
+           sizeof(data[0]) * count);
+    memcpy(contacts->bodies + contacts->count, pair_bodies + first,
+           sizeof(pair_bodies[0]) * count);
+    memcpy(contacts->tags + contacts->count, tags + first,
+           sizeof(tags[0]) * count);
+
+    contacts->count += count;
+  }
+}
+
 void collide(ActiveBodies* active_bodies, ContactData* contacts,
              BodyData bodies, ColliderData colliders,
              BodyConnections body_connections, Arena temporary)
 {
+  collide(active_bodies, contacts, bodies, colliders, body_connections,
+          temporary, ParallelFor());
+}
+
+void collide(ActiveBodies* active_bodies, ContactData* contacts,
+             BodyData bodies, ColliderData colliders,
+             BodyConnections body_connections, Arena temporary,
+             ParallelFor parallel_for)
+{
+  // Minimum number of loop iterations a parallel task handles.
+  static const unsigned bounds_grain_size = 256;
+  static const unsigned broadphase_grain_size = 16;
+  static const unsigned narrowphase_grain_size = 256;
+
   contacts->count = 0;
   contacts->sleeping_count = 0;
+  contacts->required_capacity = 0;
   active_bodies->count = 0;
 
   const Transform* body_transforms = bodies.transforms;
@@ -3466,70 +3640,80 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
 
   if (colliders.boxes.count)
   {
-    for (unsigned i = 0; i < colliders.boxes.count; ++i)
-    {
-      Transform transform = colliders.boxes.transforms[i];
-      transform = body_transforms[transform.body] * transform;
-      transform.body |= (uint32_t)colliders.boxes.tags[i] << 16;
-
-      float3x3 m = matrix(make_rotation(transform.rotation));
-
-      m.c0 *= colliders.boxes.data[i].size[0];
-      m.c1 *= colliders.boxes.data[i].size[1];
-      m.c2 *= colliders.boxes.data[i].size[2];
-
-      float3 size = {
-          fabsf(m.c0.x) + fabsf(m.c1.x) + fabsf(m.c2.x),
-          fabsf(m.c0.y) + fabsf(m.c1.y) + fabsf(m.c2.y),
-          fabsf(m.c0.z) + fabsf(m.c1.z) + fabsf(m.c2.z),
-      };
-
-      float3 min = make_float3(transform.position) - size;
-      float3 max = make_float3(transform.position) + size;
-
-      AABB aabb = {
-          min,
-          0.0f,
-          max,
-          0.0f,
-      };
-
-      transforms[i + box_bounds_offset] = transform;
-      aos_bounds[i + box_bounds_offset] = aabb;
-      collider_tags[i + box_bounds_offset] = colliders.boxes.tags[i];
-      collider_bodies[i + box_bounds_offset] =
-          colliders.boxes.transforms[i].body;
-    }
+    auto compute_box_bounds = [&](unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i)
+      {
+        Transform transform = colliders.boxes.transforms[i];
+        transform = body_transforms[transform.body] * transform;
+        transform.body |= (uint32_t)colliders.boxes.tags[i] << 16;
+
+        float3x3 m = matrix(make_rotation(transform.rotation));
+
+        m.c0 *= colliders.boxes.data[i].size[0];
+        m.c1 *= colliders.boxes.data[i].size[1];
+        m.c2 *= colliders.boxes.data[i].size[2];
+
+        float3 size = {
+            fabsf(m.c0.x) + fabsf(m.c1.x) + fabsf(m.c2.x),
+            fabsf(m.c0.y) + fabsf(m.c1.y) + fabsf(m.c2.y),
+            fabsf(m.c0.z) + fabsf(m.c1.z) + fabsf(m.c2.z),
+        };
+
+        float3 min = make_float3(transform.position) - size;
+        float3 max = make_float3(transform.position) + size;
+
+        AABB aabb = {
+            min,
+            0.0f,
+            max,
+            0.0f,
+        };
+
+        transforms[i + box_bounds_offset] = transform;
+        aos_bounds[i + box_bounds_offset] = aabb;
+        collider_tags[i + box_bounds_offset] = colliders.boxes.tags[i];
+        collider_bodies[i + box_bounds_offset] =
+            colliders.boxes.transforms[i].body;
+      }
+    };
+
+    run_parallel(parallel_for, colliders.boxes.count, bounds_grain_size,
+                 compute_box_bounds);
 
     colliders.boxes.transforms = transforms + box_bounds_offset;
   }
 
   if (colliders.spheres.count)
   {
-    for (unsigned i = 0; i < colliders.spheres.count; ++i)
-    {
-      Transform transform = colliders.spheres.transforms[i];
-      transform = body_transforms[transform.body] * transform;
-      transform.body |= (uint32_t)colliders.spheres.tags[i] << 16;
-
-      float radius = colliders.spheres.data[i].radius;
-
-      float3 min = make_float3(transform.position) - make_float3(radius);
-      float3 max = make_float3(transform.position) + make_float3(radius);
-
-      AABB aabb = {
-          min,
-          0.0f,
-          max,
-          0.0f,
-      };
-
-      transforms[i + sphere_bounds_offset] = transform;
-      aos_bounds[i + sphere_bounds_offset] = aabb;
-      collider_tags[i + sphere_bounds_offset] = colliders.spheres.tags[i];
-      collider_bodies[i + sphere_bounds_offset] =
-          colliders.spheres.transforms[i].body;
-    }
+    auto compute_sphere_bounds = [&](unsigned begin, unsigned end) {
+      for (unsigned i = begin; i < end; ++i)
+      {
+        Transform transform = colliders.spheres.transforms[i];
+        transform = body_transforms[transform.body] * transform;
+        transform.body |= (uint32_t)colliders.spheres.tags[i] << 16;
+
+        float radius = colliders.spheres.data[i].radius;
+
+        float3 min = make_float3(transform.position) - make_float3(radius);
+        float3 max = make_float3(transform.position) + make_float3(radius);
+
+        AABB aabb = {
+            min,
+            0.0f,
+            max,
+            0.0f,
+        };
+
+        transforms[i + sphere_bounds_offset] = transform;
+        aos_bounds[i + sphere_bounds_offset] = aabb;
+        collider_tags[i + sphere_bounds_offset] = colliders.spheres.tags[i];
+        collider_bodies[i + sphere_bounds_offset] =
+            colliders.spheres.transforms[i].body;
+      }
+    };
+
+    run_parallel(parallel_for, colliders.spheres.count, bounds_grain_size,
+                 compute_sphere_bounds);
 
     colliders.spheres.transforms = transforms + sphere_bounds_offset;
   }
@@ -3786,67 +3970,80 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
 
   // Test all coarse groups against each other and generate pairs with potential
   // overlap.
-  uint32_t* coarse_groups =
-      reserve_array<uint32_t>(&temporary, coarse_count * coarse_count, 32);
-  unsigned coarse_group_count = 0;
+  // Every coarse AABB writes its groups to a slot of its own, so they can be
+  // tested in parallel. The slots are compacted in order afterwards.
+  uint32_t* coarse_slot_counts =
+      allocate_array<uint32_t>(&temporary, coarse_count, 32);
+  uint32_t* coarse_groups = reserve_array<uint32_t>(
+      &temporary, coarse_count * coarse_bounds_count, 32);
+
+  auto test_coarse_bounds = [&](unsigned begin, unsigned end) {
+    for (unsigned i = begin; i < end; ++i)
+    {
+      unsigned bounds_group = i >> simdv_width32_log2;
+      unsigned bounds_lane = i & (simdv_width32 - 1);
 
-  for (unsigned i = 0; i < coarse_count; ++i)
-  {
-    unsigned bounds_group = i >> simdv_width32_log2;
-    unsigned bounds_lane = i & (simdv_width32 - 1);
+      simdv_float min_a_x = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].min_x + bounds_lane);
+      simdv_float max_a_x = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].max_x + bounds_lane);
+      simdv_float min_a_y = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].min_y + bounds_lane);
+      simdv_float max_a_y = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].max_y + bounds_lane);
+      simdv_float min_a_z = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].min_z + bounds_lane);
+      simdv_float max_a_z = simd_float::broadcast_loadv(
+          coarse_bounds[bounds_group].max_z + bounds_lane);
+
+      uint32_t* slot = coarse_groups + i * coarse_bounds_count;
+      unsigned slot_count = 0;
 
-    simdv_float min_a_x = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].min_x + bounds_lane);
-    simdv_float max_a_x = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].max_x + bounds_lane);
-    simdv_float min_a_y = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].min_y + bounds_lane);
-    simdv_float max_a_y = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].max_y + bounds_lane);
-    simdv_float min_a_z = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].min_z + bounds_lane);
-    simdv_float max_a_z = simd_float::broadcast_loadv(
-        coarse_bounds[bounds_group].max_z + bounds_lane);
-
-    unsigned first = coarse_group_count;
-
-    // Maximum number of colliders is 2^13, i.e., 13 bit indices.
-    // i needs 10 bits.
-    // j needs 7 or 8 bits.
-    // mask needs 4 or 8 bits.
-    unsigned ij_bits = (bounds_group << 8) | (i << 16);
-
-    for (unsigned j = bounds_group; j < coarse_bounds_count; ++j)
-    {
-      simdv_float min_b_x = simd_float::loadv(coarse_bounds[j].min_x);
-      simdv_float max_b_x = simd_float::loadv(coarse_bounds[j].max_x);
-      simdv_float min_b_y = simd_float::loadv(coarse_bounds[j].min_y);
-      simdv_float max_b_y = simd_float::loadv(coarse_bounds[j].max_y);
-      simdv_float min_b_z = simd_float::loadv(coarse_bounds[j].min_z);
-      simdv_float max_b_z = simd_float::loadv(coarse_bounds[j].max_z);
-
-      simdv_float inside_x =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_x, min_a_x),
-                            simd_float::cmp_gt(max_a_x, min_b_x));
-      simdv_float inside_y =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_y, min_a_y),
-                            simd_float::cmp_gt(max_a_y, min_b_y));
-      simdv_float inside_z =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_z, min_a_z),
-                            simd_float::cmp_gt(max_a_z, min_b_z));
-
-      unsigned mask = simd::signmask32(
-          simd::bitwise_and(simd::bitwise_and(inside_x, inside_y), inside_z));
-
-      coarse_groups[coarse_group_count] = mask | ij_bits;
-      coarse_group_count += mask != 0;
-
-      ij_bits += 1 << 8;
+      // Maximum number of colliders is 2^13, i.e., 13 bit indices.
+      // i needs 10 bits.
+      // j needs 7 or 8 bits.
+      // mask needs 4 or 8 bits.
+      unsigned ij_bits = (bounds_group << 8) | (i << 16);
+
+      for (unsigned j = bounds_group; j < coarse_bounds_count; ++j)
+      {
+        simdv_float min_b_x = simd_float::loadv(coarse_bounds[j].min_x);
+        simdv_float max_b_x = simd_float::loadv(coarse_bounds[j].max_x);
+        simdv_float min_b_y = simd_float::loadv(coarse_bounds[j].min_y);
+        simdv_float max_b_y = simd_float::loadv(coarse_bounds[j].max_y);
+        simdv_float min_b_z = simd_float::loadv(coarse_bounds[j].min_z);
+        simdv_float max_b_z = simd_float::loadv(coarse_bounds[j].max_z);
+
+        simdv_float inside_x =
+            simd::bitwise_and(simd_float::cmp_gt(max_b_x, min_a_x),
+                              simd_float::cmp_gt(max_a_x, min_b_x));
+        simdv_float inside_y =
+            simd::bitwise_and(simd_float::cmp_gt(max_b_y, min_a_y),
+                              simd_float::cmp_gt(max_a_y, min_b_y));
+        simdv_float inside_z =
+            simd::bitwise_and(simd_float::cmp_gt(max_b_z, min_a_z),
+                              simd_float::cmp_gt(max_a_z, min_b_z));
+
+        unsigned mask = simd::signmask32(
+            simd::bitwise_and(simd::bitwise_and(inside_x, inside_y), inside_z));
+
+        slot[slot_count] = mask | ij_bits;
+        slot_count += mask != 0;
+
+        ij_bits += 1 << 8;
+      }
+
+      // Mask out collisions already handled.
+      slot[0] &= ~((1 << bounds_lane) - 1);
+      coarse_slot_counts[i] = slot_count;
     }
+  };
 
-    // Mask out collisions already handled.
-    coarse_groups[first] &= ~((1 << bounds_lane) - 1);
-  }
+  run_parallel(parallel_for, coarse_count, broadphase_grain_size,
+               test_coarse_bounds);
+
+  unsigned coarse_group_count = compact_slots(
+      coarse_groups, coarse_slot_counts, coarse_count, coarse_bounds_count);
 
   commit_array<uint32_t>(&temporary, coarse_group_count);
 
@@ -3874,132 +4071,57 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
   commit_array<uint32_t>(&temporary, coarse_pair_count);
 
   // Test AABBs within the coarse pairs.
-  uint32_t* groups =
-      reserve_array<uint32_t>(&temporary, coarse_pair_count * 16, 32);
-  unsigned group_count = 0;
+  // Every coarse pair writes up to 16 groups to a slot of its own.
+  static const unsigned groups_per_coarse_pair = 16;
 
-#if NUDGE_SIMDV_WIDTH == 256
-  for (unsigned n = 0; n < coarse_pair_count; ++n)
-  {
-    unsigned pair = coarse_pairs[n];
-
-    unsigned a = pair >> 16;
-    unsigned b = pair & 0xffff;
-
-    unsigned lane_count = 8;
-
-    if (a == b)
-      --lane_count;
-
-    if (lane_count + (a << 3) > count)
-      lane_count = count - (a << 3);
-
-    // Maximum number of colliders is 2^13, i.e., 13 bit indices.
-    // i needs 13 bits.
-    // j needs 10 or 11 bits.
-    // mask needs 4 or 8 bits.
-    unsigned ij_bits = (b << 8) | (a << 22);
+  uint32_t* slot_counts =
+      allocate_array<uint32_t>(&temporary, coarse_pair_count, 32);
+  uint32_t* groups = reserve_array<uint32_t>(
+      &temporary, coarse_pair_count * groups_per_coarse_pair, 32);
 
-    unsigned lower_lane_mask = a == b ? 0xfe00 : 0xffff;
-
-    simdv_float min_b_x = simd_float::loadv(bounds[b].min_x);
-    simdv_float max_b_x = simd_float::loadv(bounds[b].max_x);
-    simdv_float min_b_y = simd_float::loadv(bounds[b].min_y);
-    simdv_float max_b_y = simd_float::loadv(bounds[b].max_y);
-    simdv_float min_b_z = simd_float::loadv(bounds[b].min_z);
-    simdv_float max_b_z = simd_float::loadv(bounds[b].max_z);
-
-    for (unsigned i = 0; i < lane_count; ++i, ij_bits += (1 << 19))
+  auto test_coarse_pairs = [&](unsigned begin, unsigned end) {
+#if NUDGE_SIMDV_WIDTH == 256
+    for (unsigned n = begin; n < end; ++n)
     {
-      simdv_float min_a_x = simd_float::broadcast_loadv(bounds[a].min_x + i);
-      simdv_float max_a_x = simd_float::broadcast_loadv(bounds[a].max_x + i);
-      simdv_float min_a_y = simd_float::broadcast_loadv(bounds[a].min_y + i);
-      simdv_float max_a_y = simd_float::broadcast_loadv(bounds[a].max_y + i);
-      simdv_float min_a_z = simd_float::broadcast_loadv(bounds[a].min_z + i);
-      simdv_float max_a_z = simd_float::broadcast_loadv(bounds[a].max_z + i);
-
-      simdv_float inside_x =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_x, min_a_x),
-                            simd_float::cmp_gt(max_a_x, min_b_x));
-      simdv_float inside_y =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_y, min_a_y),
-                            simd_float::cmp_gt(max_a_y, min_b_y));
-      simdv_float inside_z =
-          simd::bitwise_and(simd_float::cmp_gt(max_b_z, min_a_z),
-                            simd_float::cmp_gt(max_a_z, min_b_z));
-
-      unsigned mask = simd::signmask32(
-          simd::bitwise_and(simd::bitwise_and(inside_x, inside_y), inside_z));
+      uint32_t* slot = groups + n * groups_per_coarse_pair;
+      unsigned slot_count = 0;
 
-      // Mask out collisions already handled.
-      mask &= lower_lane_mask >> 8;
-      lower_lane_mask <<= 1;
+      unsigned pair = coarse_pairs[n];
 
-      groups[group_count] = mask | ij_bits;
-      group_count += mask != 0;
-    }
-  }
-#else
-  // TODO: This version is currently much worse than the 256-bit version. We
-  // should fix it.
-  for (unsigned n = 0; n < coarse_pair_count; ++n)
-  {
-    unsigned pair = coarse_pairs[n];
+      unsigned a = pair >> 16;
+      unsigned b = pair & 0xffff;
 
-    unsigned a = pair >> 16;
-    unsigned b = pair & 0xffff;
-
-    unsigned a_start = a << 3;
-    unsigned a_end = a_start + (1 << 3);
-
-    if (a_end > count)
-      a_end = count;
-
-    unsigned b_start = b << (3 - simdv_width32_log2);
-    unsigned b_end = b_start + (1 << (3 - simdv_width32_log2));
+      unsigned lane_count = 8;
 
-    if (b_end > bounds_count)
-      b_end = bounds_count;
-
-    for (unsigned i = a_start; i < a_end; ++i)
-    {
-      unsigned bounds_group = i >> simdv_width32_log2;
-      unsigned bounds_lane = i & (simdv_width32 - 1);
-
-      simdv_float min_a_x =
-          simd_float::broadcast_loadv(bounds[bounds_group].min_x + bounds_lane);
-      simdv_float max_a_x =
-          simd_float::broadcast_loadv(bounds[bounds_group].max_x + bounds_lane);
-      simdv_float min_a_y =
-          simd_float::broadcast_loadv(bounds[bounds_group].min_y + bounds_lane);
-      simdv_float max_a_y =
-          simd_float::broadcast_loadv(bounds[bounds_group].max_y + bounds_lane);
-      simdv_float min_a_z =
-          simd_float::broadcast_loadv(bounds[bounds_group].min_z + bounds_lane);
-      simdv_float max_a_z =
-          simd_float::broadcast_loadv(bounds[bounds_group].max_z + bounds_lane);
-
-      unsigned first = group_count;
-
-      unsigned start = (i + 1) >> simdv_width32_log2;
+      if (a == b)
+        --lane_count;
 
-      if (start < b_start)
-        start = b_start;
+      if (lane_count + (a << 3) > count)
+        lane_count = count - (a << 3);
 
       // Maximum number of colliders is 2^13, i.e., 13 bit indices.
       // i needs 13 bits.
       // j needs 10 or 11 bits.
       // mask needs 4 or 8 bits.
-      unsigned ij_bits = (start << 8) | (i << 19);
+      unsigned ij_bits = (b << 8) | (a << 22);
 
-      for (unsigned j = start; j < b_end; ++j)
+      unsigned lower_lane_mask = a == b ? 0xfe00 : 0xffff;
+
+      simdv_float min_b_x = simd_float::loadv(bounds[b].min_x);
+      simdv_float max_b_x = simd_float::loadv(bounds[b].max_x);
+      simdv_float min_b_y = simd_float::loadv(bounds[b].min_y);
+      simdv_float max_b_y = simd_float::loadv(bounds[b].max_y);
+      simdv_float min_b_z = simd_float::loadv(bounds[b].min_z);
+      simdv_float max_b_z = simd_float::loadv(bounds[b].max_z);
+
+      for (unsigned i = 0; i < lane_count; ++i, ij_bits += (1 << 19))
       {
-        simdv_float min_b_x = simd_float::loadv(bounds[j].min_x);
-        simdv_float max_b_x = simd_float::loadv(bounds[j].max_x);
-        simdv_float min_b_y = simd_float::loadv(bounds[j].min_y);
-        simdv_float max_b_y = simd_float::loadv(bounds[j].max_y);
-        simdv_float min_b_z = simd_float::loadv(bounds[j].min_z);
-        simdv_float max_b_z = simd_float::loadv(bounds[j].max_z);
+        simdv_float min_a_x = simd_float::broadcast_loadv(bounds[a].min_x + i);
+        simdv_float max_a_x = simd_float::broadcast_loadv(bounds[a].max_x + i);
+        simdv_float min_a_y = simd_float::broadcast_loadv(bounds[a].min_y + i);
+        simdv_float max_a_y = simd_float::broadcast_loadv(bounds[a].max_y + i);
+        simdv_float min_a_z = simd_float::broadcast_loadv(bounds[a].min_z + i);
+        simdv_float max_a_z = simd_float::broadcast_loadv(bounds[a].max_z + i);
 
         simdv_float inside_x =
             simd::bitwise_and(simd_float::cmp_gt(max_b_x, min_a_x),
@@ -4014,19 +4136,116 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
         unsigned mask = simd::signmask32(
             simd::bitwise_and(simd::bitwise_and(inside_x, inside_y), inside_z));
 
-        groups[group_count] = mask | ij_bits;
-        group_count += mask != 0;
+        // Mask out collisions already handled.
+        mask &= lower_lane_mask >> 8;
+        lower_lane_mask <<= 1;
 
-        ij_bits += 1 << 8;
+        slot[slot_count] = mask | ij_bits;
+        slot_count += mask != 0;
       }
 
-      // Mask out collisions already handled.
-      if (first < group_count &&
-          (groups[first] & 0x7ff00) == (bounds_group << 8))
-        groups[first] &= ~((2 << bounds_lane) - 1);
+      slot_counts[n] = slot_count;
+    }
+#else
+    // TODO: This version is currently much worse than the 256-bit version. We
+    // should fix it.
+    for (unsigned n = begin; n < end; ++n)
+    {
+      uint32_t* slot = groups + n * groups_per_coarse_pair;
+      unsigned slot_count = 0;
+
+      unsigned pair = coarse_pairs[n];
+
+      unsigned a = pair >> 16;
+      unsigned b = pair & 0xffff;
+
+      unsigned a_start = a << 3;
+      unsigned a_end = a_start + (1 << 3);
+
+      if (a_end > count)
+        a_end = count;
+
+      unsigned b_start = b << (3 - simdv_width32_log2);
+      unsigned b_end = b_start + (1 << (3 - simdv_width32_log2));
+
+      if (b_end > bounds_count)
+        b_end = bounds_count;
+
+      for (unsigned i = a_start; i < a_end; ++i)
+      {
+        unsigned bounds_group = i >> simdv_width32_log2;
+        unsigned bounds_lane = i & (simdv_width32 - 1);
+
+        simdv_float min_a_x = simd_float::broadcast_loadv(
+            bounds[bounds_group].min_x + bounds_lane);
+        simdv_float max_a_x = simd_float::broadcast_loadv(
+            bounds[bounds_group].max_x + bounds_lane);
+        simdv_float min_a_y = simd_float::broadcast_loadv(
+            bounds[bounds_group].min_y + bounds_lane);
+        simdv_float max_a_y = simd_float::broadcast_loadv(
+            bounds[bounds_group].max_y + bounds_lane);
+        simdv_float min_a_z = simd_float::broadcast_loadv(
+            bounds[bounds_group].min_z + bounds_lane);
+        simdv_float max_a_z = simd_float::broadcast_loadv(
+            bounds[bounds_group].max_z + bounds_lane);
+
+        unsigned first = slot_count;
+
+        unsigned start = (i + 1) >> simdv_width32_log2;
+
+        if (start < b_start)
+          start = b_start;
+
+        // Maximum number of colliders is 2^13, i.e., 13 bit indices.
+        // i needs 13 bits.
+        // j needs 10 or 11 bits.
+        // mask needs 4 or 8 bits.
+        unsigned ij_bits = (start << 8) | (i << 19);
+
+        for (unsigned j = start; j < b_end; ++j)
+        {
+          simdv_float min_b_x = simd_float::loadv(bounds[j].min_x);
+          simdv_float max_b_x = simd_float::loadv(bounds[j].max_x);
+          simdv_float min_b_y = simd_float::loadv(bounds[j].min_y);
+          simdv_float max_b_y = simd_float::loadv(bounds[j].max_y);
+          simdv_float min_b_z = simd_float::loadv(bounds[j].min_z);
+          simdv_float max_b_z = simd_float::loadv(bounds[j].max_z);
+
+          simdv_float inside_x =
+              simd::bitwise_and(simd_float::cmp_gt(max_b_x, min_a_x),
+                                simd_float::cmp_gt(max_a_x, min_b_x));
+          simdv_float inside_y =
+              simd::bitwise_and(simd_float::cmp_gt(max_b_y, min_a_y),
+                                simd_float::cmp_gt(max_a_y, min_b_y));
+          simdv_float inside_z =
+              simd::bitwise_and(simd_float::cmp_gt(max_b_z, min_a_z),
+                                simd_float::cmp_gt(max_a_z, min_b_z));
+
+          unsigned mask = simd::signmask32(simd::bitwise_and(
+              simd::bitwise_and(inside_x, inside_y), inside_z));
+
+          slot[slot_count] = mask | ij_bits;
+          slot_count += mask != 0;
+
+          ij_bits += 1 << 8;
+        }
+
+        // Mask out collisions already handled.
+        if (first < slot_count &&
+            (slot[first] & 0x7ff00) == (bounds_group << 8))
+          slot[first] &= ~((2 << bounds_lane) - 1);
+      }
+
+      slot_counts[n] = slot_count;
     }
-  }
 #endif
+  };
+
+  run_parallel(parallel_for, coarse_pair_count, broadphase_grain_size,
+               test_coarse_pairs);
+
+  unsigned group_count = compact_slots(groups, slot_counts, coarse_pair_count,
+                                       groups_per_coarse_pair);
 
   commit_array<uint32_t>(&temporary, group_count);
 
@@ -4053,11 +4272,29 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
 
   commit_array<uint32_t>(&temporary, pair_count);
 
+  // Every pair of boxes produces up to 16 contacts, any other pair 1. Every
+  // pair may also become a sleeping pair. Check that they fit before
+  // anything is written.
+  uint32_t max_contact_count = 0;
+
   for (unsigned i = 0; i < pair_count; ++i)
   {
     unsigned pair = pairs[i];
     pairs[i] = sorted_indices[pair & 0xffff] |
                ((uint32_t)sorted_indices[pair >> 16] << 16);
+
+    unsigned a = pairs[i] & 0xffff;
+    unsigned b = pairs[i] >> 16;
+
+    max_contact_count += a < colliders.boxes.count && b < colliders.boxes.count
+                             ? max_box_box_contacts
+                             : 1;
+  }
+
+  if (max_contact_count > contacts->capacity)
+  {
+    contacts->required_capacity = max_contact_count;
+    return;
   }
 
   radix_sort_uint32(pairs, pair_count, temporary);
@@ -4352,9 +4589,8 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
       contacts->bodies + contacts->count, contacts->tags + contacts->count,
       temporary);
 
-  // TODO: SIMD-optimize this loop.
-  for (unsigned i = 0; i < bucket_sizes[1] + bucket_sizes[2]; ++i)
-  {
+  auto collide_box_sphere = [&](unsigned i, Contact* contact,
+                                BodyPair* contact_bodies, uint64_t* tag) {
     unsigned pair = partitioned_pairs[bucket_offsets[1] + i];
 
     unsigned a = pair >> 16;
@@ -4365,19 +4601,21 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
     BoxCollider box = colliders.boxes.data[a];
     SphereCollider sphere = colliders.spheres.data[b];
 
-    contacts->tags[contacts->count] =
-        (uint64_t)((colliders.boxes.transforms[a].body >> 16) |
-                   (colliders.spheres.transforms[b].body & 0xffff0000))
-        << 32;
-    contacts->count += box_sphere_collide(
-        box, sphere, colliders.boxes.transforms[a],
-        colliders.spheres.transforms[b], contacts->data + contacts->count,
-        contacts->bodies + contacts->count);
-  }
+    *tag = (uint64_t)((colliders.boxes.transforms[a].body >> 16) |
+                      (colliders.spheres.transforms[b].body & 0xffff0000))
+           << 32;
+    return box_sphere_collide(box, sphere, colliders.boxes.transforms[a],
+                              colliders.spheres.transforms[b], contact,
+                              contact_bodies);
+  };
 
   // TODO: SIMD-optimize this loop.
-  for (unsigned i = 0; i < bucket_sizes[3]; ++i)
-  {
+  collide_pairs(contacts, bucket_sizes[1] + bucket_sizes[2],
+                narrowphase_grain_size, parallel_for, temporary,
+                collide_box_sphere);
+
+  auto collide_sphere_sphere = [&](unsigned i, Contact* contact,
+                                   BodyPair* contact_bodies, uint64_t* tag) {
     unsigned pair = partitioned_pairs[bucket_offsets[3] + i];
 
     unsigned a = pair >> 16;
@@ -4389,15 +4627,18 @@ void collide(ActiveBodies* active_bodies, ContactData* contacts,
     SphereCollider sphere_a = colliders.spheres.data[a];
     SphereCollider sphere_b = colliders.spheres.data[b];
 
-    contacts->tags[contacts->count] =
-        (uint64_t)((colliders.spheres.transforms[a].body >> 16) |
-                   (colliders.spheres.transforms[b].body & 0xffff0000))
-        << 32;
-    contacts->count += sphere_sphere_collide(
-        sphere_a, sphere_b, colliders.spheres.transforms[a],
-        colliders.spheres.transforms[b], contacts->data + contacts->count,
-        contacts->bodies + contacts->count);
-  }
+    *tag = (uint64_t)((colliders.spheres.transforms[a].body >> 16) |
+                      (colliders.spheres.transforms[b].body & 0xffff0000))
+           << 32;
+    return sphere_sphere_collide(sphere_a, sphere_b,
+                                 colliders.spheres.transforms[a],
+                                 colliders.spheres.transforms[b], contact,
+                                 contact_bodies);
+  };
+
+  // TODO: SIMD-optimize this loop.
+  collide_pairs(contacts, bucket_sizes[3], narrowphase_grain_size,
+                parallel_for, temporary, collide_sphere_sphere);
 
   // Discard islands of inactive objects at a fine level.
   {
@@ -4784,9 +5025,14 @@ void write_cached_impulses(ContactCache* contact_cache, ContactData contacts,
   uint64_t* culled_tags = contact_impulses->culled_tags;
   unsigned culled_count = contact_impulses->culled_count;
 
-  // Cache impulses.
+  // Cache impulses. The impulses of sleeping pairs which don't fit are
+  // dropped, those pairs start from zero impulses when they wake up.
   assert(contact_cache->capacity >=
-         contacts.count + culled_count); // Out of space in contact cache.
+         contacts.count); // Out of space in contact cache.
+
+  if (culled_count > contact_cache->capacity - contacts.count)
+    culled_count = contact_cache->capacity - contacts.count;
+
   contact_cache->count = contacts.count + culled_count;
   {
     // Pick sort from contacts and culled impulses.
@@ -4842,8 +5088,18 @@ struct ContactConstraintData
   ContactConstraintV* constraints;
   ContactConstraintStateV* constraint_states;
   unsigned constraint_batches;
+
+  // Batches of color c are [color_offsets[c], color_offsets[c + 1]), set by
+  // color_contact_constraints.
+  unsigned* color_offsets;
+  unsigned color_count;
 };
 
+// Maximum number of colors the constraint batches are split into. The last
+// color collects the batches which conflict with all others and is solved
+// serially.
+static const unsigned max_constraint_colors = 32;
+
 ContactConstraintData*
 setup_contact_constraints(ActiveBodies active_bodies, ContactData contacts,
                           BodyData bodies, ContactImpulseData* contact_impulses,
@@ -4855,6 +5111,8 @@ setup_contact_constraints(ActiveBodies active_bodies, ContactData contacts,
   ContactConstraintData* data =
       allocate_struct<ContactConstraintData>(memory, 64);
   data->contact_count = contacts.count;
+  data->color_offsets = 0;
+  data->color_count = 0;
 
   InertiaTransform* momentum_to_velocity =
       allocate_array<InertiaTransform>(memory, bodies.count, 32);
@@ -5531,14 +5789,16 @@ setup_contact_constraints(ActiveBodies active_bodies, ContactData contacts,
   return data;
 }
 
-void apply_impulses(ContactConstraintData* data, BodyData bodies)
+// Solves the constraint batches [begin, end) in order. Batches which run
+// concurrently with others have to skip_static, they all share body 0.
+template <bool skip_static>
+static void apply_impulses(ContactConstraintData* data, BodyData bodies,
+                           unsigned begin, unsigned end)
 {
   ContactConstraintV* constraints = data->constraints;
   ContactConstraintStateV* constraint_states = data->constraint_states;
 
-  unsigned constraint_batches = data->constraint_batches;
-
-  for (unsigned i = 0; i < constraint_batches; ++i)
+  for (unsigned i = begin; i < end; ++i)
   {
     const ContactConstraintV& constraint = constraints[i];
 
@@ -5770,7 +6030,7 @@ void apply_impulses(ContactConstraintData* data, BodyData bodies)
 
     a_angular_velocity_w = simd_float::zerov(); // Reduces register pressure.
 
-    store8<sizeof(bodies.momentum[0]), 1>(
+    store8<sizeof(bodies.momentum[0]), 1, skip_static>(
         (float*)bodies.momentum, constraint.a, a_velocity_x, a_velocity_y,
         a_velocity_z, a_mass_inverse, a_angular_velocity_x,
         a_angular_velocity_y, a_angular_velocity_z, a_angular_velocity_w);
@@ -5806,13 +6066,146 @@ void apply_impulses(ContactConstraintData* data, BodyData bodies)
 
     b_angular_velocity_w = simd_float::zerov(); // Reduces register pressure.
 
-    store8<sizeof(bodies.momentum[0]), 1>(
+    store8<sizeof(bodies.momentum[0]), 1, skip_static>(
         (float*)bodies.momentum, constraint.b, b_velocity_x, b_velocity_y,
         b_velocity_z, b_mass_inverse, b_angular_velocity_x,
         b_angular_velocity_y, b_angular_velocity_z, b_angular_velocity_w);
   }
 }
 
+void apply_impulses(ContactConstraintData* data, BodyData bodies)
+{
+  apply_impulses<false>(data, bodies, 0, data->constraint_batches);
+}
+
+void color_contact_constraints(ContactConstraintData* data, BodyData bodies,
+                               Arena* memory)
+{
+  unsigned constraint_batches = data->constraint_batches;
+
+  unsigned* color_offsets =
+      allocate_array<unsigned>(memory, max_constraint_colors + 1, 32);
+  data->color_offsets = color_offsets;
+
+  Arena temporary = *memory;
+
+  // Bit c is set if a batch of color c solves the body.
+  uint32_t* body_colors =
+      allocate_array<uint32_t>(&temporary, bodies.count, 32);
+  uint8_t* batch_colors =
+      allocate_array<uint8_t>(&temporary, constraint_batches, 32);
+  unsigned color_sizes[max_constraint_colors] = {};
+
+  memset(body_colors, 0, sizeof(body_colors[0]) * bodies.count);
+
+  static const uint32_t parallel_colors =
+      (1u << (max_constraint_colors - 1)) - 1;
+
+  // Greedily give every batch the first color none of its bodies has. The
+  // batches are visited in order, so the colors only depend on the contacts.
+  for (unsigned i = 0; i < constraint_batches; ++i)
+  {
+    const ContactConstraintV& constraint = data->constraints[i];
+
+    uint32_t used = 0;
+
+    for (unsigned j = 0; j < simdv_width32; ++j)
+      used |= body_colors[constraint.a[j]] | body_colors[constraint.b[j]];
+
+    uint32_t available = ~used & parallel_colors;
+    unsigned color =
+        available ? first_set_bit(available) : max_constraint_colors - 1;
+
+    for (unsigned j = 0; j < simdv_width32; ++j)
+    {
+      body_colors[constraint.a[j]] |= 1u << color;
+      body_colors[constraint.b[j]] |= 1u << color;
+    }
+
+    // Body 0 is the static world. The batches of a color share it, which is
+    // safe because the parallel solver never stores its momentum.
+    body_colors[0] = 0;
+
+    batch_colors[i] = (uint8_t)color;
+    ++color_sizes[color];
+  }
+
+  unsigned color_count = 0;
+  unsigned offset = 0;
+
+  for (unsigned i = 0; i < max_constraint_colors; ++i)
+  {
+    color_offsets[i] = offset;
+    offset += color_sizes[i];
+
+    if (color_sizes[i])
+      color_count = i + 1;
+  }
+
+  color_offsets[max_constraint_colors] = offset;
+  data->color_count = color_count;
+
+  // Reorder the batches by color, keeping their order within a color.
+  ContactConstraintV* constraints =
+      allocate_array<ContactConstraintV>(&temporary, constraint_batches, 32);
+  ContactConstraintStateV* constraint_states =
+      allocate_array<ContactConstraintStateV>(&temporary, constraint_batches,
+                                              32);
+  uint32_t* constraint_to_contact = allocate_array<uint32_t>(
+      &temporary, constraint_batches * simdv_width32, 32);
+
+  memcpy(constraints, data->constraints,
+         sizeof(constraints[0]) * constraint_batches);
+  memcpy(constraint_states, data->constraint_states,
+         sizeof(constraint_states[0]) * constraint_batches);
+  memcpy(constraint_to_contact, data->constraint_to_contact,
+         sizeof(constraint_to_contact[0]) * constraint_batches * simdv_width32);
+
+  unsigned written[max_constraint_colors];
+  memcpy(written, color_offsets, sizeof(written));
+
+  for (unsigned i = 0; i < constraint_batches; ++i)
+  {
+    unsigned batch = written[batch_colors[i]]++;
+
+    data->constraints[batch] = constraints[i];
+    data->constraint_states[batch] = constraint_states[i];
+    memcpy(data->constraint_to_contact + batch * simdv_width32,
+           constraint_to_contact + i * simdv_width32,
+           sizeof(constraint_to_contact[0]) * simdv_width32);
+  }
+}
+
+void apply_impulses(ContactConstraintData* data, BodyData bodies,
+                    ParallelFor parallel_for)
+{
+  static const unsigned solver_grain_size = 16;
+
+  if (!data->color_offsets)
+  {
+    apply_impulses(data, bodies);
+    return;
+  }
+
+  for (unsigned i = 0; i < data->color_count; ++i)
+  {
+    unsigned begin = data->color_offsets[i];
+    unsigned end = data->color_offsets[i + 1];
+
+    if (i == max_constraint_colors - 1)
+    {
+      apply_impulses<false>(data, bodies, begin, end);
+      continue;
+    }
+
+    auto apply_color = [&](unsigned first, unsigned last) {
+      apply_impulses<true>(data, bodies, begin + first, begin + last);
+    };
+
+    run_parallel(parallel_for, end - begin, solver_grain_size, apply_color);
+  }
+}
+
 void update_cached_impulses(ContactConstraintData* data,
                             ContactImpulseData* contact_impulses)
 {
@@ -5854,12 +6247,14 @@ void update_cached_impulses(ContactConstraintData* data,
   }
 }
 
-void advance(ActiveBodies active_bodies, BodyData bodies, float time_step)
+// Integrates the active bodies [begin, end).
+static void advance(ActiveBodies active_bodies, BodyData bodies,
+                    float time_step, unsigned begin, unsigned end)
 {
   float half_time_step = 0.5f * time_step;
 
   // TODO: Consider SIMD-optimizing this loop.
-  for (unsigned n = 0; n < active_bodies.count; ++n)
+  for (unsigned n = begin; n < end; ++n)
   {
     unsigned i = active_bodies.indices[n];
 
@@ -5900,4 +6295,22 @@ void advance(ActiveBodies active_bodies, BodyData bodies, float time_step)
   }
 }
 
+void advance(ActiveBodies active_bodies, BodyData bodies, float time_step)
+{
+  advance(active_bodies, bodies, time_step, 0, active_bodies.count);
+}
+
+void advance(ActiveBodies active_bodies, BodyData bodies, float time_step,
+             ParallelFor parallel_for)
+{
+  static const unsigned advance_grain_size = 256;
+
+  auto advance_range = [&](unsigned begin, unsigned end) {
+    advance(active_bodies, bodies, time_step, begin, end);
+  };
+
+  run_parallel(parallel_for, active_bodies.count, advance_grain_size,
+               advance_range);
+}
+
 } // namespace nudge
@@ -7,10 +7,35 @@
 #include "video/Window.h"
 
 #include <memory>
+#include <string>
 
 namespace bge
 {
 
+/**
+ * Startup settings of the application
+ */
+struct ApplicationConfig
+{
+  WindowData m_Window;     /**< the window to create, unless headless . */
+  bool m_Headless;         /**< run without a window or input, the engine must
+                                be built with BGE_NULL_RENDER_DEVICE . */
+  uint32 m_MaxFrames;      /**< frames to run before stopping, 0 for no
+                                limit . */
+  std::string m_TracePath; /**< file which receives the render commands of
+                                the last frame, only recorded by the null
+                                render device, empty for no trace . */
+
+  ApplicationConfig(WindowData window = WindowData("BGE Window"),
+                    bool headless = false, uint32 maxFrames = 0)
+      : m_Window(std::move(window))
+      , m_Headless(headless)
+      , m_MaxFrames(maxFrames)
+      , m_TracePath()
+  {
+  }
+};
+
 /**
  * The application class which must be extended by the user to create their app.
  */
@@ -20,7 +45,7 @@ class Application
   static Application* s_Instance;
 
 public:
-  Application();
+  explicit Application(const ApplicationConfig& config = ApplicationConfig());
   virtual ~Application();
 
   DELETE_COPY_AND_ASSIGN(Application)
@@ -61,6 +86,8 @@ private:
   World m_World;   /**< the main world . */
   Window m_Window; /**< the app window . */
 
+  ApplicationConfig m_Config; /**< the startup settings . */
+
   bool m_Running = true; /**< game loop flag . */
 };
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
 
 #if defined BGE_PLATFORM_WINDOWS
 #define BGE_DEBUG_BREAK                                                        \
@@ -87,7 +88,11 @@ using uintptr = std::uintptr_t;
 
 #define ARRAY_SIZE_IN_ELEMENTS(a) (sizeof(a) / sizeof(a[0]))
 
-#define BGE_BIND_EVENT_FN(fn) std::bind(&fn, this, std::placeholders::_1)
+// A lambda small enough for std::function to store without allocating
+#define BGE_BIND_EVENT_FN(fn)                                                  \
+  [this](auto&&... args) -> decltype(auto) {                                   \
+    return this->fn(std::forward<decltype(args)>(args)...);                    \
+  }
 
 #define DELETE_COPY_AND_ASSIGN(T)                                              \
   T(const T& other) = delete;                                                  \
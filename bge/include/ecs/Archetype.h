@@ -0,0 +1,168 @@
+#pragma once
+
+#include "ComponentTraits.h"
+#include "Entity.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+namespace bge
+{
+
+/// bytes of a chunk of an archetype, its entities and all of their components
+constexpr uint32 c_ArchetypeChunkSize = 16u * 1024u;
+
+/**
+ * Size and alignment of a component type stored in archetypes
+ */
+struct ComponentType
+{
+  uint32 m_Id;        ///< GetUniqueTypeId of the type
+  uint32 m_Size;      ///< size of the type in bytes
+  uint32 m_Alignment; ///< alignment of the type in bytes
+};
+
+/**
+ * @return the component type of T. The archetypes copy components as raw
+ * bytes and never destroy them, so T has to be trivially copyable.
+ */
+template <typename T> ComponentType GetComponentType()
+{
+  static_assert(std::is_trivially_copyable<T>::value &&
+                    std::is_trivially_destructible<T>::value,
+                "Archetype components are copied as raw bytes");
+
+  return ComponentType{GetUniqueTypeId<T>(), static_cast<uint32>(sizeof(T)),
+                       static_cast<uint32>(alignof(T))};
+}
+
+/**
+ * The entities which have exactly the same set of component types. They are
+ * stored in chunks of c_ArchetypeChunkSize bytes, each chunk holds an array of
+ * its entities followed by an array per component type, so iterating the
+ * components of a chunk streams contiguous memory. All chunks are full except
+ * the last one, removing an entity moves the last entity into its place.
+ */
+class Archetype
+{
+public:
+  static constexpr uint32 c_InvalidColumn = ~0u;
+
+  /**
+   * @param types the component types, sorted by id
+   */
+  explicit Archetype(const std::vector<ComponentType>& types);
+  ~Archetype();
+
+  Archetype(const Archetype&) = delete;
+  Archetype& operator=(const Archetype&) = delete;
+
+  /**
+   * Add an entity at the end, its components are left uninitialized
+   * @param entity the entity to add
+   * @return the index of the entity in the archetype
+   */
+  uint32 Add(Entity entity);
+
+  /**
+   * Remove the entity at an index, the last entity moves into its place
+   * @param index the index of the entity
+   * @return the entity which moved into the index, a null entity if the
+   * removed entity was the last one
+   */
+  Entity Remove(uint32 index);
+
+  /**
+   * @param typeId the id of a component type
+   * @return the column of the type, c_InvalidColumn if the archetype doesn't
+   * have it
+   */
+  uint32 FindColumn(uint32 typeId) const;
+
+  /**
+   * Find the columns of a set of component types
+   * @param typeIds the ids of the component types
+   * @param count number of types
+   * @param columns receives the column of every type
+   * @return true if the archetype has all of the types
+   */
+  bool FindColumns(const uint32* typeIds, uint32 count, uint32* columns) const;
+
+  /**
+   * @return the component of a column of the entity at an index
+   */
+  FORCEINLINE uint8* GetComponent(uint32 column, uint32 index)
+  {
+    return GetColumnData(index / m_ChunkCapacity, column) +
+           (index % m_ChunkCapacity) * m_Types[column].m_Size;
+  }
+
+  /**
+   * @return the entity at an index
+   */
+  FORCEINLINE Entity GetEntity(uint32 index) const
+  {
+    return reinterpret_cast<const Entity*>(
+        m_Chunks[index / m_ChunkCapacity])[index % m_ChunkCapacity];
+  }
+
+  /**
+   * @return the entities of a chunk
+   */
+  FORCEINLINE Entity* GetEntities(uint32 chunk)
+  {
+    return reinterpret_cast<Entity*>(m_Chunks[chunk]);
+  }
+
+  /**
+   * @return the components of a column in a chunk
+   */
+  FORCEINLINE uint8* GetColumnData(uint32 chunk, uint32 column)
+  {
+    return m_Chunks[chunk] + m_ColumnOffsets[column];
+  }
+
+  /**
+   * @return number of chunks which hold entities
+   */
+  FORCEINLINE uint32 GetChunkCount() const
+  {
+    return (m_Count + m_ChunkCapacity - 1) / m_ChunkCapacity;
+  }
+
+  /**
+   * @return number of entities in a chunk
+   */
+  FORCEINLINE uint32 GetChunkEntityCount(uint32 chunk) const
+  {
+    return std::min(m_ChunkCapacity, m_Count - chunk * m_ChunkCapacity);
+  }
+
+  /**
+   * @return number of entities which fit in a chunk
+   */
+  FORCEINLINE uint32 GetChunkCapacity() const { return m_ChunkCapacity; }
+
+  /**
+   * @return number of entities in the archetype
+   */
+  FORCEINLINE uint32 GetCount() const { return m_Count; }
+
+  /**
+   * @return the component types, sorted by id
+   */
+  FORCEINLINE const std::vector<ComponentType>& GetTypes() const
+  {
+    return m_Types;
+  }
+
+private:
+  std::vector<ComponentType> m_Types;  ///< the component types, sorted by id
+  std::vector<uint32> m_ColumnOffsets; ///< byte offset of each column
+  std::vector<uint8*> m_Chunks;        ///< chunks, kept when they empty out
+  uint32 m_ChunkCapacity;              ///< entities per chunk
+  uint32 m_Count;                      ///< number of entities
+};
+
+} // namespace bge
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "Archetype.h"
+
+#include "logging/Log.h"
+#include "scheduler/ParallelFor.h"
+
+#include <map>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Stores the components of entities grouped by archetype, the set of
+ * component types an entity has. Queries visit every archetype which has all
+ * of the queried types and stream the component arrays of its chunks, eg:
+ *   archetypes.AddComponents(entity, Position{}, Velocity{});
+ *   archetypes.ForEach<Position, Velocity>(
+ *     [&](Entity entity, Position& position, Velocity& velocity) { ... });
+ * Adding or removing a component moves the entity to another archetype, so
+ * it costs a copy of all of its components. The entities themselves are still
+ * created and destroyed by the EntityManager.
+ */
+class ArchetypeManager
+{
+public:
+  static constexpr uint32 c_InvalidIndex = ~0u;
+
+  ArchetypeManager();
+
+  /**
+   * Add components to an entity, the entity moves to the archetype which has
+   * its previous types plus the added ones. Components of types the entity
+   * already has are overwritten.
+   * @param entity the entity, which may or may not have components yet
+   * @param components the components to add
+   */
+  template <typename... Ts>
+  void AddComponents(Entity entity, const Ts&... components)
+  {
+    static_assert(sizeof...(Ts) > 0, "Add at least one component");
+
+    const ComponentType types[] = {GetComponentType<Ts>()...};
+    const uint32 index = AddComponentTypes(entity, types, sizeof...(Ts));
+    Archetype& archetype = *m_Archetypes[GetLocation(entity).m_Archetype];
+
+    const int expand[] = {0, (ConstructComponent(archetype, index,
+                                                 components),
+                              0)...};
+    (void)expand;
+  }
+
+  /**
+   * Add components whose types are only known at runtime, eg. the components
+   * recorded by an EntityCommandBuffer
+   * @param entity the entity, which may or may not have components yet
+   * @param types the component types
+   * @param components the bytes of every component
+   * @param count number of components
+   */
+  void AddComponentData(Entity entity, const ComponentType* types,
+                        const uint8* const* components, uint32 count);
+
+  /**
+   * Remove a component from an entity, the entity moves to the archetype
+   * without the type. Removing the last component removes the entity.
+   * @param entity the entity, which must have the component
+   */
+  template <typename T> void RemoveComponent(Entity entity)
+  {
+    RemoveComponentType(entity, GetUniqueTypeId<T>());
+  }
+
+  /**
+   * Same as RemoveComponent, for a type only known at runtime
+   * @param entity the entity, which must have the component
+   * @param typeId GetUniqueTypeId of the component type
+   */
+  void RemoveComponentType(Entity entity, uint32 typeId);
+
+  /**
+   * Remove an entity and all of its components
+   * @param entity the entity, which must have components
+   */
+  void RemoveEntity(Entity entity);
+
+  /**
+   * Remove every entity of a batch which has components
+   * @param entities the entities, which may or may not have components
+   */
+  void RemoveEntities(const std::vector<Entity>& entities);
+
+  /**
+   * @return true if the entity has components
+   */
+  bool Contains(Entity entity) const;
+
+  /**
+   * @return the component of an entity, nullptr if it doesn't have one
+   */
+  template <typename T> T* GetComponent(Entity entity)
+  {
+    if (!Contains(entity))
+    {
+      return nullptr;
+    }
+
+    const EntityLocation& location = GetLocation(entity);
+    Archetype& archetype = *m_Archetypes[location.m_Archetype];
+    const uint32 column = archetype.FindColumn(GetUniqueTypeId<T>());
+
+    return column == Archetype::c_InvalidColumn
+               ? nullptr
+               : reinterpret_cast<T*>(
+                     archetype.GetComponent(column, location.m_Index));
+  }
+
+  /**
+   * @return true if the entity has a component of type T
+   */
+  template <typename T> bool HasComponent(Entity entity)
+  {
+    return GetComponent<T>(entity) != nullptr;
+  }
+
+  /**
+   * @param typeId GetUniqueTypeId of a component type
+   * @return true if the entity has a component of the type
+   */
+  bool HasComponentType(Entity entity, uint32 typeId) const;
+
+  /**
+   * Call a function with the arrays of every chunk whose archetype has all
+   * of the types Ts..., the arrays are contiguous and in the same order
+   * @param function callable taking (uint32 count, Entity* entities, Ts*...)
+   */
+  template <typename... Ts, typename Function>
+  void ForEachChunk(const Function& function)
+  {
+    const uint32 typeIds[] = {GetUniqueTypeId<Ts>()...};
+    uint32 columns[sizeof...(Ts)];
+
+    for (auto&& archetype : m_Archetypes)
+    {
+      if (!archetype->FindColumns(typeIds, sizeof...(Ts), columns))
+      {
+        continue;
+      }
+
+      for (uint32 chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+      {
+        CallWithChunk<Ts...>(std::index_sequence_for<Ts...>(), function,
+                             *archetype, chunk, columns);
+      }
+    }
+  }
+
+  /**
+   * Call a function with every entity which has all of the types Ts... and
+   * its components
+   * @param function callable taking (Entity, Ts&...)
+   */
+  template <typename... Ts, typename Function>
+  void ForEach(const Function& function)
+  {
+    ForEachChunk<Ts...>(
+        [&function](uint32 count, Entity* entities, Ts*... components) {
+          for (uint32 i = 0; i < count; ++i)
+          {
+            function(entities[i], components[i]...);
+          }
+        });
+  }
+
+  /**
+   * Same as ForEach, but the chunks run in parallel on the scheduler, a task
+   * per chunk. The function must only touch the components it is passed.
+   * @param function callable taking (Entity, Ts&...)
+   */
+  template <typename... Ts, typename Function>
+  void ParallelForEach(const Function& function)
+  {
+    struct QueryChunk
+    {
+      Archetype* m_Archetype;
+      uint32 m_Chunk;
+      uint32 m_Columns[sizeof...(Ts)];
+    };
+
+    const uint32 typeIds[] = {GetUniqueTypeId<Ts>()...};
+    std::vector<QueryChunk> chunks;
+
+    for (auto&& archetype : m_Archetypes)
+    {
+      QueryChunk query;
+      query.m_Archetype = archetype.get();
+
+      if (!archetype->FindColumns(typeIds, sizeof...(Ts), query.m_Columns))
+      {
+        continue;
+      }
+
+      for (uint32 chunk = 0; chunk < archetype->GetChunkCount(); ++chunk)
+      {
+        query.m_Chunk = chunk;
+        chunks.push_back(query);
+      }
+    }
+
+    const auto forChunk = [&function](uint32 count, Entity* entities,
+                                      Ts*... components) {
+      for (uint32 i = 0; i < count; ++i)
+      {
+        function(entities[i], components[i]...);
+      }
+    };
+
+    ParallelFor(0u, static_cast<uint32>(chunks.size()), 1u, [&](uint32 i) {
+      CallWithChunk<Ts...>(std::index_sequence_for<Ts...>(), forChunk,
+                           *chunks[i].m_Archetype, chunks[i].m_Chunk,
+                           chunks[i].m_Columns);
+    });
+  }
+
+  /**
+   * @return number of entities with components
+   */
+  FORCEINLINE uint32 GetEntityCount() const { return m_EntityCount; }
+
+  /**
+   * @return number of archetypes created so far
+   */
+  FORCEINLINE uint32 GetArchetypeCount() const
+  {
+    return static_cast<uint32>(m_Archetypes.size());
+  }
+
+private:
+  /**
+   * Where the components of an entity are
+   */
+  struct EntityLocation
+  {
+    uint32 m_Archetype; ///< index of the archetype, c_InvalidIndex if none
+    uint32 m_Index;     ///< index of the entity in the archetype
+  };
+
+  /**
+   * Move an entity to the archetype with its types plus the passed ones
+   * @return the index of the entity in its new archetype
+   */
+  uint32 AddComponentTypes(Entity entity, const ComponentType* types,
+                           uint32 count);
+
+  /**
+   * @param types component types sorted by id
+   * @return the index of the archetype with exactly these types
+   */
+  uint32 FindOrCreateArchetype(const std::vector<ComponentType>& types);
+
+  /**
+   * Move an entity and the components both archetypes have to an archetype
+   * @return the index of the entity in the archetype
+   */
+  uint32 MoveEntity(Entity entity, uint32 archetype);
+
+  /**
+   * Remove an entity from its archetype and update the location of the
+   * entity which moved into its place
+   */
+  void RemoveFromArchetype(const EntityLocation& location);
+
+  FORCEINLINE EntityLocation& GetLocation(Entity entity)
+  {
+    return m_Locations[entity.GetId()];
+  }
+
+  template <typename T>
+  static void ConstructComponent(Archetype& archetype, uint32 index,
+                                 const T& component)
+  {
+    const uint32 column = archetype.FindColumn(GetUniqueTypeId<T>());
+    new (archetype.GetComponent(column, index)) T(component);
+  }
+
+  template <typename... Ts, size_t... Is, typename Function>
+  static void CallWithChunk(std::index_sequence<Is...>,
+                            const Function& function, Archetype& archetype,
+                            uint32 chunk, const uint32* columns)
+  {
+    function(archetype.GetChunkEntityCount(chunk),
+             archetype.GetEntities(chunk),
+             reinterpret_cast<Ts*>(
+                 archetype.GetColumnData(chunk, columns[Is]))...);
+  }
+
+private:
+  /// the archetypes, in order of creation
+  std::vector<std::unique_ptr<Archetype>> m_Archetypes;
+  /// the archetype of every set of component type ids
+  std::map<std::vector<uint32>, uint32> m_ArchetypeIndices;
+  /// the location of every entity id
+  std::vector<EntityLocation> m_Locations;
+  /// number of entities with components
+  uint32 m_EntityCount;
+  /// scratch signature of the archetype an entity moves to
+  std::vector<ComponentType> m_Signature;
+  /// scratch type ids of the archetype being looked up
+  std::vector<uint32> m_TypeIds;
+};
+
+} // namespace bge
@@ -0,0 +1,265 @@
+#pragma once
+
+#include "EntityIndex.h"
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Storage of the components Ts... of entities. The entities are kept in an
+ * EntityIndex and every component type in its own dense column, all in the
+ * same order, so adding, removing and looking up are O(1) array accesses and
+ * iterating a column is a linear loop. Removing an entity moves the last
+ * entity and its components into the hole, which changes the dense order.
+ * Usage:
+ *   ComponentStorage<DynamicMeshData, Mat4f> meshes;
+ *   meshes.Add(entity, data, Mat4f(1.0f));
+ *   std::vector<Mat4f>& transforms = meshes.GetColumn<1>();
+ */
+template <typename... Ts> class ComponentStorage
+{
+  static_assert(sizeof...(Ts) > 0, "A storage needs at least one component");
+
+public:
+  /// the component type stored in a column
+  template <uint32 Column>
+  using ColumnType =
+      typename std::tuple_element<Column, std::tuple<Ts...>>::type;
+
+  ComponentStorage()
+      : m_Index()
+      , m_Columns()
+  {
+  }
+
+  /**
+   * Add the components of an entity at the end of the columns
+   * @param entity the entity, which must not have components yet
+   * @param components the component of every column
+   * @return the dense index of the entity
+   */
+  uint32 Add(Entity entity, const Ts&... components)
+  {
+    const uint32 index = m_Index.Add(entity);
+    PushBack(std::index_sequence_for<Ts...>(), components...);
+    return index;
+  }
+
+  /**
+   * Add default constructed components for a batch of entities, which the
+   * caller fills in through the columns afterwards
+   * @param entities the entities, which must not have components yet
+   * @param count number of entities
+   * @return the dense index of the first entity, the others follow in order
+   */
+  uint32 AddBatch(const Entity* entities, uint32 count)
+  {
+    const uint32 first = GetCount();
+
+    Reserve(first + count);
+    for (uint32 i = 0; i < count; ++i)
+    {
+      m_Index.Add(entities[i]);
+    }
+    Resize(std::index_sequence_for<Ts...>(), first + count);
+
+    return first;
+  }
+
+  /**
+   * Remove the components of an entity, the last entity moves into its index
+   * @param entity the entity, which must have components
+   * @return the dense index the entity had
+   */
+  uint32 Remove(Entity entity)
+  {
+    const uint32 index = m_Index.Remove(entity);
+    SwapRemove(std::index_sequence_for<Ts...>(), index);
+    return index;
+  }
+
+  /**
+   * Remove the components of every entity of a batch which has any, with a
+   * single compaction pass over the index and every column. The remaining
+   * entities keep their order, see EntityIndex::RemoveBatch.
+   * @param entities the entities, which may or may not have components
+   * @param count number of entities
+   * @return number of entities which got removed
+   */
+  uint32 RemoveBatch(const Entity* entities, uint32 count)
+  {
+    const uint32 oldCount = GetCount();
+
+    if (m_Index.RemoveBatch(entities, count) != oldCount)
+    {
+      Compact(std::index_sequence_for<Ts...>());
+    }
+
+    return oldCount - GetCount();
+  }
+
+  /**
+   * Allocate memory for count entities in the index and every column
+   * @param count number of entities
+   */
+  void Reserve(uint32 count)
+  {
+    m_Index.Reserve(count);
+    Reserve(std::index_sequence_for<Ts...>(), count);
+  }
+
+  /**
+   * Call a function with every entity and its components, in dense order
+   * @param function callable taking (Entity, Ts&...)
+   */
+  template <typename Function> void ForEach(const Function& function)
+  {
+    ForEach(std::index_sequence_for<Ts...>(), function);
+  }
+
+  /**
+   * @return the component of an entity, which must have components
+   */
+  template <uint32 Column> FORCEINLINE ColumnType<Column>& Get(Entity entity)
+  {
+    return std::get<Column>(m_Columns)[m_Index.GetIndex(entity)];
+  }
+
+  /**
+   * @return the components of a column, in dense order
+   */
+  template <uint32 Column>
+  FORCEINLINE std::vector<ColumnType<Column>>& GetColumn()
+  {
+    return std::get<Column>(m_Columns);
+  }
+
+  /**
+   * @return the components of a column, in dense order
+   */
+  template <uint32 Column>
+  FORCEINLINE const std::vector<ColumnType<Column>>& GetColumn() const
+  {
+    return std::get<Column>(m_Columns);
+  }
+
+  /**
+   * @return the dense index of an entity, c_InvalidIndex if it has no
+   * components
+   */
+  FORCEINLINE uint32 Find(Entity entity) const { return m_Index.Find(entity); }
+
+  /**
+   * @return true if the entity has components
+   */
+  FORCEINLINE bool Contains(Entity entity) const
+  {
+    return m_Index.Contains(entity);
+  }
+
+  /**
+   * @return the dense index of an entity, which must have components
+   */
+  FORCEINLINE uint32 GetIndex(Entity entity) const
+  {
+    return m_Index.GetIndex(entity);
+  }
+
+  /**
+   * @return the entity at a dense index
+   */
+  FORCEINLINE Entity GetEntity(uint32 index) const
+  {
+    return m_Index.GetEntity(index);
+  }
+
+  /**
+   * @return the entities in dense order
+   */
+  FORCEINLINE const std::vector<Entity>& GetEntities() const
+  {
+    return m_Index.GetEntities();
+  }
+
+  /**
+   * @return number of entities with components
+   */
+  FORCEINLINE uint32 GetCount() const { return m_Index.GetCount(); }
+
+private:
+  // The helpers expand a statement for every column. The array only exists
+  // to expand the parameter pack in order.
+  template <size_t... Columns>
+  void PushBack(std::index_sequence<Columns...>, const Ts&... components)
+  {
+    const int expand[] = {
+        0, (std::get<Columns>(m_Columns).push_back(components), 0)...};
+    (void)expand;
+  }
+
+  template <size_t... Columns>
+  void Resize(std::index_sequence<Columns...>, uint32 count)
+  {
+    const int expand[] = {0,
+                          (std::get<Columns>(m_Columns).resize(count), 0)...};
+    (void)expand;
+  }
+
+  template <size_t... Columns>
+  void Reserve(std::index_sequence<Columns...>, uint32 count)
+  {
+    const int expand[] = {0,
+                          (std::get<Columns>(m_Columns).reserve(count), 0)...};
+    (void)expand;
+  }
+
+  template <size_t... Columns>
+  void SwapRemove(std::index_sequence<Columns...>, uint32 index)
+  {
+    const int expand[] = {0, (SwapRemove(std::get<Columns>(m_Columns), index),
+                              0)...};
+    (void)expand;
+  }
+
+  template <typename T>
+  static void SwapRemove(std::vector<T>& column, uint32 index)
+  {
+    if (index + 1 != column.size())
+    {
+      column[index] = std::move(column.back());
+    }
+    column.pop_back();
+  }
+
+  template <size_t... Columns> void Compact(std::index_sequence<Columns...>)
+  {
+    const int expand[] = {0, (Compact(std::get<Columns>(m_Columns)), 0)...};
+    (void)expand;
+  }
+
+  template <typename T> void Compact(std::vector<T>& column)
+  {
+    m_Index.ApplyRemoveBatch(column.data());
+    // erase instead of resize, which needs default constructible components
+    column.erase(column.begin() + GetCount(), column.end());
+  }
+
+  template <size_t... Columns, typename Function>
+  void ForEach(std::index_sequence<Columns...>, const Function& function)
+  {
+    for (uint32 i = 0; i < GetCount(); ++i)
+    {
+      function(m_Index.GetEntity(i), std::get<Columns>(m_Columns)[i]...);
+    }
+  }
+
+private:
+  EntityIndex m_Index;                      ///< the entities
+  std::tuple<std::vector<Ts>...> m_Columns; ///< a column per component type
+};
+
+} // namespace bge
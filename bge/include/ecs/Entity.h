@@ -5,10 +5,24 @@
 namespace bge
 {
 
+// The layout of an entity handle, set with the BGE_ENTITY_HANDLE_32 CMake
+// option. The 64 bit handle has 32 index and 32 generation bits, the 32 bit
+// handle 22 index and 10 generation bits. An index retires once its
+// generation runs out, see EntityManager.
+#ifdef BGE_ENTITY_HANDLE_32
+using EntityHandle = uint32;
 constexpr uint32 c_EntityIndexBits = 22u;
-constexpr uint32 c_EntityIndexMask = (1u << c_EntityIndexBits) - 1u;
-constexpr uint32 c_EntityGenerationBits = 8u;
-constexpr uint32 c_EntityGenerationMask = (1u << c_EntityGenerationBits) - 1u;
+#else
+using EntityHandle = uint64;
+constexpr uint32 c_EntityIndexBits = 32u;
+#endif
+
+constexpr uint32 c_EntityGenerationBits =
+    sizeof(EntityHandle) * 8u - c_EntityIndexBits;
+constexpr EntityHandle c_EntityIndexMask =
+    (EntityHandle(1) << c_EntityIndexBits) - 1u;
+constexpr EntityHandle c_EntityGenerationMask =
+    (EntityHandle(1) << c_EntityGenerationBits) - 1u;
 
 /**
  * The entity class which is just a unique id that is used to implicitly
@@ -17,7 +31,7 @@ constexpr uint32 c_EntityGenerationMask = (1u << c_EntityGenerationBits) - 1u;
 class Entity
 {
 public:
-  Entity(uint32 id, uint8 generation)
+  Entity(uint32 id, uint32 generation)
       : m_ID(generation)
   {
     m_ID = (m_ID << c_EntityIndexBits) | id;
@@ -26,14 +40,18 @@ public:
   /**
    * @return The unique entity id
    */
-  FORCEINLINE uint32 GetId() const { return m_ID & c_EntityIndexMask; }
+  FORCEINLINE uint32 GetId() const
+  {
+    return static_cast<uint32>(m_ID & c_EntityIndexMask);
+  }
 
   /**
    * @return The generation of the entity
    */
   FORCEINLINE uint32 GetGeneration() const
   {
-    return (m_ID >> c_EntityIndexBits) & c_EntityGenerationMask;
+    return static_cast<uint32>((m_ID >> c_EntityIndexBits) &
+                               c_EntityGenerationMask);
   }
 
   /**
@@ -55,7 +73,7 @@ public:
   }
 
 private:
-  uint32 m_ID = 0u; /**< the id containing index & generation . */
+  EntityHandle m_ID = 0u; /**< the id containing index & generation . */
 };
 
-} // namespace bge
\ No newline at end of file
+} // namespace bge
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+
+#include "Archetype.h"
+#include "Entity.h"
+
+#include "logging/Log.h"
+#include "scheduler/Scheduler.h"
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+namespace bge
+{
+
+class ArchetypeManager;
+class EntityManager;
+
+/**
+ * Records structural changes of entities, creating and destroying them and
+ * adding and removing their archetype components, to apply them later at a
+ * sync point. Every worker thread records into its own buffer, see
+ * EntityCommandQueue, so systems running in parallel never touch the shared
+ * entity and component containers. eg:
+ *   EntityCommandBuffer& commands = GetCommandBuffer();
+ *   Entity entity = commands.CreateEntity();
+ *   commands.AddComponent(entity, Position{});
+ */
+class EntityCommandBuffer
+{
+public:
+  /**
+   * @param placeholderCount counter of placeholder entities, shared by all
+   * buffers of a queue
+   */
+  explicit EntityCommandBuffer(std::atomic<uint32>* placeholderCount);
+
+  /**
+   * Create an entity when the buffer is played back. The returned entity is a
+   * placeholder which can only be passed to the commands of the same queue,
+   * playback replaces it with the real entity.
+   * @return the placeholder entity
+   */
+  Entity CreateEntity();
+
+  /**
+   * Destroy an entity when the buffer is played back, after the component
+   * commands. Destroying an entity more than once is allowed.
+   * @param entity the entity to destroy
+   */
+  void DestroyEntity(Entity entity);
+
+  /**
+   * Add or overwrite a component of an entity when the buffer is played back
+   * @param entity the entity, or a placeholder of the queue
+   * @param component the component, copied into the buffer
+   */
+  template <typename T> void AddComponent(Entity entity, const T& component)
+  {
+    const ComponentType type = GetComponentType<T>();
+    const uint32 offset = static_cast<uint32>(m_Data.size());
+
+    m_Data.resize(offset + type.m_Size);
+    memcpy(m_Data.data() + offset, &component, type.m_Size);
+
+    Record(CommandType::AddComponent, entity, type, offset);
+  }
+
+  /**
+   * Remove a component of an entity when the buffer is played back, it's
+   * skipped if the entity doesn't have one
+   * @param entity the entity, or a placeholder of the queue
+   */
+  template <typename T> void RemoveComponent(Entity entity)
+  {
+    Record(CommandType::RemoveComponent, entity, GetComponentType<T>(), 0u);
+  }
+
+  /**
+   * Set the key which orders the following commands against the commands of
+   * other buffers, eg. the index of the system which records them
+   * @param sortKey the key, commands with lower keys play back first
+   */
+  FORCEINLINE void SetSortKey(uint32 sortKey) { m_SortKey = sortKey; }
+
+  /**
+   * @return number of recorded commands
+   */
+  FORCEINLINE uint32 GetCommandCount() const
+  {
+    return static_cast<uint32>(m_Commands.size());
+  }
+
+  /**
+   * Drop the recorded commands, keeping the memory for the next frame
+   */
+  void Clear();
+
+private:
+  friend class EntityCommandQueue;
+
+  enum class CommandType : uint8
+  {
+    DestroyEntity,
+    AddComponent,
+    RemoveComponent
+  };
+
+  /**
+   * A recorded command, the component bytes of additions are in m_Data
+   */
+  struct Command
+  {
+    Entity m_Entity;       ///< the entity or placeholder
+    ComponentType m_Type;  ///< the component type, unused by destroys
+    uint32 m_DataOffset;   ///< offset of the component bytes in m_Data
+    CommandType m_Command; ///< what the command does
+  };
+
+  /**
+   * The commands recorded with the same sort key in a row
+   */
+  struct CommandRun
+  {
+    uint32 m_SortKey; ///< the key of the commands
+    uint32 m_Begin;   ///< index of the first command of the run
+  };
+
+  void Record(CommandType command, Entity entity, const ComponentType& type,
+              uint32 dataOffset);
+
+  std::vector<Command> m_Commands;         ///< commands in recording order
+  std::vector<CommandRun> m_Runs;          ///< runs of the commands by key
+  std::vector<uint8> m_Data;               ///< bytes of the added components
+  std::atomic<uint32>* m_PlaceholderCount; ///< counter shared by the queue
+  uint32 m_SortKey;                        ///< key of the next commands
+};
+
+/**
+ * The command buffers of all worker threads and their playback. Playback
+ * creates all placeholder entities in one batch, applies the component
+ * commands in the order of their sort keys, adding the components of
+ * consecutive additions to an entity in one archetype move, and then destroys
+ * the entities.
+ */
+class EntityCommandQueue
+{
+public:
+  EntityCommandQueue();
+
+  EntityCommandQueue(const EntityCommandQueue&) = delete;
+  EntityCommandQueue& operator=(const EntityCommandQueue&) = delete;
+
+  /**
+   * Create a buffer per worker, called once the scheduler is initialized
+   */
+  void Init();
+
+  /**
+   * @return the buffer of the calling worker thread
+   */
+  FORCEINLINE EntityCommandBuffer& GetBuffer()
+  {
+    const uint32 worker = Scheduler::GetWorkerIndex();
+    BGE_CORE_ASSERT(worker < m_Buffers.size(),
+                    "Commands are recorded on an unregistered thread");
+
+    return m_Buffers[worker];
+  }
+
+  /**
+   * Apply the commands of all buffers and clear them. Must not run while
+   * commands are recorded.
+   * @param entityManager creates and destroys the entities
+   * @param archetypes receives the component commands
+   * @param destroyed receives the destroyed entities
+   */
+  void Playback(EntityManager& entityManager, ArchetypeManager& archetypes,
+                std::vector<Entity>& destroyed);
+
+private:
+  /**
+   * A run of commands of a buffer, in playback order
+   */
+  struct SortedRun
+  {
+    uint32 m_SortKey;                    ///< the key of the commands
+    const EntityCommandBuffer* m_Buffer; ///< the buffer of the commands
+    uint32 m_Begin;                      ///< index of the first command
+    uint32 m_End;                        ///< index past the last command
+  };
+
+  /**
+   * @return the real entity of an entity or a placeholder
+   */
+  Entity Resolve(Entity entity) const;
+
+  /**
+   * Apply the component commands of a run and collect its destroyed entities
+   */
+  void ApplyRun(EntityManager& entityManager, ArchetypeManager& archetypes,
+                const SortedRun& run);
+
+  std::vector<EntityCommandBuffer> m_Buffers; ///< a buffer per worker
+  std::atomic<uint32> m_PlaceholderCount;     ///< placeholders recorded
+  std::vector<Entity> m_Created;              ///< entity of each placeholder
+  std::vector<SortedRun> m_Runs;              ///< runs in playback order
+  std::vector<Entity> m_Destroyed;            ///< entities to destroy
+  std::vector<ComponentType> m_AddedTypes;    ///< types of an addition run
+  std::vector<const uint8*> m_AddedData;      ///< bytes of an addition run
+};
+
+} // namespace bge
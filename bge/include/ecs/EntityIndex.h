@@ -0,0 +1,136 @@
+#pragma once
+
+#include "Entity.h"
+
+#include "logging/Log.h"
+
+#include <utility>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Sparse set which maps entities to dense indices in [0, GetCount()).
+ * The sparse array is indexed by Entity::GetId(), so a lookup is an array
+ * access. The dense array holds the entities themselves, which validates the
+ * generation of a lookup and keeps the indices packed for linear loops.
+ * Removing an entity moves the last entity into its index, systems keep their
+ * component arrays in the same order by doing the same swap.
+ */
+class EntityIndex
+{
+public:
+  static constexpr uint32 c_InvalidIndex = ~0u;
+
+  EntityIndex();
+
+  /**
+   * Add an entity at the end of the dense array
+   * @param entity the entity to add, must not be in the index yet
+   * @return the dense index of the entity
+   */
+  uint32 Add(Entity entity);
+
+  /**
+   * Remove an entity, the last entity moves into its dense index
+   * @param entity the entity to remove, must be in the index
+   * @return the dense index the entity had
+   */
+  uint32 Remove(Entity entity);
+
+  /**
+   * Remove every entity of a batch which is in the index with a single pass
+   * over the dense array. Unlike Remove, the remaining entities keep their
+   * order, they move down over the holes.
+   * @param entities the entities to remove, which may or may not be in the
+   * index
+   * @param count number of entities
+   * @return the first dense index which changed, GetCount() if no entity got
+   * removed
+   */
+  uint32 RemoveBatch(const Entity* entities, uint32 count);
+
+  /**
+   * Move the elements of an array the same way the last RemoveBatch moved the
+   * entities, so arrays kept in dense order stay in sync. The elements past
+   * GetCount() are left over and can be cut off.
+   * @param data the array, still in the dense order from before RemoveBatch
+   */
+  template <typename T> void ApplyRemoveBatch(T* data) const
+  {
+    // Every entity moves down, so the moves in order never overwrite an
+    // element which is still to be moved
+    for (uint32 i = 0; i < m_MovedFrom.size(); ++i)
+    {
+      data[m_FirstMoved + i] = std::move(data[m_MovedFrom[i]]);
+    }
+  }
+
+  /**
+   * Allocate memory for count entities
+   * @param count number of entities
+   */
+  void Reserve(uint32 count);
+
+  /**
+   * @return the dense index of an entity, c_InvalidIndex if the entity (with
+   * this generation) is not in the index
+   */
+  FORCEINLINE uint32 Find(Entity entity) const
+  {
+    const uint32 id = entity.GetId();
+
+    if (id >= m_Sparse.size())
+    {
+      return c_InvalidIndex;
+    }
+
+    const uint32 index = m_Sparse[id];
+    return index < m_Dense.size() && m_Dense[index] == entity ? index
+                                                              : c_InvalidIndex;
+  }
+
+  /**
+   * @return true if the entity (with this generation) is in the index
+   */
+  FORCEINLINE bool Contains(Entity entity) const
+  {
+    return Find(entity) != c_InvalidIndex;
+  }
+
+  /**
+   * @return the dense index of an entity, which must be in the index
+   */
+  FORCEINLINE uint32 GetIndex(Entity entity) const
+  {
+    BGE_CORE_ASSERT(Contains(entity), "Entity is not in the index");
+    return m_Sparse[entity.GetId()];
+  }
+
+  /**
+   * @return the entity at a dense index
+   */
+  FORCEINLINE Entity GetEntity(uint32 index) const { return m_Dense[index]; }
+
+  /**
+   * @return the entities in dense order
+   */
+  FORCEINLINE const std::vector<Entity>& GetEntities() const { return m_Dense; }
+
+  /**
+   * @return number of entities in the index
+   */
+  FORCEINLINE uint32 GetCount() const
+  {
+    return static_cast<uint32>(m_Dense.size());
+  }
+
+private:
+  std::vector<uint32> m_Sparse;    ///< dense index of every entity id
+  std::vector<Entity> m_Dense;     ///< the entities, in dense order
+  std::vector<uint32> m_MovedFrom; ///< old index of the last batch's moves
+  uint32 m_FirstMoved;             ///< new index of the first of the moves
+};
+
+} // namespace bge
@@ -2,19 +2,29 @@
 
 #include "Entity.h"
 
-#include <deque>
 #include <vector>
 
 namespace bge
 {
 
+/// Default number of free indices kept before destroyed indices get reused
+constexpr uint32 c_DefaultMinFreeEntityIndices = 1024u;
+
 /**
- * The class which handles creation and destruction of entities in the engine
+ * The class which handles creation and destruction of entities in the engine.
+ * Destroyed indices are reused first in first out, and only while more than a
+ * minimum number of them are free, so the generation of a single index grows
+ * slowly. An index whose generation runs out is never reused, so a stale
+ * handle can't become valid again.
  */
 class EntityManager
 {
 public:
-  EntityManager();
+  /**
+   * @param minFreeIndices number of free indices kept before reusing them
+   */
+  explicit EntityManager(
+      uint32 minFreeIndices = c_DefaultMinFreeEntityIndices);
 
   /**
    * Create a new entity
@@ -22,12 +32,26 @@ public:
    */
   Entity CreateEntity();
 
+  /**
+   * Create a batch of new entities
+   * @param count number of entities to create
+   * @param output receives count entities
+   */
+  void CreateEntities(uint32 count, Entity* output);
+
   /**
    * Destroy an existing entity
    * @param id the entity to destroy
    */
   void DestroyEntity(Entity id);
 
+  /**
+   * Destroy a batch of existing entities
+   * @param entities the entities to destroy, all of them alive
+   * @param count number of entities
+   */
+  void DestroyEntities(const Entity* entities, uint32 count);
+
   /**
    * Check if an entity is alive
    * @param id the entity to check
@@ -38,9 +62,36 @@ public:
     return m_EntityVersion[entity.GetId()] == entity.GetGeneration();
   }
 
+  /**
+   * @return number of destroyed indices waiting to be reused
+   */
+  FORCEINLINE uint32 GetFreeCount() const
+  {
+    return static_cast<uint32>(m_FreeList.size()) - m_FreeHead;
+  }
+
 private:
-  std::vector<uint8> m_EntityVersion; /**< vector of entity generations */
-  std::deque<uint32> m_FreeList;      /**< List of available entity slots. */
+  /**
+   * Take the next free index, there must be more than m_MinFreeIndices
+   */
+  FORCEINLINE uint32 PopFreeIndex() { return m_FreeList[m_FreeHead++]; }
+
+  /**
+   * Bump the generation of a destroyed index and queue it for reuse, unless
+   * its generation ran out
+   */
+  void ReleaseIndex(uint32 index);
+
+  /**
+   * Drop the indices popped off the front of the FIFO once they outnumber the
+   * free ones, so the list doesn't grow forever
+   */
+  void CompactFreeList();
+
+  std::vector<uint32> m_EntityVersion; /**< vector of entity generations */
+  std::vector<uint32> m_FreeList; /**< FIFO of available entity slots. */
+  uint32 m_FreeHead;              /**< first slot of the FIFO in the list */
+  uint32 m_MinFreeIndices;        /**< free slots kept before reusing */
 };
 
 } // namespace bge
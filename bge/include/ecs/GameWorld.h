@@ -1,8 +1,11 @@
 #pragma once
 
 #include "ecs/ComponentTraits.h"
+#include "ecs/EntityCommandBuffer.h"
 #include "events/ECSEvents.h"
+#include "events/EventBus.h"
 #include "logging/Log.h"
+#include "scheduler/JobGraph.h"
 
 #include <map>
 #include <memory>
@@ -30,10 +33,73 @@ public:
    */
   virtual void Tick(float deltaSeconds) {}
 
+protected:
   /**
-   * virtual function called when an event is broadcast
+   * Declare the types of the data the system reads in Tick, eg. components or
+   * other systems, called in the constructor. A system which declares its
+   * access ticks on the scheduler concurrently with the systems it doesn't
+   * conflict with, so it must record structural changes through
+   * GetCommandBuffer. Systems without a declaration tick on the main thread,
+   * eg. to poll input. Can be called without types to only declare the access
+   * to the state of the system itself.
    */
-  virtual void OnEvent(Event& event) {}
+  template <typename... Ts> void DeclareReads()
+  {
+    m_HasAccessDeclaration = true;
+    m_Reads.insert(m_Reads.end(), {GetJobResourceId<Ts>()...});
+  }
+
+  /**
+   * Declare the types of the data the system modifies in Tick, see
+   * DeclareReads
+   */
+  template <typename... Ts> void DeclareWrites()
+  {
+    m_HasAccessDeclaration = true;
+    m_Writes.insert(m_Writes.end(), {GetJobResourceId<Ts>()...});
+  }
+
+  /**
+   * Subscribe a handler of the system to the events of the type it receives,
+   * called in the constructor. The game world queues the broadcast events and
+   * delivers them to their subscribers on the main thread before the systems
+   * tick. eg:
+   *   SubscribeEvent<BGE_EVENT_HANDLER(MySystem::OnKeyPressed)>();
+   */
+  template <typename Handler, Handler Method> void SubscribeEvent()
+  {
+    m_EventSubscriptions.push_back([](EventBus& bus, GameSystem* system) {
+      bus.Subscribe<Handler, Method>(
+          static_cast<typename EventHandlerTraits<Handler>::Class*>(system));
+    });
+  }
+
+  /**
+   * @return the command buffer of the calling thread, played back after all
+   * systems ticked
+   */
+  EntityCommandBuffer& GetCommandBuffer()
+  {
+    BGE_CORE_ASSERT(m_CommandQueue, "System isn't added to a game world");
+    return m_CommandQueue->GetBuffer();
+  }
+
+private:
+  friend class GameWorld;
+
+  /// subscribes a handler of the system to the bus of the game world
+  using EventSubscription = void (*)(EventBus&, GameSystem*);
+
+  /// queue of the world, set when the system is added
+  EntityCommandQueue* m_CommandQueue = nullptr;
+  /// resources only read by Tick
+  std::vector<JobResourceId> m_Reads;
+  /// resources modified by Tick
+  std::vector<JobResourceId> m_Writes;
+  /// whether the system declared its access and can tick on any thread
+  bool m_HasAccessDeclaration = false;
+  /// event handlers subscribed when the system is added
+  std::vector<EventSubscription> m_EventSubscriptions;
 };
 
 /**
@@ -50,6 +116,12 @@ public:
    */
   void SetEventCallback(const std::function<void(Event&)>& callback);
 
+  /**
+   * Sets the queue the systems record their structural changes into
+   * @param commandQueue the command queue of the world
+   */
+  void SetCommandQueue(EntityCommandQueue* commandQueue);
+
   /**
    * Adds a unique custom game system to the list of systems
    * Does not support the adding of the same type more than once
@@ -60,7 +132,13 @@ public:
   {
     static_assert(std::is_base_of<GameSystem, T>::value,
                   "Custom game systems must inherit from GameSystem");
+    system->m_CommandQueue = m_CommandQueue;
+    for (auto&& subscribe : system->m_EventSubscriptions)
+    {
+      subscribe(m_EventBus, system.get());
+    }
     m_GameSystems.emplace_back(std::move(system));
+    m_Schedule.reset();
 
     uint32 typeId = GetUniqueTypeId<T>();
 
@@ -96,23 +174,51 @@ public:
   }
 
   /**
-   * Calls the tick function of all added game systems
+   * Delivers the events queued since the last tick to the systems, then
+   * calls the tick function of all added game systems. The systems which
+   * declared their access tick on a job graph, which runs the systems without
+   * conflicting access concurrently and the rest in the order they were added.
+   * Then the systems without a declaration tick on the calling thread. Every
+   * system records with its index as the sort key, so the commands play back
+   * in the same order however the systems ran.
    * @param deltaSeconds the time passed since last update.
    * Always a fixed 0.040 seconds (25 FPS)
    */
   void Tick(float deltaSeconds);
 
   /**
-   * Calls the OnEvent function of all added game systems
+   * Queues the event for the systems subscribed to its type, they receive it
+   * at the start of the next tick
    * @param event the broadcast event
    */
   void OnEvent(Event& event);
 
 private:
+  /**
+   * Build the job graph of the systems which declared their access
+   */
+  void BuildSchedule();
+
+  /**
+   * Tick a system with the sort key of its commands set
+   * @param index index of the system
+   */
+  void TickSystem(uint32 index);
+
   /// array of custom game systems
   std::vector<std::unique_ptr<GameSystem>> m_GameSystems;
   /// Array which maps unique system id to array index
   std::vector<int32> m_SystemIdToArrayIndex;
+  /// job graph of the declared systems, rebuilt when a system is added
+  std::unique_ptr<JobGraph> m_Schedule;
+  /// indices of the systems without a declaration, ticked serially
+  std::vector<uint32> m_SerialSystems;
+  /// the time passed to the systems ticking on the job graph
+  float m_DeltaSeconds = 0.0f;
+  /// queue the systems record their structural changes into
+  EntityCommandQueue* m_CommandQueue = nullptr;
+  /// the event handlers of the systems
+  EventBus m_EventBus;
 
   /// function pointer to broadcast events
   std::function<void(Event&)> m_EventCallback;
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "ArchetypeManager.h"
 #include "ComponentTraits.h"
+#include "EntityCommandBuffer.h"
 #include "EntityManager.h"
 #include "GameWorld.h"
 
 #include "events/Event.h"
 #include "physics/PhysicsWorld.h"
 #include "rendering/RenderWorld.h"
+#include "scheduler/JobGraph.h"
 
 namespace bge
 {
@@ -33,8 +36,8 @@ public:
   void SetEventCallback(const std::function<void(Event&)>& callback);
 
   /**
-   * Updates the game state by updating the sub-worlds in order and passing
-   * relevant data through the worlds
+   * Updates the game state by executing the update job graph, which runs the
+   * sub-worlds in dependency order and passes relevant data through them
    * @param deltaSeconds the time passed since last update.
    * Always a fixed 0.040 seconds (25 FPS)
    */
@@ -53,24 +56,61 @@ public:
    */
   Entity CreateEntity();
 
+  /**
+   * Create a batch of new entities
+   * @param count number of entities to create
+   * @param output receives count entities
+   */
+  void CreateEntities(uint32 count, Entity* output);
+
   /**
    * Destroy an existing entity
    * @param id the entity to destroy
    */
   void DestroyEntity(Entity entity);
 
+  /**
+   * Destroy a batch of existing entities
+   * @param entities the entities to destroy
+   * @param count number of entities
+   */
+  void DestroyEntities(const Entity* entities, uint32 count);
+
   /**
    * Calls the OnEvent function of all sub-worlds
    * @param event the broadcast event
    */
   void OnEvent(Event& event);
 
+  FORCEINLINE ArchetypeManager& GetArchetypeManager() { return m_Archetypes; }
+  FORCEINLINE EntityCommandQueue& GetCommandQueue() { return m_Commands; }
   FORCEINLINE RenderWorld& GetRenderWorld() { return m_RenderWorld; }
   FORCEINLINE GameWorld& GetGameWorld() { return m_GameWorld; }
   FORCEINLINE PhysicsWorld& GetPhysicsWorld() { return m_PhysicsWorld; }
+  FORCEINLINE const JobGraph& GetUpdateGraph() const { return m_UpdateGraph; }
 
 private:
+  /**
+   * Adds the update jobs of the sub-worlds to the update graph and builds it
+   */
+  void BuildUpdateGraph();
+
+  /**
+   * Sends the entities destroyed since the last update to a sub-world
+   * @param subWorld the world to notify
+   */
+  template <typename SubWorld> void FlushDestroyedEntities(SubWorld& subWorld)
+  {
+    if (!m_DestroyedEntities.empty())
+    {
+      EntitiesDestroyedEvent event(m_DestroyedEntities);
+      subWorld.OnEvent(event);
+    }
+  }
+
   EntityManager m_EntityManager; /**< manager of entities */
+  ArchetypeManager m_Archetypes; /**< components grouped by archetype */
+  EntityCommandQueue m_Commands; /**< changes recorded by game systems */
 
   RenderWorld m_RenderWorld;   /**< the rendering sub-world */
   PhysicsWorld m_PhysicsWorld; /**< the physics sub-world */
@@ -78,6 +118,8 @@ private:
 
   std::vector<Entity> m_DestroyedEntities; /**< list of destroyed entities */
 
+  JobGraph m_UpdateGraph; /**< jobs executed every update */
+
   std::function<void(Event&)> m_EventCallback; /**< event broadcast ptr */
 };
 
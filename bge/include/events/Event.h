@@ -31,6 +31,10 @@ enum class EventType
   CollidedBodies
 };
 
+/// Number of event types, to index arrays by the event type
+constexpr uint32 c_EventTypeCount =
+    static_cast<uint32>(EventType::CollidedBodies) + 1u;
+
 #define EVENT_CLASS_TYPE(type)                                                 \
   static EventType GetStaticType() { return EventType::type; }                 \
   virtual EventType GetEventType() const override { return GetStaticType(); }
@@ -56,8 +60,6 @@ public:
  */
 class EventDispatcher
 {
-  template <typename T> using EventFn = std::function<bool(T&)>;
-
 public:
   explicit EventDispatcher(Event& event)
       : m_Event(event)
@@ -67,14 +69,15 @@ public:
   /**
    * The dispatch function is used to call event handler function safely
    * by ignoring ones which do not match the event type
-   * @param func the event handler function of a specific event type
+   * @param func the event handler function of a specific event type, called
+   * directly instead of through a std::function
    * @return flag whether the event has been dispatched successfully
    */
-  template <typename T> bool Dispatch(EventFn<T> func)
+  template <typename T, typename F> bool Dispatch(const F& func)
   {
     if (m_Event.GetEventType() == T::GetStaticType())
     {
-      m_Event.m_Handled = func(*(T*)&m_Event);
+      m_Event.m_Handled = func(static_cast<T&>(m_Event));
       return true;
     }
     return false;
@@ -0,0 +1,200 @@
+#pragma once
+
+#include "Event.h"
+
+#include <memory>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Splits the type of an event handler member function, eg.
+ * bool (System::*)(KeyPressedEvent&), into its class and event type
+ */
+template <typename Handler> struct EventHandlerTraits;
+
+template <typename C, typename T> struct EventHandlerTraits<bool (C::*)(T&)>
+{
+  using Class = C;  ///< the class of the handler
+  using EventT = T; ///< the event type the handler receives
+};
+
+/// The template arguments of an event handler member function, eg.
+/// bus.Subscribe<BGE_EVENT_HANDLER(System::OnKeyPressed)>(this)
+#define BGE_EVENT_HANDLER(fn) decltype(&fn), &fn
+
+/**
+ * A call to an event handler member function of an instance. Unlike a
+ * std::function of a std::bind it never allocates, and it's 2 pointers which
+ * are cheap to store in subscriber lists.
+ */
+class EventDelegate
+{
+public:
+  /**
+   * @param instance the object whose handler is called
+   * @return the delegate calling the handler Method of the instance
+   */
+  template <typename Handler, Handler Method>
+  static EventDelegate
+  Create(typename EventHandlerTraits<Handler>::Class* instance)
+  {
+    return EventDelegate(instance, &Invoke<Handler, Method>);
+  }
+
+  /**
+   * @param event the event, of the type the handler receives
+   * @return flag whether the handler handled the event
+   */
+  FORCEINLINE bool operator()(Event& event) const
+  {
+    return m_Function(m_Instance, event);
+  }
+
+private:
+  using InvokeFunction = bool (*)(void*, Event&);
+
+  EventDelegate(void* instance, InvokeFunction function)
+      : m_Instance(instance)
+      , m_Function(function)
+  {
+  }
+
+  template <typename Handler, Handler Method>
+  static bool Invoke(void* instance, Event& event)
+  {
+    using Traits = EventHandlerTraits<Handler>;
+    return (static_cast<typename Traits::Class*>(instance)->*Method)(
+        static_cast<typename Traits::EventT&>(event));
+  }
+
+  void* m_Instance;          ///< the object whose handler is called
+  InvokeFunction m_Function; ///< calls the handler on the object
+};
+
+/**
+ * Delivers events to the handlers subscribed to their type. Every event type
+ * has its own list of subscribers, so listeners are never called for events
+ * they aren't interested in. Events can be published immediately or queued
+ * and delivered in a batch per type once a frame, eg:
+ *   bus.Subscribe<BGE_EVENT_HANDLER(System::OnKeyPressed)>(this);
+ *   bus.Enqueue(event);
+ *   bus.DeliverQueued();
+ */
+class EventBus
+{
+public:
+  EventBus();
+
+  DELETE_COPY_AND_ASSIGN(EventBus)
+
+  /**
+   * Subscribe a handler to the events of the type it receives, handlers of
+   * a type are called in the order they subscribed
+   * @param instance the object whose handler is called
+   */
+  template <typename Handler, Handler Method>
+  void Subscribe(typename EventHandlerTraits<Handler>::Class* instance)
+  {
+    using T = typename EventHandlerTraits<Handler>::EventT;
+    const uint32 type = static_cast<uint32>(T::GetStaticType());
+
+    // Only events of subscribed types get queued
+    if (!m_Queues[type])
+    {
+      m_Queues[type] = std::make_unique<EventQueue<T>>();
+    }
+
+    m_Subscribers[type].push_back(
+        EventDelegate::Create<Handler, Method>(instance));
+  }
+
+  /**
+   * Call the subscribers of the event type until one handles the event
+   * @param event the event to deliver
+   */
+  void Publish(Event& event);
+
+  /**
+   * Copy the event to deliver it with the next DeliverQueued, events of types
+   * without subscribers are dropped
+   * @param event the event to queue
+   */
+  void Enqueue(const Event& event);
+
+  /**
+   * Publish the queued events, all events of a type in a row, the types in
+   * the order their first event was queued. Events the handlers queue for a
+   * type which was already delivered wait for the next call.
+   */
+  void DeliverQueued();
+
+  /**
+   * @return number of subscribers of the event type
+   */
+  FORCEINLINE uint32 GetSubscriberCount(EventType type) const
+  {
+    return static_cast<uint32>(
+        m_Subscribers[static_cast<uint32>(type)].size());
+  }
+
+private:
+  /**
+   * The queued events of a single type
+   */
+  class EventQueueBase
+  {
+  public:
+    virtual ~EventQueueBase() = default;
+
+    /**
+     * Copy an event of the type of the queue to the end of the queue
+     */
+    virtual void Push(const Event& event) = 0;
+
+    /**
+     * Publish the queued events and clear the queue, keeping its memory
+     */
+    virtual void Deliver(EventBus& bus) = 0;
+
+    virtual bool IsEmpty() const = 0;
+  };
+
+  template <typename T> class EventQueue : public EventQueueBase
+  {
+  public:
+    void Push(const Event& event) override
+    {
+      m_Events.push_back(static_cast<const T&>(event));
+    }
+
+    void Deliver(EventBus& bus) override
+    {
+      // Handlers may queue events of the same type, they go to m_Events
+      m_Delivered.swap(m_Events);
+      for (auto&& event : m_Delivered)
+      {
+        bus.Publish(event);
+      }
+      m_Delivered.clear();
+    }
+
+    bool IsEmpty() const override { return m_Events.empty(); }
+
+  private:
+    std::vector<T> m_Events;    ///< events waiting for the next delivery
+    std::vector<T> m_Delivered; ///< events of the current delivery
+  };
+
+  /// handlers of each event type
+  std::vector<EventDelegate> m_Subscribers[c_EventTypeCount];
+  /// queue of each subscribed event type
+  std::unique_ptr<EventQueueBase> m_Queues[c_EventTypeCount];
+  /// types with queued events in the order their first event was queued
+  std::vector<uint32> m_QueuedTypes;
+  /// types of the current delivery
+  std::vector<uint32> m_DeliveredTypes;
+};
+
+} // namespace bge
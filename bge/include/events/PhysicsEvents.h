@@ -8,7 +8,8 @@ namespace bge
 {
 
 /**
- * Event which represents the collided bodies in a single game state update
+ * Event which represents the contact pairs which began, persisted or ended in a
+ * single game state update
  */
 class EntitiesCollidedEvent : public Event
 {
@@ -23,7 +24,7 @@ public:
   EVENT_CLASS_TYPE(CollidedBodies)
 
 private:
-  CollidedBodies m_CollidedBodies; /**< The collided bodies of the update */
+  CollidedBodies m_CollidedBodies; /**< The contact pairs of the update */
 };
 
 } // namespace bge
\ No newline at end of file
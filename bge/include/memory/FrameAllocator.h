@@ -0,0 +1,96 @@
+#pragma once
+
+#include "LinearAllocator.h"
+
+#include "core/Common.h"
+
+namespace bge
+{
+
+/// Initial size of the blocks of the frame allocators of every thread, they
+/// grow to fit the busiest frame
+constexpr size_t c_DefaultFrameAllocatorCapacity = 64u * 1024u;
+
+/**
+ * Allocation statistics of the frame allocators of all threads
+ */
+struct FrameAllocatorStats
+{
+  uint64 m_FrameBytes;      ///< bytes allocated in the last frame
+  uint64 m_PeakFrameBytes;  ///< most bytes allocated in any frame
+  uint64 m_CapacityBytes;   ///< summed size of all blocks
+  uint32 m_HeapAllocations; ///< allocations of the last frame which didn't
+                            ///< fit in their block and went to the heap
+  uint32 m_FrameCount;      ///< frames since initialization
+};
+
+/**
+ * Per-thread linear allocators for temporary data of a frame, which is freed
+ * all at once when the next frame starts. Every worker thread of the
+ * scheduler allocates from its own allocators, so allocating never locks.
+ * Data which must survive into the next frame, eg. to render it, goes to the
+ * double buffered allocators, which are freed one frame later. eg:
+ *   LinearVector<Mat4f> matrices = FrameAllocator::CreateVector<Mat4f>();
+ */
+namespace FrameAllocator
+{
+
+/**
+ * Initialize the allocators of every worker, called after the scheduler is
+ * initialized
+ * @param capacity initial size in bytes of the block of each allocator
+ */
+void Initialize(size_t capacity = c_DefaultFrameAllocatorCapacity);
+
+/**
+ * Shutdown the allocators, called before the scheduler shuts down
+ */
+void Shutdown();
+
+/**
+ * Free the memory of the frame that ended and the double buffered memory of
+ * the frame before it. Must not run while other threads allocate.
+ */
+void NextFrame();
+
+/**
+ * @return the allocator of the calling worker, its memory is valid until the
+ * next NextFrame
+ */
+LinearAllocator& GetAllocator();
+
+/**
+ * @return the double buffered allocator of the calling worker, its memory is
+ * valid until the second NextFrame from now
+ */
+LinearAllocator& GetDoubleBufferedAllocator();
+
+/**
+ * @return statistics of the allocators of all workers
+ */
+const FrameAllocatorStats& GetStats();
+
+/**
+ * Logs the statistics of the last frame
+ */
+void LogStats();
+
+/**
+ * @return an empty vector in the memory of the calling worker's allocator
+ */
+template <typename T> LinearVector<T> CreateVector()
+{
+  return LinearVector<T>(LinearStlAllocator<T>(GetAllocator()));
+}
+
+/**
+ * @return an empty vector in the memory of the calling worker's double
+ * buffered allocator
+ */
+template <typename T> LinearVector<T> CreateDoubleBufferedVector()
+{
+  return LinearVector<T>(LinearStlAllocator<T>(GetDoubleBufferedAllocator()));
+}
+
+} // namespace FrameAllocator
+} // namespace bge
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "core/Common.h"
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * A bump allocator which hands out memory from a single block and frees all
+ * of it at once on Reset. Allocations which don't fit in the block go to the
+ * heap, and the next Reset grows the block to fit everything allocated since
+ * the last one, so a steady workload stops touching the heap after the first
+ * Reset. Owned by a single thread.
+ */
+class LinearAllocator
+{
+public:
+  /**
+   * @param capacity size in bytes of the initial block
+   */
+  explicit LinearAllocator(size_t capacity = 0);
+
+  DELETE_COPY_AND_ASSIGN(LinearAllocator)
+
+  /**
+   * @param size number of bytes to allocate
+   * @param alignment alignment of the memory, a power of 2
+   * @return the memory, valid until the next Reset
+   */
+  void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+  /**
+   * @param count number of elements of the array
+   * @return uninitialized memory for the array, valid until the next Reset
+   */
+  template <typename T> T* AllocateArray(size_t count)
+  {
+    return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  /**
+   * Free all allocations, growing the block if they didn't fit in it
+   */
+  void Reset();
+
+  /**
+   * @return bytes allocated since the last Reset, including alignment
+   */
+  FORCEINLINE uint64 GetUsedBytes() const
+  {
+    return m_Offset + m_OverflowBytes;
+  }
+
+  /**
+   * @return most bytes allocated between 2 Resets
+   */
+  FORCEINLINE uint64 GetPeakBytes() const { return m_PeakBytes; }
+
+  /**
+   * @return size of the block in bytes
+   */
+  FORCEINLINE uint64 GetCapacity() const { return m_Capacity; }
+
+  /**
+   * @return number of allocations since the last Reset which went to the heap
+   */
+  FORCEINLINE uint32 GetOverflowCount() const
+  {
+    return static_cast<uint32>(m_OverflowBlocks.size());
+  }
+
+private:
+  /**
+   * Allocate memory which doesn't fit in the block on the heap
+   */
+  void* AllocateOverflow(size_t size, size_t alignment);
+
+  std::unique_ptr<uint8[]> m_Buffer; ///< the block allocations are taken from
+  size_t m_Capacity;                 ///< size of the block
+  size_t m_Offset;                   ///< bytes of the block in use
+  size_t m_OverflowBytes;            ///< bytes allocated on the heap
+  size_t m_PeakBytes;                ///< most bytes used between 2 Resets
+  /// heap allocations since the last Reset
+  std::vector<std::unique_ptr<uint8[]>> m_OverflowBlocks;
+};
+
+/**
+ * Adapter to use a LinearAllocator with STL containers. Deallocation does
+ * nothing, the memory is freed when the allocator resets, so containers must
+ * not outlive the Reset.
+ */
+template <typename T> class LinearStlAllocator
+{
+public:
+  using value_type = T;
+  // Containers take the allocator of the container they're moved from, so
+  // they keep pointing to its memory instead of copying the elements
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit LinearStlAllocator(LinearAllocator& allocator)
+      : m_Allocator(&allocator)
+  {
+  }
+
+  template <typename U>
+  LinearStlAllocator(const LinearStlAllocator<U>& other)
+      : m_Allocator(other.GetAllocator())
+  {
+  }
+
+  T* allocate(size_t count) { return m_Allocator->AllocateArray<T>(count); }
+  void deallocate(T*, size_t) {}
+
+  FORCEINLINE LinearAllocator* GetAllocator() const { return m_Allocator; }
+
+  template <typename U> bool operator==(const LinearStlAllocator<U>& rhs) const
+  {
+    return m_Allocator == rhs.GetAllocator();
+  }
+  template <typename U> bool operator!=(const LinearStlAllocator<U>& rhs) const
+  {
+    return m_Allocator != rhs.GetAllocator();
+  }
+
+private:
+  LinearAllocator* m_Allocator; ///< the allocator the memory comes from
+};
+
+/// A vector in the memory of a LinearAllocator
+template <typename T>
+using LinearVector = std::vector<T, LinearStlAllocator<T>>;
+
+} // namespace bge
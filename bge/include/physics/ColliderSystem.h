@@ -2,12 +2,11 @@
 
 #include "PhysicsDevice.h"
 
+#include "ecs/ComponentStorage.h"
 #include "ecs/Entity.h"
 #include "events/ECSEvents.h"
 #include "math/Transform.h"
 
-#include <unordered_map>
-
 namespace bge
 {
 
@@ -47,7 +46,7 @@ public:
    */
   FORCEINLINE const std::vector<Transform>& GetBodyTransforms() const
   {
-    return m_BodyTransforms;
+    return m_Colliders.GetColumn<c_TransformColumn>();
   }
 
   /**
@@ -64,14 +63,13 @@ private:
   bool OnEntitiesDestroyed(EntitiesDestroyedEvent& event);
 
 private:
-  // Map of entity's Id to the array index of the vectors
-  std::unordered_map<uint32, uint32> m_EntityToComponentId;
-  // Vector of all entities which have a collider
-  std::vector<Entity> m_Entities;
-  // Vector of the collider types for every collider allocated
-  std::vector<ColliderType> m_ColliderTypes;
-  // Vector of the transforms of each collider
-  std::vector<Transform> m_BodyTransforms;
+  static constexpr uint32 c_TypeColumn = 0u;
+  static constexpr uint32 c_TransformColumn = 1u;
+
+  // The type and the transform of every collider
+  ComponentStorage<ColliderType, Transform> m_Colliders;
+  // The entities of a destroyed batch which have a collider
+  std::vector<Entity> m_DestroyedEntities;
 };
 
 } // namespace bge
\ No newline at end of file
@@ -2,11 +2,21 @@
 
 #include "core/Common.h"
 #include "ecs/Entity.h"
+#include "ecs/EntityIndex.h"
 #include "math/Transform.h"
+#include "memory/FrameAllocator.h"
 
 namespace bge
 {
 
+/**
+ * Maximum number of box and sphere colliders together. nudge's broadphase packs
+ * collider indices into 13 bits and its contacts store 16 bit body indices, so
+ * larger worlds need a broadphase with wider pair indices (or multiple nudge
+ * worlds). Storage below the limit grows on demand.
+ */
+constexpr uint32 c_MaxPhysicsColliderCount = 1u << 13;
+
 /**
  * Enum of the currently supported collider types
  */
@@ -17,21 +27,95 @@ enum ColliderType
 };
 
 /**
- * Pair of bodies used for collision
+ * How the contact between 2 colliders changed since the previous Simulate
+ */
+enum class ContactState : uint8
+{
+  Begin,   ///< the colliders started touching
+  Persist, ///< the colliders were touching already
+  End      ///< the colliders stopped touching (or one of them got destroyed)
+};
+
+/**
+ * Pair of colliders which are touching, or stopped touching
  */
-struct BodyPair
+struct ContactPair
 {
-  uint16 m_BodyA{0};
-  uint16 m_BodyB{0};
+  uint32 m_ColliderTags; ///< nudge collider tags, the larger in the low bits
+  ContactState m_State;  ///< how the contact changed since the last Simulate
+};
+
+/**
+ * View over the contact pairs of the last simulation step, sorted by their
+ * collider tags. The pairs and the entity table are owned by the physics
+ * device and reused by the next Simulate, so the view must not be stored.
+ */
+class CollidedBodies
+{
+public:
+  CollidedBodies()
+      : m_Pairs(nullptr)
+      , m_Count(0)
+      , m_TagEntities(nullptr)
+  {
+  }
+
+  CollidedBodies(const ContactPair* pairs, uint32 count,
+                 const Entity* tagEntities)
+      : m_Pairs(pairs)
+      , m_Count(count)
+      , m_TagEntities(tagEntities)
+  {
+  }
+
+  /**
+   * @return number of contact pairs in the report
+   */
+  FORCEINLINE uint32 GetCount() const { return m_Count; }
+
+  /**
+   * @param pair index of the pair in [0, GetCount())
+   * @return how the contact changed since the previous Simulate
+   */
+  FORCEINLINE ContactState GetState(uint32 pair) const
+  {
+    return m_Pairs[pair].m_State;
+  }
+
+  /**
+   * @param pair index of the pair in [0, GetCount())
+   * @return the entity of the first collider
+   */
+  FORCEINLINE Entity GetEntityA(uint32 pair) const
+  {
+    return m_TagEntities[m_Pairs[pair].m_ColliderTags & 0xffff];
+  }
+
+  /**
+   * @param pair index of the pair in [0, GetCount())
+   * @return the entity of the second collider
+   */
+  FORCEINLINE Entity GetEntityB(uint32 pair) const
+  {
+    return m_TagEntities[m_Pairs[pair].m_ColliderTags >> 16];
+  }
+
+private:
+  const ContactPair* m_Pairs;  ///< the pairs of the last Simulate
+  uint32 m_Count;              ///< number of pairs
+  const Entity* m_TagEntities; ///< entity of each collider tag
 };
 
 /**
- * Stores all collided bodies from a simulation step
+ * Memory used by the physics device
  */
-struct CollidedBodies
+struct PhysicsMemoryStats
 {
-  BodyPair* m_Bodies{nullptr};
-  uint32 m_Count{0};
+  uint32 m_BodyCapacity;     ///< bodies which fit without reallocating
+  uint32 m_ColliderCapacity; ///< boxes and spheres which fit without growing
+  uint32 m_ContactCapacity;  ///< contacts which fit in a single step
+  uint64 m_ArenaSize;        ///< bytes of the temporary memory of a step
+  uint64 m_ArenaPeakUsage;   ///< most temporary bytes a step ever used
 };
 
 namespace PhysicsDevice
@@ -44,9 +128,16 @@ void Initialize();
 
 /**
  * Step through the physics simulation
+ * @return the contact pairs which began, persisted or ended during the step,
+ * valid until the next Simulate
  */
 CollidedBodies Simulate();
 
+/**
+ * @return the current capacities and temporary memory usage
+ */
+PhysicsMemoryStats GetMemoryStats();
+
 /**
  * Set the gravity value
  * @param gravity the new gravity value
@@ -83,6 +174,14 @@ void DestroyBoxCollider(Entity entity);
  */
 void DestroySphereCollider(Entity entity);
 
+/**
+ * Destroy the colliders of a batch of entities in one pass per collider type.
+ * The entities must not have bodies, those are destroyed with DestroyBodies.
+ * @param entities the entities, which may or may not have a collider
+ * @param count number of entities
+ */
+void DestroyColliders(const Entity* entities, uint32 count);
+
 // uint32 MakeBoxBody(uint32 entityId, float mass, float cx, float cy, float
 // cz); uint32 MakeSphereBody(uint32 entityId, float mass, float radius);
 
@@ -116,6 +215,16 @@ void DestroyBox(Entity entity);
  */
 void DestroySphere(Entity entity);
 
+/**
+ * Destroy the rigidbodies of a batch of entities and their colliders, in one
+ * compaction pass over the bodies. Unlike DestroyBox and DestroySphere the
+ * remaining bodies keep their order in GetBodyIndex(), the same order
+ * EntityIndex::RemoveBatch leaves behind.
+ * @param entities the entities, which may or may not have a rigidbody
+ * @param count number of entities
+ */
+void DestroyBodies(const Entity* entities, uint32 count);
+
 /**
  * Set the position of a physics body
  * @param entity the entity which the body is mapped to
@@ -174,6 +283,35 @@ void SetSphereColliderRadius(Entity entity, float radius);
  */
 void GetBodyTransform(Entity entity, Transform& output);
 
+/**
+ * @return the entities with a body, in the order of the bodies. Systems which
+ * keep per-body data use these indices and mirror the swap of removals.
+ */
+const EntityIndex& GetBodyIndex();
+
+/**
+ * Copy the transforms of a range of bodies, in the order of GetBodyIndex()
+ * @param first the index of the first body
+ * @param count number of bodies to copy
+ * @param output receives count transforms, only translation and rotation are
+ * written
+ */
+void GetBodyTransforms(uint32 first, uint32 count, Transform* output);
+
+/**
+ * Write the model matrices of a range of bodies, in the order of
+ * GetBodyIndex(). Only bodies which moved since their last export are written,
+ * so the matrices of sleeping bodies cost nothing. Different threads may
+ * export disjoint ranges at the same time.
+ * @param first the index of the first body
+ * @param count number of bodies
+ * @param scales the scale of each body of the range
+ * @param output the matrices of the range, kept from the previous export
+ * @return the number of matrices which were written
+ */
+uint32 ExportBodyMatrices(uint32 first, uint32 count, const Vec3f* scales,
+                          Mat4f* output);
+
 /**
  * Get the box collider scale of an entity
  * @param entity the entity which the collider is mapped to
@@ -189,14 +327,16 @@ Vec3f GetBoxColliderScale(Entity entity);
 float GetSphereColliderRadius(Entity entity);
 
 /**
- * @return get all allocated box collider transforms
+ * @return get all allocated box collider transforms, in the memory of the
+ * frame allocator
  */
-std::vector<Mat4f> GetAllBoxColliderTransforms();
+LinearVector<Mat4f> GetAllBoxColliderTransforms();
 
 /**
- * @return get all allocated sphere collider transforms
+ * @return get all allocated sphere collider transforms, in the memory of the
+ * frame allocator
  */
-std::vector<Mat4f> GetAllSphereColliderTransforms();
+LinearVector<Mat4f> GetAllSphereColliderTransforms();
 
 } // namespace PhysicsDevice
 } // namespace bge
@@ -2,23 +2,25 @@
 
 #include "PhysicsDevice.h"
 
+#include "ecs/ComponentStorage.h"
 #include "ecs/Entity.h"
 #include "events/ECSEvents.h"
 #include "math/Transform.h"
 
-#include <unordered_map>
-
 namespace bge
 {
 
 /**
- * System which handles rigid bodies
+ * System which handles rigid bodies. The components are added and removed
+ * like the physics device's bodies, which keeps them in the same order as
+ * PhysicsDevice::GetBodyIndex(), so every body of the device must be created
+ * through this system.
  */
 class RigidBodySystem
 {
 public:
   /**
-   * Updates the array of transforms to match the physics world
+   * Updates the model matrices of the bodies which moved in the physics world
    */
   void UpdateTransforms();
 
@@ -69,12 +71,20 @@ public:
   void AddBodyVelocity(Entity entity, const Vec3f& amountToAdd);
 
   /**
-   * Getter for all the transforms of the allocated colliders
-   * @return the vector of transforms
+   * @return true if the entity has a rigidbody
    */
-  FORCEINLINE const std::vector<Transform>& GetBodyTransforms() const
+  FORCEINLINE bool HasRigidBody(Entity entity) const
   {
-    return m_BodyTransforms;
+    return m_Bodies.Contains(entity);
+  }
+
+  /**
+   * Getter for the model matrices of all bodies, in body order
+   * @return the vector of matrices
+   */
+  FORCEINLINE const std::vector<Mat4f>& GetBodyMatrices() const
+  {
+    return m_Bodies.GetColumn<c_MatrixColumn>();
   }
 
   /**
@@ -91,14 +101,12 @@ private:
   bool OnEntitiesDestroyed(EntitiesDestroyedEvent& event);
 
 private:
-  // Map of entity's Id to the array index of the vectors
-  std::unordered_map<uint32, uint32> m_EntityToComponentId;
-  // Vector of all entities which have a rigidbody
-  std::vector<Entity> m_Entities;
-  // Vector of the collider types for every body allocated
-  std::vector<ColliderType> m_ColliderTypes;
-  // Vector of the transforms of each collider
-  std::vector<Transform> m_BodyTransforms;
+  static constexpr uint32 c_TypeColumn = 0u;
+  static constexpr uint32 c_ScaleColumn = 1u;
+  static constexpr uint32 c_MatrixColumn = 2u;
+
+  // The collider type, the collider scale and the model matrix of every body
+  ComponentStorage<ColliderType, Vec3f, Mat4f> m_Bodies;
 };
 
 } // namespace bge
@@ -1,14 +1,15 @@
 #pragma once
 
+#include "FrustumCuller.h"
+#include "InstancedMeshRenderer.h"
 #include "Material.h"
 #include "Mesh.h"
 
+#include "ecs/ComponentStorage.h"
 #include "ecs/Entity.h"
 #include "events/ECSEvents.h"
 #include "math/Transform.h"
 
-#include <unordered_map>
-
 namespace bge
 {
 
@@ -41,11 +42,18 @@ public:
   void UpdateTransforms(const std::vector<Transform>& transforms);
 
   /**
-   * Renders the existing meshes in the system from the POV of the input camera
-   * @param projection the camera's projection matrix
-   * @param view the camera's view matrix
+   * Update the internal transforms of the meshes to matrices from outside
+   * @param matrices array of model matrices to be linearly copied
    */
-  void RenderMeshes(const Mat4f& projection, const Mat4f& view);
+  void UpdateTransforms(const std::vector<Mat4f>& matrices);
+
+  /**
+   * Submits the meshes in the system which are inside the frustum of a
+   * camera to its render queue
+   * @param queue the render queue of the camera
+   * @param frustum the frustum of the camera
+   */
+  void SubmitMeshes(RenderQueue& queue, const Frustum& frustum);
 
   /**
    * Allocates a new component instance mapped to the passed entity
@@ -80,10 +88,17 @@ private:
   bool OnEntitiesDestroyed(EntitiesDestroyedEvent& event);
 
 private:
-  std::unordered_map<uint32, uint32> m_EntityToComponentId;
-  std::vector<DynamicMeshData> m_Meshes;
-  std::vector<Mat4f> m_Transforms;
-  std::vector<Entity> m_Entities;
+  static constexpr uint32 c_MeshColumn = 0u;
+  static constexpr uint32 c_TransformColumn = 1u;
+
+  // The mesh data and the model matrix of every entity
+  ComponentStorage<DynamicMeshData, Mat4f> m_Meshes;
+  // Draws the meshes in batches of the same mesh and material
+  InstancedMeshRenderer m_Renderer;
+  // Culls the meshes outside of a camera's view
+  FrustumCuller m_Culler;
+  // The meshes inside of the last culled frustum
+  std::vector<uint32> m_VisibleInstances;
   std::function<void(Event&)> m_EventCallback;
 };
 
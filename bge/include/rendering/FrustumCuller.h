@@ -0,0 +1,125 @@
+#pragma once
+
+#include "Mesh.h"
+
+#include "math/Mat.h"
+#include "scheduler/ParallelFor.h"
+
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * The planes of a camera's view volume in world space. A point p is on the
+ * inner side of a plane when dot(plane.xyz, p) + plane.w >= 0.
+ */
+struct Frustum
+{
+  Vec4f m_Planes[6]; /**< left, right, bottom, top, near and far planes */
+};
+
+/**
+ * Extracts the world space frustum of a camera from its matrices
+ * @param projection the camera's projection matrix
+ * @param view the camera's view matrix
+ * @return the frustum of the camera
+ */
+Frustum ExtractFrustum(const Mat4f& projection, const Mat4f& view);
+
+/**
+ * Culls the instances of a mesh system against camera frustums. The world
+ * space bounding boxes of the instances are kept as SoA, a center and an
+ * extent array per axis, so a frustum plane is tested against 8 boxes with AVX
+ * (4 with SSE) per instruction. The boxes are recomputed only when the
+ * instances change, large sets are culled in parallel tasks.
+ */
+class FrustumCuller
+{
+public:
+  FrustumCuller();
+
+  /**
+   * Marks the bounding boxes as outdated, called when instances are added,
+   * removed, moved or may have changed their mesh
+   */
+  FORCEINLINE void Invalidate() { m_IsValid = false; }
+
+  /**
+   * Recomputes the world space bounding boxes of the instances, if outdated
+   * @param instances the mesh data of every instance, with a m_Mesh
+   * @param getTransform returns the model matrix of an instance index
+   */
+  template <typename MeshData, typename GetTransform>
+  void UpdateBounds(const std::vector<MeshData>& instances,
+                    const GetTransform& getTransform)
+  {
+    if (m_IsValid)
+    {
+      return;
+    }
+
+    const uint32 count = static_cast<uint32>(instances.size());
+    Resize(count);
+
+    ParallelFor(0u, count, c_BoundsGrainSize, [&](uint32 i) {
+      const Mesh& mesh = instances[i].m_Mesh;
+      SetBounds(i, getTransform(i), mesh.m_BoundsCenter, mesh.m_BoundsExtents);
+    });
+
+    m_IsValid = true;
+  }
+
+  /**
+   * Tests the bounding boxes of the instances against a frustum
+   * @param frustum the camera's frustum
+   * @param visibleInstances filled with the indices of the instances whose box
+   * is at least partly inside the frustum, in ascending order
+   */
+  void Cull(const Frustum& frustum, std::vector<uint32>& visibleInstances);
+
+private:
+  /// Number of bounding boxes transformed by a single task
+  static constexpr uint32 c_BoundsGrainSize = 256u;
+
+  /**
+   * Sets the number of bounding boxes, the arrays are padded to a whole
+   * number of SIMD lanes
+   * @param count the number of instances
+   */
+  void Resize(uint32 count);
+
+  /**
+   * Transforms the local bounding box of an instance's mesh to world space
+   * @param index the index of the instance
+   * @param transform the model matrix of the instance
+   * @param center the center of the local bounding box
+   * @param extents the half sizes of the local bounding box
+   */
+  void SetBounds(uint32 index, const Mat4f& transform, const Vec3f& center,
+                 const Vec3f& extents);
+
+  /**
+   * Tests the bounding boxes in [begin, end) against a frustum
+   * @param frustum the camera's frustum
+   * @param begin the first box, a multiple of the SIMD lane count
+   * @param end one past the last box
+   * @param visibleInstances receives the indices of the visible boxes, it
+   * must have room for end - begin indices
+   * @return the number of visible boxes
+   */
+  uint32 CullRange(const Frustum& frustum, uint32 begin, uint32 end,
+                   uint32* visibleInstances) const;
+
+  std::vector<float> m_CenterX;        /**< World space centers on x */
+  std::vector<float> m_CenterY;        /**< World space centers on y */
+  std::vector<float> m_CenterZ;        /**< World space centers on z */
+  std::vector<float> m_ExtentX;        /**< World space half sizes on x */
+  std::vector<float> m_ExtentY;        /**< World space half sizes on y */
+  std::vector<float> m_ExtentZ;        /**< World space half sizes on z */
+  std::vector<uint32> m_ChunkVisibles; /**< Visible boxes of each chunk */
+  uint32 m_Count;                      /**< The number of boxes */
+  bool m_IsValid;                      /**< Flag whether boxes are current */
+};
+
+} // namespace bge
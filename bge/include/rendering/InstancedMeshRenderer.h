@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Material.h"
+#include "Mesh.h"
+#include "RenderQueue.h"
+
+#include "math/Mat.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Instances which share a mesh and a material
+ */
+struct MeshBatch
+{
+  Mesh m_Mesh;         /**< The mesh of the instances */
+  Material m_Material; /**< The material of the instances */
+};
+
+/**
+ * Submits the instances of a mesh system with one instanced draw packet for
+ * each unique pair of mesh and material. The instances are grouped only when
+ * they change, every frame just groups the visible instances by batch and
+ * gathers their model matrices into the render queue.
+ */
+class InstancedMeshRenderer
+{
+public:
+  InstancedMeshRenderer();
+
+  /**
+   * Marks the batches as outdated, called when instances are added, removed
+   * or may have changed their mesh or material
+   */
+  FORCEINLINE void Invalidate() { m_IsValid = false; }
+
+  /**
+   * Regroups the instances into batches, if they are outdated
+   * @param instances the mesh data of every instance, with a m_Mesh and a
+   * m_Material
+   */
+  template <typename MeshData>
+  void UpdateBatches(const std::vector<MeshData>& instances)
+  {
+    if (m_IsValid)
+    {
+      return;
+    }
+
+    m_Instances.resize(instances.size());
+    std::iota(m_Instances.begin(), m_Instances.end(), 0u);
+
+    // Equal meshes and materials become neighbours, in the order they were
+    // added in, so the batches are the same every time
+    std::sort(m_Instances.begin(), m_Instances.end(),
+              [&instances](uint32 lhs, uint32 rhs) {
+                const int32 order = CompareBatches(
+                    instances[lhs].m_Mesh, instances[lhs].m_Material,
+                    instances[rhs].m_Mesh, instances[rhs].m_Material);
+                return order < 0 || (order == 0 && lhs < rhs);
+              });
+
+    m_Batches.clear();
+    m_InstanceBatches.resize(instances.size());
+    for (uint32 i = 0; i < m_Instances.size(); ++i)
+    {
+      const MeshData& instance = instances[m_Instances[i]];
+
+      if (m_Batches.empty() ||
+          CompareBatches(m_Batches.back().m_Mesh, m_Batches.back().m_Material,
+                         instance.m_Mesh, instance.m_Material) != 0)
+      {
+        m_Batches.push_back(MeshBatch{instance.m_Mesh, instance.m_Material});
+      }
+      m_InstanceBatches[m_Instances[i]] =
+          static_cast<uint32>(m_Batches.size() - 1);
+    }
+
+    m_IsValid = true;
+  }
+
+  /**
+   * Submits an instanced draw of every batch with visible instances to a
+   * render queue
+   * @param queue the render queue of the camera
+   * @param visibleInstances the indices of the instances the camera sees
+   * @param getTransform returns the model matrix of an instance index
+   */
+  template <typename GetTransform>
+  void Submit(RenderQueue& queue, const std::vector<uint32>& visibleInstances,
+              const GetTransform& getTransform)
+  {
+    BGE_CORE_ASSERT(m_IsValid, "Submitting outdated mesh batches");
+
+    // Counting sort of the visible instances by their batch, afterwards the
+    // offset of a batch is the end of its instances
+    m_BatchOffsets.assign(m_Batches.size(), 0u);
+    for (uint32 instance : visibleInstances)
+    {
+      ++m_BatchOffsets[m_InstanceBatches[instance]];
+    }
+
+    uint32 offset = 0;
+    for (uint32& batchOffset : m_BatchOffsets)
+    {
+      const uint32 count = batchOffset;
+      batchOffset = offset;
+      offset += count;
+    }
+
+    m_VisibleByBatch.resize(visibleInstances.size());
+    for (uint32 instance : visibleInstances)
+    {
+      m_VisibleByBatch[m_BatchOffsets[m_InstanceBatches[instance]]++] =
+          instance;
+    }
+
+    uint32 batchBegin = 0;
+    for (uint32 i = 0; i < m_Batches.size(); ++i)
+    {
+      const MeshBatch& batch = m_Batches[i];
+      const uint32 batchEnd = m_BatchOffsets[i];
+      const uint32 instanceCount = batchEnd - batchBegin;
+
+      if (instanceCount == 0)
+      {
+        continue;
+      }
+
+      // The instances of a batch are at many depths, it sorts by state only
+      const RenderSortKey sortKey = queue.MakeSortKey(
+          c_OpaqueViewLayer, batch.m_Mesh, batch.m_Material, 0.0f);
+      Mat4f* transforms = queue.Submit(sortKey, batch.m_Mesh, batch.m_Material,
+                                       instanceCount);
+
+      for (uint32 j = 0; j < instanceCount; ++j)
+      {
+        transforms[j] = getTransform(m_VisibleByBatch[batchBegin + j]);
+      }
+      batchBegin = batchEnd;
+    }
+  }
+
+  /**
+   * @return the largest number of draw packets of a submit
+   */
+  FORCEINLINE uint32 GetBatchCount() const
+  {
+    return static_cast<uint32>(m_Batches.size());
+  }
+
+private:
+  /**
+   * Orders batches by their mesh and material
+   * @return less than 0 if the lhs batch comes first, 0 if they're the same
+   * batch, more than 0 if the rhs batch comes first
+   */
+  static int32 CompareBatches(const Mesh& lhsMesh, const Material& lhsMaterial,
+                              const Mesh& rhsMesh,
+                              const Material& rhsMaterial);
+
+  std::vector<MeshBatch> m_Batches;      /**< The batches in submit order */
+  std::vector<uint32> m_Instances;       /**< Instances sorted by batch */
+  std::vector<uint32> m_InstanceBatches; /**< The batch of each instance */
+  std::vector<uint32> m_BatchOffsets;    /**< Visible instances per batch */
+  std::vector<uint32> m_VisibleByBatch;  /**< Visible instances by batch */
+  bool m_IsValid;                        /**< Whether the batches are current */
+};
+
+} // namespace bge
@@ -13,7 +13,10 @@ struct Mesh
   VertexArrayHandle m_VertexArray;
   VertexBufferHandle m_VertexBuffer;
   IndexBufferHandle m_IndexBuffer;
+  VertexBufferHandle m_InstanceBuffer;
   uint16 m_IndicesCount;
+  Vec3f m_BoundsCenter;  /**< Center of the vertices bounding box */
+  Vec3f m_BoundsExtents; /**< Half sizes of the vertices bounding box */
 };
 
 } // namespace bge
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "core/Common.h"
+
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Counts of the commands recorded by the null render device
+ */
+struct RenderDeviceStats
+{
+  uint64 m_DrawCalls;          ///< indexed and wireframe draw calls
+  uint64 m_DrawnInstances;     ///< instances of all draw calls
+  uint64 m_DrawnIndices;       ///< indices of all instances of all draw calls
+  uint64 m_Binds;              ///< binds of vertex arrays, index buffers,
+                               ///< shader programs and textures
+  uint64 m_UniformUploads;     ///< uniform uploads
+  uint64 m_UploadedBytes;      ///< bytes of buffer, texture and uniform data
+  uint64 m_StateChanges;       ///< clears, viewport and pipeline states
+  uint64 m_CreatedResources;   ///< buffers, arrays, shaders, textures created
+  uint64 m_DestroyedResources; ///< resources destroyed
+};
+
+/**
+ * The render device functions recorded in a command trace
+ */
+enum class RenderCommandType : uint32
+{
+  SetClearColor,
+  ClearBuffers,
+  SetDepthTesting,
+  SetBlend,
+  SetCulling,
+  SetViewport,
+  CreateVertexArray,
+  DestroyVertexArray,
+  BindVertexArray,
+  CreateVertexBuffer,
+  UpdateVertexBuffer,
+  DestroyVertexBuffer,
+  CreateIndexBuffer,
+  DestroyIndexBuffer,
+  BindIndexBuffer,
+  CreateShaderProgram,
+  DestroyShaderProgram,
+  BindShaderProgram,
+  SetUniform,
+  CreateUniformBuffer,
+  UpdateUniformBuffer,
+  DestroyUniformBuffer,
+  BindUniformBuffer,
+  CreateTexture2D,
+  DestroyTexture2D,
+  BindTexture2D,
+  Draw,
+  DrawInstanced,
+  DrawWireframeLines,
+  Count
+};
+
+/**
+ * A command of the trace recorded by the null render device
+ */
+struct RenderCommand
+{
+  RenderCommandType m_Type; ///< the device function which was called
+  uint32 m_Argument;        ///< index of the handle the command takes, the
+                            ///< instances of instanced draws, or the flags of
+                            ///< state changes
+  uint64 m_Size;            ///< bytes uploaded or indices drawn
+};
+
+/**
+ * The render device used when the engine is built with
+ * BGE_NULL_RENDER_DEVICE. It implements the RenderDevice interface without a
+ * graphics context: every call is accepted, handles are validated like on the
+ * OpenGL device, and the commands are counted instead of drawn, so the frame
+ * loop can run and be profiled on machines without a GPU or display.
+ */
+namespace NullRenderDevice
+{
+
+/**
+ * @return the commands recorded since the last ResetStats
+ */
+const RenderDeviceStats& GetStats();
+
+/**
+ * Clear the recorded commands
+ */
+void ResetStats();
+
+/**
+ * Logs the recorded commands, averaged over a number of frames
+ * @param frameCount the frames the commands were recorded in
+ */
+void LogStats(uint32 frameCount);
+
+/**
+ * Clear the command trace and start recording every command into it. The
+ * trace is kept until the next StartTrace, so starting it at the beginning of
+ * every frame keeps the commands of the last frame.
+ */
+void StartTrace();
+
+/**
+ * Stop recording commands into the trace
+ */
+void StopTrace();
+
+/**
+ * @return the commands recorded since the last StartTrace
+ */
+const std::vector<RenderCommand>& GetTrace();
+
+/**
+ * Write the command trace to a text file, a command per line, so the traces of
+ * two runs can be compared with diff
+ * @param filepath the file to write
+ * @return true if the file was written
+ */
+bool SaveTrace(const char* filepath);
+
+} // namespace NullRenderDevice
+} // namespace bge
@@ -13,6 +13,7 @@ using IndexBufferHandle = GenericHandle<8, 24>;
 using VertexArrayHandle = GenericHandle<8, 24>;
 using ShaderProgramHandle = GenericHandle<8, 24>;
 using Texture2DHandle = GenericHandle<8, 24>;
+using UniformBufferHandle = GenericHandle<8, 24>;
 
 /**
  * Supported texture wrap types
@@ -59,12 +60,46 @@ struct TextureParameters
   TextureWrap m_Wrap;
 };
 
+/**
+ * @return the FNV-1a hash of the name of a uniform
+ */
+constexpr uint32 HashUniformName(const char* name)
+{
+  uint32 hash = 2166136261u;
+  for (; *name != '\0'; ++name)
+  {
+    hash = (hash ^ static_cast<uint8>(*name)) * 16777619u;
+  }
+  return hash;
+}
+
+/**
+ * Identifies a uniform or a uniform block of a shader by the hash of its name.
+ * Declare them as constants, eg. constexpr UniformId c_Model("in_Model"), so
+ * the hash is computed once and setting a uniform is a table lookup.
+ */
+struct UniformId
+{
+  constexpr explicit UniformId(const char* name)
+      : m_Hash(HashUniformName(name))
+  {
+  }
+
+  uint32 m_Hash; /**< The hash of the uniform's name */
+};
+
 /**
  * Represents the layout of a vertex buffer
  */
 class VertexBufferLayout
 {
 public:
+  /**
+   * @param instanced flag whether the attributes advance once per instance
+   * instead of once per vertex
+   */
+  explicit VertexBufferLayout(bool instanced = false);
+
   /**
    * pushes a float to the layout stack
    * @param count number of floats
@@ -87,9 +122,12 @@ public:
   void PushUint8(uint32 count, bool normalized);
 
   /**
-   * Applies the layout to the currently bound VBO
+   * Applies the layout to the currently bound VBO. Elements of more than 4
+   * components, eg. matrices, take one attribute location per 4 components.
+   * @param firstLocation the attribute location of the first element
+   * @return the attribute location after the last element
    */
-  void Apply() const;
+  uint32 Apply(uint32 firstLocation) const;
 
 private:
   struct BufferElement
@@ -105,6 +143,7 @@ private:
   };
   std::vector<BufferElement> m_Elements;
   uint32 m_CurrentSizeInBytes = 0;
+  bool m_IsInstanced;
 };
 
 namespace RenderDevice
@@ -166,7 +205,8 @@ void SetViewport(uint32 x, uint32 y, uint32 width, uint32 height);
 /**
  * Create a vertex array
  * @param vertexBuffers array of vertex buffers to bind to the VAO
- * @param layouts array of vertex buffer layouts for each vertex buffer
+ * @param layouts array of vertex buffer layouts for each vertex buffer, their
+ * attribute locations follow each other in the order of the array
  * @param count number of vertex buffers & layouts
  * @return a handle to the vertex array
  */
@@ -208,6 +248,16 @@ VertexBufferHandle CreateVertexBuffer(uint32 vertexCount, uint32 stride,
  */
 VertexBufferHandle CreateDynamicVertexBuffer(uint32 vertexCount, uint32 stride);
 
+/**
+ * Replace the data of a dynamic vertex buffer, resizing it to fit the data
+ * @param handle reference to the vertex buffer
+ * @param vertexCount number of vertices
+ * @param stride the stride of the vertices
+ * @param data the vertex data
+ */
+void UpdateDynamicVertexBuffer(VertexBufferHandle handle, uint32 vertexCount,
+                               uint32 stride, const void* data);
+
 /**
  * Destroy a vertex buffer
  * @param handle reference to the vertex buffer
@@ -277,77 +327,112 @@ void UnbindShaderProgram();
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param value the value to upload to the shader
  */
-void SetUniform1f(ShaderProgramHandle handle, const std::string& name,
-                  float value);
+void SetUniform1f(ShaderProgramHandle handle, UniformId uniform, float value);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param value the array of values to upload to the shader
  * @param count the number of elements of the value array
  */
-void SetUniform1fv(ShaderProgramHandle handle, const std::string& name,
-                   float* value, int32 count);
+void SetUniform1fv(ShaderProgramHandle handle, UniformId uniform, float* value,
+                   int32 count);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param value the value to upload to the shader
  */
-void SetUniform1i(ShaderProgramHandle handle, const std::string& name,
-                  int32 value);
+void SetUniform1i(ShaderProgramHandle handle, UniformId uniform, int32 value);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param value the array of values to upload to the shader
  * @param count the number of elements of the value array
  */
-void SetUniform1iv(ShaderProgramHandle handle, const std::string& name,
-                   int32* value, int32 count);
+void SetUniform1iv(ShaderProgramHandle handle, UniformId uniform, int32* value,
+                   int32 count);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param vector the 2D vec to upload to the shader
  */
-void SetUniform2f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform2f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec2f& vector);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param vector the 3D vec to upload to the shader
  */
-void SetUniform3f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform3f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec3f& vector);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param vector the 4D vec to upload to the shader
  */
-void SetUniform4f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform4f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec4f& vector);
 
 /**
  * Upload uniform information to a shader
  * @param handle the handle to the shader which will receive the data
- * @param name the name of the uniform (must match the uniform in the shader)
+ * @param uniform the id of the uniform (must match a uniform in the shader)
  * @param matrix the 4x4 matrix to upload to the shader
  * @param transpose flag whether to transpose the matrix
  */
-void SetUniformMat4(ShaderProgramHandle handle, const std::string& name,
-                    Mat4f matrix, bool transpose = true);
+void SetUniformMat4(ShaderProgramHandle handle, UniformId uniform, Mat4f matrix,
+                    bool transpose = true);
+
+/**
+ * Binds a uniform block to a binding point in every shader program created
+ * after the call, so the uniform buffer bound to that point feeds the block
+ * @param block the id of the uniform block's name
+ * @param bindingPoint the binding point of the block
+ */
+void SetUniformBlockBinding(UniformId block, uint32 bindingPoint);
+
+/**
+ * Create a uniform buffer (can upload its data at a later point)
+ * @param size the size of the buffer in bytes
+ * @return handle to the uniform buffer
+ */
+UniformBufferHandle CreateUniformBuffer(uint32 size);
+
+/**
+ * Replace the data of a uniform buffer
+ * @param handle reference to the uniform buffer
+ * @param size the size of the data in bytes
+ * @param data the data, laid out as the std140 uniform block
+ */
+void UpdateUniformBuffer(UniformBufferHandle handle, uint32 size,
+                         const void* data);
+
+/**
+ * Destroy a uniform buffer
+ * @param handle reference to the uniform buffer
+ */
+void DestroyUniformBuffer(UniformBufferHandle handle);
+
+/**
+ * Bind a uniform buffer to a uniform block binding point
+ * @param handle reference to the uniform buffer
+ * @param bindingPoint the binding point of the uniform blocks to feed
+ */
+void BindUniformBuffer(UniformBufferHandle handle, uint32 bindingPoint);
 
 /**
  * Create a 2D texture
@@ -387,6 +472,14 @@ void UnbindTexture2D(uint32 slot);
  */
 void Draw(VertexArrayHandle vao, IndexBufferHandle ibo, uint32 indicesCount);
 
+/**
+ * Instanced indexed draw call of the currently bound VAO and IBO to the
+ * currently bound framebuffer
+ * @param indicesCount the number of indices of the bound IBO
+ * @param instanceCount the number of instances to draw
+ */
+void DrawInstanced(uint32 indicesCount, uint32 instanceCount);
+
 /**
  * Draws in wireframe mode the currently bound VAO to the framebuffer
  * @param indicesCount the number of indices of the bound IBO
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "Material.h"
+#include "Mesh.h"
+
+#include "math/Mat.h"
+
+#include <map>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * Key which orders the draw packets of a frame. From the most significant
+ * bits: view layer (8), shader (8), texture set (16), mesh (8), depth (24),
+ * so packets which share state are submitted one after another.
+ */
+using RenderSortKey = uint64;
+
+/// View layer of opaque geometry, drawn first
+constexpr uint8 c_OpaqueViewLayer = 0u;
+
+/**
+ * @return a key of a render resource handle, equal for equal handles
+ */
+FORCEINLINE uint32 GetRenderHandleKey(GenericHandle<8, 24> handle)
+{
+  return (handle.m_Index << 24) | handle.m_Generation;
+}
+
+/**
+ * An instanced draw of a mesh with a material
+ */
+struct DrawPacket
+{
+  RenderSortKey m_SortKey;    /**< The order of the packet */
+  Mesh m_Mesh;                /**< The mesh to draw */
+  const Material* m_Material; /**< The material, valid until Flush */
+  uint32 m_FirstTransform;    /**< The first model matrix of the queue */
+  uint32 m_InstanceCount;     /**< The number of instances */
+};
+
+/**
+ * Render state changes of the submitted packets
+ */
+struct RenderQueueStats
+{
+  uint64 m_Packets;                 ///< packets submitted
+  uint64 m_ShaderBinds;             ///< shader programs bound
+  uint64 m_TextureBinds;            ///< textures bound
+  uint64 m_VertexArrayBinds;        ///< vertex arrays bound
+  uint64 m_SkippedShaderBinds;      ///< shader binds of an already bound one
+  uint64 m_SkippedTextureBinds;     ///< texture binds of an already bound one
+  uint64 m_SkippedVertexArrayBinds; ///< vertex array binds of a bound one
+};
+
+/**
+ * Collects the draw packets of a camera, sorts them by their key and submits
+ * them to the render device, binding shaders, textures and vertex arrays only
+ * when they change from the previous packet
+ */
+class RenderQueue
+{
+public:
+  RenderQueue();
+
+  /**
+   * Makes the sort key of a packet
+   * @param viewLayer the layer the packet is drawn in, lower layers first
+   * @param mesh the mesh to draw
+   * @param material the material to draw with
+   * @param depth distance from the camera in [0, 1], closer packets first
+   * @return the sort key
+   */
+  RenderSortKey MakeSortKey(uint8 viewLayer, const Mesh& mesh,
+                            const Material& material, float depth);
+
+  /**
+   * Adds an instanced draw to the queue
+   * @param sortKey the order of the draw
+   * @param mesh the mesh to draw
+   * @param material the material to draw with, must stay valid until Flush
+   * @param instanceCount the number of instances
+   * @return the model matrices of the instances to fill in, valid until the
+   * next Submit
+   */
+  Mat4f* Submit(RenderSortKey sortKey, const Mesh& mesh,
+                const Material& material, uint32 instanceCount);
+
+  /**
+   * Sorts and draws the submitted packets, then clears the queue. The camera
+   * matrices come from the camera uniform buffer.
+   */
+  void Flush();
+
+  /**
+   * @return the state changes since the last ResetStats
+   */
+  FORCEINLINE const RenderQueueStats& GetStats() const { return m_Stats; }
+
+  /**
+   * Clear the state change counts
+   */
+  void ResetStats();
+
+  /**
+   * Logs the state change counts, averaged over a number of frames
+   * @param frameCount the frames the counts were recorded in
+   */
+  void LogStats(uint32 frameCount) const;
+
+private:
+  /**
+   * Sort entry of a packet
+   */
+  struct SortEntry
+  {
+    RenderSortKey m_Key; /**< The key of the packet */
+    uint32 m_Packet;     /**< The index of the packet */
+  };
+
+  /**
+   * @return the id of the textures of a material, the same for equal sets
+   */
+  uint16 GetTextureSetId(const Material& material);
+
+  /**
+   * Sorts the entries by their key, keeping the submit order of equal keys
+   */
+  void SortPackets();
+
+  std::vector<DrawPacket> m_Packets;    /**< Packets in submit order */
+  std::vector<Mat4f> m_Transforms;      /**< Model matrices of all packets */
+  std::vector<SortEntry> m_SortEntries; /**< Packet order being sorted */
+  std::vector<SortEntry> m_SortScratch; /**< Other buffer of the sort */
+  /// Ids of the texture sets, keyed by their texture handles
+  std::map<std::vector<uint32>, uint16> m_TextureSetIds;
+  std::vector<uint32> m_TextureSetKey; /**< Lookup key of GetTextureSetId */
+  RenderQueueStats m_Stats;            /**< State change counts */
+};
+
+} // namespace bge
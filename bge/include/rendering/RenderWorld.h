@@ -3,6 +3,7 @@
 #include "CameraManager.h"
 #include "DynamicMeshSystem.h"
 #include "MeshLibrary.h"
+#include "RenderQueue.h"
 #include "ShaderLibrary.h"
 #include "StaticMeshSystem.h"
 #include "Texture2DLibrary.h"
@@ -108,6 +109,7 @@ public:
   {
     return m_DynamicMeshSystem;
   }
+  FORCEINLINE RenderQueue& GetRenderQueue() { return m_RenderQueue; }
 
   /**
    * Event handler function
@@ -128,6 +130,12 @@ private:
   WireframeBoxRenderer m_WireframeBoxRenderer;
   WireframeSphereRenderer m_WireframeSphereRenderer;
 
+  // Draw packets of the mesh systems, sorted by render state
+  RenderQueue m_RenderQueue;
+
+  // Uniform buffer of the camera matrices, updated once per camera
+  UniformBufferHandle m_CameraBuffer;
+
   // Resource Libraries
   MeshLibrary m_MeshLibrary;
   ShaderLibrary m_ShaderLibrary;
@@ -1,14 +1,15 @@
 #pragma once
 
+#include "FrustumCuller.h"
+#include "InstancedMeshRenderer.h"
 #include "Material.h"
 #include "Mesh.h"
 
+#include "ecs/ComponentStorage.h"
 #include "ecs/Entity.h"
 #include "events/ECSEvents.h"
 #include "math/Mat.h"
 
-#include <unordered_map>
-
 namespace bge
 {
 
@@ -38,11 +39,12 @@ public:
   void SetEventCallback(const std::function<void(Event&)>& callback);
 
   /**
-   * Renders the existing meshes in the system from the POV of the input camera
-   * @param projection the camera's projection matrix
-   * @param view the camera's view matrix
+   * Submits the meshes in the system which are inside the frustum of a
+   * camera to its render queue
+   * @param queue the render queue of the camera
+   * @param frustum the frustum of the camera
    */
-  void RenderMeshes(const Mat4f& projection, const Mat4f& view);
+  void SubmitMeshes(RenderQueue& queue, const Frustum& frustum);
 
   /**
    * Allocates a new component instance mapped to the passed entity
@@ -76,9 +78,10 @@ private:
    */
   bool OnEntitiesDestroyed(EntitiesDestroyedEvent& event);
 
-  std::unordered_map<uint32, uint32> m_EntityToComponentId;
-  std::vector<StaticMeshData> m_Meshes;
-  std::vector<Entity> m_Entities;
+  ComponentStorage<StaticMeshData> m_Meshes;
+  InstancedMeshRenderer m_Renderer;
+  FrustumCuller m_Culler;
+  std::vector<uint32> m_VisibleInstances;
   std::function<void(Event&)> m_EventCallback;
 };
 
@@ -15,11 +15,9 @@ class WireframeBoxRenderer
 {
 public:
   /**
-   * Renders all existing collider boxes from the POV of the input camera
-   * @param projection the camera's projection matrix
-   * @param view the camera's view matrix
+   * Renders all existing collider boxes from the POV of the camera
    */
-  void RenderWireframes(const Mat4f& projection, const Mat4f& view);
+  void RenderWireframes();
 
   /**
    * Sets the mesh which is used for rendering to the collider's location.
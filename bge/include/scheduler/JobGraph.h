@@ -0,0 +1,192 @@
+#pragma once
+
+#include "Scheduler.h"
+
+#include "core/Common.h"
+#include "ecs/ComponentTraits.h"
+#include "util/Timer.h"
+
+#include <atomic>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace bge
+{
+
+using JobId = uint32;
+using JobResourceId = uint32;
+
+/**
+ * @return unique id of the resource type T, to declare what a job reads and
+ * writes
+ */
+template <typename T> FORCEINLINE JobResourceId GetJobResourceId()
+{
+  return GetUniqueTypeId<T>();
+}
+
+/**
+ * Timings of the last execution of a job graph
+ */
+struct JobGraphReport
+{
+  float m_FrameMilli;        ///< from the start of the graph to the last job end
+  float m_WorkMilli;         ///< summed durations of all jobs
+  float m_CriticalPathMilli; ///< summed durations of the critical path jobs
+  std::vector<JobId> m_CriticalPath; ///< the longest chain of dependent jobs
+                                     ///< (by duration), first job first
+};
+
+/**
+ * A graph of jobs which is built once and executed every frame on top of the
+ * scheduler. A job starts as soon as all of its predecessors finish, so
+ * independent jobs run concurrently and dependent jobs chain without any
+ * thread blocking in between.
+ *
+ * Jobs depend on earlier added jobs which are declared as predecessors and on
+ * earlier added jobs whose resource access conflicts with theirs (a write
+ * after a read or write, or a read after a write). Adding the jobs in the
+ * order they would run serially keeps the results the same.
+ */
+class JobGraph
+{
+public:
+  JobGraph();
+
+  DELETE_COPY_AND_ASSIGN(JobGraph)
+
+  /**
+   * Add a job to the graph, must be called before Build
+   * @param name name of the job used in reports, must outlive the graph
+   * @param function the work of the job
+   * @param reads resources the job only reads
+   * @param writes resources the job modifies
+   * @param predecessors earlier added jobs which must finish first
+   * @return the id of the new job
+   */
+  JobId AddJob(const char* name, std::function<void()> function,
+               std::initializer_list<JobResourceId> reads,
+               std::initializer_list<JobResourceId> writes,
+               std::initializer_list<JobId> predecessors = {});
+
+  /**
+   * Same as AddJob with initializer lists, for accesses only known at runtime
+   */
+  JobId AddJob(const char* name, std::function<void()> function,
+               std::vector<JobResourceId> reads,
+               std::vector<JobResourceId> writes,
+               std::vector<JobId> predecessors = {});
+
+  /**
+   * Resolve the dependencies between the added jobs, called once before the
+   * first Run
+   */
+  void Build();
+
+  /**
+   * Start executing the graph without waiting for it
+   * @return the handle to wait on, its task finishes once every job has
+   * finished
+   */
+  TaskHandle Run();
+
+  /**
+   * Execute the graph, help with the jobs until all of them finished and
+   * update the report
+   */
+  void Execute();
+
+  /**
+   * Update the report, must be called after the task returned by Run finished
+   */
+  void UpdateReport();
+
+  /**
+   * Logs the frame time, the total work and the critical path of the last run
+   */
+  void LogReport() const;
+
+  FORCEINLINE const JobGraphReport& GetReport() const { return m_Report; }
+  FORCEINLINE const char* GetJobName(JobId job) const
+  {
+    return m_Jobs[job].m_Name;
+  }
+  FORCEINLINE uint32 GetJobCount() const
+  {
+    return static_cast<uint32>(m_Jobs.size());
+  }
+
+private:
+  /**
+   * A single node of the graph
+   */
+  struct Job
+  {
+    const char* m_Name;                 ///< name used in reports
+    std::function<void()> m_Function;   ///< the work of the job
+    std::vector<JobResourceId> m_Reads;  ///< resources which are only read
+    std::vector<JobResourceId> m_Writes; ///< resources which are modified
+    std::vector<JobId> m_Predecessors;   ///< jobs which must finish first
+    std::vector<JobId> m_Successors;     ///< jobs which wait for this job
+  };
+
+  /**
+   * Data stored in the scheduler task of a job
+   */
+  struct JobTaskData
+  {
+    JobGraph* m_Graph; ///< the graph the job belongs to
+    JobId m_Job;       ///< the job to execute
+  };
+
+  /**
+   * Task which starts all the jobs without predecessors
+   * @param task the root task of the graph
+   * @param taskData pointer to the graph
+   */
+  static void RootTask(Task* task, const void* taskData);
+
+  /**
+   * Task which executes a job and starts the successors that became ready
+   * @param task the job task
+   * @param taskData JobTaskData of the job
+   */
+  static void JobTask(Task* task, const void* taskData);
+
+  /**
+   * Create and run the task of a job whose predecessors have all finished
+   * @param job the job to run
+   */
+  void RunJob(JobId job);
+
+  /**
+   * Check if 2 jobs access a common resource and at least one of them writes
+   * @return true if the second job has to wait for the first one
+   */
+  static bool HasConflict(const Job& first, const Job& second);
+
+  /**
+   * @return nanos passed since the last Run
+   */
+  int64 GetNanosSinceStart() const;
+
+  std::vector<Job> m_Jobs; ///< jobs in the order they were added
+  /// number of unfinished predecessors of each job in the current run
+  std::unique_ptr<std::atomic_int32_t[]> m_UnfinishedPredecessors;
+  std::vector<int64> m_StartNanos; ///< job start times of the last run
+  std::vector<int64> m_EndNanos;   ///< job end times of the last run
+  /// longest path ending at each job, filled by UpdateReport
+  std::vector<int64> m_PathNanos;
+  /// previous job of the longest path ending at each job
+  std::vector<JobId> m_PathPredecessors;
+
+  TimePoint m_StartTime; ///< the time the last run started
+  Task* m_RootTask;      ///< parent task of all jobs in the current run
+  bool m_IsBuilt;        ///< whether Build was called
+
+  JobGraphReport m_Report; ///< timings of the last run
+};
+
+} // namespace bge
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace bge
+{
+
+/**
+ * @return number of chunks of at most grainSize elements in count elements
+ */
+FORCEINLINE uint32 GetParallelChunkCount(uint32 count, uint32 grainSize)
+{
+  return (count + grainSize - 1) / grainSize;
+}
+
+/**
+ * Transforms every index in [begin, end) and reduces the results in parallel.
+ * The range is cut into fixed chunks of grainSize indices which are reduced
+ * in order, so the result doesn't depend on how the tasks got scheduled (even
+ * for floating point sums).
+ * Usable for sums, min/max or bounding volumes, eg:
+ *   ParallelTransformReduce(0, count, 256, AABB(...),
+ *     [&](uint32 i) { return boxes[i]; },
+ *     [](const AABB& a, const AABB& b) { return a.AddAABB(b); });
+ * @param begin first index
+ * @param end one past the last index
+ * @param grainSize the number of indices a single chunk reduces serially
+ * @param identity the value which the reduction starts with (eg. 0 for sums)
+ * @param transform callable mapping a uint32 index to a value of type T
+ * @param reduce associative callable combining 2 values of type T
+ * @return the reduced value, identity if the range is empty
+ */
+template <typename T, typename TransformFunction, typename ReduceFunction>
+T ParallelTransformReduce(uint32 begin, uint32 end, uint32 grainSize,
+                          const T& identity, const TransformFunction& transform,
+                          const ReduceFunction& reduce)
+{
+  if (begin >= end)
+  {
+    return identity;
+  }
+
+  const uint32 chunkCount = GetParallelChunkCount(end - begin, grainSize);
+  std::vector<T> partials(chunkCount, identity);
+
+  ParallelFor(0u, chunkCount, 1u, [&](uint32 chunk) {
+    const uint32 chunkBegin = begin + chunk * grainSize;
+    const uint32 chunkEnd = std::min(chunkBegin + grainSize, end);
+
+    T partial = identity;
+    for (uint32 i = chunkBegin; i < chunkEnd; ++i)
+    {
+      partial = reduce(partial, transform(i));
+    }
+    partials[chunk] = partial;
+  });
+
+  T result = identity;
+  for (const T& partial : partials)
+  {
+    result = reduce(result, partial);
+  }
+
+  return result;
+}
+
+/**
+ * Parallel prefix scan in 2 passes: every chunk of grainSize elements is
+ * reduced in parallel, the chunk totals are scanned serially and then every
+ * chunk is scanned in parallel starting from its offset.
+ * @param input array of count elements
+ * @param output array of count elements, can be the same as input
+ * @param count number of elements
+ * @param grainSize the number of elements a single chunk scans serially
+ * @param identity the value of the first output in an exclusive scan
+ * @param scan associative callable combining 2 values of type T
+ * @param isInclusive whether output[i] includes input[i]
+ */
+template <typename T, typename ScanFunction>
+void ParallelScan(const T* input, T* output, uint32 count, uint32 grainSize,
+                  const T& identity, const ScanFunction& scan,
+                  bool isInclusive)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  const uint32 chunkCount = GetParallelChunkCount(count, grainSize);
+  std::vector<T> chunkOffsets(chunkCount, identity);
+
+  ParallelFor(0u, chunkCount, 1u, [&](uint32 chunk) {
+    const uint32 chunkBegin = chunk * grainSize;
+    const uint32 chunkEnd = std::min(chunkBegin + grainSize, count);
+
+    T total = identity;
+    for (uint32 i = chunkBegin; i < chunkEnd; ++i)
+    {
+      total = scan(total, input[i]);
+    }
+    chunkOffsets[chunk] = total;
+  });
+
+  // Turn the chunk totals into the offset each chunk starts from
+  T offset = identity;
+  for (T& chunkOffset : chunkOffsets)
+  {
+    const T total = chunkOffset;
+    chunkOffset = offset;
+    offset = scan(offset, total);
+  }
+
+  ParallelFor(0u, chunkCount, 1u, [&](uint32 chunk) {
+    const uint32 chunkBegin = chunk * grainSize;
+    const uint32 chunkEnd = std::min(chunkBegin + grainSize, count);
+
+    T running = chunkOffsets[chunk];
+    for (uint32 i = chunkBegin; i < chunkEnd; ++i)
+    {
+      // Read before writing, the output may alias the input
+      const T value = input[i];
+
+      if (isInclusive)
+      {
+        running = scan(running, value);
+        output[i] = running;
+      }
+      else
+      {
+        output[i] = running;
+        running = scan(running, value);
+      }
+    }
+  });
+}
+
+/**
+ * Parallel inclusive prefix scan, output[i] = input[0] op ... op input[i]
+ * (see ParallelScan)
+ */
+template <typename T, typename ScanFunction>
+FORCEINLINE void ParallelInclusiveScan(const T* input, T* output, uint32 count,
+                                       uint32 grainSize, const T& identity,
+                                       const ScanFunction& scan)
+{
+  ParallelScan(input, output, count, grainSize, identity, scan, true);
+}
+
+/**
+ * Parallel exclusive prefix scan, output[0] = identity and
+ * output[i] = input[0] op ... op input[i - 1] (see ParallelScan)
+ */
+template <typename T, typename ScanFunction>
+FORCEINLINE void ParallelExclusiveScan(const T* input, T* output, uint32 count,
+                                       uint32 grainSize, const T& identity,
+                                       const ScanFunction& scan)
+{
+  ParallelScan(input, output, count, grainSize, identity, scan, false);
+}
+
+} // namespace bge
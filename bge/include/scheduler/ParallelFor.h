@@ -3,6 +3,9 @@
 #include "ParallelForSplitters.h"
 #include "Scheduler.h"
 
+#include <chrono>
+#include <type_traits>
+
 namespace bge
 {
 
@@ -31,44 +34,78 @@ template <typename T, typename S> struct ParralelForTaskData
 };
 
 /**
- * The parralel for task function, which splits the passed data until it
- * doesn't meet the split requirements and  then executes all the leaves
+ * Splits the range [begin, end) based on the splitter. While the splitter
+ * allows it, the right half of the range is handed to spawnRight, then the
+ * leaves are passed to executeLeaf. Lazy splitters are asked again after every
+ * leaf, because their decision depends on other threads.
  * example of splitting 5 elements into loops of 2 (or lower)
  *       *  - 5 elements
  *      / \
- *     *   * - 3/2 elements (execute 2)
+ *     *   * - 2/3 elements (spawn 3)
  *    / \
- *   *   *    - 2/1 (execute 2 and 1)
+ *   *   *    - 1/1 (execute 1 and 1)
+ */
+template <typename T, typename SplitterType, typename SpawnFunction,
+          typename LeafFunction>
+FORCEINLINE void SplitParallelForRange(uint32 begin, uint32 end,
+                                       const SplitterType& splitter,
+                                       const SpawnFunction& spawnRight,
+                                       const LeafFunction& executeLeaf)
+{
+  while (begin < end)
+  {
+    const uint32 count = end - begin;
+
+    if (splitter.template Split<T>(count))
+    {
+      const uint32 middle = begin + count / 2u;
+      spawnRight(middle, end);
+      end = middle;
+      continue;
+    }
+
+    const uint32 leafEnd = begin + splitter.template GetLeafCount<T>(count);
+
+    if (SplitterType::c_RecordsLeafTimes)
+    {
+      const auto start = std::chrono::steady_clock::now();
+      executeLeaf(begin, leafEnd);
+      splitter.RecordLeaf(leafEnd - begin,
+                          std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - start)
+                              .count());
+    }
+    else
+    {
+      executeLeaf(begin, leafEnd);
+    }
+
+    begin = leafEnd;
+  }
+}
+
+/**
+ * The parralel for task function, which splits the passed data until it
+ * doesn't meet the split requirements and then executes all the leaves
  */
 template <typename TaskData>
 void ParallelForTask(Task* task, const void* taskData)
 {
   const TaskData* data = static_cast<const TaskData*>(taskData);
-  const TaskData::SplitterType& splitter = data->m_Splitter;
+  using DataType = typename TaskData::DataType;
 
-  if (splitter.Split<TaskData::DataType>(data->m_Count))
-  {
-    // Left side
-    const uint32 leftCount = data->m_Count / 2u;
-    const TaskData leftData(data->m_Data, leftCount, data->m_Function,
-                            splitter);
-
-    Task* left = Scheduler::CreateChildTask(task, ParallelForTask<TaskData>,
-                                            &leftData, sizeof(leftData));
-    Scheduler::Run(left);
-
-    // Right side
-    const uint32 rightCount = data->m_Count - leftCount;
-    const TaskData rightData(data->m_Data + leftCount, rightCount,
-                             data->m_Function, splitter);
-    Task* right = Scheduler::CreateChildTask(task, ParallelForTask<TaskData>,
-                                             &rightData, sizeof(rightData));
-    Scheduler::Run(right);
-  }
-  else
-  {
-    (data->m_Function)(data->m_Data, data->m_Count);
-  }
+  SplitParallelForRange<DataType>(
+      0u, data->m_Count, data->m_Splitter,
+      [task, data](uint32 begin, uint32 end) {
+        const TaskData rightData(data->m_Data + begin, end - begin,
+                                 data->m_Function, data->m_Splitter);
+        Task* right = Scheduler::CreateChildTask(
+            task, ParallelForTask<TaskData>, &rightData, sizeof(rightData));
+        Scheduler::Run(right);
+      },
+      [data](uint32 begin, uint32 end) {
+        (data->m_Function)(data->m_Data + begin, end - begin);
+      });
 }
 
 /**
@@ -93,4 +130,105 @@ Task* ParralelFor(DataType* data, uint32 count,
   return task;
 }
 
+/**
+ * Data that the index range parralel for task uses. Only a pointer to the
+ * function is stored, so the captured state of a lambda can be of any size.
+ */
+template <typename F, typename S> struct ParallelForRangeTaskData
+{
+  using FunctionType = F;
+  using SplitterType = S;
+
+  ParallelForRangeTaskData(const FunctionType* function, uint32 begin,
+                           uint32 end, const SplitterType& splitter)
+      : m_Function(function)
+      , m_Begin(begin)
+      , m_End(end)
+      , m_Splitter(splitter)
+  {
+  }
+
+  const FunctionType* m_Function;
+  uint32 m_Begin;
+  uint32 m_End;
+  SplitterType m_Splitter;
+};
+
+/**
+ * The index range parralel for task function. Keeps splitting off the right
+ * half of the range into a child task while the splitter allows it and then
+ * calls the function for every index left in the range.
+ */
+template <typename TaskData>
+void ParallelForRangeTask(Task* task, const void* taskData)
+{
+  const TaskData* data = static_cast<const TaskData*>(taskData);
+
+  SplitParallelForRange<uint32>(
+      data->m_Begin, data->m_End, data->m_Splitter,
+      [task, data](uint32 begin, uint32 end) {
+        const TaskData rightData(data->m_Function, begin, end,
+                                 data->m_Splitter);
+        Task* right = Scheduler::CreateChildTask(
+            task, ParallelForRangeTask<TaskData>, &rightData,
+            sizeof(rightData));
+        Scheduler::Run(right);
+      },
+      [data](uint32 begin, uint32 end) {
+        const typename TaskData::FunctionType& function = *data->m_Function;
+        for (uint32 i = begin; i < end; ++i)
+        {
+          function(i);
+        }
+      });
+}
+
+/**
+ * Calls function(index) for every index in [begin, end) in parallel and waits
+ * for all of them to finish. The range is cut into tasks by the splitter.
+ * @param begin first index
+ * @param end one past the last index
+ * @param splitter how to split the range into multiple tasks
+ * @param function callable taking the uint32 index, it must stay valid until
+ * the call returns, which is why it isn't copied into the tasks
+ */
+template <typename SplitterType, typename Function,
+          typename = std::enable_if_t<std::is_class<SplitterType>::value>>
+void ParallelFor(uint32 begin, uint32 end, const SplitterType& splitter,
+                 const Function& function)
+{
+  using TaskData = ParallelForRangeTaskData<Function, SplitterType>;
+
+  if (begin >= end)
+  {
+    return;
+  }
+
+  const TaskData taskData(&function, begin, end, splitter);
+
+  static_assert(sizeof(TaskData) <= c_SpaceForTaskData,
+                "Parallel for task data must fit in a task");
+
+  Task* task = Scheduler::CreateTask(ParallelForRangeTask<TaskData>, &taskData,
+                                     sizeof(taskData));
+  Scheduler::Wait(Scheduler::Run(task));
+}
+
+/**
+ * Calls function(index) for every index in [begin, end) in parallel and waits
+ * for all of them to finish. The range is split in halves until a range holds
+ * at most grainSize indices.
+ * @param begin first index
+ * @param end one past the last index
+ * @param grainSize the maximum number of indices a single task processes
+ * @param function callable taking the uint32 index, it must stay valid until
+ * the call returns, which is why it isn't copied into the tasks
+ */
+template <typename Function>
+FORCEINLINE void ParallelFor(uint32 begin, uint32 end, uint32 grainSize,
+                             const Function& function)
+{
+  ParallelFor(begin, end, CountSplitter(grainSize), function);
+}
+
 } // namespace bge
\ No newline at end of file
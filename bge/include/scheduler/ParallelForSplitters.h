@@ -1,10 +1,25 @@
 #pragma once
 
+#include "Scheduler.h"
+
 #include "core/Common.h"
+#include "logging/Log.h"
+
+#include <atomic>
 
 namespace bge
 {
 
+/**
+ * Splitters decide how the parallel for functions cut their range into tasks:
+ * - Split<T>(count) returns whether a range of count elements of type T should
+ *   be halved, handing the right half to another task
+ * - GetLeafCount<T>(count) returns how many elements to process before Split
+ *   is asked again (lazy splitters process leaves in small chunks)
+ * - RecordLeaf(count, nanos) receives the timing of every processed leaf when
+ *   c_RecordsLeafTimes is true
+ */
+
 /**
  * Splits the data based on the passed count.
  */
@@ -14,14 +29,23 @@ public:
   explicit CountSplitter(uint32 count)
       : m_Count(count)
   {
-    BGE_CORE_ASSERT(m_Count > 1, "Count must be higher than 1");
+    BGE_CORE_ASSERT(m_Count > 0, "Count must be higher than 0");
   }
 
+  static constexpr bool c_RecordsLeafTimes = false;
+
   template <typename T> FORCEINLINE bool Split(uint32 count) const
   {
     return (count > m_Count);
   }
 
+  template <typename T> FORCEINLINE uint32 GetLeafCount(uint32 count) const
+  {
+    return count;
+  }
+
+  FORCEINLINE void RecordLeaf(uint32, int64) const {}
+
 private:
   uint32 m_Count;
 };
@@ -39,13 +63,151 @@ public:
     BGE_CORE_ASSERT(m_Size > 1, "Size must be more than 1");
   }
 
+  static constexpr bool c_RecordsLeafTimes = false;
+
   template <typename T> FORCEINLINE bool Split(uint32 count) const
   {
     return (count * sizeof(T) > m_Size);
   }
 
+  template <typename T> FORCEINLINE uint32 GetLeafCount(uint32 count) const
+  {
+    return count;
+  }
+
+  FORCEINLINE void RecordLeaf(uint32, int64) const {}
+
 private:
   uint32 m_Size;
 };
 
+/**
+ * Lazy binary splitting: a range is only split while the task queue of the
+ * executing thread is empty, which means its earlier split off work got
+ * stolen and other threads are hungry for more. Otherwise the range is
+ * processed in chunks, checking the queue again after every chunk. This adapts
+ * to the number of idle threads without a hand picked grain size.
+ */
+class LazySplitter
+{
+public:
+  /**
+   * @param minCount ranges of this many elements or less are never split
+   * @param chunkCount number of elements processed between checking the queue
+   */
+  explicit LazySplitter(uint32 minCount = 64u, uint32 chunkCount = 64u)
+      : m_MinCount(minCount)
+      , m_ChunkCount(chunkCount)
+  {
+    BGE_CORE_ASSERT(m_ChunkCount > 0, "Chunk count must be higher than 0");
+  }
+
+  static constexpr bool c_RecordsLeafTimes = false;
+
+  template <typename T> FORCEINLINE bool Split(uint32 count) const
+  {
+    return count > m_MinCount && Scheduler::GetQueuedTaskCount() == 0;
+  }
+
+  template <typename T> FORCEINLINE uint32 GetLeafCount(uint32 count) const
+  {
+    return count < m_ChunkCount ? count : m_ChunkCount;
+  }
+
+  FORCEINLINE void RecordLeaf(uint32, int64) const {}
+
+private:
+  uint32 m_MinCount;   ///< never split ranges of this many elements or less
+  uint32 m_ChunkCount; ///< elements processed between queue checks
+};
+
+/**
+ * Timing profile of a single parallel for call site, shared by all of its
+ * tasks and kept across frames. It tracks the average time spent per element
+ * and derives the grain size which makes a leaf take the budgeted time.
+ */
+class SplitterProfile
+{
+public:
+  /**
+   * @param leafBudgetMicros how long a single leaf task should take
+   * @param initialGrainSize grain size used until the first leaf is timed
+   */
+  explicit SplitterProfile(float leafBudgetMicros = 50.0f,
+                           uint32 initialGrainSize = 256u);
+
+  DELETE_COPY_AND_ASSIGN(SplitterProfile)
+
+  /**
+   * Adds the timing of a processed leaf to the profile (threadsafe)
+   * @param count number of elements in the leaf
+   * @param nanos time it took to process the leaf
+   */
+  void RecordLeaf(uint32 count, int64 nanos);
+
+  /**
+   * @return the number of elements which fit in the leaf budget
+   */
+  uint32 GetGrainSize() const;
+
+  /**
+   * @return the average nanos spent per element, 0 if nothing was timed yet
+   */
+  FORCEINLINE float GetNanosPerElement() const
+  {
+    return m_NanosPerElement.load(std::memory_order_relaxed);
+  }
+
+private:
+  float m_LeafBudgetNanos;   ///< how long a single leaf should take
+  uint32 m_InitialGrainSize; ///< grain size before anything is timed
+  std::atomic<float> m_NanosPerElement; ///< moving average of leaf timings
+};
+
+/**
+ * Splits ranges down to the grain size that a SplitterProfile measured for
+ * its call site. Every leaf is timed, so the grain size follows changes of
+ * the workload and of the machine over time.
+ */
+class ProfiledSplitter
+{
+public:
+  explicit ProfiledSplitter(SplitterProfile& profile)
+      : m_Profile(&profile)
+  {
+  }
+
+  static constexpr bool c_RecordsLeafTimes = true;
+
+  template <typename T> FORCEINLINE bool Split(uint32 count) const
+  {
+    return count > m_Profile->GetGrainSize();
+  }
+
+  template <typename T> FORCEINLINE uint32 GetLeafCount(uint32 count) const
+  {
+    return count;
+  }
+
+  FORCEINLINE void RecordLeaf(uint32 count, int64 nanos) const
+  {
+    m_Profile->RecordLeaf(count, nanos);
+  }
+
+private:
+  SplitterProfile* m_Profile; ///< the profile of the call site
+};
+
+/**
+ * Creates a ProfiledSplitter with a profile that is unique to the call site
+ * and lives for the whole program, eg.
+ *   ParallelFor(0, count, BGE_PROFILED_SPLITTER(50.0f), function);
+ * @param leafBudgetMicros how long a single leaf task should take
+ */
+#define BGE_PROFILED_SPLITTER(leafBudgetMicros)                                \
+  ::bge::ProfiledSplitter([]() -> ::bge::SplitterProfile& {                    \
+    static ::bge::SplitterProfile s_Profile(leafBudgetMicros);                 \
+    return s_Profile;                                                          \
+  }())
+
 } // namespace bge
\ No newline at end of file
@@ -9,16 +9,62 @@ namespace bge
 namespace Scheduler
 {
 
+/// number of threads besides the engine's own which can be registered as
+/// workers at the same time (eg. an I/O or render thread)
+constexpr uint32 c_MaxExternalThreadCount = 4u;
+
+/// worker index of threads which aren't known to the scheduler
+constexpr uint32 c_InvalidWorkerIndex = ~0u;
+
 /**
  * Initialize the scheduler, called once on startup
  */
 void Initialize();
 
+/**
+ * Initialize the scheduler with a fixed number of worker threads, eg. to
+ * measure how work scales with the thread count. The scheduler can be
+ * initialized again after a Shutdown.
+ * @param workerThreadCount number of threads created besides the main thread
+ */
+void Initialize(uint32 workerThreadCount);
+
 /**
  * Shutdown the scheduler, called on app exit
  */
 void Shutdown();
 
+/**
+ * Register the calling thread as a worker, giving it its own task queue so it
+ * can run and wait for tasks. Must be called after Initialize.
+ * @return the worker index of the calling thread
+ */
+uint32 RegisterThread();
+
+/**
+ * Unregister the calling thread, executing any tasks left in its queue. All
+ * tasks created by the thread must have finished before it exits.
+ */
+void UnregisterThread();
+
+/**
+ * @return index of the calling thread in [0, GetMaxWorkerCount()), 0 being the
+ * main thread, or c_InvalidWorkerIndex if the thread isn't a worker
+ */
+uint32 GetWorkerIndex();
+
+/**
+ * @return the number of worker indices, including the main thread and the
+ * slots for external threads (useful for sizing per-worker data)
+ */
+uint32 GetMaxWorkerCount();
+
+/**
+ * @return number of tasks waiting in the queue of the calling thread, 0 if the
+ * thread isn't a worker
+ */
+uint32 GetQueuedTaskCount();
+
 /**
  * create a task which takes no data
  * @param function the task function to execute
@@ -59,14 +105,15 @@ Task* CreateChildTask(Task* parent, TaskFunction function, const void* taskData,
  * Run a task, which adds it to the task queue,
  * enabling other workers to steal it
  * @param task pointer to task to run
+ * @return the handle to wait on the task with
  */
-void Run(Task* task);
+TaskHandle Run(Task* task);
 
 /**
  * Wait for a task to finish, and while waiting, help with executing tasks
- * @param task pointer to task to wait for
+ * @param handle the handle Run returned for the task to wait for
  */
-void Wait(const Task* task);
+void Wait(TaskHandle handle);
 
 /**
  * Task function which does nothing (useful for empty root tasks)
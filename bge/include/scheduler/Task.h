@@ -1,5 +1,7 @@
 #pragma once
 
+#include "core/Common.h"
+
 #include <atomic>
 
 namespace bge
@@ -10,7 +12,8 @@ struct Task;
 typedef void (*TaskFunction)(Task*, const void*);
 
 constexpr int c_SpaceForTaskData =
-    64 - (sizeof(TaskFunction) + sizeof(Task*) + sizeof(std::atomic_int32_t));
+    64 - (sizeof(TaskFunction) + sizeof(Task*) + sizeof(std::atomic_int32_t) +
+          sizeof(std::atomic_uint32_t));
 
 struct Task
 {
@@ -18,6 +21,8 @@ struct Task
   TaskFunction m_Function; ///< function to execute
   std::atomic_int32_t
       m_UnfinishedTasks; ///< number of unfinished tasks (1 by default for this)
+  std::atomic_uint32_t m_Generation; ///< incremented every time the task pool
+                                     ///< recycles this task
   char m_Data[c_SpaceForTaskData]; ///< bytes to pad the struct to 64 bytes;
                                    ///< This is also used to store data for the
                                    ///< task. If it's under c_spaceForTaskData
@@ -26,4 +31,15 @@ struct Task
                                    ///< data on the heap.
 };
 
+/**
+ * A task and the generation it had when it was run. Finished tasks are
+ * recycled by their pool, so a handle whose generation no longer matches the
+ * task's refers to a task which has finished.
+ */
+struct TaskHandle
+{
+  Task* m_Task;        ///< the task which was run
+  uint32 m_Generation; ///< generation of the task when it was run
+};
+
 } // namespace bge
\ No newline at end of file
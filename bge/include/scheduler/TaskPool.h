@@ -0,0 +1,55 @@
+#pragma once
+
+#include "Task.h"
+#include "core/Common.h"
+
+#include <vector>
+
+namespace bge
+{
+
+constexpr uint32 c_TaskChunkSize = 1024u;
+constexpr uint32 c_TaskChunkMask = c_TaskChunkSize - 1;
+constexpr uint32 c_MaxTaskChunkCount = 256u;
+
+/**
+ * A task pool owned by a single thread. Tasks are stored in cache line aligned
+ * chunks of c_TaskChunkSize tasks and a task is only handed out again once it
+ * has finished (its unfinished task counter is 0). When every task is still
+ * in flight the pool grows by another chunk, up to c_MaxTaskChunkCount.
+ *
+ * Every time a task is recycled its generation is incremented, so code which
+ * holds on to a TaskHandle (eg. Scheduler::Wait) can tell that the task it
+ * was waiting for has finished and the memory now belongs to a new task.
+ */
+class TaskPool
+{
+public:
+  TaskPool();
+  ~TaskPool();
+
+  DELETE_COPY_AND_ASSIGN(TaskPool)
+
+  /**
+   * Allocate a finished task (owner thread only)
+   * @return pointer to the task or nullptr if all c_MaxTaskChunkCount chunks
+   * are full of unfinished tasks
+   */
+  Task* Allocate();
+
+  /**
+   * @return number of tasks the pool can currently hold
+   */
+  uint32 GetCapacity() const;
+
+private:
+  /**
+   * Allocate a new chunk of finished tasks
+   */
+  void AddChunk();
+
+  std::vector<Task*> m_Chunks; ///< 64 byte aligned arrays of c_TaskChunkSize
+  uint32 m_Cursor; ///< index of the next task to check in the pool
+};
+
+} // namespace bge
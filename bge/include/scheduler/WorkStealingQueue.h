@@ -3,7 +3,7 @@
 #include "Task.h"
 #include "core/Common.h"
 
-#include <array>
+#include <atomic>
 #include <mutex>
 
 namespace bge
@@ -18,17 +18,66 @@ constexpr uint32 c_Mask = c_NumberOfTasks - 1;
  * tasks from the back of the queue and also enable the ability to steal tasks
  * from the front of the queue so other threads can take on some work if
  * they're empty. These operations must be threadsafe.
+ *
+ * This is a lock-free Chase-Lev deque: the owner thread only synchronizes with
+ * thieves when the queue holds a single task, so Push/Pop are uncontended in
+ * the common case.
  */
 class WorkStealingQueue
 {
 public:
   WorkStealingQueue();
 
+  /**
+   * Push a task to the back (owner thread only)
+   * @param task pointer to task to push back
+   * @return false if the ring buffer is full and the task was not pushed
+   */
+  bool Push(Task* task);
+
+  /**
+   * Pop a task from the back (owner thread only)
+   * @return pointer to popped task
+   */
+  Task* Pop();
+
+  /**
+   * Steal a task from the front (any thread)
+   * @return pointer to stolen task
+   */
+  Task* Steal();
+
+  /**
+   * @return approximate number of tasks in the queue
+   */
+  uint32 Size() const;
+
+private:
+  /// size of the padding which keeps the indices on separate cache lines
+  static constexpr uint32 c_IndexPadding = 64u - sizeof(std::atomic<int64>);
+
+  std::atomic<int64> m_Top;             ///< "index" to the front task
+  char m_TopPadding[c_IndexPadding];    ///< avoids false sharing with thieves
+  std::atomic<int64> m_Bottom;          ///< "index" to the back task
+  char m_BottomPadding[c_IndexPadding]; ///< avoids false sharing with tasks
+  std::atomic<Task*> m_Tasks[c_NumberOfTasks]; ///< ring buffer of tasks
+};
+
+/**
+ * The mutex guarded work stealing queue which the scheduler used before the
+ * lock-free queue. Kept as a reference point for the contention benchmarks.
+ */
+class LockingWorkStealingQueue
+{
+public:
+  LockingWorkStealingQueue();
+
   /**
    * Push a task to the back
    * @param task pointer to task to push back
+   * @return false if the ring buffer is full and the task was not pushed
    */
-  void Push(Task* task); ///< push a task to the back
+  bool Push(Task* task);
 
   /**
    * Pop a task from the back
@@ -49,4 +98,4 @@ private:
   uint32 m_Top;                   ///< "index" to the front task
 };
 
-} // namespace bge
\ No newline at end of file
+} // namespace bge
@@ -1,11 +1,14 @@
 #include "core/Application.h"
 
 #include "logging/Log.h"
+#include "memory/FrameAllocator.h"
 #include "physics/PhysicsDevice.h"
+#include "rendering/NullRenderDevice.h"
 #include "rendering/RenderDevice.h"
 #include "scheduler/Scheduler.h"
 #include "util/Timer.h"
 
+#include <cstdlib>
 #include <functional>
 #include <thread>
 
@@ -26,19 +29,43 @@ constexpr float c_DesiredRenderFrameMS = c_MillisPerSecond / c_DesiredRenderFPS;
 
 Application* Application::s_Instance = nullptr;
 
-Application::Application()
+Application::Application(const ApplicationConfig& config)
     : m_World()
     , m_Window()
+    , m_Config(config)
     , m_Running(true)
 {
   BGE_CORE_ASSERT(!s_Instance, "Application already exists!");
   s_Instance = this;
 
-  m_Window.Create(WindowData("BGE Window"));
-  m_Window.SetEventCallback(BGE_BIND_EVENT_FN(Application::OnEvent));
+#if !defined BGE_NULL_RENDER_DEVICE
+  // Without a window the OpenGL device has no context to draw into
+  if (m_Config.m_Headless)
+  {
+    BGE_CORE_ERROR("Headless applications need the engine built with "
+                   "BGE_NULL_RENDER_DEVICE!");
+    std::exit(EXIT_FAILURE);
+  }
+  if (!m_Config.m_TracePath.empty())
+  {
+    BGE_CORE_WARN("Render command traces are only recorded by the null "
+                  "render device, no trace is written.");
+  }
+#endif
+
+  if (m_Config.m_Headless)
+  {
+    BGE_CORE_INFO("Running headless, without a window.");
+  }
+  else
+  {
+    m_Window.Create(m_Config.m_Window);
+    m_Window.SetEventCallback(BGE_BIND_EVENT_FN(Application::OnEvent));
+  }
   m_World.SetEventCallback(BGE_BIND_EVENT_FN(Application::OnEvent));
 
   Scheduler::Initialize();
+  FrameAllocator::Initialize();
   RenderDevice::Initialize();
   PhysicsDevice::Initialize();
 
@@ -48,6 +75,7 @@ Application::Application()
 Application::~Application()
 {
   RenderDevice::Shutdown();
+  FrameAllocator::Shutdown();
   Scheduler::Shutdown();
 }
 
@@ -62,11 +90,24 @@ void Application::Run()
   float averageAccumulator = 0.0f;
   int frameCounter = 0;
   int framesToAverage = 100;
+  uint32 framesRun = 0;
 
-  while (m_Running)
+  while (m_Running &&
+         (m_Config.m_MaxFrames == 0 || framesRun < m_Config.m_MaxFrames))
   {
     renderTimer.Renew();
 
+    // The temporary memory of the last frame is freed
+    FrameAllocator::NextFrame();
+
+#if defined BGE_NULL_RENDER_DEVICE
+    // Restarted every frame, so the trace holds the commands of the last one
+    if (!m_Config.m_TracePath.empty())
+    {
+      NullRenderDevice::StartTrace();
+    }
+#endif
+
     int32 numUpdates = 0;
 
     while (updateTimer.GetElapsedMilli() > millisElapsed &&
@@ -87,8 +128,9 @@ void Application::Run()
 
     m_Window.OnTick();
 
+    // Without a window there's nothing to present, frames run back to back
     float elapsed = renderTimer.GetElapsedMilli();
-    if (elapsed < c_DesiredRenderFrameMS)
+    if (!m_Config.m_Headless && elapsed < c_DesiredRenderFrameMS)
     {
       std::this_thread::sleep_for(std::chrono::duration<float, std::milli>(
           c_DesiredRenderFrameMS - elapsed));
@@ -96,16 +138,33 @@ void Application::Run()
 
     averageAccumulator += elapsed;
     ++frameCounter;
+    ++framesRun;
     if (frameCounter == framesToAverage)
     {
       BGE_CORE_ERROR("Average frame time of {0} frames: {1} ms", frameCounter,
                      averageAccumulator / framesToAverage);
+      m_World.GetUpdateGraph().LogReport();
+      FrameAllocator::LogStats();
+      m_World.GetRenderWorld().GetRenderQueue().LogStats(framesToAverage);
+      m_World.GetRenderWorld().GetRenderQueue().ResetStats();
+#if defined BGE_NULL_RENDER_DEVICE
+      NullRenderDevice::LogStats(framesToAverage);
+      NullRenderDevice::ResetStats();
+#endif
       averageAccumulator = 0.0f;
       frameCounter = 0;
     }
     // BGE_CORE_INFO("numUpdates: {0}", numUpdates);
     // BGE_CORE_INFO("interpolation: {0}", interpolation);
   }
+
+#if defined BGE_NULL_RENDER_DEVICE
+  if (!m_Config.m_TracePath.empty())
+  {
+    NullRenderDevice::StopTrace();
+    NullRenderDevice::SaveTrace(m_Config.m_TracePath.c_str());
+  }
+#endif
 }
 
 void Application::OnEvent(Event& event)
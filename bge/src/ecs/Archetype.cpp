@@ -0,0 +1,153 @@
+#include "ecs/Archetype.h"
+
+#include "logging/Log.h"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+namespace bge
+{
+
+constexpr uint32 Archetype::c_InvalidColumn;
+
+/// alignment of the chunks and of every column, enough for SIMD loads
+static constexpr uint32 s_ColumnAlignment = 64u;
+
+/**
+ * @return value rounded up to a multiple of alignment, a power of 2
+ */
+static FORCEINLINE uint32 AlignUp(uint32 value, uint32 alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+/**
+ * Lay out the columns of count entities after the entity array of a chunk
+ * @param types the component types
+ * @param count number of entities per chunk
+ * @param offsets receives the byte offset of every column
+ * @return the bytes the chunk needs
+ */
+static uint32 LayOutColumns(const std::vector<ComponentType>& types,
+                            uint32 count, std::vector<uint32>& offsets)
+{
+  uint32 size = count * static_cast<uint32>(sizeof(Entity));
+
+  offsets.clear();
+  for (auto&& type : types)
+  {
+    BGE_CORE_ASSERT(type.m_Alignment <= s_ColumnAlignment,
+                    "Component alignment is larger than the column alignment");
+
+    size = AlignUp(size, s_ColumnAlignment);
+    offsets.push_back(size);
+    size += count * type.m_Size;
+  }
+
+  return size;
+}
+
+Archetype::Archetype(const std::vector<ComponentType>& types)
+    : m_Types(types)
+    , m_ColumnOffsets()
+    , m_Chunks()
+    , m_ChunkCapacity(0)
+    , m_Count(0)
+{
+  uint32 entitySize = static_cast<uint32>(sizeof(Entity));
+  for (auto&& type : m_Types)
+  {
+    entitySize += type.m_Size;
+  }
+
+  // Start from the count which ignores the column padding and shrink it until
+  // the padded columns fit
+  m_ChunkCapacity = c_ArchetypeChunkSize / entitySize;
+  while (LayOutColumns(m_Types, m_ChunkCapacity, m_ColumnOffsets) >
+             c_ArchetypeChunkSize &&
+         m_ChunkCapacity > 1)
+  {
+    --m_ChunkCapacity;
+  }
+
+  BGE_CORE_ASSERT(m_ChunkCapacity > 0, "Components don't fit in a chunk");
+}
+
+Archetype::~Archetype()
+{
+  for (auto&& chunk : m_Chunks)
+  {
+    _mm_free(chunk);
+  }
+}
+
+uint32 Archetype::Add(Entity entity)
+{
+  const uint32 index = m_Count;
+
+  if (index / m_ChunkCapacity == m_Chunks.size())
+  {
+    m_Chunks.push_back(static_cast<uint8*>(
+        _mm_malloc(c_ArchetypeChunkSize, s_ColumnAlignment)));
+  }
+
+  ++m_Count;
+  GetEntities(index / m_ChunkCapacity)[index % m_ChunkCapacity] = entity;
+
+  return index;
+}
+
+Entity Archetype::Remove(uint32 index)
+{
+  BGE_CORE_ASSERT(index < m_Count, "Index is out of the archetype");
+
+  const uint32 last = --m_Count;
+
+  if (index == last)
+  {
+    return Entity(0u, 0u);
+  }
+
+  const Entity moved = GetEntity(last);
+  GetEntities(index / m_ChunkCapacity)[index % m_ChunkCapacity] = moved;
+
+  for (uint32 column = 0; column < m_Types.size(); ++column)
+  {
+    memcpy(GetComponent(column, index), GetComponent(column, last),
+           m_Types[column].m_Size);
+  }
+
+  return moved;
+}
+
+uint32 Archetype::FindColumn(uint32 typeId) const
+{
+  for (uint32 column = 0; column < m_Types.size(); ++column)
+  {
+    if (m_Types[column].m_Id == typeId)
+    {
+      return column;
+    }
+  }
+
+  return c_InvalidColumn;
+}
+
+bool Archetype::FindColumns(const uint32* typeIds, uint32 count,
+                            uint32* columns) const
+{
+  for (uint32 i = 0; i < count; ++i)
+  {
+    columns[i] = FindColumn(typeIds[i]);
+
+    if (columns[i] == c_InvalidColumn)
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+} // namespace bge
@@ -0,0 +1,234 @@
+#include "ecs/ArchetypeManager.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bge
+{
+
+constexpr uint32 ArchetypeManager::c_InvalidIndex;
+
+ArchetypeManager::ArchetypeManager()
+    : m_Archetypes()
+    , m_ArchetypeIndices()
+    , m_Locations()
+    , m_EntityCount(0)
+    , m_Signature()
+    , m_TypeIds()
+{
+}
+
+void ArchetypeManager::RemoveEntity(Entity entity)
+{
+  BGE_CORE_ASSERT(Contains(entity), "Entity has no components");
+
+  EntityLocation& location = GetLocation(entity);
+  RemoveFromArchetype(location);
+
+  location.m_Archetype = c_InvalidIndex;
+  --m_EntityCount;
+}
+
+void ArchetypeManager::RemoveEntities(const std::vector<Entity>& entities)
+{
+  for (auto&& entity : entities)
+  {
+    if (Contains(entity))
+    {
+      RemoveEntity(entity);
+    }
+  }
+}
+
+bool ArchetypeManager::Contains(Entity entity) const
+{
+  const uint32 id = entity.GetId();
+
+  if (id >= m_Locations.size() ||
+      m_Locations[id].m_Archetype == c_InvalidIndex)
+  {
+    return false;
+  }
+
+  // An older generation of the id may still be stored
+  const EntityLocation& location = m_Locations[id];
+  return m_Archetypes[location.m_Archetype]->GetEntity(location.m_Index) ==
+         entity;
+}
+
+bool ArchetypeManager::HasComponentType(Entity entity, uint32 typeId) const
+{
+  return Contains(entity) &&
+         m_Archetypes[m_Locations[entity.GetId()].m_Archetype]->FindColumn(
+             typeId) != Archetype::c_InvalidColumn;
+}
+
+void ArchetypeManager::AddComponentData(Entity entity,
+                                        const ComponentType* types,
+                                        const uint8* const* components,
+                                        uint32 count)
+{
+  const uint32 index = AddComponentTypes(entity, types, count);
+  Archetype& archetype = *m_Archetypes[GetLocation(entity).m_Archetype];
+
+  for (uint32 i = 0; i < count; ++i)
+  {
+    memcpy(archetype.GetComponent(archetype.FindColumn(types[i].m_Id), index),
+           components[i], types[i].m_Size);
+  }
+}
+
+uint32 ArchetypeManager::AddComponentTypes(Entity entity,
+                                           const ComponentType* types,
+                                           uint32 count)
+{
+  std::vector<ComponentType>& signature = m_Signature;
+  signature.clear();
+
+  if (Contains(entity))
+  {
+    const std::vector<ComponentType>& current =
+        m_Archetypes[GetLocation(entity).m_Archetype]->GetTypes();
+    signature.assign(current.begin(), current.end());
+  }
+
+  for (uint32 i = 0; i < count; ++i)
+  {
+    const auto found = std::find_if(
+        signature.begin(), signature.end(),
+        [&](const ComponentType& type) { return type.m_Id == types[i].m_Id; });
+
+    if (found == signature.end())
+    {
+      signature.push_back(types[i]);
+    }
+  }
+
+  std::sort(signature.begin(), signature.end(),
+            [](const ComponentType& a, const ComponentType& b) {
+              return a.m_Id < b.m_Id;
+            });
+
+  return MoveEntity(entity, FindOrCreateArchetype(signature));
+}
+
+void ArchetypeManager::RemoveComponentType(Entity entity, uint32 typeId)
+{
+  BGE_CORE_ASSERT(Contains(entity), "Entity has no components");
+
+  std::vector<ComponentType>& signature = m_Signature;
+  const std::vector<ComponentType>& current =
+      m_Archetypes[GetLocation(entity).m_Archetype]->GetTypes();
+  signature.assign(current.begin(), current.end());
+
+  const auto found = std::find_if(
+      signature.begin(), signature.end(),
+      [&](const ComponentType& type) { return type.m_Id == typeId; });
+
+  BGE_CORE_ASSERT(found != signature.end(), "Entity has no such component");
+
+  signature.erase(found);
+
+  if (signature.empty())
+  {
+    RemoveEntity(entity);
+    return;
+  }
+
+  MoveEntity(entity, FindOrCreateArchetype(signature));
+}
+
+uint32
+ArchetypeManager::FindOrCreateArchetype(const std::vector<ComponentType>& types)
+{
+  std::vector<uint32>& typeIds = m_TypeIds;
+  typeIds.clear();
+  for (auto&& type : types)
+  {
+    typeIds.push_back(type.m_Id);
+  }
+
+  const auto found = m_ArchetypeIndices.find(typeIds);
+  if (found != m_ArchetypeIndices.end())
+  {
+    return found->second;
+  }
+
+  const uint32 index = static_cast<uint32>(m_Archetypes.size());
+  m_Archetypes.emplace_back(std::make_unique<Archetype>(types));
+  m_ArchetypeIndices.emplace(typeIds, index);
+
+  return index;
+}
+
+uint32 ArchetypeManager::MoveEntity(Entity entity, uint32 archetype)
+{
+  if (entity.GetId() >= m_Locations.size())
+  {
+    m_Locations.resize(
+        std::max<size_t>(entity.GetId() + 1, m_Locations.size() * 2),
+        EntityLocation{c_InvalidIndex, 0u});
+  }
+
+  const bool hadComponents = Contains(entity);
+  EntityLocation& location = GetLocation(entity);
+
+  if (hadComponents && location.m_Archetype == archetype)
+  {
+    return location.m_Index;
+  }
+
+  if (!hadComponents && location.m_Archetype != c_InvalidIndex)
+  {
+    // A destroyed generation of the id which was never removed, it would
+    // lose its location otherwise
+    RemoveFromArchetype(location);
+    --m_EntityCount;
+  }
+
+  Archetype& destination = *m_Archetypes[archetype];
+  const uint32 index = destination.Add(entity);
+
+  if (hadComponents)
+  {
+    Archetype& source = *m_Archetypes[location.m_Archetype];
+    const std::vector<ComponentType>& types = source.GetTypes();
+
+    for (uint32 column = 0; column < types.size(); ++column)
+    {
+      const uint32 destinationColumn =
+          destination.FindColumn(types[column].m_Id);
+
+      if (destinationColumn != Archetype::c_InvalidColumn)
+      {
+        memcpy(destination.GetComponent(destinationColumn, index),
+               source.GetComponent(column, location.m_Index),
+               types[column].m_Size);
+      }
+    }
+
+    RemoveFromArchetype(location);
+  }
+  else
+  {
+    ++m_EntityCount;
+  }
+
+  location.m_Archetype = archetype;
+  location.m_Index = index;
+
+  return index;
+}
+
+void ArchetypeManager::RemoveFromArchetype(const EntityLocation& location)
+{
+  const Entity moved =
+      m_Archetypes[location.m_Archetype]->Remove(location.m_Index);
+
+  if (!moved.IsNull())
+  {
+    GetLocation(moved).m_Index = location.m_Index;
+  }
+}
+
+} // namespace bge
@@ -2,13 +2,17 @@
 
 #include "logging/Log.h"
 
+#include <atomic>
+
 namespace bge
 {
 
 uint32 internal::GenerateUniqueTypeId()
 {
-  static uint32 s_uniqueComponentIdCounter = 0;
-  return s_uniqueComponentIdCounter++;
+  // Command buffers are recorded in parallel, so the first use of a component
+  // type can happen on several threads at once
+  static std::atomic<uint32> s_uniqueComponentIdCounter{0u};
+  return s_uniqueComponentIdCounter.fetch_add(1u);
 }
 
 } // namespace bge
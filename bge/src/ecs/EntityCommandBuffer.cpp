@@ -0,0 +1,211 @@
+#include "ecs/EntityCommandBuffer.h"
+
+#include "ecs/ArchetypeManager.h"
+#include "ecs/EntityManager.h"
+
+#include <algorithm>
+
+namespace bge
+{
+
+EntityCommandBuffer::EntityCommandBuffer(std::atomic<uint32>* placeholderCount)
+    : m_Commands()
+    , m_Runs()
+    , m_Data()
+    , m_PlaceholderCount(placeholderCount)
+    , m_SortKey(0)
+{
+}
+
+Entity EntityCommandBuffer::CreateEntity()
+{
+  const uint32 index =
+      m_PlaceholderCount->fetch_add(1u, std::memory_order_relaxed);
+  BGE_CORE_ASSERT(index <= c_EntityIndexMask, "Entity Index Overflow");
+
+  // The EntityManager never hands out the last generation, so it marks
+  // placeholders, whose index is the index of the placeholder in the queue
+  return Entity(index, static_cast<uint32>(c_EntityGenerationMask));
+}
+
+void EntityCommandBuffer::DestroyEntity(Entity entity)
+{
+  Record(CommandType::DestroyEntity, entity, ComponentType{0u, 0u, 0u}, 0u);
+}
+
+void EntityCommandBuffer::Clear()
+{
+  m_Commands.clear();
+  m_Runs.clear();
+  m_Data.clear();
+}
+
+void EntityCommandBuffer::Record(CommandType command, Entity entity,
+                                 const ComponentType& type, uint32 dataOffset)
+{
+  if (m_Runs.empty() || m_Runs.back().m_SortKey != m_SortKey)
+  {
+    m_Runs.push_back(
+        CommandRun{m_SortKey, static_cast<uint32>(m_Commands.size())});
+  }
+
+  m_Commands.push_back(Command{entity, type, dataOffset, command});
+}
+
+EntityCommandQueue::EntityCommandQueue()
+    : m_Buffers()
+    , m_PlaceholderCount(0u)
+    , m_Created()
+    , m_Runs()
+    , m_Destroyed()
+    , m_AddedTypes()
+    , m_AddedData()
+{
+}
+
+void EntityCommandQueue::Init()
+{
+  m_Buffers.assign(Scheduler::GetMaxWorkerCount(),
+                   EntityCommandBuffer(&m_PlaceholderCount));
+}
+
+void EntityCommandQueue::Playback(EntityManager& entityManager,
+                                  ArchetypeManager& archetypes,
+                                  std::vector<Entity>& destroyed)
+{
+  // All placeholders become entities in one batch
+  const uint32 createdCount = m_PlaceholderCount.exchange(0u);
+  m_Created.assign(createdCount, Entity(0u, 0u));
+  entityManager.CreateEntities(createdCount, m_Created.data());
+
+  // Only the runs are sorted, the commands of a run are already in the order
+  // they were recorded in
+  m_Runs.clear();
+  for (auto&& buffer : m_Buffers)
+  {
+    const uint32 runCount = static_cast<uint32>(buffer.m_Runs.size());
+
+    for (uint32 run = 0; run < runCount; ++run)
+    {
+      const uint32 end = run + 1 < runCount ? buffer.m_Runs[run + 1].m_Begin
+                                            : buffer.GetCommandCount();
+      m_Runs.push_back(SortedRun{buffer.m_Runs[run].m_SortKey, &buffer,
+                                 buffer.m_Runs[run].m_Begin, end});
+    }
+  }
+
+  // Runs with the same key stay in the order of the workers, whose buffers
+  // are contiguous, and then of the recording. Unlike std::stable_sort, which
+  // takes a temporary buffer from the heap, std::sort works in place.
+  std::sort(m_Runs.begin(), m_Runs.end(),
+            [](const SortedRun& a, const SortedRun& b) {
+              if (a.m_SortKey != b.m_SortKey)
+              {
+                return a.m_SortKey < b.m_SortKey;
+              }
+              if (a.m_Buffer != b.m_Buffer)
+              {
+                return a.m_Buffer < b.m_Buffer;
+              }
+              return a.m_Begin < b.m_Begin;
+            });
+
+  m_Destroyed.clear();
+  for (auto&& run : m_Runs)
+  {
+    ApplyRun(entityManager, archetypes, run);
+  }
+
+  // An entity recorded more than once is destroyed once, entities which were
+  // already dead are skipped, the rest is destroyed in one batch
+  std::sort(m_Destroyed.begin(), m_Destroyed.end());
+  m_Destroyed.erase(std::unique(m_Destroyed.begin(), m_Destroyed.end()),
+                    m_Destroyed.end());
+  m_Destroyed.erase(std::remove_if(m_Destroyed.begin(), m_Destroyed.end(),
+                                   [&](Entity entity) {
+                                     return !entityManager.IsAlive(entity);
+                                   }),
+                    m_Destroyed.end());
+
+  entityManager.DestroyEntities(m_Destroyed.data(),
+                                static_cast<uint32>(m_Destroyed.size()));
+  destroyed.insert(destroyed.end(), m_Destroyed.begin(), m_Destroyed.end());
+
+  for (auto&& buffer : m_Buffers)
+  {
+    buffer.Clear();
+  }
+}
+
+Entity EntityCommandQueue::Resolve(Entity entity) const
+{
+  if (entity.GetGeneration() != c_EntityGenerationMask)
+  {
+    return entity;
+  }
+
+  BGE_CORE_ASSERT(entity.GetId() < m_Created.size(),
+                  "Placeholder entity of another queue");
+
+  return m_Created[entity.GetId()];
+}
+
+void EntityCommandQueue::ApplyRun(EntityManager& entityManager,
+                                  ArchetypeManager& archetypes,
+                                  const SortedRun& run)
+{
+  using CommandType = EntityCommandBuffer::CommandType;
+
+  const std::vector<EntityCommandBuffer::Command>& commands =
+      run.m_Buffer->m_Commands;
+  const uint8* data = run.m_Buffer->m_Data.data();
+
+  for (uint32 i = run.m_Begin; i < run.m_End;)
+  {
+    const EntityCommandBuffer::Command& command = commands[i];
+    const Entity entity = Resolve(command.m_Entity);
+
+    if (command.m_Command == CommandType::DestroyEntity)
+    {
+      m_Destroyed.push_back(entity);
+      ++i;
+      continue;
+    }
+
+    // Entities destroyed before the playback drop their commands
+    if (!entityManager.IsAlive(entity))
+    {
+      ++i;
+      continue;
+    }
+
+    if (command.m_Command == CommandType::RemoveComponent)
+    {
+      if (archetypes.HasComponentType(entity, command.m_Type.m_Id))
+      {
+        archetypes.RemoveComponentType(entity, command.m_Type.m_Id);
+      }
+
+      ++i;
+      continue;
+    }
+
+    // Consecutive additions to an entity move it to its new archetype once
+    m_AddedTypes.clear();
+    m_AddedData.clear();
+
+    for (; i < run.m_End &&
+           commands[i].m_Command == CommandType::AddComponent &&
+           commands[i].m_Entity == command.m_Entity;
+         ++i)
+    {
+      m_AddedTypes.push_back(commands[i].m_Type);
+      m_AddedData.push_back(data + commands[i].m_DataOffset);
+    }
+
+    archetypes.AddComponentData(entity, m_AddedTypes.data(), m_AddedData.data(),
+                                static_cast<uint32>(m_AddedTypes.size()));
+  }
+}
+
+} // namespace bge
@@ -0,0 +1,93 @@
+#include "ecs/EntityIndex.h"
+
+#include <algorithm>
+
+namespace bge
+{
+
+constexpr uint32 EntityIndex::c_InvalidIndex;
+
+EntityIndex::EntityIndex()
+    : m_Sparse()
+    , m_Dense()
+    , m_MovedFrom()
+    , m_FirstMoved(0)
+{
+}
+
+uint32 EntityIndex::Add(Entity entity)
+{
+  BGE_CORE_ASSERT(!Contains(entity), "Entity is already in the index");
+
+  const uint32 id = entity.GetId();
+
+  if (id >= m_Sparse.size())
+  {
+    // Grow geometrically, ids are handed out mostly in increasing order
+    m_Sparse.resize(std::max<size_t>(id + 1, m_Sparse.size() * 2),
+                    c_InvalidIndex);
+  }
+
+  const uint32 index = GetCount();
+  m_Sparse[id] = index;
+  m_Dense.push_back(entity);
+
+  return index;
+}
+
+uint32 EntityIndex::Remove(Entity entity)
+{
+  const uint32 index = GetIndex(entity);
+  const Entity last = m_Dense.back();
+
+  m_Dense[index] = last;
+  m_Sparse[last.GetId()] = index;
+
+  m_Dense.pop_back();
+  m_Sparse[entity.GetId()] = c_InvalidIndex;
+
+  return index;
+}
+
+uint32 EntityIndex::RemoveBatch(const Entity* entities, uint32 count)
+{
+  uint32 first = GetCount();
+
+  // Clear the sparse entries first, so the pass below can tell the removed
+  // entities apart. Entities which are not in the index are skipped.
+  for (uint32 i = 0; i < count; ++i)
+  {
+    const uint32 index = Find(entities[i]);
+
+    if (index != c_InvalidIndex)
+    {
+      m_Sparse[entities[i].GetId()] = c_InvalidIndex;
+      first = std::min(first, index);
+    }
+  }
+
+  m_MovedFrom.clear();
+  m_FirstMoved = first;
+
+  // Everything before the first removed entity stays where it is
+  uint32 write = first;
+  for (uint32 read = first; read < GetCount(); ++read)
+  {
+    const Entity entity = m_Dense[read];
+
+    if (m_Sparse[entity.GetId()] != c_InvalidIndex)
+    {
+      m_Sparse[entity.GetId()] = write;
+      m_Dense[write++] = entity;
+      m_MovedFrom.push_back(read);
+    }
+  }
+
+  m_Dense.erase(m_Dense.begin() + write, m_Dense.end());
+
+  return first;
+}
+
+void EntityIndex::Reserve(uint32 count) { m_Dense.reserve(count); }
+
+} // namespace bge
@@ -2,12 +2,16 @@
 
 #include "logging/Log.h"
 
+#include <algorithm>
+
 namespace bge
 {
 
-static constexpr uint32 c_MinFreeIndices = 1024;
-
-EntityManager::EntityManager()
+EntityManager::EntityManager(uint32 minFreeIndices)
+    : m_EntityVersion()
+    , m_FreeList()
+    , m_FreeHead(0)
+    , m_MinFreeIndices(minFreeIndices)
 {
   // Emplace the first entity which will act as the null (index of 0)
   m_EntityVersion.push_back(0u);
@@ -17,28 +21,97 @@ Entity EntityManager::CreateEntity()
 {
   uint32 index = 0;
 
-  if (m_FreeList.size() > c_MinFreeIndices)
+  if (GetFreeCount() > m_MinFreeIndices)
   {
-    index = m_FreeList.front();
-    m_FreeList.pop_front();
+    index = PopFreeIndex();
   }
   else
   {
+    index = static_cast<uint32>(m_EntityVersion.size());
+    BGE_CORE_ASSERT(index <= c_EntityIndexMask, "Entity Index Overflow");
     m_EntityVersion.push_back(0u);
-    index = m_EntityVersion.size() - 1;
-    BGE_CORE_ASSERT(index < (1 << c_EntityIndexBits), "Entity Index Overflow");
   }
 
   return Entity(index, m_EntityVersion[index]);
 }
 
+void EntityManager::CreateEntities(uint32 count, Entity* output)
+{
+  const uint32 freeCount = GetFreeCount();
+  const uint32 reusedCount =
+      freeCount > m_MinFreeIndices
+          ? std::min(count, freeCount - m_MinFreeIndices)
+          : 0u;
+
+  for (uint32 i = 0; i < reusedCount; ++i)
+  {
+    const uint32 index = PopFreeIndex();
+    output[i] = Entity(index, m_EntityVersion[index]);
+  }
+
+  // The rest are new indices, appended in one go
+  const uint32 first = static_cast<uint32>(m_EntityVersion.size());
+  const uint32 newCount = count - reusedCount;
+
+  BGE_CORE_ASSERT(newCount == 0 || first + newCount - 1 <= c_EntityIndexMask,
+                  "Entity Index Overflow");
+
+  m_EntityVersion.resize(first + newCount, 0u);
+  for (uint32 i = 0; i < newCount; ++i)
+  {
+    output[reusedCount + i] = Entity(first + i, 0u);
+  }
+}
+
 void EntityManager::DestroyEntity(Entity id)
 {
   BGE_CORE_ASSERT(IsAlive(id), "Entity is already destroyed");
 
-  uint32 index = id.GetId();
-  ++m_EntityVersion[index];
+  ReleaseIndex(id.GetId());
+}
+
+void EntityManager::DestroyEntities(const Entity* entities, uint32 count)
+{
+  CompactFreeList();
+
+  // Append to the FIFO through a pointer, the retired indices are skipped
+  const size_t first = m_FreeList.size();
+  m_FreeList.resize(first + count);
+  uint32* freeList = m_FreeList.data() + first;
+  uint32 freeCount = 0;
+
+  for (uint32 i = 0; i < count; ++i)
+  {
+    BGE_CORE_ASSERT(IsAlive(entities[i]), "Entity is already destroyed");
+
+    const uint32 index = entities[i].GetId();
+    freeList[freeCount] = index;
+    freeCount += ++m_EntityVersion[index] != c_EntityGenerationMask ? 1 : 0;
+  }
+
+  m_FreeList.resize(first + freeCount);
+}
+
+void EntityManager::ReleaseIndex(uint32 index)
+{
+  // The last generation is never handed out, it marks a retired index
+  if (++m_EntityVersion[index] == c_EntityGenerationMask)
+  {
+    return;
+  }
+
+  CompactFreeList();
   m_FreeList.push_back(index);
 }
 
-} // namespace bge
\ No newline at end of file
+void EntityManager::CompactFreeList()
+{
+  // Drop the consumed front of the FIFO once it's the larger part
+  if (m_FreeHead > 0 && m_FreeHead >= GetFreeCount())
+  {
+    m_FreeList.erase(m_FreeList.begin(), m_FreeList.begin() + m_FreeHead);
+    m_FreeHead = 0;
+  }
+}
+
+} // namespace bge
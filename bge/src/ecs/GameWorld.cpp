@@ -10,26 +10,70 @@ void GameWorld::SetEventCallback(const std::function<void(Event&)>& callback)
   m_EventCallback = callback;
 }
 
-void GameWorld::Tick(float deltaSeconds)
+void GameWorld::SetCommandQueue(EntityCommandQueue* commandQueue)
 {
+  m_CommandQueue = commandQueue;
+
   for (auto&& system : m_GameSystems)
   {
-    system->Tick(deltaSeconds);
+    system->m_CommandQueue = commandQueue;
   }
 }
 
-void GameWorld::OnEvent(Event& event)
+void GameWorld::Tick(float deltaSeconds)
 {
-  EventDispatcher dispatcher(event);
+  m_EventBus.DeliverQueued();
 
-  for (auto&& system : m_GameSystems)
+  if (!m_Schedule)
+  {
+    BuildSchedule();
+  }
+
+  m_DeltaSeconds = deltaSeconds;
+  if (m_Schedule->GetJobCount() > 0)
   {
-    system->OnEvent(event);
-    if (event.m_Handled)
+    m_Schedule->Execute();
+  }
+
+  for (auto&& index : m_SerialSystems)
+  {
+    TickSystem(index);
+  }
+}
+
+void GameWorld::BuildSchedule()
+{
+  m_Schedule = std::make_unique<JobGraph>();
+  m_SerialSystems.clear();
+
+  for (uint32 i = 0; i < m_GameSystems.size(); ++i)
+  {
+    const GameSystem& system = *m_GameSystems[i];
+
+    if (!system.m_HasAccessDeclaration)
     {
-      break;
+      m_SerialSystems.push_back(i);
+      continue;
     }
+
+    // Jobs are added in the order of the systems, so systems with conflicting
+    // access tick in that order
+    m_Schedule->AddJob("GameSystem::Tick", [this, i]() { TickSystem(i); },
+                       system.m_Reads, system.m_Writes);
+  }
+
+  m_Schedule->Build();
+}
+
+void GameWorld::TickSystem(uint32 index)
+{
+  if (m_CommandQueue)
+  {
+    m_CommandQueue->GetBuffer().SetSortKey(index);
   }
+  m_GameSystems[index]->Tick(m_DeltaSeconds);
 }
 
+void GameWorld::OnEvent(Event& event) { m_EventBus.Enqueue(event); }
+
 } // namespace bge
@@ -7,15 +7,63 @@ namespace bge
 
 World::World()
     : m_EntityManager()
+    , m_Archetypes()
+    , m_Commands()
     , m_RenderWorld()
     , m_PhysicsWorld()
     , m_GameWorld()
     , m_DestroyedEntities()
+    , m_UpdateGraph()
     , m_EventCallback()
 {
+  m_GameWorld.SetCommandQueue(&m_Commands);
 }
 
-void World::Init() { m_RenderWorld.Init(); }
+void World::Init()
+{
+  m_Commands.Init();
+  m_RenderWorld.Init();
+  BuildUpdateGraph();
+}
+
+void World::BuildUpdateGraph()
+{
+  const JobResourceId entities = GetJobResourceId<EntityManager>();
+  const JobResourceId archetypes = GetJobResourceId<ArchetypeManager>();
+  const JobResourceId game = GetJobResourceId<GameWorld>();
+  const JobResourceId physics = GetJobResourceId<PhysicsWorld>();
+  const JobResourceId render = GetJobResourceId<RenderWorld>();
+
+  // Collision events are broadcast to all sub-worlds
+  m_UpdateGraph.AddJob("PhysicsWorld::Simulate",
+                       [this]() { m_PhysicsWorld.Simulate(); }, {},
+                       {physics, game, render});
+
+  m_UpdateGraph.AddJob("DynamicMeshSystem::UpdateTransforms",
+                       [this]() {
+                         m_RenderWorld.GetDynamicMeshSystem().UpdateTransforms(
+                             m_PhysicsWorld.GetRigidBodySystem()
+                                 .GetBodyMatrices());
+                       },
+                       {physics}, {render});
+
+  // Every sub-world handles the destroyed entities independently
+  m_UpdateGraph.AddJob("RenderWorld destroyed entities",
+                       [this]() { FlushDestroyedEntities(m_RenderWorld); },
+                       {entities}, {render});
+  m_UpdateGraph.AddJob("PhysicsWorld destroyed entities",
+                       [this]() { FlushDestroyedEntities(m_PhysicsWorld); },
+                       {entities}, {physics});
+  m_UpdateGraph.AddJob("GameWorld destroyed entities",
+                       [this]() { FlushDestroyedEntities(m_GameWorld); },
+                       {entities}, {game});
+  m_UpdateGraph.AddJob(
+      "ArchetypeManager destroyed entities",
+      [this]() { m_Archetypes.RemoveEntities(m_DestroyedEntities); },
+      {entities}, {archetypes});
+
+  m_UpdateGraph.Build();
+}
 
 void World::SetEventCallback(const std::function<void(Event&)>& callback)
 {
@@ -28,31 +76,42 @@ void World::SetEventCallback(const std::function<void(Event&)>& callback)
 
 Entity World::CreateEntity() { return m_EntityManager.CreateEntity(); }
 
+void World::CreateEntities(uint32 count, Entity* output)
+{
+  m_EntityManager.CreateEntities(count, output);
+}
+
 void World::DestroyEntity(Entity entity)
 {
   m_EntityManager.DestroyEntity(entity);
   m_DestroyedEntities.push_back(entity);
 }
 
+void World::DestroyEntities(const Entity* entities, uint32 count)
+{
+  m_EntityManager.DestroyEntities(entities, count);
+  m_DestroyedEntities.insert(m_DestroyedEntities.end(), entities,
+                             entities + count);
+}
+
 void World::Update(float deltaTime)
 {
+  // Game systems which aren't thread safe poll input, which has to happen on
+  // the main thread, and can touch any sub-world, so they tick before the
+  // graph starts
   m_GameWorld.Tick(deltaTime);
-  // m_audioWorld.Update();
-  m_PhysicsWorld.Simulate();
 
-  m_RenderWorld.GetDynamicMeshSystem().UpdateTransforms(
-      m_PhysicsWorld.GetRigidBodySystem().GetBodyTransforms());
+  // The sync point of the structural changes the systems recorded, the
+  // destroyed entities are handled by the graph with the rest
+  m_Commands.Playback(m_EntityManager, m_Archetypes, m_DestroyedEntities);
 
-  if (!m_DestroyedEntities.empty())
-  {
-    EntitiesDestroyedEvent event(m_DestroyedEntities);
-    // No need to use the event callback which sends the event to the "app
-    // layer" For now, entity deletion only matters for the sub-worlds
-    OnEvent(event);
+  // m_audioWorld.Update();
+  // Destroyed entities aren't sent through the event callback to the "app
+  // layer". For now, entity deletion only matters for the sub-worlds
+  m_UpdateGraph.Execute();
 
-    // Clear the list now that it's been handled
-    m_DestroyedEntities.clear();
-  }
+  // Clear the list now that it's been handled
+  m_DestroyedEntities.clear();
 }
 
 void World::Render(float interpolation) { m_RenderWorld.Render(interpolation); }
@@ -0,0 +1,57 @@
+#include "events/EventBus.h"
+
+namespace bge
+{
+
+EventBus::EventBus()
+    : m_Subscribers()
+    , m_Queues()
+    , m_QueuedTypes()
+    , m_DeliveredTypes()
+{
+}
+
+void EventBus::Publish(Event& event)
+{
+  const uint32 type = static_cast<uint32>(event.GetEventType());
+
+  for (auto&& subscriber : m_Subscribers[type])
+  {
+    if (subscriber(event))
+    {
+      event.m_Handled = true;
+      break;
+    }
+  }
+}
+
+void EventBus::Enqueue(const Event& event)
+{
+  const uint32 type = static_cast<uint32>(event.GetEventType());
+  EventQueueBase* queue = m_Queues[type].get();
+
+  if (!queue)
+  {
+    return;
+  }
+
+  if (queue->IsEmpty())
+  {
+    m_QueuedTypes.push_back(type);
+  }
+  queue->Push(event);
+}
+
+void EventBus::DeliverQueued()
+{
+  m_DeliveredTypes.swap(m_QueuedTypes);
+
+  for (auto&& type : m_DeliveredTypes)
+  {
+    m_Queues[type]->Deliver(*this);
+  }
+
+  m_DeliveredTypes.clear();
+}
+
+} // namespace bge
@@ -235,6 +235,10 @@ bool IsKeyPressed(KeyCode key)
 {
   GLFWwindow* window = static_cast<GLFWwindow*>(
       Application::Get().GetWindow().GetNativeWindow());
+  if (!window)
+  {
+    return false;
+  }
   int state = glfwGetKey(window, GetGLFWKeyFromKeyCode(key));
   return state == GLFW_PRESS || state == GLFW_REPEAT;
 }
@@ -242,6 +246,10 @@ bool IsMouseButtonPressed(MouseButtonCode button)
 {
   GLFWwindow* window = static_cast<GLFWwindow*>(
       Application::Get().GetWindow().GetNativeWindow());
+  if (!window)
+  {
+    return false;
+  }
   int state =
       glfwGetMouseButton(window, GetGLFWButtonFromMouseButtonCode(button));
   return state == GLFW_PRESS;
@@ -250,8 +258,11 @@ std::pair<float, float> GetMousePosition()
 {
   GLFWwindow* window = static_cast<GLFWwindow*>(
       Application::Get().GetWindow().GetNativeWindow());
-  double xpos, ypos;
-  glfwGetCursorPos(window, &xpos, &ypos);
+  double xpos = 0.0, ypos = 0.0;
+  if (window)
+  {
+    glfwGetCursorPos(window, &xpos, &ypos);
+  }
 
   return {(float)xpos, (float)ypos};
 }
@@ -0,0 +1,135 @@
+#include "memory/FrameAllocator.h"
+
+#include "logging/Log.h"
+#include "scheduler/Scheduler.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace bge
+{
+namespace FrameAllocator
+{
+
+using WorkerAllocators = std::vector<std::unique_ptr<LinearAllocator>>;
+
+/// allocator of each worker for the current frame
+static WorkerAllocators s_FrameAllocators;
+/// double buffered allocators of each worker, the current frame allocates
+/// from s_DoubleBufferedAllocators[s_DoubleBufferedIndex]
+static WorkerAllocators s_DoubleBufferedAllocators[2];
+/// index of the double buffered allocators of the current frame
+static uint32 s_DoubleBufferedIndex = 0u;
+/// statistics updated every frame
+static FrameAllocatorStats s_Stats = {};
+
+/**
+ * Create an allocator for every worker
+ */
+static void CreateAllocators(WorkerAllocators& allocators, size_t capacity)
+{
+  allocators.clear();
+  for (uint32 i = 0; i < Scheduler::GetMaxWorkerCount(); ++i)
+  {
+    allocators.emplace_back(std::make_unique<LinearAllocator>(capacity));
+  }
+}
+
+/**
+ * Add the allocations of the current frame to the statistics
+ */
+static void CountFrameAllocations(const WorkerAllocators& allocators)
+{
+  for (auto&& allocator : allocators)
+  {
+    s_Stats.m_FrameBytes += allocator->GetUsedBytes();
+    s_Stats.m_HeapAllocations += allocator->GetOverflowCount();
+  }
+}
+
+/**
+ * @return the allocator of the calling worker
+ */
+static LinearAllocator& GetWorkerAllocator(const WorkerAllocators& allocators)
+{
+  const uint32 worker = Scheduler::GetWorkerIndex();
+  BGE_CORE_ASSERT(worker < allocators.size(),
+                  "Frame memory is allocated on an unregistered thread");
+
+  return *allocators[worker];
+}
+
+void Initialize(size_t capacity)
+{
+  CreateAllocators(s_FrameAllocators, capacity);
+  CreateAllocators(s_DoubleBufferedAllocators[0], capacity);
+  CreateAllocators(s_DoubleBufferedAllocators[1], capacity);
+
+  s_DoubleBufferedIndex = 0u;
+  s_Stats = FrameAllocatorStats{};
+}
+
+void Shutdown()
+{
+  s_FrameAllocators.clear();
+  s_DoubleBufferedAllocators[0].clear();
+  s_DoubleBufferedAllocators[1].clear();
+}
+
+void NextFrame()
+{
+  s_Stats.m_FrameBytes = 0u;
+  s_Stats.m_HeapAllocations = 0u;
+  CountFrameAllocations(s_FrameAllocators);
+  CountFrameAllocations(s_DoubleBufferedAllocators[s_DoubleBufferedIndex]);
+
+  s_Stats.m_PeakFrameBytes =
+      std::max(s_Stats.m_PeakFrameBytes, s_Stats.m_FrameBytes);
+  ++s_Stats.m_FrameCount;
+
+  // The double buffered memory of the frame that ended stays for one more
+  // frame, the memory of the frame before it is freed
+  s_DoubleBufferedIndex ^= 1u;
+  for (auto&& allocator : s_FrameAllocators)
+  {
+    allocator->Reset();
+  }
+  for (auto&& allocator : s_DoubleBufferedAllocators[s_DoubleBufferedIndex])
+  {
+    allocator->Reset();
+  }
+
+  s_Stats.m_CapacityBytes = 0u;
+  for (auto* allocators : {&s_FrameAllocators, &s_DoubleBufferedAllocators[0],
+                           &s_DoubleBufferedAllocators[1]})
+  {
+    for (auto&& allocator : *allocators)
+    {
+      s_Stats.m_CapacityBytes += allocator->GetCapacity();
+    }
+  }
+}
+
+LinearAllocator& GetAllocator()
+{
+  return GetWorkerAllocator(s_FrameAllocators);
+}
+
+LinearAllocator& GetDoubleBufferedAllocator()
+{
+  return GetWorkerAllocator(s_DoubleBufferedAllocators[s_DoubleBufferedIndex]);
+}
+
+const FrameAllocatorStats& GetStats() { return s_Stats; }
+
+void LogStats()
+{
+  BGE_CORE_INFO("Frame allocator: {0} bytes in the last frame, peak: {1} "
+                "bytes, heap allocations: {2}, capacity: {3} bytes",
+                s_Stats.m_FrameBytes, s_Stats.m_PeakFrameBytes,
+                s_Stats.m_HeapAllocations, s_Stats.m_CapacityBytes);
+}
+
+} // namespace FrameAllocator
+} // namespace bge
@@ -0,0 +1,73 @@
+#include "memory/LinearAllocator.h"
+
+#include "logging/Log.h"
+
+#include <algorithm>
+
+namespace bge
+{
+
+/**
+ * @return the address rounded up to the alignment
+ */
+static FORCEINLINE uintptr_t AlignAddress(uintptr_t address, size_t alignment)
+{
+  return (address + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+}
+
+LinearAllocator::LinearAllocator(size_t capacity)
+    : m_Buffer(capacity > 0 ? new uint8[capacity] : nullptr)
+    , m_Capacity(capacity)
+    , m_Offset(0)
+    , m_OverflowBytes(0)
+    , m_PeakBytes(0)
+    , m_OverflowBlocks()
+{
+}
+
+void* LinearAllocator::Allocate(size_t size, size_t alignment)
+{
+  BGE_CORE_ASSERT((alignment & (alignment - 1)) == 0,
+                  "Alignment must be a power of 2");
+
+  const uintptr_t base = reinterpret_cast<uintptr_t>(m_Buffer.get());
+  const size_t offset = AlignAddress(base + m_Offset, alignment) - base;
+
+  if (m_Buffer && offset + size <= m_Capacity)
+  {
+    m_Offset = offset + size;
+    return m_Buffer.get() + offset;
+  }
+
+  return AllocateOverflow(size, alignment);
+}
+
+void LinearAllocator::Reset()
+{
+  const size_t usedBytes = m_Offset + m_OverflowBytes;
+  m_PeakBytes = std::max(m_PeakBytes, usedBytes);
+
+  // Grow the block so the same allocations fit in it next time
+  if (!m_OverflowBlocks.empty())
+  {
+    m_OverflowBlocks.clear();
+    m_Capacity = std::max(m_Capacity * 2, usedBytes);
+    m_Buffer.reset(new uint8[m_Capacity]);
+  }
+
+  m_Offset = 0;
+  m_OverflowBytes = 0;
+}
+
+void* LinearAllocator::AllocateOverflow(size_t size, size_t alignment)
+{
+  const size_t blockSize = size + alignment - 1;
+  m_OverflowBlocks.emplace_back(new uint8[blockSize]);
+  m_OverflowBytes += blockSize;
+
+  const uintptr_t block =
+      reinterpret_cast<uintptr_t>(m_OverflowBlocks.back().get());
+  return reinterpret_cast<void*>(AlignAddress(block, alignment));
+}
+
+} // namespace bge
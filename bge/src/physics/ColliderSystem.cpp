@@ -8,66 +8,42 @@ namespace bge
 void ColliderSystem::AddBoxCollider(Entity entity, const Vec3f& position,
                                     const Quatf& rotation, const Vec3f& size)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!m_Colliders.Contains(entity),
                   "Component already exists for this entity");
 
   PhysicsDevice::MakeBoxCollider(entity, position, rotation, size);
 
-  m_Entities.push_back(entity);
-  m_ColliderTypes.push_back(ColliderType::Box);
-
-  m_BodyTransforms.emplace_back(position, size, rotation);
-
-  m_EntityToComponentId[entity.GetId()] = m_Entities.size() - 1;
+  m_Colliders.Add(entity, ColliderType::Box,
+                  Transform(position, size, rotation));
 }
 
 void ColliderSystem::AddSphereCollider(Entity entity, const Vec3f& position,
                                        float radius)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!m_Colliders.Contains(entity),
                   "Component already exists for this entity");
 
   PhysicsDevice::MakeSphereCollider(entity, position, radius);
 
-  m_Entities.push_back(entity);
-  m_ColliderTypes.push_back(ColliderType::Sphere);
-
-  m_BodyTransforms.emplace_back(position, Vec3f(radius), Quatf());
-
-  m_EntityToComponentId[entity.GetId()] = m_Entities.size() - 1;
+  m_Colliders.Add(entity, ColliderType::Sphere,
+                  Transform(position, Vec3f(radius), Quatf()));
 }
 
 void ColliderSystem::DestroyCollider(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(m_Colliders.Contains(entity),
                   "Component does not exist for this entity");
 
-  uint32 idToRemove = m_EntityToComponentId[entity.GetId()];
-  uint32 lastComponentIndex = m_Entities.size() - 1;
-  Entity lastEntity = m_Entities[lastComponentIndex];
-
-  Entity entityToRemove = m_Entities[idToRemove];
-  ColliderType type = m_ColliderTypes[idToRemove];
-
-  if (type == ColliderType::Box)
+  if (m_Colliders.Get<c_TypeColumn>(entity) == ColliderType::Box)
   {
-    PhysicsDevice::DestroyBoxCollider(entityToRemove);
+    PhysicsDevice::DestroyBoxCollider(entity);
   }
   else
   {
-    PhysicsDevice::DestroySphereCollider(entityToRemove);
+    PhysicsDevice::DestroySphereCollider(entity);
   }
 
-  m_Entities[idToRemove] = m_Entities[lastComponentIndex];
-  m_BodyTransforms[idToRemove] = m_BodyTransforms[lastComponentIndex];
-  m_ColliderTypes[idToRemove] = m_ColliderTypes[lastComponentIndex];
-
-  m_Entities.pop_back();
-  m_BodyTransforms.pop_back();
-  m_ColliderTypes.pop_back();
-
-  m_EntityToComponentId[lastEntity.GetId()] = idToRemove;
-  m_EntityToComponentId.erase(entity.GetId());
+  m_Colliders.Remove(entity);
 }
 
 void ColliderSystem::OnEvent(Event& event)
@@ -80,17 +56,26 @@ void ColliderSystem::OnEvent(Event& event)
 
 bool ColliderSystem::OnEntitiesDestroyed(EntitiesDestroyedEvent& event)
 {
-  for (auto&& entity : event.GetEntities())
+  const std::vector<Entity>& entities = event.GetEntities();
+  const uint32 count = static_cast<uint32>(entities.size());
+
+  // Only the static colliders, the colliders of rigid bodies are destroyed
+  // together with their bodies
+  m_DestroyedEntities.clear();
+  for (uint32 i = 0; i < count; ++i)
   {
-    for (auto&& existingEntity : m_Entities)
+    if (m_Colliders.Contains(entities[i]))
     {
-      if (entity == existingEntity)
-      {
-        DestroyCollider(entity);
-      }
+      m_DestroyedEntities.push_back(entities[i]);
     }
   }
 
+  PhysicsDevice::DestroyColliders(
+      m_DestroyedEntities.data(),
+      static_cast<uint32>(m_DestroyedEntities.size()));
+  m_Colliders.RemoveBatch(m_DestroyedEntities.data(),
+                          static_cast<uint32>(m_DestroyedEntities.size()));
+
   return false;
 }
 
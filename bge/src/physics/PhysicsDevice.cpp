@@ -1,43 +1,545 @@
 #include "physics/PhysicsDevice.h"
 
+#include "ecs/EntityIndex.h"
 #include "logging/Log.h"
+#include "scheduler/ParallelAlgorithms.h"
 
 #include <nudge/nudge.h>
 
 #include <immintrin.h>
 
-namespace bge
-{
+#include <algorithm>
 
-struct RigidBody
+namespace bge
 {
-  int32 m_ColliderId{-1};
-  int32 m_BodyId{-1};
-  int32 m_EntityArrayId{-1};
-};
 
-static constexpr uint32 s_MaxBodyCount = 8192;
-static constexpr uint32 s_MaxBoxCount = 8192;
-static constexpr uint32 s_MaxSphereCount = 8192;
+// Every body has a collider, plus the static world body
+static constexpr uint32 s_MaxBodyCount = c_MaxPhysicsColliderCount + 1;
+// Box tags are [0, s_SphereTagOffset), sphere tags follow
+static constexpr uint32 s_SphereTagOffset = c_MaxPhysicsColliderCount;
+static constexpr uint32 s_MaxTagCount = 2 * c_MaxPhysicsColliderCount;
+static constexpr uint32 s_InitialCapacity = 256;
+static constexpr uint32 s_ContactsPerCollider = 64;
+// The arena is at least this large and grows to 1.5x the measured peak usage
+static constexpr uintptr_t s_MinArenaSize = 4 * 1024 * 1024;
 static constexpr uint32 s_Steps = 2;
 static constexpr uint32 s_Iterations = 20;
 static constexpr float s_TimeStep = 1.0f / (25.0f * (float)s_Steps);
 static constexpr float s_Damping = 1.0f - s_TimeStep * 0.25f;
+static constexpr uint32 s_BodyGrainSize = 256;
 static float s_Gravity = 9.82f;
 
 static nudge::Arena s_Arena;
+static intptr_t s_ArenaLowWaterSize = 0;
+static uintptr_t s_ArenaPeakUsage = 0;
+
+// Memory of the allocations which didn't fit in the arena during a step, freed
+// after the step. Their size counts towards the peak usage.
+static std::vector<void*> s_ArenaFallbacks;
+static uintptr_t s_ArenaFallbackSize = 0;
+static uint32 s_BodyCapacity = 0;
+static uint32 s_BoxCapacity = 0;
+static uint32 s_SphereCapacity = 0;
 static nudge::BodyData s_Bodies;
 static nudge::ColliderData s_Colliders;
 static nudge::ContactData s_ContactData;
 static nudge::ContactCache s_ContactCache;
 static nudge::ActiveBodies s_ActiveBodies;
 
-static std::unordered_map<uint32, RigidBody> s_EntityToRigidBody;
-static std::vector<Entity> s_EntitiesWithBodies;
+// Set for every body which moved since its matrix was last exported, see
+// ExportBodyMatrices. Bodies nudge keeps asleep stay clear.
+static uint8* s_BodyMoved = nullptr;
+
+// Entities in the order of the bodies, boxes and spheres. The static world body
+// isn't in the index, so nudge body i + 1 is at dense index i.
+static EntityIndex s_BodyIndex;
+static EntityIndex s_BoxIndex;
+static EntityIndex s_SphereIndex;
+
+// Tags of destroyed colliders, which new colliders reuse so tags stay unique
+static std::vector<uint16> s_FreeBoxTags;
+static std::vector<uint16> s_FreeSphereTags;
+
+// The entities of the batch which DestroyBodies is destroying
+static std::vector<Entity> s_BatchEntities;
+
+// The entity of each collider tag, box tags come first, then sphere tags
+static Entity* s_TagEntities = nullptr;
+
+// Sorted keys of the collider pairs touching after the current and the
+// previous Simulate, see UpdateContactReport
+static uint32 s_ContactPairKeyCapacity = 0;
+static uint32* s_CurrentPairKeys = nullptr;
+static uint32 s_CurrentPairKeyCount = 0;
+static uint32* s_PreviousPairKeys = nullptr;
+static uint32 s_PreviousPairKeyCount = 0;
+
+// The contact report of the last Simulate
+static ContactPair* s_ContactPairs = nullptr;
+static uint32 s_ContactPairCount = 0;
 
 static constexpr nudge::Transform s_IdentityTransform = {
     {}, 0, {0.0f, 0.0f, 0.0f, 1.0f}};
 
+/**
+ * Reallocate an array with the 64 byte alignment the SIMD code of nudge needs
+ * @param data the old array which is freed, can be null
+ * @param count number of elements to copy over
+ * @param capacity number of elements of the new array
+ * @return the new array
+ */
+template <typename T>
+static T* ReallocateAligned(T* data, uint32 count, uint32 capacity)
+{
+  T* newData = static_cast<T*>(_mm_malloc(sizeof(T) * capacity, 64));
+
+  if (data)
+  {
+    memcpy(newData, data, sizeof(T) * count);
+    _mm_free(data);
+  }
+
+  return newData;
+}
+
+/**
+ * @return the capacity to grow to, at least double the current one
+ */
+static uint32 GetGrownCapacity(uint32 capacity, uint32 requiredCapacity,
+                               uint32 maxCapacity)
+{
+  return std::min(std::max({capacity * 2, requiredCapacity, s_InitialCapacity}),
+                  maxCapacity);
+}
+
+/**
+ * Make sure count contacts fit, growing the contact arrays and the contact
+ * cache if needed. The contact cache keeps its impulses.
+ */
+static void ReserveContacts(uint32 count)
+{
+  const uint32 capacity = std::max(
+      count, (s_BoxCapacity + s_SphereCapacity) * s_ContactsPerCollider);
+
+  if (capacity <= s_ContactData.capacity)
+  {
+    return;
+  }
+
+  s_ContactData.bodies =
+      ReallocateAligned(s_ContactData.bodies, s_ContactData.count, capacity);
+  s_ContactData.data =
+      ReallocateAligned(s_ContactData.data, s_ContactData.count, capacity);
+  s_ContactData.tags =
+      ReallocateAligned(s_ContactData.tags, s_ContactData.count, capacity);
+  s_ContactData.sleeping_pairs = ReallocateAligned(
+      s_ContactData.sleeping_pairs, s_ContactData.sleeping_count, capacity);
+  s_ContactData.capacity = capacity;
+
+  s_ContactCache.data =
+      ReallocateAligned(s_ContactCache.data, s_ContactCache.count, capacity);
+  s_ContactCache.tags =
+      ReallocateAligned(s_ContactCache.tags, s_ContactCache.count, capacity);
+  s_ContactCache.capacity = capacity;
+}
+
+/**
+ * Make sure count bodies fit, growing the body arrays if needed
+ */
+static void ReserveBodies(uint32 count)
+{
+  if (count <= s_BodyCapacity)
+  {
+    return;
+  }
+
+  const uint32 capacity =
+      GetGrownCapacity(s_BodyCapacity, count, s_MaxBodyCount);
+
+  s_Bodies.idle_counters =
+      ReallocateAligned(s_Bodies.idle_counters, s_Bodies.count, capacity);
+  s_Bodies.transforms =
+      ReallocateAligned(s_Bodies.transforms, s_Bodies.count, capacity);
+  s_Bodies.momentum =
+      ReallocateAligned(s_Bodies.momentum, s_Bodies.count, capacity);
+  s_Bodies.properties =
+      ReallocateAligned(s_Bodies.properties, s_Bodies.count, capacity);
+  s_BodyMoved = ReallocateAligned(s_BodyMoved, s_Bodies.count, capacity);
+
+  // Only filled by collide, nothing to keep
+  s_ActiveBodies.indices =
+      ReallocateAligned(s_ActiveBodies.indices, 0, capacity);
+  s_ActiveBodies.capacity = capacity;
+  s_ActiveBodies.count = 0;
+
+  s_BodyCapacity = capacity;
+}
+
+/**
+ * Make sure count box colliders fit, growing the box arrays if needed
+ */
+static void ReserveBoxes(uint32 count)
+{
+  if (count <= s_BoxCapacity)
+  {
+    return;
+  }
+
+  const uint32 capacity =
+      GetGrownCapacity(s_BoxCapacity, count, c_MaxPhysicsColliderCount);
+  const uint32 boxCount = s_Colliders.boxes.count;
+
+  s_Colliders.boxes.data =
+      ReallocateAligned(s_Colliders.boxes.data, boxCount, capacity);
+  s_Colliders.boxes.tags =
+      ReallocateAligned(s_Colliders.boxes.tags, boxCount, capacity);
+  s_Colliders.boxes.transforms =
+      ReallocateAligned(s_Colliders.boxes.transforms, boxCount, capacity);
+
+  s_BoxCapacity = capacity;
+  ReserveContacts(0);
+}
+
+/**
+ * Make sure count sphere colliders fit, growing the sphere arrays if needed
+ */
+static void ReserveSpheres(uint32 count)
+{
+  if (count <= s_SphereCapacity)
+  {
+    return;
+  }
+
+  const uint32 capacity =
+      GetGrownCapacity(s_SphereCapacity, count, c_MaxPhysicsColliderCount);
+  const uint32 sphereCount = s_Colliders.spheres.count;
+
+  s_Colliders.spheres.data =
+      ReallocateAligned(s_Colliders.spheres.data, sphereCount, capacity);
+  s_Colliders.spheres.tags =
+      ReallocateAligned(s_Colliders.spheres.tags, sphereCount, capacity);
+  s_Colliders.spheres.transforms =
+      ReallocateAligned(s_Colliders.spheres.transforms, sphereCount, capacity);
+
+  s_SphereCapacity = capacity;
+  ReserveContacts(0);
+}
+
+/**
+ * @return number of box and sphere colliders
+ */
+static FORCEINLINE uint32 GetColliderCount()
+{
+  return s_Colliders.boxes.count + s_Colliders.spheres.count;
+}
+
+/**
+ * Allocates the memory nudge needs when the arena is full, so nudge never runs
+ * past the end of the arena. Only called from the thread running Simulate.
+ */
+static void* AllocateArenaFallback(void*, uintptr_t size, uintptr_t alignment)
+{
+  void* data = _mm_malloc(size, std::max<uintptr_t>(alignment, 64));
+
+  s_ArenaFallbacks.push_back(data);
+  s_ArenaFallbackSize += size + alignment;
+
+  return data;
+}
+
+/**
+ * Grow the temporary memory of a step to 1.5x the peak usage measured so far
+ */
+static void ReserveArena()
+{
+  const uintptr_t size =
+      std::max(s_MinArenaSize, s_ArenaPeakUsage + s_ArenaPeakUsage / 2);
+
+  if (size <= s_Arena.size)
+  {
+    return;
+  }
+
+  _mm_free(s_Arena.data);
+  s_Arena.data = _mm_malloc(size, 8192);
+  s_Arena.size = size;
+  s_Arena.low_water_size = &s_ArenaLowWaterSize;
+  s_Arena.fallback = AllocateArenaFallback;
+}
+
+/**
+ * Runs the parallel loops of nudge on the scheduler, one task per grain
+ */
+static void RunNudgeParallelFor(void*, unsigned count,
+                                unsigned grainSize,
+                                nudge::ParallelForFunction function,
+                                void* data)
+{
+  const uint32 chunkCount = GetParallelChunkCount(count, grainSize);
+
+  ParallelFor(0u, chunkCount, 1u, [&](uint32 chunk) {
+    const uint32 begin = chunk * grainSize;
+    function(data, begin, std::min(begin + grainSize, count));
+  });
+}
+
+static const nudge::ParallelFor s_NudgeParallelFor = {RunNudgeParallelFor,
+                                                      nullptr};
+
+/**
+ * Give a new collider a unique tag, reusing the tags of destroyed colliders
+ * @param freeTags the free tags of the collider type
+ * @param firstTag the tag of the first collider of the type
+ * @param collider the index of the new collider
+ * @param entity the entity the collider is mapped to
+ * @return the tag of the new collider
+ */
+static uint16 AcquireColliderTag(std::vector<uint16>& freeTags,
+                                 uint32 firstTag, uint32 collider,
+                                 Entity entity)
+{
+  // Without free tags every tag below firstTag + collider is in use
+  uint16 tag = static_cast<uint16>(firstTag + collider);
+
+  if (!freeTags.empty())
+  {
+    tag = freeTags.back();
+    freeTags.pop_back();
+  }
+
+  s_TagEntities[tag] = entity;
+
+  return tag;
+}
+
+/**
+ * @return the nudge body of an entity, which must have a body
+ */
+static FORCEINLINE uint32 GetBody(Entity entity)
+{
+  return s_BodyIndex.GetIndex(entity) + 1;
+}
+
+/**
+ * @return true if the entity has a box or a sphere collider
+ */
+static FORCEINLINE bool HasCollider(Entity entity)
+{
+  return s_BoxIndex.Contains(entity) || s_SphereIndex.Contains(entity);
+}
+
+/**
+ * Remove the box collider of an entity, the last box moves into its place
+ */
+static void RemoveBoxCollider(Entity entity)
+{
+  const uint32 collider = s_BoxIndex.Remove(entity);
+  const uint32 last = --s_Colliders.boxes.count;
+
+  s_FreeBoxTags.push_back(s_Colliders.boxes.tags[collider]);
+
+  s_Colliders.boxes.data[collider] = s_Colliders.boxes.data[last];
+  s_Colliders.boxes.tags[collider] = s_Colliders.boxes.tags[last];
+  s_Colliders.boxes.transforms[collider] = s_Colliders.boxes.transforms[last];
+}
+
+/**
+ * Remove the sphere collider of an entity, the last sphere moves into its place
+ */
+static void RemoveSphereCollider(Entity entity)
+{
+  const uint32 collider = s_SphereIndex.Remove(entity);
+  const uint32 last = --s_Colliders.spheres.count;
+
+  s_FreeSphereTags.push_back(s_Colliders.spheres.tags[collider]);
+
+  s_Colliders.spheres.data[collider] = s_Colliders.spheres.data[last];
+  s_Colliders.spheres.tags[collider] = s_Colliders.spheres.tags[last];
+  s_Colliders.spheres.transforms[collider] =
+      s_Colliders.spheres.transforms[last];
+}
+
+/**
+ * Point the collider of the entity of a body at the body, after the body moved
+ * @param body the nudge body, not the static world body
+ */
+static void PointColliderAtBody(uint32 body)
+{
+  const Entity entity = s_BodyIndex.GetEntity(body - 1);
+  const uint32 box = s_BoxIndex.Find(entity);
+
+  if (box != EntityIndex::c_InvalidIndex)
+  {
+    s_Colliders.boxes.transforms[box].body = body;
+  }
+  else
+  {
+    const uint32 sphere = s_SphereIndex.GetIndex(entity);
+    s_Colliders.spheres.transforms[sphere].body = body;
+  }
+}
+
+/**
+ * Remove the body of an entity, the last body moves into its place and the
+ * collider of the moved body is pointed at it
+ */
+static void RemoveBody(Entity entity)
+{
+  const uint32 body = s_BodyIndex.Remove(entity) + 1;
+  const uint32 last = --s_Bodies.count;
+
+  if (body == last)
+  {
+    return;
+  }
+
+  s_Bodies.idle_counters[body] = s_Bodies.idle_counters[last];
+  s_Bodies.momentum[body] = s_Bodies.momentum[last];
+  s_Bodies.properties[body] = s_Bodies.properties[last];
+  s_Bodies.transforms[body] = s_Bodies.transforms[last];
+  s_BodyMoved[body] = s_BodyMoved[last];
+
+  PointColliderAtBody(body);
+}
+
+/**
+ * Remove the colliders of a batch of entities with a single compaction pass,
+ * the remaining colliders keep their order
+ * @param index the entities of the collider type
+ * @param colliders the collider arrays of the type
+ * @param freeTags receives the tags of the removed colliders
+ * @param entities the entities, which may or may not have such a collider
+ * @param count number of entities
+ */
+template <typename Colliders>
+static void RemoveColliders(EntityIndex& index, Colliders& colliders,
+                            std::vector<uint16>& freeTags,
+                            const Entity* entities, uint32 count)
+{
+  for (uint32 i = 0; i < count; ++i)
+  {
+    const uint32 collider = index.Find(entities[i]);
+
+    if (collider != EntityIndex::c_InvalidIndex)
+    {
+      freeTags.push_back(colliders.tags[collider]);
+    }
+  }
+
+  if (index.RemoveBatch(entities, count) == colliders.count)
+  {
+    return;
+  }
+
+  index.ApplyRemoveBatch(colliders.data);
+  index.ApplyRemoveBatch(colliders.tags);
+  index.ApplyRemoveBatch(colliders.transforms);
+  colliders.count = index.GetCount();
+}
+
+/**
+ * @param colliderTags a pair of collider tags in the low and high 16 bits
+ * @return the same key for both orders of the pair, larger tag in the low bits
+ */
+static FORCEINLINE uint32 MakeContactPairKey(uint32 colliderTags)
+{
+  const uint32 a = colliderTags & 0xffff;
+  const uint32 b = colliderTags >> 16;
+
+  return a > b ? a | (b << 16) : b | (a << 16);
+}
+
+/**
+ * Collect the collider pairs touching after the last step of Simulate and
+ * classify them against the pairs of the previous Simulate
+ */
+static void UpdateContactReport()
+{
+  // The keys are collected from the cached contacts and the sleeping pairs,
+  // which both hold at most the contact capacity. The report holds at most
+  // every pair of the previous and the current step.
+  if (s_ContactPairKeyCapacity < s_ContactCache.capacity * 2)
+  {
+    s_ContactPairKeyCapacity = s_ContactCache.capacity * 2;
+    s_CurrentPairKeys = ReallocateAligned(
+        s_CurrentPairKeys, s_CurrentPairKeyCount, s_ContactPairKeyCapacity);
+    s_PreviousPairKeys =
+        ReallocateAligned(s_PreviousPairKeys, 0u, s_ContactPairKeyCapacity);
+    s_ContactPairs =
+        ReallocateAligned(s_ContactPairs, 0u, s_ContactPairKeyCapacity * 2);
+  }
+
+  std::swap(s_CurrentPairKeys, s_PreviousPairKeys);
+  std::swap(s_CurrentPairKeyCount, s_PreviousPairKeyCount);
+
+  const uint32* previousBegin = s_PreviousPairKeys;
+  const uint32* previousEnd = s_PreviousPairKeys + s_PreviousPairKeyCount;
+  uint32 count = 0;
+
+  // The cache holds the contacts of the last step and the ones kept for
+  // sleeping pairs, sorted by tag, so each pair is a run of equal keys
+  for (uint32 i = 0; i < s_ContactCache.count; ++i)
+  {
+    const uint32 key =
+        MakeContactPairKey(static_cast<uint32>(s_ContactCache.tags[i] >> 32));
+
+    if (count == 0 || s_CurrentPairKeys[count - 1] != key)
+    {
+      BGE_CORE_ASSERT(count < s_ContactPairKeyCapacity,
+                      "Too many contact pairs");
+      s_CurrentPairKeys[count++] = key;
+    }
+  }
+
+  // Sleeping bodies don't move, so their pairs keep touching if they did
+  // before, even when the cache dropped their contacts
+  for (uint32 i = 0; i < s_ContactData.sleeping_count; ++i)
+  {
+    const uint32 key = MakeContactPairKey(s_ContactData.sleeping_pairs[i]);
+
+    if (std::binary_search(previousBegin, previousEnd, key))
+    {
+      BGE_CORE_ASSERT(count < s_ContactPairKeyCapacity,
+                      "Too many contact pairs");
+      s_CurrentPairKeys[count++] = key;
+    }
+  }
+
+  std::sort(s_CurrentPairKeys, s_CurrentPairKeys + count);
+  s_CurrentPairKeyCount = static_cast<uint32>(
+      std::unique(s_CurrentPairKeys, s_CurrentPairKeys + count) -
+      s_CurrentPairKeys);
+
+  // Merge both sorted key lists, keys only in the previous list ended and
+  // keys only in the current list began
+  uint32 previous = 0;
+  uint32 current = 0;
+  s_ContactPairCount = 0;
+
+  while (previous < s_PreviousPairKeyCount ||
+         current < s_CurrentPairKeyCount)
+  {
+    ContactPair& pair = s_ContactPairs[s_ContactPairCount++];
+
+    if (current == s_CurrentPairKeyCount ||
+        (previous < s_PreviousPairKeyCount &&
+         s_PreviousPairKeys[previous] < s_CurrentPairKeys[current]))
+    {
+      pair = ContactPair{s_PreviousPairKeys[previous++], ContactState::End};
+    }
+    else if (previous == s_PreviousPairKeyCount ||
+             s_CurrentPairKeys[current] < s_PreviousPairKeys[previous])
+    {
+      pair = ContactPair{s_CurrentPairKeys[current++], ContactState::Begin};
+    }
+    else
+    {
+      pair = ContactPair{s_CurrentPairKeys[current++], ContactState::Persist};
+      ++previous;
+    }
+  }
+}
+
 static FORCEINLINE void QuaternionConcat(float r[4], const float a[4],
                                          const float b[4])
 {
@@ -102,6 +604,84 @@ static FORCEINLINE void MakeMatrix(float r[16], const float s[3],
   r[15] = 1.0f;
 }
 
+/**
+ * MakeMatrix for 4 bodies at once, with the quaternions transposed into SSE
+ * registers. Writes row-major matrices, the layout of Mat4f.
+ * @param output the 4 matrices
+ * @param scales the scale of each body
+ * @param transforms the nudge transform of each body
+ */
+static FORCEINLINE void MakeMatrices4(float* const output[4],
+                                      const Vec3f* const scales[4],
+                                      const nudge::Transform* const
+                                          transforms[4])
+{
+  __m128 qx = _mm_loadu_ps(transforms[0]->rotation);
+  __m128 qy = _mm_loadu_ps(transforms[1]->rotation);
+  __m128 qz = _mm_loadu_ps(transforms[2]->rotation);
+  __m128 qw = _mm_loadu_ps(transforms[3]->rotation);
+  _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+  // The 4th lane holds the body index, which the transpose moves into tw
+  __m128 tx = _mm_loadu_ps(transforms[0]->position);
+  __m128 ty = _mm_loadu_ps(transforms[1]->position);
+  __m128 tz = _mm_loadu_ps(transforms[2]->position);
+  __m128 tw = _mm_loadu_ps(transforms[3]->position);
+  _MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+  const __m128 scaleX = _mm_setr_ps((*scales[0])[0], (*scales[1])[0],
+                                    (*scales[2])[0], (*scales[3])[0]);
+  const __m128 scaleY = _mm_setr_ps((*scales[0])[1], (*scales[1])[1],
+                                    (*scales[2])[1], (*scales[3])[1]);
+  const __m128 scaleZ = _mm_setr_ps((*scales[0])[2], (*scales[1])[2],
+                                    (*scales[2])[2], (*scales[3])[2]);
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  const __m128 kx = _mm_add_ps(qx, qx);
+  const __m128 ky = _mm_add_ps(qy, qy);
+  const __m128 kz = _mm_add_ps(qz, qz);
+
+  const __m128 xx = _mm_mul_ps(kx, qx);
+  const __m128 yy = _mm_mul_ps(ky, qy);
+  const __m128 zz = _mm_mul_ps(kz, qz);
+  const __m128 xy = _mm_mul_ps(kx, qy);
+  const __m128 xz = _mm_mul_ps(kx, qz);
+  const __m128 yz = _mm_mul_ps(ky, qz);
+  const __m128 sx = _mm_mul_ps(kx, qw);
+  const __m128 sy = _mm_mul_ps(ky, qw);
+  const __m128 sz = _mm_mul_ps(kz, qw);
+
+  // Element (row, column) of all 4 matrices
+  __m128 m00 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, yy), zz), scaleX);
+  __m128 m01 = _mm_mul_ps(_mm_sub_ps(xy, sz), scaleY);
+  __m128 m02 = _mm_mul_ps(_mm_add_ps(xz, sy), scaleZ);
+
+  __m128 m10 = _mm_mul_ps(_mm_add_ps(xy, sz), scaleX);
+  __m128 m11 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), zz), scaleY);
+  __m128 m12 = _mm_mul_ps(_mm_sub_ps(yz, sx), scaleZ);
+
+  __m128 m20 = _mm_mul_ps(_mm_sub_ps(xz, sy), scaleX);
+  __m128 m21 = _mm_mul_ps(_mm_add_ps(yz, sx), scaleY);
+  __m128 m22 = _mm_mul_ps(_mm_sub_ps(_mm_sub_ps(one, xx), yy), scaleZ);
+
+  // Transpose back, so each register holds a row of a single matrix
+  _MM_TRANSPOSE4_PS(m00, m01, m02, tx);
+  _MM_TRANSPOSE4_PS(m10, m11, m12, ty);
+  _MM_TRANSPOSE4_PS(m20, m21, m22, tz);
+
+  const __m128 lastRow = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  const __m128 rows[3][4] = {
+      {m00, m01, m02, tx}, {m10, m11, m12, ty}, {m20, m21, m22, tz}};
+
+  for (uint32 i = 0; i < 4; ++i)
+  {
+    _mm_storeu_ps(output[i], rows[0][i]);
+    _mm_storeu_ps(output[i] + 4, rows[1][i]);
+    _mm_storeu_ps(output[i] + 8, rows[2][i]);
+    _mm_storeu_ps(output[i] + 12, lastRow);
+  }
+}
+
 namespace PhysicsDevice
 {
 
@@ -125,91 +705,77 @@ void Initialize()
   BGE_CORE_INFO("FMA: Disabled");
 #endif
 
-  // Allocate memory for simulation s_Arena.
-  s_Arena.size = 64 * 1024 * 1024; // 64 MegaBytes
-  s_Arena.data = _mm_malloc(s_Arena.size, 8192);
+  // Allocate the initial memory for s_Bodies, s_Colliders, contacts and the
+  // simulation s_Arena, all of it grows when needed.
+  ReserveBodies(s_InitialCapacity);
+  ReserveBoxes(s_InitialCapacity);
+  ReserveSpheres(s_InitialCapacity);
+  ReserveArena();
 
-  // Allocate memory for s_Bodies, s_Colliders, and contacts.
-  s_ActiveBodies.capacity = s_MaxBoxCount;
-  s_ActiveBodies.indices =
-      static_cast<uint16_t*>(_mm_malloc(sizeof(uint16_t) * s_MaxBodyCount, 64));
+  // Allocate memory for the collider tags, the contact report buffers grow
+  // with the contact cache in UpdateContactReport
+  s_FreeBoxTags.reserve(c_MaxPhysicsColliderCount);
+  s_FreeSphereTags.reserve(c_MaxPhysicsColliderCount);
 
-  s_Bodies.idle_counters =
-      static_cast<uint8_t*>(_mm_malloc(sizeof(uint8_t) * s_MaxBodyCount, 64));
-  s_Bodies.transforms = static_cast<nudge::Transform*>(
-      _mm_malloc(sizeof(nudge::Transform) * s_MaxBodyCount, 64));
-  s_Bodies.momentum = static_cast<nudge::BodyMomentum*>(
-      _mm_malloc(sizeof(nudge::BodyMomentum) * s_MaxBodyCount, 64));
-  s_Bodies.properties = static_cast<nudge::BodyProperties*>(
-      _mm_malloc(sizeof(nudge::BodyProperties) * s_MaxBodyCount, 64));
-
-  s_Colliders.boxes.data = static_cast<nudge::BoxCollider*>(
-      _mm_malloc(sizeof(nudge::BoxCollider) * s_MaxBoxCount, 64));
-  s_Colliders.boxes.tags =
-      static_cast<uint16_t*>(_mm_malloc(sizeof(uint16_t) * s_MaxBoxCount, 64));
-  s_Colliders.boxes.transforms = static_cast<nudge::Transform*>(
-      _mm_malloc(sizeof(nudge::Transform) * s_MaxBoxCount, 64));
-
-  s_Colliders.spheres.data = static_cast<nudge::SphereCollider*>(
-      _mm_malloc(sizeof(nudge::SphereCollider) * s_MaxSphereCount, 64));
-  s_Colliders.spheres.tags = static_cast<uint16_t*>(
-      _mm_malloc(sizeof(uint16_t) * s_MaxSphereCount, 64));
-  s_Colliders.spheres.transforms = static_cast<nudge::Transform*>(
-      _mm_malloc(sizeof(nudge::Transform) * s_MaxSphereCount, 64));
-
-  s_ContactData.capacity = s_MaxBodyCount * 64;
-  s_ContactData.bodies = static_cast<nudge::BodyPair*>(
-      _mm_malloc(sizeof(nudge::BodyPair) * s_ContactData.capacity, 64));
-  s_ContactData.data = static_cast<nudge::Contact*>(
-      _mm_malloc(sizeof(nudge::Contact) * s_ContactData.capacity, 64));
-  s_ContactData.tags = static_cast<uint64_t*>(
-      _mm_malloc(sizeof(uint64_t) * s_ContactData.capacity, 64));
-  s_ContactData.sleeping_pairs = static_cast<uint32_t*>(
-      _mm_malloc(sizeof(uint32_t) * s_ContactData.capacity, 64));
-
-  s_ContactCache.capacity = s_MaxBodyCount * 64;
-  s_ContactCache.data = static_cast<nudge::CachedContactImpulse*>(_mm_malloc(
-      sizeof(nudge::CachedContactImpulse) * s_ContactCache.capacity, 64));
-  s_ContactCache.tags = static_cast<uint64_t*>(
-      _mm_malloc(sizeof(uint64_t) * s_ContactCache.capacity, 64));
+  s_TagEntities = static_cast<Entity*>(
+      _mm_malloc(sizeof(Entity) * s_MaxTagCount, 64));
+  std::fill(s_TagEntities, s_TagEntities + s_MaxTagCount, Entity(0, 0));
 
   // The first body is the static world.
   // colliders without a rigid body will have their body reference be the world
   s_Bodies.count = 1;
   s_Bodies.idle_counters[0] = 0;
   s_Bodies.transforms[0] = s_IdentityTransform;
+  s_BodyMoved[0] = 0;
   memset(s_Bodies.momentum, 0, sizeof(s_Bodies.momentum[0]));
   memset(s_Bodies.properties, 0, sizeof(s_Bodies.properties[0]));
 }
 
+PhysicsMemoryStats GetMemoryStats()
+{
+  return PhysicsMemoryStats{s_BodyCapacity, s_BoxCapacity + s_SphereCapacity,
+                            s_ContactData.capacity, s_Arena.size,
+                            s_ArenaPeakUsage};
+}
+
 CollidedBodies Simulate()
 {
   for (uint32 n = 0; n < s_Steps; ++n)
   {
     // Setup a temporary memory s_Arena. The same temporary memory is reused
     // each iteration.
+    ReserveArena();
     nudge::Arena temporary = s_Arena;
+    s_ArenaLowWaterSize = static_cast<intptr_t>(s_Arena.size);
+    s_ArenaFallbackSize = 0;
 
     // Find contacts.
     // NOTE: Custom constraints should be added as body connections.
     nudge::BodyConnections connections = {};
 
     nudge::collide(&s_ActiveBodies, &s_ContactData, s_Bodies, s_Colliders,
-                   connections, temporary);
+                   connections, temporary, s_NudgeParallelFor);
+
+    // collide writes nothing when the contacts of the step may not fit, so
+    // it runs again once they do
+    if (s_ContactData.required_capacity > 0)
+    {
+      ReserveContacts(s_ContactData.required_capacity);
 
-    // CollidedBodies collidedBodies;
-    // collidedBodies.m_Count = s_ContactData.count;
-    // memcpy(collidedBodies.m_Bodies, s_ContactData.bodies,
-    //        s_ContactData.count * sizeof(s_ContactData.bodies[0]));
+      nudge::collide(&s_ActiveBodies, &s_ContactData, s_Bodies, s_Colliders,
+                     connections, temporary, s_NudgeParallelFor);
+    }
 
     // NOTE: Custom contacts can be added here, e.g., against the static
     // environment.
 
     // Apply gravity and damping.
-    for (uint32 i = 0; i < s_ActiveBodies.count; ++i)
-    {
+    ParallelFor(0u, s_ActiveBodies.count, s_BodyGrainSize, [](uint32 i) {
       uint32 index = s_ActiveBodies.indices[i];
 
+      // Only active bodies get advanced, every other body keeps its transform
+      s_BodyMoved[index] = 1;
+
       s_Bodies.momentum[index].velocity[1] -= s_Gravity * s_TimeStep;
 
       s_Bodies.momentum[index].velocity[0] *= s_Damping;
@@ -219,7 +785,7 @@ CollidedBodies Simulate()
       s_Bodies.momentum[index].angular_velocity[0] *= s_Damping;
       s_Bodies.momentum[index].angular_velocity[1] *= s_Damping;
       s_Bodies.momentum[index].angular_velocity[2] *= s_Damping;
-    }
+    });
 
     // Read previous impulses from contact cache.
     nudge::ContactImpulseData* contactImpulses =
@@ -230,11 +796,16 @@ CollidedBodies Simulate()
         nudge::setup_contact_constraints(s_ActiveBodies, s_ContactData,
                                          s_Bodies, contactImpulses, &temporary);
 
+    // Group the constraints into colors which don't share bodies, so each
+    // color can be solved in parallel. The colors only depend on the contacts,
+    // which keeps the results the same for any number of threads.
+    nudge::color_contact_constraints(contactConstraints, s_Bodies, &temporary);
+
     // Apply contact impulses. Increasing the number of iterations will improve
     // stability.
     for (uint32 i = 0; i < s_Iterations; ++i)
     {
-      nudge::apply_impulses(contactConstraints, s_Bodies);
+      nudge::apply_impulses(contactConstraints, s_Bodies, s_NudgeParallelFor);
       // NOTE: Custom constraint impulses should be applied here.
     }
 
@@ -246,10 +817,32 @@ CollidedBodies Simulate()
                                  contactImpulses);
 
     // Move active s_Bodies.
-    nudge::advance(s_ActiveBodies, s_Bodies, s_TimeStep);
+    nudge::advance(s_ActiveBodies, s_Bodies, s_TimeStep, s_NudgeParallelFor);
+
+    // The allocations which didn't fit in the arena count towards the peak,
+    // so the arena grows to fit them before the next step
+    if (s_ArenaFallbackSize > 0)
+    {
+      BGE_CORE_WARN("Physics arena of {0} bytes was {1} bytes too small",
+                    s_Arena.size, s_ArenaFallbackSize);
+    }
+
+    for (void* data : s_ArenaFallbacks)
+    {
+      _mm_free(data);
+    }
+    s_ArenaFallbacks.clear();
+
+    s_ArenaPeakUsage = std::max(
+        s_ArenaPeakUsage,
+        static_cast<uintptr_t>(static_cast<intptr_t>(s_Arena.size) -
+                               s_ArenaLowWaterSize) +
+            s_ArenaFallbackSize);
   }
 
-  return CollidedBodies();
+  UpdateContactReport();
+
+  return CollidedBodies(s_ContactPairs, s_ContactPairCount, s_TagEntities);
 }
 
 void SetGravity(float gravity) { s_Gravity = gravity; }
@@ -257,13 +850,14 @@ void SetGravity(float gravity) { s_Gravity = gravity; }
 void MakeBoxCollider(Entity entity, const Vec3f& position,
                      const Quatf& rotation, const Vec3f& size)
 {
-  BGE_CORE_ASSERT(s_Colliders.boxes.count < s_MaxBoxCount,
+  BGE_CORE_ASSERT(GetColliderCount() < c_MaxPhysicsColliderCount,
                   "Max count colliders reached");
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()) == 0,
-                  "This entity already has a rigid body!");
+  BGE_CORE_ASSERT(!HasCollider(entity), "This entity already has a collider!");
+
+  ReserveBoxes(s_Colliders.boxes.count + 1);
 
   int32 collider = s_Colliders.boxes.count++;
-  s_EntitiesWithBodies.push_back(entity);
+  s_BoxIndex.Add(entity);
 
   s_Colliders.boxes.transforms[collider] = s_IdentityTransform;
 
@@ -276,21 +870,20 @@ void MakeBoxCollider(Entity entity, const Vec3f& position,
   memcpy(s_Colliders.boxes.data[collider].size, size.m_Elements,
          sizeof(size[0]) * 3);
 
-  s_Colliders.boxes.tags[collider] = collider;
-
-  RigidBody rigidBody{collider, -1, int32(s_EntitiesWithBodies.size() - 1)};
-  s_EntityToRigidBody[entity.GetId()] = rigidBody;
+  s_Colliders.boxes.tags[collider] =
+      AcquireColliderTag(s_FreeBoxTags, 0, collider, entity);
 }
 
 void MakeSphereCollider(Entity entity, const Vec3f& position, float radius)
 {
-  BGE_CORE_ASSERT(s_Colliders.spheres.count <= s_MaxSphereCount,
+  BGE_CORE_ASSERT(GetColliderCount() < c_MaxPhysicsColliderCount,
                   "Max count colliders reached");
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()) == 0,
-                  "This entity already has a rigid body!");
+  BGE_CORE_ASSERT(!HasCollider(entity), "This entity already has a collider!");
+
+  ReserveSpheres(s_Colliders.spheres.count + 1);
 
   int32 collider = s_Colliders.spheres.count++;
-  s_EntitiesWithBodies.push_back(entity);
+  s_SphereIndex.Add(entity);
 
   s_Colliders.spheres.transforms[collider] = s_IdentityTransform;
 
@@ -299,70 +892,40 @@ void MakeSphereCollider(Entity entity, const Vec3f& position, float radius)
 
   s_Colliders.spheres.data[collider].radius = radius;
 
-  s_Colliders.spheres.tags[collider] = collider + s_MaxBoxCount;
-
-  RigidBody rigidBody{collider, -1, int32(s_EntitiesWithBodies.size() - 1)};
-  s_EntityToRigidBody[entity.GetId()] = rigidBody;
+  s_Colliders.spheres.tags[collider] = AcquireColliderTag(
+      s_FreeSphereTags, s_SphereTagOffset, collider, entity);
 }
 
 void DestroyBoxCollider(Entity entity)
 {
-  Entity lastEntity = s_EntitiesWithBodies.back();
-
-  RigidBody toDestroyRb = s_EntityToRigidBody[entity.GetId()];
-  RigidBody lastEntityRb = s_EntityToRigidBody[lastEntity.GetId()];
-
-  if (lastEntityRb.m_BodyId > -1)
-  {
-    toDestroyRb.m_BodyId = lastEntityRb.m_BodyId;
-  }
+  BGE_CORE_ASSERT(!s_BodyIndex.Contains(entity),
+                  "Destroy bodies with DestroyBox.");
 
-  --s_Colliders.boxes.count;
-
-  s_EntitiesWithBodies[toDestroyRb.m_EntityArrayId] = lastEntity;
-  s_EntitiesWithBodies.pop_back();
-
-  s_Colliders.boxes.data[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.data[lastEntityRb.m_ColliderId];
-
-  s_Colliders.boxes.tags[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.tags[lastEntityRb.m_ColliderId];
-
-  s_Colliders.boxes.transforms[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.transforms[lastEntityRb.m_ColliderId];
-
-  s_EntityToRigidBody[lastEntity.GetId()] = toDestroyRb;
-  s_EntityToRigidBody.erase(entity.GetId());
+  RemoveBoxCollider(entity);
 }
 
 void DestroySphereCollider(Entity entity)
 {
-  Entity lastEntity = s_EntitiesWithBodies.back();
+  BGE_CORE_ASSERT(!s_BodyIndex.Contains(entity),
+                  "Destroy bodies with DestroySphere.");
 
-  RigidBody toDestroyRb = s_EntityToRigidBody[entity.GetId()];
-  RigidBody lastEntityRb = s_EntityToRigidBody[lastEntity.GetId()];
+  RemoveSphereCollider(entity);
+}
 
-  if (lastEntityRb.m_BodyId > -1)
+void DestroyColliders(const Entity* entities, uint32 count)
+{
+#ifdef BGE_ENABLE_ASSERTS
+  for (uint32 i = 0; i < count; ++i)
   {
-    toDestroyRb.m_BodyId = lastEntityRb.m_BodyId;
+    BGE_CORE_ASSERT(!s_BodyIndex.Contains(entities[i]),
+                    "Destroy bodies with DestroyBodies.");
   }
+#endif
 
-  --s_Colliders.spheres.count;
-
-  s_EntitiesWithBodies[toDestroyRb.m_EntityArrayId] = lastEntity;
-  s_EntitiesWithBodies.pop_back();
-
-  s_Colliders.spheres.data[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.data[lastEntityRb.m_ColliderId];
-
-  s_Colliders.spheres.tags[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.tags[lastEntityRb.m_ColliderId];
-
-  s_Colliders.spheres.transforms[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.transforms[lastEntityRb.m_ColliderId];
-
-  s_EntityToRigidBody[lastEntity.GetId()] = toDestroyRb;
-  s_EntityToRigidBody.erase(entity.GetId());
+  RemoveColliders(s_BoxIndex, s_Colliders.boxes, s_FreeBoxTags, entities,
+                  count);
+  RemoveColliders(s_SphereIndex, s_Colliders.spheres, s_FreeSphereTags,
+                  entities, count);
 }
 
 // uint32 MakeBoxBody(float mass, float cx, float cy, float cz)
@@ -416,14 +979,17 @@ void DestroySphereCollider(Entity entity)
 void CreateBox(Entity entity, float mass, float cx, float cy, float cz)
 {
   BGE_CORE_ASSERT(s_Bodies.count < s_MaxBodyCount, "Max count bodies reached");
-  BGE_CORE_ASSERT(s_Colliders.boxes.count < s_MaxBoxCount,
+  BGE_CORE_ASSERT(GetColliderCount() < c_MaxPhysicsColliderCount,
                   "Max count colliders reached");
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()) == 0,
-                  "This entity already has a rigid body!");
+  BGE_CORE_ASSERT(!HasCollider(entity), "This entity already has a collider!");
+
+  ReserveBodies(s_Bodies.count + 1);
+  ReserveBoxes(s_Colliders.boxes.count + 1);
 
   int32 body = s_Bodies.count++;
   int32 collider = s_Colliders.boxes.count++;
-  s_EntitiesWithBodies.push_back(entity);
+  s_BodyIndex.Add(entity);
+  s_BoxIndex.Add(entity);
 
   float k = mass * (1.0f / 3.0f);
 
@@ -441,6 +1007,7 @@ void CreateBox(Entity entity, float mass, float cx, float cy, float cz)
   s_Bodies.idle_counters[body] = 0;
   s_Bodies.properties[body] = properties;
   s_Bodies.transforms[body] = s_IdentityTransform;
+  s_BodyMoved[body] = 1;
 
   s_Colliders.boxes.transforms[collider] = s_IdentityTransform;
   s_Colliders.boxes.transforms[collider].body = body;
@@ -448,23 +1015,24 @@ void CreateBox(Entity entity, float mass, float cx, float cy, float cz)
   s_Colliders.boxes.data[collider].size[0] = cx;
   s_Colliders.boxes.data[collider].size[1] = cy;
   s_Colliders.boxes.data[collider].size[2] = cz;
-  s_Colliders.boxes.tags[collider] = collider;
-
-  RigidBody rigidBody{collider, body, int32(s_EntitiesWithBodies.size() - 1)};
-  s_EntityToRigidBody[entity.GetId()] = rigidBody;
+  s_Colliders.boxes.tags[collider] =
+      AcquireColliderTag(s_FreeBoxTags, 0, collider, entity);
 }
 
 void CreateSphere(Entity entity, float mass, float radius)
 {
   BGE_CORE_ASSERT(s_Bodies.count < s_MaxBodyCount, "Max count bodies reached");
-  BGE_CORE_ASSERT(s_Colliders.spheres.count < s_MaxSphereCount,
+  BGE_CORE_ASSERT(GetColliderCount() < c_MaxPhysicsColliderCount,
                   "Max count colliders reached");
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()) == 0,
-                  "This entity already has a rigid body!");
+  BGE_CORE_ASSERT(!HasCollider(entity), "This entity already has a collider!");
+
+  ReserveBodies(s_Bodies.count + 1);
+  ReserveSpheres(s_Colliders.spheres.count + 1);
 
   int32 body = s_Bodies.count++;
   int32 collider = s_Colliders.spheres.count++;
-  s_EntitiesWithBodies.push_back(entity);
+  s_BodyIndex.Add(entity);
+  s_SphereIndex.Add(entity);
 
   float k = 2.5f / (mass * radius * radius);
 
@@ -478,146 +1046,128 @@ void CreateSphere(Entity entity, float mass, float radius)
   s_Bodies.idle_counters[body] = 0;
   s_Bodies.properties[body] = properties;
   s_Bodies.transforms[body] = s_IdentityTransform;
+  s_BodyMoved[body] = 1;
 
   s_Colliders.spheres.transforms[collider] = s_IdentityTransform;
   s_Colliders.spheres.transforms[collider].body = body;
 
   s_Colliders.spheres.data[collider].radius = radius;
-  s_Colliders.spheres.tags[collider] = collider + s_MaxBoxCount;
-
-  RigidBody rigidBody{collider, body, int32(s_EntitiesWithBodies.size() - 1)};
-  s_EntityToRigidBody[entity.GetId()] = rigidBody;
+  s_Colliders.spheres.tags[collider] = AcquireColliderTag(
+      s_FreeSphereTags, s_SphereTagOffset, collider, entity);
 }
 
 void DestroyBox(Entity entity)
 {
-  Entity lastEntity = s_EntitiesWithBodies.back();
-
-  RigidBody toDestroyRb = s_EntityToRigidBody[entity.GetId()];
-  RigidBody lastEntityRb = s_EntityToRigidBody[lastEntity.GetId()];
-
-  --s_Bodies.count;
-  --s_Colliders.boxes.count;
-
-  s_Bodies.idle_counters[toDestroyRb.m_BodyId] =
-      s_Bodies.idle_counters[lastEntityRb.m_BodyId];
-
-  s_Bodies.momentum[toDestroyRb.m_BodyId] =
-      s_Bodies.momentum[lastEntityRb.m_BodyId];
-
-  s_Bodies.properties[toDestroyRb.m_BodyId] =
-      s_Bodies.properties[lastEntityRb.m_BodyId];
-
-  s_Bodies.transforms[toDestroyRb.m_BodyId] =
-      s_Bodies.transforms[lastEntityRb.m_BodyId];
-
-  s_EntitiesWithBodies[toDestroyRb.m_EntityArrayId] = lastEntity;
-  s_EntitiesWithBodies.pop_back();
-
-  s_Colliders.boxes.data[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.data[lastEntityRb.m_ColliderId];
-
-  s_Colliders.boxes.tags[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.tags[lastEntityRb.m_ColliderId];
-
-  s_Colliders.boxes.transforms[toDestroyRb.m_ColliderId] =
-      s_Colliders.boxes.transforms[lastEntityRb.m_ColliderId];
-
-  s_EntityToRigidBody[lastEntity.GetId()] = toDestroyRb;
-  s_EntityToRigidBody.erase(entity.GetId());
+  RemoveBoxCollider(entity);
+  RemoveBody(entity);
 }
 
 void DestroySphere(Entity entity)
 {
-  Entity lastEntity = s_EntitiesWithBodies.back();
-
-  RigidBody toDestroyRb = s_EntityToRigidBody[entity.GetId()];
-  RigidBody lastEntityRb = s_EntityToRigidBody[lastEntity.GetId()];
-
-  --s_Bodies.count;
-  --s_Colliders.spheres.count;
-
-  s_Bodies.idle_counters[toDestroyRb.m_BodyId] =
-      s_Bodies.idle_counters[lastEntityRb.m_BodyId];
-
-  s_Bodies.momentum[toDestroyRb.m_BodyId] =
-      s_Bodies.momentum[lastEntityRb.m_BodyId];
-
-  s_Bodies.properties[toDestroyRb.m_BodyId] =
-      s_Bodies.properties[lastEntityRb.m_BodyId];
+  RemoveSphereCollider(entity);
+  RemoveBody(entity);
+}
 
-  s_Bodies.transforms[toDestroyRb.m_BodyId] =
-      s_Bodies.transforms[lastEntityRb.m_BodyId];
+void DestroyBodies(const Entity* entities, uint32 count)
+{
+  // Only the colliders of the bodies, other entities of the batch may have
+  // colliders without a body
+  s_BatchEntities.clear();
+  for (uint32 i = 0; i < count; ++i)
+  {
+    if (s_BodyIndex.Contains(entities[i]))
+    {
+      s_BatchEntities.push_back(entities[i]);
+    }
+  }
 
-  s_EntitiesWithBodies[toDestroyRb.m_EntityArrayId] = lastEntity;
-  s_EntitiesWithBodies.pop_back();
+  const uint32 bodyCount = static_cast<uint32>(s_BatchEntities.size());
+  if (bodyCount == 0)
+  {
+    return;
+  }
 
-  s_Colliders.spheres.data[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.data[lastEntityRb.m_ColliderId];
+  RemoveColliders(s_BoxIndex, s_Colliders.boxes, s_FreeBoxTags,
+                  s_BatchEntities.data(), bodyCount);
+  RemoveColliders(s_SphereIndex, s_Colliders.spheres, s_FreeSphereTags,
+                  s_BatchEntities.data(), bodyCount);
 
-  s_Colliders.spheres.tags[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.tags[lastEntityRb.m_ColliderId];
+  const uint32 first =
+      s_BodyIndex.RemoveBatch(s_BatchEntities.data(), bodyCount);
 
-  s_Colliders.spheres.transforms[toDestroyRb.m_ColliderId] =
-      s_Colliders.spheres.transforms[lastEntityRb.m_ColliderId];
+  // Dense index i is nudge body i + 1
+  s_BodyIndex.ApplyRemoveBatch(s_Bodies.idle_counters + 1);
+  s_BodyIndex.ApplyRemoveBatch(s_Bodies.momentum + 1);
+  s_BodyIndex.ApplyRemoveBatch(s_Bodies.properties + 1);
+  s_BodyIndex.ApplyRemoveBatch(s_Bodies.transforms + 1);
+  s_BodyIndex.ApplyRemoveBatch(s_BodyMoved + 1);
+  s_Bodies.count = s_BodyIndex.GetCount() + 1;
 
-  s_EntityToRigidBody[lastEntity.GetId()] = toDestroyRb;
-  s_EntityToRigidBody.erase(entity.GetId());
+  for (uint32 body = first + 1; body < s_Bodies.count; ++body)
+  {
+    PointColliderAtBody(body);
+  }
 }
 
 void SetBodyPosition(Entity entity, const Vec3f& position)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
+  BGE_CORE_ASSERT(s_BodyIndex.Contains(entity),
                   "Entity not registered with a body.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 body = GetBody(entity);
 
-  memcpy(s_Bodies.transforms[rb.m_BodyId].position, position.m_Elements,
+  memcpy(s_Bodies.transforms[body].position, position.m_Elements,
          sizeof(position[0]) * 3);
+
+  // Wake the body up, nudge doesn't move or collide sleeping bodies
+  s_Bodies.idle_counters[body] = 0;
+  s_BodyMoved[body] = 1;
 }
 
 void SetBodyVelocity(Entity entity, const Vec3f& velocity)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
+  BGE_CORE_ASSERT(s_BodyIndex.Contains(entity),
                   "Entity not registered with a body.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 body = GetBody(entity);
 
-  memcpy(s_Bodies.momentum[rb.m_BodyId].velocity, velocity.m_Elements,
+  memcpy(s_Bodies.momentum[body].velocity, velocity.m_Elements,
          sizeof(velocity[0]) * 3);
+  s_Bodies.idle_counters[body] = 0;
 }
 
 void AddBodyVelocity(Entity entity, const Vec3f& amountToAdd)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
+  BGE_CORE_ASSERT(s_BodyIndex.Contains(entity),
                   "Entity not registered with a body.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 body = GetBody(entity);
 
-  s_Bodies.momentum[rb.m_BodyId].velocity[0] += amountToAdd[0];
-  s_Bodies.momentum[rb.m_BodyId].velocity[1] += amountToAdd[1];
-  s_Bodies.momentum[rb.m_BodyId].velocity[2] += amountToAdd[2];
+  s_Bodies.momentum[body].velocity[0] += amountToAdd[0];
+  s_Bodies.momentum[body].velocity[1] += amountToAdd[1];
+  s_Bodies.momentum[body].velocity[2] += amountToAdd[2];
+  s_Bodies.idle_counters[body] = 0;
 }
 
 void SetBoxColliderPosition(Entity entity, const Vec3f& position)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_BoxIndex.Contains(entity),
+                  "Entity not registered with a box collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_BoxIndex.GetIndex(entity);
 
-  memcpy(s_Colliders.boxes.transforms[rb.m_ColliderId].position,
+  memcpy(s_Colliders.boxes.transforms[collider].position,
          position.m_Elements, sizeof(position[0]) * 3);
 }
 
 void SetBoxColliderSize(Entity entity, const Vec3f& size)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_BoxIndex.Contains(entity),
+                  "Entity not registered with a box collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_BoxIndex.GetIndex(entity);
 
-  memcpy(s_Colliders.boxes.data[rb.m_ColliderId].size, size.m_Elements,
+  memcpy(s_Colliders.boxes.data[collider].size, size.m_Elements,
          sizeof(size[0]) * 3);
 }
 
@@ -631,23 +1181,23 @@ void SetBoxColliderSize(Entity entity, const Vec3f& size)
 
 void SetSphereColliderPosition(Entity entity, const Vec3f& position)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_SphereIndex.Contains(entity),
+                  "Entity not registered with a sphere collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_SphereIndex.GetIndex(entity);
 
-  memcpy(s_Colliders.spheres.transforms[rb.m_ColliderId].position,
+  memcpy(s_Colliders.spheres.transforms[collider].position,
          position.m_Elements, sizeof(position[0]) * 3);
 }
 
 void SetSphereColliderRadius(Entity entity, float radius)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_SphereIndex.Contains(entity),
+                  "Entity not registered with a sphere collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_SphereIndex.GetIndex(entity);
 
-  s_Colliders.spheres.data[rb.m_ColliderId].radius = radius;
+  s_Colliders.spheres.data[collider].radius = radius;
 }
 
 // void SetSphereColliderBody(uint32 colliderId, uint32 bodyId)
@@ -660,37 +1210,116 @@ void SetSphereColliderRadius(Entity entity, float radius)
 
 void GetBodyTransform(Entity entity, Transform& output)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
+  BGE_CORE_ASSERT(s_BodyIndex.Contains(entity),
                   "Entity not registered with a body.");
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  // Only reads the sparse set, so systems may call this from parallel tasks
+  const uint32 body = GetBody(entity);
+
+  output.SetTranslation(Vec3f(s_Bodies.transforms[body].position));
+  output.SetRotation(Quatf(s_Bodies.transforms[body].rotation));
+}
+
+const EntityIndex& GetBodyIndex() { return s_BodyIndex; }
+
+void GetBodyTransforms(uint32 first, uint32 count, Transform* output)
+{
+  BGE_CORE_ASSERT(first + count <= s_BodyIndex.GetCount(),
+                  "Body range out of bounds.");
+
+  // Skip the static world body
+  nudge::Transform* transforms = s_Bodies.transforms + first + 1;
+
+  for (uint32 i = 0; i < count; ++i)
+  {
+    output[i].SetTranslation(Vec3f(transforms[i].position));
+    output[i].SetRotation(Quatf(transforms[i].rotation));
+  }
+}
+
+uint32 ExportBodyMatrices(uint32 first, uint32 count, const Vec3f* scales,
+                          Mat4f* output)
+{
+  BGE_CORE_ASSERT(first + count <= s_BodyIndex.GetCount(),
+                  "Body range out of bounds.");
+
+  // Skip the static world body
+  const nudge::Transform* transforms = s_Bodies.transforms + first + 1;
+  uint8* moved = s_BodyMoved + first + 1;
+
+  uint32 exportedCount = 0;
+  // Receives the matrices which must not be written
+  Mat4f discarded[4];
+
+  for (uint32 i = 0; i < count; i += 4)
+  {
+    // Lanes past the end repeat the last body
+    uint32 lanes[4];
+    uint32 movedMask = 0;
 
-  output.SetTranslation(Vec3f(s_Bodies.transforms[rb.m_BodyId].position));
-  output.SetRotation(Quatf(s_Bodies.transforms[rb.m_BodyId].rotation));
+    for (uint32 lane = 0; lane < 4; ++lane)
+    {
+      lanes[lane] = std::min(i + lane, count - 1);
+
+      if (i + lane < count && moved[lanes[lane]])
+      {
+        movedMask |= 1u << lane;
+      }
+    }
+
+    // Groups of sleeping bodies cost only the flag checks
+    if (movedMask == 0)
+    {
+      continue;
+    }
+
+    float* matrices[4];
+    const Vec3f* bodyScales[4];
+    const nudge::Transform* bodyTransforms[4];
+
+    for (uint32 lane = 0; lane < 4; ++lane)
+    {
+      const bool isMoved = (movedMask >> lane) & 1u;
+
+      matrices[lane] = isMoved ? &output[lanes[lane]][0] : &discarded[lane][0];
+      bodyScales[lane] = &scales[lanes[lane]];
+      bodyTransforms[lane] = &transforms[lanes[lane]];
+
+      if (isMoved)
+      {
+        moved[lanes[lane]] = 0;
+        ++exportedCount;
+      }
+    }
+
+    MakeMatrices4(matrices, bodyScales, bodyTransforms);
+  }
+
+  return exportedCount;
 }
 
 Vec3f GetBoxColliderScale(Entity entity)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_BoxIndex.Contains(entity),
+                  "Entity not registered with a box collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_BoxIndex.GetIndex(entity);
 
-  return Vec3f(s_Colliders.boxes.data[rb.m_ColliderId].size);
+  return Vec3f(s_Colliders.boxes.data[collider].size);
 }
 
 float GetSphereColliderRadius(Entity entity)
 {
-  BGE_CORE_ASSERT(s_EntityToRigidBody.count(entity.GetId()),
-                  "Entity not registered with a body.");
+  BGE_CORE_ASSERT(s_SphereIndex.Contains(entity),
+                  "Entity not registered with a sphere collider.");
 
-  RigidBody rb = s_EntityToRigidBody[entity.GetId()];
+  const uint32 collider = s_SphereIndex.GetIndex(entity);
 
-  return s_Colliders.spheres.data[rb.m_ColliderId].radius;
+  return s_Colliders.spheres.data[collider].radius;
 }
 
-std::vector<Mat4f> GetAllBoxColliderTransforms()
+LinearVector<Mat4f> GetAllBoxColliderTransforms()
 {
-  std::vector<Mat4f> matrices;
+  LinearVector<Mat4f> matrices = FrameAllocator::CreateVector<Mat4f>();
   matrices.reserve(s_Colliders.boxes.count);
 
   for (uint32 i = 0; i < s_Colliders.boxes.count; ++i)
@@ -720,9 +1349,9 @@ std::vector<Mat4f> GetAllBoxColliderTransforms()
   return matrices;
 }
 
-std::vector<Mat4f> GetAllSphereColliderTransforms()
+LinearVector<Mat4f> GetAllSphereColliderTransforms()
 {
-  std::vector<Mat4f> matrices;
+  LinearVector<Mat4f> matrices = FrameAllocator::CreateVector<Mat4f>();
   matrices.reserve(s_Colliders.spheres.count);
 
   for (uint32 i = 0; i < s_Colliders.spheres.count; ++i)
@@ -1,88 +1,85 @@
 #include "physics/RigidBodySystem.h"
 
 #include "logging/Log.h"
+#include "scheduler/ParallelAlgorithms.h"
 
 namespace bge
 {
 
+/// number of body matrices exported by a single task
+constexpr uint32 c_TransformGrainSize = 256u;
+
 void RigidBodySystem::UpdateTransforms()
 {
-  for (size_t i = 0; i < m_BodyTransforms.size(); i++)
-  {
-    PhysicsDevice::GetBodyTransform(m_Entities[i], m_BodyTransforms[i]);
-  }
+  const uint32 count = m_Bodies.GetCount();
+  const Vec3f* scales = m_Bodies.GetColumn<c_ScaleColumn>().data();
+  Mat4f* matrices = m_Bodies.GetColumn<c_MatrixColumn>().data();
+
+  BGE_CORE_ASSERT(count == PhysicsDevice::GetBodyIndex().GetCount(),
+                  "Bodies were created outside of the rigid body system");
+
+  // The matrices are in body order, so every task exports a contiguous range.
+  // Sleeping bodies keep the matrix of their last export.
+  ParallelFor(0u, GetParallelChunkCount(count, c_TransformGrainSize), 1u,
+              [=](uint32 chunk) {
+                const uint32 first = chunk * c_TransformGrainSize;
+                PhysicsDevice::ExportBodyMatrices(
+                    first, std::min(c_TransformGrainSize, count - first),
+                    scales + first, matrices + first);
+              });
 }
 
 void RigidBodySystem::AddBoxBodyComponent(Entity entity, float mass, float cx,
                                           float cy, float cz)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!HasRigidBody(entity),
                   "Component already exists for this entity");
 
   PhysicsDevice::CreateBox(entity, mass, cx, cy, cz);
 
-  m_Entities.push_back(entity);
-  m_ColliderTypes.push_back(ColliderType::Box);
-
-  m_BodyTransforms.emplace_back();
-  m_BodyTransforms.back().SetScale(Vec3f(cx, cy, cz));
+  m_Bodies.Add(entity, ColliderType::Box, Vec3f(cx, cy, cz), Mat4f(1.0f));
 
-  m_EntityToComponentId[entity.GetId()] = m_Entities.size() - 1;
+  BGE_CORE_ASSERT(m_Bodies.GetIndex(entity) ==
+                      PhysicsDevice::GetBodyIndex().GetIndex(entity),
+                  "Rigid bodies are out of order with the physics bodies");
 }
 
 void RigidBodySystem::AddSphereBodyComponent(Entity entity, float mass,
                                              float radius)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!HasRigidBody(entity),
                   "Component already exists for this entity");
 
   PhysicsDevice::CreateSphere(entity, mass, radius);
 
-  m_Entities.push_back(entity);
-  m_ColliderTypes.push_back(ColliderType::Sphere);
+  m_Bodies.Add(entity, ColliderType::Sphere, Vec3f(radius), Mat4f(1.0f));
 
-  m_BodyTransforms.emplace_back();
-  m_BodyTransforms.back().SetScale(Vec3f(radius));
-
-  m_EntityToComponentId[entity.GetId()] = m_Entities.size() - 1;
+  BGE_CORE_ASSERT(m_Bodies.GetIndex(entity) ==
+                      PhysicsDevice::GetBodyIndex().GetIndex(entity),
+                  "Rigid bodies are out of order with the physics bodies");
 }
 
 void RigidBodySystem::DestroyRigidBody(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(HasRigidBody(entity),
                   "Component does not exist for this entity");
 
-  uint32 idToRemove = m_EntityToComponentId[entity.GetId()];
-  uint32 lastComponentIndex = m_Entities.size() - 1;
-  Entity lastEntity = m_Entities[lastComponentIndex];
-
-  Entity entityToRemove = m_Entities[idToRemove];
-  ColliderType type = m_ColliderTypes[idToRemove];
-
-  if (type == ColliderType::Box)
+  if (m_Bodies.Get<c_TypeColumn>(entity) == ColliderType::Box)
   {
-    PhysicsDevice::DestroyBox(entityToRemove);
+    PhysicsDevice::DestroyBox(entity);
   }
   else
   {
-    PhysicsDevice::DestroySphere(entityToRemove);
+    PhysicsDevice::DestroySphere(entity);
   }
 
-  m_Entities[idToRemove] = m_Entities[lastComponentIndex];
-  m_BodyTransforms[idToRemove] = m_BodyTransforms[lastComponentIndex];
-  m_ColliderTypes[idToRemove] = m_ColliderTypes[lastComponentIndex];
-
-  m_Entities.pop_back();
-  m_BodyTransforms.pop_back();
-  m_ColliderTypes.pop_back();
-
-  m_EntityToComponentId[lastEntity.GetId()] = idToRemove;
-  m_EntityToComponentId.erase(entity.GetId());
+  // Both move their last body into the hole, which keeps the order the same
+  m_Bodies.Remove(entity);
 }
 
 void RigidBodySystem::SetBodyPosition(Entity entity, const Vec3f& position)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(HasRigidBody(entity),
                   "Component does not exist for this entity");
 
   PhysicsDevice::SetBodyPosition(entity, position);
@@ -90,26 +87,19 @@ void RigidBodySystem::SetBodyPosition(Entity entity, const Vec3f& position)
 
 void RigidBodySystem::SetBodyVelocity(Entity entity, const Vec3f& velocity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(HasRigidBody(entity),
                   "Component does not exist for this entity");
 
   PhysicsDevice::SetBodyVelocity(entity, velocity);
 }
 void RigidBodySystem::AddBodyVelocity(Entity entity, const Vec3f& amountToAdd)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(HasRigidBody(entity),
                   "Component does not exist for this entity");
 
   PhysicsDevice::AddBodyVelocity(entity, amountToAdd);
 }
 
-// uint32 RigidBodySystem::LookUpBody(Entity entity)
-// {
-//   BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
-//                   "Component does not exist for this entity");
-//   return m_Bodies[m_EntityToComponentId[entity.GetId()]];
-// }
-
 void RigidBodySystem::OnEvent(Event& event)
 {
   EventDispatcher dispatcher(event);
@@ -120,16 +110,13 @@ void RigidBodySystem::OnEvent(Event& event)
 
 bool RigidBodySystem::OnEntitiesDestroyed(EntitiesDestroyedEvent& event)
 {
-  for (auto&& entity : event.GetEntities())
-  {
-    for (auto&& existingEntity : m_Entities)
-    {
-      if (entity == existingEntity)
-      {
-        DestroyRigidBody(entity);
-      }
-    }
-  }
+  const std::vector<Entity>& entities = event.GetEntities();
+  const uint32 count = static_cast<uint32>(entities.size());
+
+  // Both compact the same entities without reordering, so the components stay
+  // in the order of the bodies
+  PhysicsDevice::DestroyBodies(entities.data(), count);
+  m_Bodies.RemoveBatch(entities.data(), count);
 
   return false;
 }
@@ -1,10 +1,14 @@
 #include "rendering/DynamicMeshSystem.h"
 
 #include "math/Quat.h"
+#include "scheduler/ParallelFor.h"
 
 namespace bge
 {
 
+/// number of transforms converted to matrices by a single task
+constexpr uint32 c_TransformGrainSize = 256u;
+
 void DynamicMeshSystem::SetEventCallback(
     const std::function<void(Event&)>& callback)
 {
@@ -14,85 +18,71 @@ void DynamicMeshSystem::SetEventCallback(
 void DynamicMeshSystem::UpdateTransforms(
     const std::vector<Transform>& transforms)
 {
-  BGE_CORE_ASSERT(transforms.size() == m_Meshes.size(),
+  BGE_CORE_ASSERT(transforms.size() == m_Meshes.GetCount(),
+                  "Uneven amount of physical transforms and graphic instances");
+
+  std::vector<Mat4f>& matrices = m_Meshes.GetColumn<c_TransformColumn>();
+
+  ParallelFor(0u, static_cast<uint32>(transforms.size()), c_TransformGrainSize,
+              [&](uint32 i) { matrices[i] = transforms[i].ToMatrix(); });
+  m_Culler.Invalidate();
+}
+
+void DynamicMeshSystem::UpdateTransforms(const std::vector<Mat4f>& matrices)
+{
+  BGE_CORE_ASSERT(matrices.size() == m_Meshes.GetCount(),
                   "Uneven amount of physical transforms and graphic instances");
 
-  for (size_t i = 0; i < transforms.size(); i++)
-  {
-    m_Transforms[i] = transforms[i].ToMatrix();
-  }
+  // Same size, so this copies without reallocating
+  m_Meshes.GetColumn<c_TransformColumn>() = matrices;
+  m_Culler.Invalidate();
 }
 
-void DynamicMeshSystem::RenderMeshes(const Mat4f& projection, const Mat4f& view)
+void DynamicMeshSystem::SubmitMeshes(RenderQueue& queue, const Frustum& frustum)
 {
-  for (size_t meshIndex = 0; meshIndex < m_Meshes.size(); ++meshIndex)
-  {
-    RenderDevice::BindShaderProgram(m_Meshes[meshIndex].m_Material.m_Shader);
-
-    RenderDevice::SetUniformMat4(m_Meshes[meshIndex].m_Material.m_Shader,
-                                 "in_Projection", projection);
-    RenderDevice::SetUniformMat4(m_Meshes[meshIndex].m_Material.m_Shader,
-                                 "in_View", view);
-    RenderDevice::SetUniformMat4(m_Meshes[meshIndex].m_Material.m_Shader,
-                                 "in_Model", m_Transforms[meshIndex]);
-
-    for (size_t textureId = 0;
-         textureId < m_Meshes[meshIndex].m_Material.m_Textures.size();
-         ++textureId)
-    {
-      RenderDevice::BindTexture2D(
-          m_Meshes[meshIndex].m_Material.m_Textures[textureId], textureId);
-    }
-
-    RenderDevice::Draw(m_Meshes[meshIndex].m_Mesh.m_VertexArray,
-                       m_Meshes[meshIndex].m_Mesh.m_IndexBuffer,
-                       m_Meshes[meshIndex].m_Mesh.m_IndicesCount);
-
-    for (int textureId = m_Meshes[meshIndex].m_Material.m_Textures.size() - 1;
-         textureId >= 0; --textureId)
-    {
-      RenderDevice::UnbindTexture2D(textureId);
-    }
-  }
+  const std::vector<Mat4f>& transforms =
+      m_Meshes.GetColumn<c_TransformColumn>();
+
+  const std::vector<DynamicMeshData>& meshes =
+      m_Meshes.GetColumn<c_MeshColumn>();
+  const auto getTransform = [&transforms](uint32 instance) {
+    return transforms[instance];
+  };
+
+  m_Renderer.UpdateBatches(meshes);
+  m_Culler.UpdateBounds(meshes, getTransform);
+  m_Culler.Cull(frustum, m_VisibleInstances);
+  m_Renderer.Submit(queue, m_VisibleInstances, getTransform);
 }
 
 void DynamicMeshSystem::AddComponent(Entity entity, const DynamicMeshData& data)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!m_Meshes.Contains(entity),
                   "Component already exists for this entity");
 
-  m_Entities.push_back(entity);
-  m_Meshes.push_back(data);
-  m_Transforms.emplace_back(1.0f);
-  m_EntityToComponentId[entity.GetId()] = m_Meshes.size() - 1;
+  m_Meshes.Add(entity, data, Mat4f(1.0f));
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 }
 
 void DynamicMeshSystem::DestroyComponent(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(m_Meshes.Contains(entity),
                   "Component does not exist for this entity");
 
-  uint32 componentIndexToRemove = m_EntityToComponentId[entity.GetId()];
-  uint32 lastComponentIndex = m_Meshes.size() - 1;
-  Entity lastEntity = m_Entities[lastComponentIndex];
-
-  m_Meshes[componentIndexToRemove] = m_Meshes[lastComponentIndex];
-  m_Entities[componentIndexToRemove] = m_Entities[lastComponentIndex];
-  m_Transforms[componentIndexToRemove] = m_Transforms[lastComponentIndex];
-
-  m_Meshes.pop_back();
-  m_Entities.pop_back();
-  m_Transforms.pop_back();
-
-  m_EntityToComponentId[lastEntity.GetId()] = componentIndexToRemove;
-  m_EntityToComponentId.erase(entity.GetId());
+  m_Meshes.Remove(entity);
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 }
 
 DynamicMeshData* DynamicMeshSystem::LookUpComponent(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(m_Meshes.Contains(entity),
                   "Component does not exist for this entity");
-  return &m_Meshes[m_EntityToComponentId[entity.GetId()]];
+  // The caller may change the mesh or the material
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
+  return &m_Meshes.Get<c_MeshColumn>(entity);
 }
 
 void DynamicMeshSystem::OnEvent(Event& event)
@@ -105,16 +95,10 @@ void DynamicMeshSystem::OnEvent(Event& event)
 
 bool DynamicMeshSystem::OnEntitiesDestroyed(EntitiesDestroyedEvent& event)
 {
-  for (auto&& entity : event.GetEntities())
-  {
-    for (auto&& existingEntity : m_Entities)
-    {
-      if (entity == existingEntity)
-      {
-        DestroyComponent(entity);
-      }
-    }
-  }
+  const std::vector<Entity>& entities = event.GetEntities();
+  m_Meshes.RemoveBatch(entities.data(), static_cast<uint32>(entities.size()));
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 
   return false;
 }
@@ -0,0 +1,231 @@
+#include "rendering/FrustumCuller.h"
+
+#include "scheduler/ParallelAlgorithms.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace bge
+{
+
+/// Boxes culled serially, larger sets are culled in parallel tasks
+constexpr uint32 c_ParallelCullThreshold = 16384u;
+/// Number of boxes culled by a single task, a multiple of the lane count
+constexpr uint32 c_CullGrainSize = 4096u;
+
+#if defined __AVX__
+/// Boxes tested per instruction
+constexpr uint32 c_CullLaneCount = 8u;
+using CullLanes = __m256;
+
+static FORCEINLINE CullLanes LoadLanes(const float* data)
+{
+  return _mm256_loadu_ps(data);
+}
+static FORCEINLINE CullLanes SetLanes(float value)
+{
+  return _mm256_set1_ps(value);
+}
+static FORCEINLINE CullLanes MultiplyAdd(CullLanes a, CullLanes b, CullLanes c)
+{
+  return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+}
+/**
+ * @return a bit per lane, set if the lane isn't negative
+ */
+static FORCEINLINE uint32 GetNonNegativeMask(CullLanes lanes)
+{
+  return _mm256_movemask_ps(
+      _mm256_cmp_ps(lanes, _mm256_setzero_ps(), _CMP_GE_OQ));
+}
+#else
+/// Boxes tested per instruction
+constexpr uint32 c_CullLaneCount = 4u;
+using CullLanes = __m128;
+
+static FORCEINLINE CullLanes LoadLanes(const float* data)
+{
+  return _mm_loadu_ps(data);
+}
+static FORCEINLINE CullLanes SetLanes(float value)
+{
+  return _mm_set1_ps(value);
+}
+static FORCEINLINE CullLanes MultiplyAdd(CullLanes a, CullLanes b, CullLanes c)
+{
+  return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+/**
+ * @return a bit per lane, set if the lane isn't negative
+ */
+static FORCEINLINE uint32 GetNonNegativeMask(CullLanes lanes)
+{
+  return _mm_movemask_ps(_mm_cmpge_ps(lanes, _mm_setzero_ps()));
+}
+#endif
+
+static_assert(c_CullGrainSize % c_CullLaneCount == 0,
+              "Parallel chunks must start at the first lane of a block");
+
+Frustum ExtractFrustum(const Mat4f& projection, const Mat4f& view)
+{
+  // A point is inside the view volume when -w <= x, y, z <= w in clip space,
+  // so every plane is the w row of the clip matrix plus or minus another row
+  const Mat4f clip = projection * view;
+
+  Vec4f rows[4];
+  for (uint32 row = 0; row < 4; ++row)
+  {
+    rows[row] = Vec4f(clip[row * 4 + 0], clip[row * 4 + 1], clip[row * 4 + 2],
+                      clip[row * 4 + 3]);
+  }
+
+  Frustum frustum;
+  frustum.m_Planes[0] = rows[3] + rows[0];
+  frustum.m_Planes[1] = rows[3] - rows[0];
+  frustum.m_Planes[2] = rows[3] + rows[1];
+  frustum.m_Planes[3] = rows[3] - rows[1];
+  frustum.m_Planes[4] = rows[3] + rows[2];
+  frustum.m_Planes[5] = rows[3] - rows[2];
+  return frustum;
+}
+
+FrustumCuller::FrustumCuller()
+    : m_CenterX()
+    , m_CenterY()
+    , m_CenterZ()
+    , m_ExtentX()
+    , m_ExtentY()
+    , m_ExtentZ()
+    , m_ChunkVisibles()
+    , m_Count(0)
+    , m_IsValid(false)
+{
+}
+
+void FrustumCuller::Cull(const Frustum& frustum,
+                         std::vector<uint32>& visibleInstances)
+{
+  // Room for every box, the visible ones are compacted to the front
+  visibleInstances.resize(m_Count);
+
+  if (m_Count < c_ParallelCullThreshold)
+  {
+    visibleInstances.resize(
+        CullRange(frustum, 0u, m_Count, visibleInstances.data()));
+    return;
+  }
+
+  // Every chunk writes its visible boxes from the index of its first box
+  const uint32 chunkCount = GetParallelChunkCount(m_Count, c_CullGrainSize);
+  m_ChunkVisibles.resize(chunkCount);
+
+  ParallelFor(0u, chunkCount, 1u, [&](uint32 chunk) {
+    const uint32 begin = chunk * c_CullGrainSize;
+    const uint32 end = std::min(begin + c_CullGrainSize, m_Count);
+
+    m_ChunkVisibles[chunk] =
+        CullRange(frustum, begin, end, visibleInstances.data() + begin);
+  });
+
+  uint32 visibleCount = 0;
+  for (uint32 chunk = 0; chunk < chunkCount; ++chunk)
+  {
+    const auto chunkBegin = visibleInstances.begin() + chunk * c_CullGrainSize;
+    std::copy(chunkBegin, chunkBegin + m_ChunkVisibles[chunk],
+              visibleInstances.begin() + visibleCount);
+    visibleCount += m_ChunkVisibles[chunk];
+  }
+  visibleInstances.resize(visibleCount);
+}
+
+void FrustumCuller::Resize(uint32 count)
+{
+  // The lanes past the last box are read but never reported as visible
+  const uint32 paddedCount = GetParallelChunkCount(count, c_CullLaneCount) *
+                             c_CullLaneCount;
+
+  m_CenterX.resize(paddedCount, 0.0f);
+  m_CenterY.resize(paddedCount, 0.0f);
+  m_CenterZ.resize(paddedCount, 0.0f);
+  m_ExtentX.resize(paddedCount, 0.0f);
+  m_ExtentY.resize(paddedCount, 0.0f);
+  m_ExtentZ.resize(paddedCount, 0.0f);
+  m_Count = count;
+}
+
+void FrustumCuller::SetBounds(uint32 index, const Mat4f& transform,
+                              const Vec3f& center, const Vec3f& extents)
+{
+  // The world box encloses the transformed local box: the center is
+  // transformed, the half sizes are projected on the world axes
+  float worldCenter[3];
+  float worldExtents[3];
+  for (uint32 row = 0; row < 3; ++row)
+  {
+    const uint32 first = row * 4;
+
+    worldCenter[row] = transform[first + 0] * center[0] +
+                       transform[first + 1] * center[1] +
+                       transform[first + 2] * center[2] + transform[first + 3];
+    worldExtents[row] = std::abs(transform[first + 0]) * extents[0] +
+                        std::abs(transform[first + 1]) * extents[1] +
+                        std::abs(transform[first + 2]) * extents[2];
+  }
+
+  m_CenterX[index] = worldCenter[0];
+  m_CenterY[index] = worldCenter[1];
+  m_CenterZ[index] = worldCenter[2];
+  m_ExtentX[index] = worldExtents[0];
+  m_ExtentY[index] = worldExtents[1];
+  m_ExtentZ[index] = worldExtents[2];
+}
+
+uint32 FrustumCuller::CullRange(const Frustum& frustum, uint32 begin,
+                                uint32 end, uint32* visibleInstances) const
+{
+  const uint32 allLanesMask = (1u << c_CullLaneCount) - 1u;
+  uint32 visibleCount = 0;
+
+  for (uint32 block = begin; block < end; block += c_CullLaneCount)
+  {
+    const CullLanes centerX = LoadLanes(&m_CenterX[block]);
+    const CullLanes centerY = LoadLanes(&m_CenterY[block]);
+    const CullLanes centerZ = LoadLanes(&m_CenterZ[block]);
+    const CullLanes extentX = LoadLanes(&m_ExtentX[block]);
+    const CullLanes extentY = LoadLanes(&m_ExtentY[block]);
+    const CullLanes extentZ = LoadLanes(&m_ExtentZ[block]);
+
+    // A box is outside when its center is further behind a plane than the
+    // box reaches towards the plane's normal
+    uint32 insideMask = allLanesMask;
+    for (uint32 i = 0; i < 6 && insideMask != 0; ++i)
+    {
+      const Vec4f& plane = frustum.m_Planes[i];
+
+      CullLanes distance = SetLanes(plane[3]);
+      distance = MultiplyAdd(SetLanes(plane[0]), centerX, distance);
+      distance = MultiplyAdd(SetLanes(plane[1]), centerY, distance);
+      distance = MultiplyAdd(SetLanes(plane[2]), centerZ, distance);
+      distance = MultiplyAdd(SetLanes(std::abs(plane[0])), extentX, distance);
+      distance = MultiplyAdd(SetLanes(std::abs(plane[1])), extentY, distance);
+      distance = MultiplyAdd(SetLanes(std::abs(plane[2])), extentZ, distance);
+
+      insideMask &= GetNonNegativeMask(distance);
+    }
+
+    // Every index is written, but only kept if its box is visible
+    const uint32 laneCount = std::min(c_CullLaneCount, end - block);
+    for (uint32 lane = 0; lane < laneCount; ++lane)
+    {
+      visibleInstances[visibleCount] = block + lane;
+      visibleCount += (insideMask >> lane) & 1u;
+    }
+  }
+
+  return visibleCount;
+}
+
+} // namespace bge
@@ -0,0 +1,58 @@
+#include "rendering/InstancedMeshRenderer.h"
+
+namespace bge
+{
+
+/**
+ * @return less than 0, 0 or more than 0 if lhs is ordered before, the same as
+ * or after rhs
+ */
+static FORCEINLINE int32 CompareHandles(GenericHandle<8, 24> lhs,
+                                        GenericHandle<8, 24> rhs)
+{
+  const uint32 lhsKey = GetRenderHandleKey(lhs);
+  const uint32 rhsKey = GetRenderHandleKey(rhs);
+
+  return lhsKey < rhsKey ? -1 : (lhsKey > rhsKey ? 1 : 0);
+}
+
+InstancedMeshRenderer::InstancedMeshRenderer()
+    : m_Batches()
+    , m_Instances()
+    , m_InstanceBatches()
+    , m_BatchOffsets()
+    , m_VisibleByBatch()
+    , m_IsValid(false)
+{
+}
+
+int32 InstancedMeshRenderer::CompareBatches(const Mesh& lhsMesh,
+                                            const Material& lhsMaterial,
+                                            const Mesh& rhsMesh,
+                                            const Material& rhsMaterial)
+{
+  // The vertex array identifies the mesh, it holds the buffers of the mesh
+  int32 order = CompareHandles(lhsMesh.m_VertexArray, rhsMesh.m_VertexArray);
+  if (order == 0)
+  {
+    order = CompareHandles(lhsMaterial.m_Shader, rhsMaterial.m_Shader);
+  }
+
+  const std::vector<Texture2DHandle>& lhsTextures = lhsMaterial.m_Textures;
+  const std::vector<Texture2DHandle>& rhsTextures = rhsMaterial.m_Textures;
+
+  for (size_t i = 0;
+       order == 0 && i < lhsTextures.size() && i < rhsTextures.size(); ++i)
+  {
+    order = CompareHandles(lhsTextures[i], rhsTextures[i]);
+  }
+
+  if (order == 0 && lhsTextures.size() != rhsTextures.size())
+  {
+    order = lhsTextures.size() < rhsTextures.size() ? -1 : 1;
+  }
+
+  return order;
+}
+
+} // namespace bge
@@ -5,6 +5,8 @@
 
 #include <tinyobj/tiny_obj_loader.h>
 
+#include <algorithm>
+
 namespace bge
 {
 
@@ -79,19 +81,44 @@ Mesh MeshLibrary::GetMesh(const std::string& filepath)
   newMesh.m_VertexBuffer = RenderDevice::CreateVertexBuffer(
       vertices.size(), sizeof(Vertex), vertices.data());
 
+  // Instanced draws stream the model matrices of the instances, resized to
+  // fit them every draw
+  newMesh.m_InstanceBuffer =
+      RenderDevice::CreateDynamicVertexBuffer(1, sizeof(Mat4f));
+
   VertexBufferLayout bufferLayout;
   bufferLayout.PushFloat(3, false); // first 3 floats (position)
   bufferLayout.PushFloat(3, false); // last 3 floats (normals)
   bufferLayout.PushFloat(2, false); // next 2 floats (texCoords)
 
-  newMesh.m_VertexArray = RenderDevice::CreateVertexArray(
-      &newMesh.m_VertexBuffer, &bufferLayout, 1);
+  VertexBufferLayout instanceLayout(true);
+  instanceLayout.PushFloat(16, false); // model matrix (locations 3 to 6)
+
+  VertexBufferHandle buffers[] = {newMesh.m_VertexBuffer,
+                                  newMesh.m_InstanceBuffer};
+  VertexBufferLayout layouts[] = {bufferLayout, instanceLayout};
+
+  newMesh.m_VertexArray = RenderDevice::CreateVertexArray(buffers, layouts, 2);
 
   newMesh.m_IndexBuffer =
       RenderDevice::CreateIndexBuffer(indices.size(), indices.data());
 
   newMesh.m_IndicesCount = indices.size();
 
+  // The local bounding box the instances of the mesh are culled with
+  Vec3f boundsMin = vertices.front().m_Pos;
+  Vec3f boundsMax = vertices.front().m_Pos;
+  for (const Vertex& vertex : vertices)
+  {
+    for (uint32 axis = 0; axis < 3; ++axis)
+    {
+      boundsMin[axis] = std::min(boundsMin[axis], vertex.m_Pos[axis]);
+      boundsMax[axis] = std::max(boundsMax[axis], vertex.m_Pos[axis]);
+    }
+  }
+  newMesh.m_BoundsCenter = (boundsMin + boundsMax) * 0.5f;
+  newMesh.m_BoundsExtents = (boundsMax - boundsMin) * 0.5f;
+
   m_MeshMap.insert(std::make_pair(filepath, newMesh));
   return newMesh;
 }
@@ -103,6 +130,7 @@ void MeshLibrary::ClearLibrary()
     RenderDevice::DestroyIndexBuffer(mesh.second.m_IndexBuffer);
     RenderDevice::DestroyVertexArray(mesh.second.m_VertexArray);
     RenderDevice::DestroyVertexBuffer(mesh.second.m_VertexBuffer);
+    RenderDevice::DestroyVertexBuffer(mesh.second.m_InstanceBuffer);
   }
 
   m_MeshMap.clear();
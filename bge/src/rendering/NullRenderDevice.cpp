@@ -0,0 +1,588 @@
+#if defined BGE_NULL_RENDER_DEVICE
+
+#include "rendering/NullRenderDevice.h"
+
+#include "logging/Log.h"
+#include "rendering/RenderDevice.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bge
+{
+
+// Types of the layout elements, only the null device reads them
+constexpr uint32 c_FloatElementType = 0;
+constexpr uint32 c_Uint32ElementType = 1;
+constexpr uint32 c_Uint8ElementType = 2;
+
+TextureParameters::TextureParameters()
+    : m_Format(TextureFormat::RGBA)
+    , m_Filter(TextureFilter::Linear)
+    , m_Wrap(TextureWrap::ClampToEdge)
+{
+}
+
+TextureParameters::TextureParameters(TextureFormat format, TextureFilter filter,
+                                     TextureWrap wrap)
+    : m_Format(format)
+    , m_Filter(filter)
+    , m_Wrap(wrap)
+{
+}
+
+VertexBufferLayout::BufferElement::BufferElement(uint32 type, uint32 size,
+                                                 uint32 count, uint32 offset,
+                                                 bool normalized)
+    : m_Type(type)
+    , m_Size(size)
+    , m_Count(count)
+    , m_Offset(offset)
+    , m_Normalized(normalized)
+{
+}
+
+VertexBufferLayout::VertexBufferLayout(bool instanced)
+    : m_Elements()
+    , m_CurrentSizeInBytes(0)
+    , m_IsInstanced(instanced)
+{
+}
+
+void VertexBufferLayout::PushFloat(uint32 count, bool normalized)
+{
+  m_Elements.emplace_back(c_FloatElementType, sizeof(float), count,
+                          m_CurrentSizeInBytes, normalized);
+
+  m_CurrentSizeInBytes += sizeof(float) * count;
+}
+void VertexBufferLayout::PushUint32(uint32 count, bool normalized)
+{
+  m_Elements.emplace_back(c_Uint32ElementType, sizeof(uint32), count,
+                          m_CurrentSizeInBytes, normalized);
+
+  m_CurrentSizeInBytes += sizeof(uint32) * count;
+}
+void VertexBufferLayout::PushUint8(uint32 count, bool normalized)
+{
+  m_Elements.emplace_back(c_Uint8ElementType, sizeof(uint8), count,
+                          m_CurrentSizeInBytes, normalized);
+
+  m_CurrentSizeInBytes += sizeof(uint8) * count;
+}
+
+uint32 VertexBufferLayout::Apply(uint32 firstLocation) const
+{
+  BGE_CORE_ASSERT(!m_Elements.empty(), "Can't apply an empty layout.");
+
+  // Same locations as on the OpenGL device, at most 4 components each
+  uint32 location = firstLocation;
+  for (const BufferElement& element : m_Elements)
+  {
+    location += (element.m_Count + 3) / 4;
+  }
+
+  return location;
+}
+
+namespace RenderDevice
+{
+
+/**
+ * Indices and generations of the handles of one type of resource, recycled
+ * the same way as on the OpenGL device
+ */
+struct HandlePool
+{
+  std::vector<uint32> m_Generations; ///< generation of every index
+  std::vector<uint32> m_FreeIds;     ///< indices of destroyed resources
+};
+
+static constexpr uint32 c_MaxBuffersAllocated = 1 << 8;
+static constexpr uint32 c_MaxVertexArrayBuffersAllocated = 1 << 8;
+static constexpr uint32 c_MaxShaderProgramsAllocated = 1 << 8;
+static constexpr uint32 c_MaxTexturesAllocated = 1 << 8;
+
+static HandlePool s_Buffers;
+static HandlePool s_VAOBuffers;
+static HandlePool s_ShaderPrograms;
+static HandlePool s_Textures;
+
+/// commands recorded since the last reset
+static RenderDeviceStats s_Stats = {};
+/// commands recorded since the last StartTrace
+static std::vector<RenderCommand> s_Trace;
+/// whether the commands are recorded into the trace
+static bool s_IsTracing = false;
+
+/**
+ * Append a command to the trace, if it's being recorded
+ */
+static void RecordCommand(RenderCommandType type, uint32 argument = 0,
+                          uint64 size = 0)
+{
+  if (s_IsTracing)
+  {
+    s_Trace.push_back(RenderCommand{type, argument, size});
+  }
+}
+
+/**
+ * Take a free index of the pool, or a new one
+ * @param maxCount the most resources of the pool which can exist at once
+ * @param type the command which creates the resource
+ * @param size bytes of the initial data of the resource
+ * @return the handle of the new resource
+ */
+static GenericHandle<8, 24> CreateHandle(HandlePool& pool, uint32 maxCount,
+                                         RenderCommandType type,
+                                         uint64 size = 0)
+{
+  uint32 index = 0;
+
+  if (!pool.m_FreeIds.empty())
+  {
+    index = pool.m_FreeIds.back();
+    pool.m_FreeIds.pop_back();
+  }
+  else
+  {
+    pool.m_Generations.emplace_back(0);
+    index = pool.m_Generations.size() - 1;
+    BGE_CORE_ASSERT(index < maxCount, "Can't have more than max buffers.");
+  }
+
+  ++s_Stats.m_CreatedResources;
+  s_Stats.m_UploadedBytes += size;
+  RecordCommand(type, index, size);
+
+  return GenericHandle<8, 24>{index, pool.m_Generations[index]};
+}
+
+/**
+ * Return the index of a handle to the pool, so its handle becomes invalid
+ */
+static void DestroyHandle(HandlePool& pool, GenericHandle<8, 24> handle,
+                          RenderCommandType type)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == pool.m_Generations[handle.m_Index],
+                  "Trying to destroy an invalid handle");
+
+  uint32 index = handle.m_Index;
+  ++pool.m_Generations[index];
+  pool.m_FreeIds.emplace_back(index);
+
+  ++s_Stats.m_DestroyedResources;
+  RecordCommand(type, index);
+}
+
+/**
+ * Record a bind of a handle
+ */
+static void BindHandle(const HandlePool& pool, GenericHandle<8, 24> handle,
+                       RenderCommandType type)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == pool.m_Generations[handle.m_Index],
+                  "Trying to bind an invalid handle");
+
+  ++s_Stats.m_Binds;
+  RecordCommand(type, handle.m_Index);
+}
+
+/**
+ * Record the upload of a uniform
+ * @param size bytes of the uniform data
+ */
+static void UploadUniform(ShaderProgramHandle handle, uint64 size)
+{
+  BGE_CORE_ASSERT(handle.m_Generation ==
+                      s_ShaderPrograms.m_Generations[handle.m_Index],
+                  "Trying to use an invalid shader program");
+
+  ++s_Stats.m_UniformUploads;
+  s_Stats.m_UploadedBytes += size;
+  RecordCommand(RenderCommandType::SetUniform, handle.m_Index, size);
+}
+
+/**
+ * @return bytes of a pixel of a texture format
+ */
+static uint32 GetPixelSize(TextureFormat format)
+{
+  switch (format)
+  {
+    case TextureFormat::RGB:
+      return 3;
+    case TextureFormat::RGBA:
+    case TextureFormat::Depth:
+    case TextureFormat::DepthStencil:
+      return 4;
+  }
+
+  return 4;
+}
+
+void Initialize()
+{
+  s_Stats = RenderDeviceStats{};
+
+  BGE_CORE_INFO("Initialized the null render device, commands are recorded "
+                "but not drawn");
+}
+
+void Shutdown()
+{
+  s_Buffers = HandlePool{};
+  s_VAOBuffers = HandlePool{};
+  s_ShaderPrograms = HandlePool{};
+  s_Textures = HandlePool{};
+}
+
+void SetClearColor(float, float, float, float)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::SetClearColor);
+}
+
+void ClearBuffers(bool color, bool depth)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::ClearBuffers,
+                (color ? 1u : 0u) | (depth ? 2u : 0u));
+}
+
+void SetDepthTesting(bool enabled)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::SetDepthTesting, enabled ? 1u : 0u);
+}
+
+void SetBlend(bool enabled)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::SetBlend, enabled ? 1u : 0u);
+}
+
+void SetCulling(bool enabled)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::SetCulling, enabled ? 1u : 0u);
+}
+
+void SetViewport(uint32, uint32, uint32, uint32)
+{
+  ++s_Stats.m_StateChanges;
+  RecordCommand(RenderCommandType::SetViewport);
+}
+
+VertexArrayHandle CreateVertexArray(VertexBufferHandle* vertexBuffers,
+                                    VertexBufferLayout* layouts, uint32 count)
+{
+  uint32 location = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    BGE_CORE_ASSERT(vertexBuffers[i].m_Generation ==
+                        s_Buffers.m_Generations[vertexBuffers[i].m_Index],
+                    "Trying to use an invalid vertex buffer");
+    location = layouts[i].Apply(location);
+  }
+
+  return CreateHandle(s_VAOBuffers, c_MaxVertexArrayBuffersAllocated,
+                      RenderCommandType::CreateVertexArray);
+}
+
+void DestroyVertexArray(VertexArrayHandle handle)
+{
+  DestroyHandle(s_VAOBuffers, handle, RenderCommandType::DestroyVertexArray);
+}
+
+void BindVertexArray(VertexArrayHandle handle)
+{
+  BindHandle(s_VAOBuffers, handle, RenderCommandType::BindVertexArray);
+}
+
+void UnbindVertexArray() {}
+
+VertexBufferHandle CreateVertexBuffer(uint32 vertexCount, uint32 stride,
+                                      const void* initialData)
+{
+  const uint64 size =
+      initialData ? static_cast<uint64>(vertexCount) * stride : 0;
+
+  return CreateHandle(s_Buffers, c_MaxBuffersAllocated,
+                      RenderCommandType::CreateVertexBuffer, size);
+}
+
+VertexBufferHandle CreateDynamicVertexBuffer(uint32, uint32)
+{
+  return CreateHandle(s_Buffers, c_MaxBuffersAllocated,
+                      RenderCommandType::CreateVertexBuffer);
+}
+
+void UpdateDynamicVertexBuffer(VertexBufferHandle handle, uint32 vertexCount,
+                               uint32 stride, const void*)
+{
+  BGE_CORE_ASSERT(handle.m_Generation ==
+                      s_Buffers.m_Generations[handle.m_Index],
+                  "Trying to update an invalid handle");
+
+  const uint64 size = static_cast<uint64>(vertexCount) * stride;
+  s_Stats.m_UploadedBytes += size;
+  RecordCommand(RenderCommandType::UpdateVertexBuffer, handle.m_Index, size);
+}
+
+void DestroyVertexBuffer(VertexBufferHandle handle)
+{
+  DestroyHandle(s_Buffers, handle, RenderCommandType::DestroyVertexBuffer);
+}
+
+IndexBufferHandle CreateIndexBuffer(uint32 indexCount,
+                                    const uint32* initialData)
+{
+  const uint64 size =
+      initialData ? static_cast<uint64>(indexCount) * sizeof(uint32) : 0;
+
+  return CreateHandle(s_Buffers, c_MaxBuffersAllocated,
+                      RenderCommandType::CreateIndexBuffer, size);
+}
+
+void DestroyIndexBuffer(IndexBufferHandle handle)
+{
+  DestroyHandle(s_Buffers, handle, RenderCommandType::DestroyIndexBuffer);
+}
+
+void BindIndexBuffer(IndexBufferHandle handle)
+{
+  BindHandle(s_Buffers, handle, RenderCommandType::BindIndexBuffer);
+}
+
+void UnbindIndexBuffer() {}
+
+ShaderProgramHandle CreateShaderProgram(const char*)
+{
+  return CreateHandle(s_ShaderPrograms, c_MaxShaderProgramsAllocated,
+                      RenderCommandType::CreateShaderProgram);
+}
+
+ShaderProgramHandle CreateShaderProgram(const char*, const char*)
+{
+  return CreateHandle(s_ShaderPrograms, c_MaxShaderProgramsAllocated,
+                      RenderCommandType::CreateShaderProgram);
+}
+
+void DestroyShaderProgram(ShaderProgramHandle handle)
+{
+  DestroyHandle(s_ShaderPrograms, handle,
+                RenderCommandType::DestroyShaderProgram);
+}
+
+void BindShaderProgram(ShaderProgramHandle handle)
+{
+  BindHandle(s_ShaderPrograms, handle, RenderCommandType::BindShaderProgram);
+}
+
+void UnbindShaderProgram() {}
+
+void SetUniform1f(ShaderProgramHandle handle, UniformId, float)
+{
+  UploadUniform(handle, sizeof(float));
+}
+void SetUniform1fv(ShaderProgramHandle handle, UniformId, float*, int32 count)
+{
+  UploadUniform(handle, sizeof(float) * count);
+}
+void SetUniform1i(ShaderProgramHandle handle, UniformId, int32)
+{
+  UploadUniform(handle, sizeof(int32));
+}
+void SetUniform1iv(ShaderProgramHandle handle, UniformId, int32*, int32 count)
+{
+  UploadUniform(handle, sizeof(int32) * count);
+}
+void SetUniform2f(ShaderProgramHandle handle, UniformId, const Vec2f&)
+{
+  UploadUniform(handle, sizeof(float) * 2);
+}
+void SetUniform3f(ShaderProgramHandle handle, UniformId, const Vec3f&)
+{
+  UploadUniform(handle, sizeof(float) * 3);
+}
+void SetUniform4f(ShaderProgramHandle handle, UniformId, const Vec4f&)
+{
+  UploadUniform(handle, sizeof(float) * 4);
+}
+void SetUniformMat4(ShaderProgramHandle handle, UniformId, Mat4f, bool)
+{
+  UploadUniform(handle, sizeof(float) * 16);
+}
+
+void SetUniformBlockBinding(UniformId, uint32) {}
+
+UniformBufferHandle CreateUniformBuffer(uint32)
+{
+  return CreateHandle(s_Buffers, c_MaxBuffersAllocated,
+                      RenderCommandType::CreateUniformBuffer);
+}
+
+void UpdateUniformBuffer(UniformBufferHandle handle, uint32 size, const void*)
+{
+  BGE_CORE_ASSERT(handle.m_Generation ==
+                      s_Buffers.m_Generations[handle.m_Index],
+                  "Trying to update an invalid handle");
+
+  s_Stats.m_UploadedBytes += size;
+  RecordCommand(RenderCommandType::UpdateUniformBuffer, handle.m_Index, size);
+}
+
+void DestroyUniformBuffer(UniformBufferHandle handle)
+{
+  DestroyHandle(s_Buffers, handle, RenderCommandType::DestroyUniformBuffer);
+}
+
+void BindUniformBuffer(UniformBufferHandle handle, uint32)
+{
+  BindHandle(s_Buffers, handle, RenderCommandType::BindUniformBuffer);
+}
+
+Texture2DHandle CreateTexture2D(uint32 width, uint32 height, uint8* data,
+                                TextureParameters parameters)
+{
+  const uint64 size = data ? static_cast<uint64>(width) * height *
+                                 GetPixelSize(parameters.m_Format)
+                          : 0;
+
+  return CreateHandle(s_Textures, c_MaxTexturesAllocated,
+                      RenderCommandType::CreateTexture2D, size);
+}
+
+void DestroyTexture2D(Texture2DHandle handle)
+{
+  DestroyHandle(s_Textures, handle, RenderCommandType::DestroyTexture2D);
+}
+
+void BindTexture2D(Texture2DHandle handle, uint32)
+{
+  BindHandle(s_Textures, handle, RenderCommandType::BindTexture2D);
+}
+void UnbindTexture2D(uint32) {}
+
+void Draw(VertexArrayHandle vao, IndexBufferHandle ibo, uint32 indicesCount)
+{
+  BindVertexArray(vao);
+  BindIndexBuffer(ibo);
+
+  ++s_Stats.m_DrawCalls;
+  ++s_Stats.m_DrawnInstances;
+  s_Stats.m_DrawnIndices += indicesCount;
+  RecordCommand(RenderCommandType::Draw, 1u, indicesCount);
+}
+
+void DrawInstanced(uint32 indicesCount, uint32 instanceCount)
+{
+  ++s_Stats.m_DrawCalls;
+  s_Stats.m_DrawnInstances += instanceCount;
+  s_Stats.m_DrawnIndices += static_cast<uint64>(indicesCount) * instanceCount;
+  RecordCommand(RenderCommandType::DrawInstanced, instanceCount, indicesCount);
+}
+
+void DrawWireframeLines(uint32 indicesCount)
+{
+  ++s_Stats.m_DrawCalls;
+  ++s_Stats.m_DrawnInstances;
+  s_Stats.m_DrawnIndices += indicesCount;
+  RecordCommand(RenderCommandType::DrawWireframeLines, 1u, indicesCount);
+}
+
+} // namespace RenderDevice
+
+namespace NullRenderDevice
+{
+
+const RenderDeviceStats& GetStats() { return RenderDevice::s_Stats; }
+
+void ResetStats() { RenderDevice::s_Stats = RenderDeviceStats{}; }
+
+void LogStats(uint32 frameCount)
+{
+  const RenderDeviceStats& stats = RenderDevice::s_Stats;
+  const double frames = frameCount > 0 ? frameCount : 1;
+
+  BGE_CORE_INFO("Null render device, per frame: {0} draws, {1} instances, "
+                "{2} indices, {3} binds, {4} uniform uploads, {5} uploaded "
+                "bytes, {6} state changes",
+                stats.m_DrawCalls / frames, stats.m_DrawnInstances / frames,
+                stats.m_DrawnIndices / frames, stats.m_Binds / frames,
+                stats.m_UniformUploads / frames, stats.m_UploadedBytes / frames,
+                stats.m_StateChanges / frames);
+}
+
+void StartTrace()
+{
+  RenderDevice::s_Trace.clear();
+  RenderDevice::s_IsTracing = true;
+}
+
+void StopTrace() { RenderDevice::s_IsTracing = false; }
+
+const std::vector<RenderCommand>& GetTrace() { return RenderDevice::s_Trace; }
+
+bool SaveTrace(const char* filepath)
+{
+  static const char* s_CommandNames[] = {
+      "SetClearColor",
+      "ClearBuffers",
+      "SetDepthTesting",
+      "SetBlend",
+      "SetCulling",
+      "SetViewport",
+      "CreateVertexArray",
+      "DestroyVertexArray",
+      "BindVertexArray",
+      "CreateVertexBuffer",
+      "UpdateVertexBuffer",
+      "DestroyVertexBuffer",
+      "CreateIndexBuffer",
+      "DestroyIndexBuffer",
+      "BindIndexBuffer",
+      "CreateShaderProgram",
+      "DestroyShaderProgram",
+      "BindShaderProgram",
+      "SetUniform",
+      "CreateUniformBuffer",
+      "UpdateUniformBuffer",
+      "DestroyUniformBuffer",
+      "BindUniformBuffer",
+      "CreateTexture2D",
+      "DestroyTexture2D",
+      "BindTexture2D",
+      "Draw",
+      "DrawInstanced",
+      "DrawWireframeLines"};
+  static_assert(sizeof(s_CommandNames) / sizeof(s_CommandNames[0]) ==
+                    static_cast<size_t>(RenderCommandType::Count),
+                "Every command type needs a name");
+
+  std::ofstream file(filepath);
+  if (!file)
+  {
+    BGE_CORE_ERROR("Could not open the render command trace file {0}",
+                   filepath);
+    return false;
+  }
+
+  for (const RenderCommand& command : RenderDevice::s_Trace)
+  {
+    file << s_CommandNames[static_cast<uint32>(command.m_Type)] << ' '
+         << command.m_Argument << ' ' << command.m_Size << '\n';
+  }
+
+  BGE_CORE_INFO("Wrote {0} render commands to {1}",
+                RenderDevice::s_Trace.size(), filepath);
+  return true;
+}
+
+} // namespace NullRenderDevice
+} // namespace bge
+
+#endif
@@ -1,4 +1,5 @@
-#if defined BGE_PLATFORM_UNIX || BGE_PLATFORM_APPLE || BGE_PLATFORM_WINDOWS
+#if !defined BGE_NULL_RENDER_DEVICE &&                                         \
+    (defined BGE_PLATFORM_UNIX || BGE_PLATFORM_APPLE || BGE_PLATFORM_WINDOWS)
 
 #include "logging/Log.h"
 #include "rendering/RenderDevice.h"
@@ -8,6 +9,7 @@
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -63,6 +65,13 @@ VertexBufferLayout::BufferElement::BufferElement(uint32 type, uint32 size,
 {
 }
 
+VertexBufferLayout::VertexBufferLayout(bool instanced)
+    : m_Elements()
+    , m_CurrentSizeInBytes(0)
+    , m_IsInstanced(instanced)
+{
+}
+
 void VertexBufferLayout::PushFloat(uint32 count, bool normalized)
 {
   m_Elements.emplace_back(GL_FLOAT, sizeof(float), count, m_CurrentSizeInBytes,
@@ -85,18 +94,31 @@ void VertexBufferLayout::PushUint8(uint32 count, bool normalized)
   m_CurrentSizeInBytes += sizeof(uint8) * count;
 }
 
-void VertexBufferLayout::Apply() const
+uint32 VertexBufferLayout::Apply(uint32 firstLocation) const
 {
   BGE_CORE_ASSERT(!m_Elements.empty(), "Can't apply an empty layout.");
 
+  uint32 location = firstLocation;
   for (std::size_t i = 0; i < m_Elements.size(); i++)
   {
     const BufferElement& element = m_Elements[i];
-    GLCall(glEnableVertexAttribArray(i));
-    GLCall(glVertexAttribPointer(
-        i, element.m_Count, element.m_Type, element.m_Normalized,
-        m_CurrentSizeInBytes, reinterpret_cast<const void*>(element.m_Offset)));
+
+    // An attribute has at most 4 components
+    for (uint32 component = 0; component < element.m_Count; component += 4)
+    {
+      const uint32 offset = element.m_Offset + component * element.m_Size;
+
+      GLCall(glEnableVertexAttribArray(location));
+      GLCall(glVertexAttribPointer(
+          location, std::min(element.m_Count - component, 4u), element.m_Type,
+          element.m_Normalized, m_CurrentSizeInBytes,
+          reinterpret_cast<const void*>(offset)));
+      GLCall(glVertexAttribDivisor(location, m_IsInstanced ? 1 : 0));
+      ++location;
+    }
   }
+
+  return location;
 }
 
 namespace RenderDevice
@@ -109,6 +131,8 @@ static GLenum GetGLTextureWrap(TextureWrap wrap);
 static GLuint AddShader(GLuint shaderProgram, const char* src, GLenum type);
 static bool CheckShaderError(GLuint shader, int flag, bool isProgram,
                              const std::string& errorMessage);
+static void BuildUniformTable(uint32 programId);
+static void BindUniformBlocks(uint32 programId);
 
 static constexpr uint32 c_MaxBuffersAllocated = 1 << 8;
 static constexpr uint32 c_MaxVertexArrayBuffersAllocated = 1 << 8;
@@ -130,6 +154,28 @@ static std::vector<uint32> s_FreeVAOBufferIds;
 static std::vector<uint32> s_FreeShaderIds;
 static std::vector<uint32> s_FreeTextureIds;
 
+/**
+ * A slot of a shader program's uniform table
+ */
+struct UniformSlot
+{
+  uint32 m_Hash;    /**< The id of the uniform */
+  GLint m_Location; /**< The location of the uniform, -1 in a free slot */
+};
+
+/**
+ * The binding point of a uniform block
+ */
+struct UniformBlockBinding
+{
+  uint32 m_Hash;         /**< The id of the uniform block */
+  uint32 m_BindingPoint; /**< The binding point of the block */
+};
+
+// Open addressed uniform locations of each shader program, made at link time
+static std::vector<UniformSlot> s_UniformTables[c_MaxShaderProgramsAllocated];
+static std::vector<UniformBlockBinding> s_UniformBlockBindings;
+
 void Initialize()
 {
   // Initialize glad
@@ -244,6 +290,7 @@ VertexArrayHandle CreateVertexArray(VertexBufferHandle* vertexBuffers,
 
   GLCall(glBindVertexArray(s_VAOBuffers[vaoBufferId]));
 
+  uint32 location = 0;
   for (size_t i = 0; i < count; i++)
   {
     VertexBufferHandle& vboHandle = vertexBuffers[i];
@@ -254,7 +301,7 @@ VertexArrayHandle CreateVertexArray(VertexBufferHandle* vertexBuffers,
                     "Trying to use an invalid vertex buffer");
 
     GLCall(glBindBuffer(GL_ARRAY_BUFFER, s_Buffers[vboHandle.m_Index]));
-    vboLayout.Apply();
+    location = vboLayout.Apply(location);
   }
 
   return VertexArrayHandle{vaoBufferId, s_VAOBufferGenerations[vaoBufferId]};
@@ -327,6 +374,19 @@ VertexBufferHandle CreateDynamicVertexBuffer(uint32 vertexCount, uint32 stride)
   return VertexBufferHandle{bufferId, s_BufferGenerations[bufferId]};
 }
 
+void UpdateDynamicVertexBuffer(VertexBufferHandle handle, uint32 vertexCount,
+                               uint32 stride, const void* data)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == s_BufferGenerations[handle.m_Index],
+                  "Trying to update an invalid handle");
+
+  // Respecifying the whole store lets the driver give the buffer new memory
+  // instead of waiting for the draws which still read the old data
+  GLCall(glBindBuffer(GL_ARRAY_BUFFER, s_Buffers[handle.m_Index]));
+  GLCall(glBufferData(GL_ARRAY_BUFFER, vertexCount * stride, data,
+                      GL_DYNAMIC_DRAW));
+}
+
 void DestroyVertexBuffer(VertexBufferHandle handle)
 {
   BGE_CORE_ASSERT(handle.m_Generation == s_BufferGenerations[handle.m_Index],
@@ -439,6 +499,9 @@ ShaderProgramHandle CreateShaderProgram(const char* vertexShaderSource,
 
   BGE_CORE_ASSERT(validProgram, "Could not validate shader program.");
 
+  BuildUniformTable(programId);
+  BindUniformBlocks(programId);
+
   GLCall(glDetachShader(s_ShaderPrograms[programId], vertexShader));
   GLCall(glDetachShader(s_ShaderPrograms[programId], fragmentShader));
   GLCall(glDeleteShader(vertexShader));
@@ -456,6 +519,7 @@ void DestroyShaderProgram(ShaderProgramHandle handle)
   uint32 index = handle.m_Index;
   ++s_ShaderProgramGenerations[index];
   s_FreeShaderIds.emplace_back(index);
+  s_UniformTables[index].clear();
 
   GLCall(glDeleteProgram(s_ShaderPrograms[index]));
 }
@@ -471,61 +535,143 @@ void BindShaderProgram(ShaderProgramHandle handle)
 
 void UnbindShaderProgram() { GLCall(glUseProgram(0)); }
 
-int32 GetUniformLocation(ShaderProgramHandle handle, const std::string& name)
+/**
+ * Looks up the location of a uniform in the uniform table of a shader program
+ */
+static GLint GetUniformLocation(ShaderProgramHandle handle, UniformId uniform)
 {
-  GLCall(GLint result = glGetUniformLocation(s_ShaderPrograms[handle.m_Index],
-                                             name.c_str()));
+  BGE_CORE_ASSERT(handle.m_Generation ==
+                      s_ShaderProgramGenerations[handle.m_Index],
+                  "Trying to use an invalid handle");
+
+  const std::vector<UniformSlot>& table = s_UniformTables[handle.m_Index];
+  const uint32 mask = static_cast<uint32>(table.size()) - 1;
+
+  // The table always has free slots, which end the probing
+  uint32 slot = uniform.m_Hash & mask;
+  while (table[slot].m_Location != -1 && table[slot].m_Hash != uniform.m_Hash)
+  {
+    slot = (slot + 1) & mask;
+  }
 
-  BGE_CORE_ASSERT(result != -1, "Shader could not find uniform ");
+  BGE_CORE_ASSERT(table[slot].m_Location != -1,
+                  "Shader could not find uniform ");
 
-  return result;
+  return table[slot].m_Location;
 }
 
-void SetUniform1f(ShaderProgramHandle handle, const std::string& name,
-                  float value)
+void SetUniform1f(ShaderProgramHandle handle, UniformId uniform, float value)
 {
-  GLCall(glUniform1f(GetUniformLocation(handle, name), value));
+  GLCall(glUniform1f(GetUniformLocation(handle, uniform), value));
 }
-void SetUniform1fv(ShaderProgramHandle handle, const std::string& name,
-                   float* value, int32 count)
+void SetUniform1fv(ShaderProgramHandle handle, UniformId uniform, float* value,
+                   int32 count)
 {
-  GLCall(glUniform1fv(GetUniformLocation(handle, name), count, value));
+  GLCall(glUniform1fv(GetUniformLocation(handle, uniform), count, value));
 }
-void SetUniform1i(ShaderProgramHandle handle, const std::string& name,
-                  int32 value)
+void SetUniform1i(ShaderProgramHandle handle, UniformId uniform, int32 value)
 {
-  GLCall(glUniform1i(GetUniformLocation(handle, name), value));
+  GLCall(glUniform1i(GetUniformLocation(handle, uniform), value));
 }
-void SetUniform1iv(ShaderProgramHandle handle, const std::string& name,
-                   int32* value, int32 count)
+void SetUniform1iv(ShaderProgramHandle handle, UniformId uniform, int32* value,
+                   int32 count)
 {
-  GLCall(glUniform1iv(GetUniformLocation(handle, name), count, value));
+  GLCall(glUniform1iv(GetUniformLocation(handle, uniform), count, value));
 }
-void SetUniform2f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform2f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec2f& vector)
 {
-  GLCall(glUniform2f(GetUniformLocation(handle, name), vector[0], vector[1]));
+  GLCall(
+      glUniform2f(GetUniformLocation(handle, uniform), vector[0], vector[1]));
 }
-void SetUniform3f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform3f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec3f& vector)
 {
-  GLCall(glUniform3f(GetUniformLocation(handle, name), vector[0], vector[1],
+  GLCall(glUniform3f(GetUniformLocation(handle, uniform), vector[0], vector[1],
                      vector[2]));
 }
-void SetUniform4f(ShaderProgramHandle handle, const std::string& name,
+void SetUniform4f(ShaderProgramHandle handle, UniformId uniform,
                   const Vec4f& vector)
 {
-  GLCall(glUniform4f(GetUniformLocation(handle, name), vector[0], vector[1],
+  GLCall(glUniform4f(GetUniformLocation(handle, uniform), vector[0], vector[1],
                      vector[2], vector[3]));
 }
-void SetUniformMat4(ShaderProgramHandle handle, const std::string& name,
-                    Mat4f matrix, bool transpose)
+void SetUniformMat4(ShaderProgramHandle handle, UniformId uniform, Mat4f matrix,
+                    bool transpose)
 {
   // Transpose flag is set to GL_TRUE, because the matrix class is row-major
-  GLCall(glUniformMatrix4fv(GetUniformLocation(handle, name), 1, transpose,
+  GLCall(glUniformMatrix4fv(GetUniformLocation(handle, uniform), 1, transpose,
                             &matrix[0]));
 }
 
+void SetUniformBlockBinding(UniformId block, uint32 bindingPoint)
+{
+  for (UniformBlockBinding& binding : s_UniformBlockBindings)
+  {
+    if (binding.m_Hash == block.m_Hash)
+    {
+      binding.m_BindingPoint = bindingPoint;
+      return;
+    }
+  }
+
+  s_UniformBlockBindings.push_back(
+      UniformBlockBinding{block.m_Hash, bindingPoint});
+}
+
+UniformBufferHandle CreateUniformBuffer(uint32 size)
+{
+  uint32 bufferId = 0;
+
+  if (!s_FreeBufferIds.empty())
+  {
+    bufferId = s_FreeBufferIds.back();
+    s_FreeBufferIds.pop_back();
+  }
+  else
+  {
+    s_BufferGenerations.emplace_back(0);
+    bufferId = s_BufferGenerations.size() - 1;
+    BGE_CORE_ASSERT(bufferId < c_MaxBuffersAllocated,
+                    "Can't have more than max buffers.");
+  }
+  GLCall(glBindBuffer(GL_UNIFORM_BUFFER, s_Buffers[bufferId]));
+  GLCall(glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW));
+
+  return UniformBufferHandle{bufferId, s_BufferGenerations[bufferId]};
+}
+
+void UpdateUniformBuffer(UniformBufferHandle handle, uint32 size,
+                         const void* data)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == s_BufferGenerations[handle.m_Index],
+                  "Trying to update an invalid handle");
+
+  // Respecified like the dynamic vertex buffers, so a camera can update it
+  // while the draws of the previous camera still read the old data
+  GLCall(glBindBuffer(GL_UNIFORM_BUFFER, s_Buffers[handle.m_Index]));
+  GLCall(glBufferData(GL_UNIFORM_BUFFER, size, data, GL_DYNAMIC_DRAW));
+}
+
+void DestroyUniformBuffer(UniformBufferHandle handle)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == s_BufferGenerations[handle.m_Index],
+                  "Trying to destroy an invalid handle");
+
+  uint32 index = handle.m_Index;
+  ++s_BufferGenerations[index];
+  s_FreeBufferIds.emplace_back(index);
+}
+
+void BindUniformBuffer(UniformBufferHandle handle, uint32 bindingPoint)
+{
+  BGE_CORE_ASSERT(handle.m_Generation == s_BufferGenerations[handle.m_Index],
+                  "Trying to bind an invalid handle");
+
+  GLCall(glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint,
+                          s_Buffers[handle.m_Index]));
+}
+
 Texture2DHandle CreateTexture2D(uint32 width, uint32 height, uint8* data,
                                 TextureParameters parameters)
 {
@@ -601,6 +747,12 @@ void Draw(VertexArrayHandle vao, IndexBufferHandle ibo, uint32 indicesCount)
   GLCall(glDrawElements(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT, nullptr));
 }
 
+void DrawInstanced(uint32 indicesCount, uint32 instanceCount)
+{
+  GLCall(glDrawElementsInstanced(GL_TRIANGLES, indicesCount, GL_UNSIGNED_INT,
+                                 nullptr, instanceCount));
+}
+
 void DrawWireframeLines(uint32 indicesCount)
 {
   GLCall(glDrawElements(GL_LINE_STRIP, indicesCount, GL_UNSIGNED_INT, nullptr));
@@ -661,6 +813,91 @@ static bool CheckShaderError(GLuint shader, int flag, bool isProgram,
   return false;
 }
 
+static void BuildUniformTable(uint32 programId)
+{
+  GLuint program = s_ShaderPrograms[programId];
+
+  GLint uniformCount = 0;
+  GLint maxNameLength = 0;
+  GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount));
+  GLCall(
+      glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength));
+
+  // At least twice as many slots as uniforms, so a probe ends quickly
+  uint32 slotCount = 1;
+  while (slotCount < 2 * static_cast<uint32>(uniformCount))
+  {
+    slotCount <<= 1;
+  }
+
+  std::vector<UniformSlot>& table = s_UniformTables[programId];
+  table.assign(slotCount, UniformSlot{0, -1});
+
+  std::vector<GLchar> name(maxNameLength + 1);
+  for (GLint i = 0; i < uniformCount; ++i)
+  {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    GLCall(glGetActiveUniform(program, i, name.size(), &length, &size, &type,
+                              name.data()));
+    GLCall(GLint location = glGetUniformLocation(program, name.data()));
+
+    // Members of uniform blocks have no location, they're set by buffers
+    if (location == -1)
+    {
+      continue;
+    }
+
+    // Arrays are listed by their first element, eg. "in_Lights[0]"
+    std::string uniformName(name.data(), length);
+    uniformName = uniformName.substr(0, uniformName.find('['));
+
+    const uint32 hash = HashUniformName(uniformName.c_str());
+    uint32 slot = hash & (slotCount - 1);
+    while (table[slot].m_Location != -1)
+    {
+      BGE_CORE_ASSERT(table[slot].m_Hash != hash,
+                      "Two uniforms of a shader have the same id");
+      slot = (slot + 1) & (slotCount - 1);
+    }
+    table[slot] = UniformSlot{hash, location};
+  }
+}
+
+static void BindUniformBlocks(uint32 programId)
+{
+  GLuint program = s_ShaderPrograms[programId];
+
+  GLint blockCount = 0;
+  GLint maxNameLength = 0;
+  GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount));
+  GLCall(glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH,
+                        &maxNameLength));
+
+  std::vector<GLchar> name(maxNameLength + 1);
+  for (GLint i = 0; i < blockCount; ++i)
+  {
+    GLCall(glGetActiveUniformBlockName(program, i, name.size(), nullptr,
+                                       name.data()));
+
+    const uint32 hash = HashUniformName(name.data());
+    auto foundIt = std::find_if(s_UniformBlockBindings.begin(),
+                                s_UniformBlockBindings.end(),
+                                [hash](const UniformBlockBinding& binding) {
+                                  return binding.m_Hash == hash;
+                                });
+
+    if (foundIt == s_UniformBlockBindings.end())
+    {
+      BGE_CORE_WARN("Uniform block {0} has no binding point", name.data());
+      continue;
+    }
+
+    GLCall(glUniformBlockBinding(program, i, foundIt->m_BindingPoint));
+  }
+}
+
 static GLenum GetGLTextureWrap(TextureWrap wrap)
 {
   switch (wrap)
@@ -0,0 +1,229 @@
+#include "rendering/RenderQueue.h"
+
+#include "logging/Log.h"
+
+#include <algorithm>
+
+namespace bge
+{
+
+/// Texture slots whose bound texture is tracked
+constexpr uint32 c_MaxTrackedTextureSlots = 16u;
+/// Largest depth of a sort key
+constexpr uint32 c_MaxKeyDepth = (1u << 24) - 1;
+/// Bits of the sort key sorted by a radix sort pass
+constexpr uint32 c_RadixBits = 8u;
+constexpr uint32 c_RadixBucketCount = 1u << c_RadixBits;
+
+RenderQueue::RenderQueue()
+    : m_Packets()
+    , m_Transforms()
+    , m_SortEntries()
+    , m_SortScratch()
+    , m_TextureSetIds()
+    , m_TextureSetKey()
+    , m_Stats()
+{
+}
+
+RenderSortKey RenderQueue::MakeSortKey(uint8 viewLayer, const Mesh& mesh,
+                                       const Material& material, float depth)
+{
+  const float clampedDepth = std::min(std::max(depth, 0.0f), 1.0f);
+
+  return (static_cast<RenderSortKey>(viewLayer) << 56) |
+         (static_cast<RenderSortKey>(material.m_Shader.m_Index) << 48) |
+         (static_cast<RenderSortKey>(GetTextureSetId(material)) << 32) |
+         (static_cast<RenderSortKey>(mesh.m_VertexArray.m_Index) << 24) |
+         static_cast<RenderSortKey>(clampedDepth * c_MaxKeyDepth);
+}
+
+Mat4f* RenderQueue::Submit(RenderSortKey sortKey, const Mesh& mesh,
+                           const Material& material, uint32 instanceCount)
+{
+  const uint32 firstTransform = static_cast<uint32>(m_Transforms.size());
+
+  m_Packets.push_back(
+      DrawPacket{sortKey, mesh, &material, firstTransform, instanceCount});
+  m_Transforms.resize(firstTransform + instanceCount);
+
+  ++m_Stats.m_Packets;
+
+  return m_Transforms.data() + firstTransform;
+}
+
+void RenderQueue::Flush()
+{
+  SortPackets();
+
+  // Nothing is bound at the start, the first packet binds all of its state
+  bool hasBoundState = false;
+  ShaderProgramHandle boundShader = {};
+  VertexArrayHandle boundVertexArray = {};
+  Texture2DHandle boundTextures[c_MaxTrackedTextureSlots] = {};
+  uint32 boundTextureCount = 0;
+
+  for (const SortEntry& entry : m_SortEntries)
+  {
+    const DrawPacket& packet = m_Packets[entry.m_Packet];
+    const Material& material = *packet.m_Material;
+
+    BGE_CORE_ASSERT(material.m_Textures.size() <= c_MaxTrackedTextureSlots,
+                    "Too many textures in a material");
+
+    // The instance buffer belongs to the mesh, so it's filled before each
+    // draw of the mesh
+    RenderDevice::UpdateDynamicVertexBuffer(
+        packet.m_Mesh.m_InstanceBuffer, packet.m_InstanceCount, sizeof(Mat4f),
+        m_Transforms.data() + packet.m_FirstTransform);
+
+    if (!hasBoundState || GetRenderHandleKey(boundShader) !=
+                              GetRenderHandleKey(material.m_Shader))
+    {
+      RenderDevice::BindShaderProgram(material.m_Shader);
+
+      boundShader = material.m_Shader;
+      ++m_Stats.m_ShaderBinds;
+    }
+    else
+    {
+      ++m_Stats.m_SkippedShaderBinds;
+    }
+
+    for (uint32 slot = 0; slot < material.m_Textures.size(); ++slot)
+    {
+      if (slot >= boundTextureCount ||
+          GetRenderHandleKey(boundTextures[slot]) !=
+              GetRenderHandleKey(material.m_Textures[slot]))
+      {
+        RenderDevice::BindTexture2D(material.m_Textures[slot], slot);
+
+        boundTextures[slot] = material.m_Textures[slot];
+        ++m_Stats.m_TextureBinds;
+      }
+      else
+      {
+        ++m_Stats.m_SkippedTextureBinds;
+      }
+    }
+    // Textures of higher slots stay bound, they're unused by this material
+    boundTextureCount =
+        std::max(boundTextureCount,
+                 static_cast<uint32>(material.m_Textures.size()));
+
+    if (!hasBoundState || GetRenderHandleKey(boundVertexArray) !=
+                              GetRenderHandleKey(packet.m_Mesh.m_VertexArray))
+    {
+      RenderDevice::BindVertexArray(packet.m_Mesh.m_VertexArray);
+      RenderDevice::BindIndexBuffer(packet.m_Mesh.m_IndexBuffer);
+
+      boundVertexArray = packet.m_Mesh.m_VertexArray;
+      ++m_Stats.m_VertexArrayBinds;
+    }
+    else
+    {
+      ++m_Stats.m_SkippedVertexArrayBinds;
+    }
+
+    hasBoundState = true;
+
+    RenderDevice::DrawInstanced(packet.m_Mesh.m_IndicesCount,
+                                packet.m_InstanceCount);
+  }
+
+  for (int slot = boundTextureCount - 1; slot >= 0; --slot)
+  {
+    RenderDevice::UnbindTexture2D(slot);
+  }
+
+  m_Packets.clear();
+  m_Transforms.clear();
+}
+
+void RenderQueue::ResetStats() { m_Stats = RenderQueueStats{}; }
+
+void RenderQueue::LogStats(uint32 frameCount) const
+{
+  const double frames = frameCount > 0 ? frameCount : 1;
+
+  BGE_CORE_INFO("Render queue, per frame: {0} packets, binds of shaders: {1} "
+                "({2} skipped), textures: {3} ({4} skipped), vertex arrays: "
+                "{5} ({6} skipped)",
+                m_Stats.m_Packets / frames, m_Stats.m_ShaderBinds / frames,
+                m_Stats.m_SkippedShaderBinds / frames,
+                m_Stats.m_TextureBinds / frames,
+                m_Stats.m_SkippedTextureBinds / frames,
+                m_Stats.m_VertexArrayBinds / frames,
+                m_Stats.m_SkippedVertexArrayBinds / frames);
+}
+
+uint16 RenderQueue::GetTextureSetId(const Material& material)
+{
+  m_TextureSetKey.clear();
+  for (const Texture2DHandle& texture : material.m_Textures)
+  {
+    m_TextureSetKey.push_back(GetRenderHandleKey(texture));
+  }
+
+  auto foundIt = m_TextureSetIds.find(m_TextureSetKey);
+  if (foundIt != m_TextureSetIds.end())
+  {
+    return foundIt->second;
+  }
+
+  BGE_CORE_ASSERT(m_TextureSetIds.size() <= UINT16_MAX,
+                  "Too many texture sets for the sort key");
+
+  const uint16 id = static_cast<uint16>(m_TextureSetIds.size());
+  m_TextureSetIds.emplace(m_TextureSetKey, id);
+  return id;
+}
+
+void RenderQueue::SortPackets()
+{
+  m_SortEntries.clear();
+  for (uint32 i = 0; i < m_Packets.size(); ++i)
+  {
+    m_SortEntries.push_back(SortEntry{m_Packets[i].m_SortKey, i});
+  }
+  m_SortScratch.resize(m_SortEntries.size());
+
+  // Least significant digit first radix sort, which keeps equal keys in their
+  // submit order. Digits which are the same in every key are skipped.
+  RenderSortKey differingBits = 0;
+  for (const SortEntry& entry : m_SortEntries)
+  {
+    differingBits |= entry.m_Key ^ m_SortEntries.front().m_Key;
+  }
+
+  for (uint32 shift = 0; shift < 64; shift += c_RadixBits)
+  {
+    if (((differingBits >> shift) & (c_RadixBucketCount - 1)) == 0)
+    {
+      continue;
+    }
+
+    uint32 offsets[c_RadixBucketCount] = {};
+    for (const SortEntry& entry : m_SortEntries)
+    {
+      ++offsets[(entry.m_Key >> shift) & (c_RadixBucketCount - 1)];
+    }
+
+    uint32 offset = 0;
+    for (uint32 bucket = 0; bucket < c_RadixBucketCount; ++bucket)
+    {
+      const uint32 count = offsets[bucket];
+      offsets[bucket] = offset;
+      offset += count;
+    }
+
+    for (const SortEntry& entry : m_SortEntries)
+    {
+      m_SortScratch[offsets[(entry.m_Key >> shift) &
+                            (c_RadixBucketCount - 1)]++] = entry;
+    }
+    m_SortEntries.swap(m_SortScratch);
+  }
+}
+
+} // namespace bge
@@ -5,6 +5,22 @@
 namespace bge
 {
 
+// Binding point of the camera uniform buffer
+constexpr uint32 c_CameraBinding = 0;
+// Uniform block of the camera matrices, declared in res/shaders/camera.glsl
+constexpr UniformId c_CameraBlock("Camera");
+
+/**
+ * The std140 layout of the camera uniform block
+ */
+struct CameraUniforms
+{
+  Mat4f m_Projection; /**< The camera's projection matrix */
+  Mat4f m_View;       /**< The camera's view matrix */
+};
+static_assert(sizeof(CameraUniforms) == 2 * 16 * sizeof(float),
+              "The camera block must match two std140 mat4s");
+
 RenderWorld::RenderWorld()
 {
 
@@ -17,6 +33,11 @@ RenderWorld::RenderWorld()
 
 void RenderWorld::Init()
 {
+  // Shaders link their camera block to the buffer's binding point
+  RenderDevice::SetUniformBlockBinding(c_CameraBlock, c_CameraBinding);
+  m_CameraBuffer = RenderDevice::CreateUniformBuffer(sizeof(CameraUniforms));
+  RenderDevice::BindUniformBuffer(m_CameraBuffer, c_CameraBinding);
+
   m_WireframeBoxRenderer.SetMesh(m_MeshLibrary.GetMesh("res/models/cube.obj"));
   m_WireframeBoxRenderer.SetShader(
       m_ShaderLibrary.GetShader("res/shaders/wireframe"));
@@ -49,10 +70,17 @@ void RenderWorld::Render(float interpolation)
     RenderDevice::SetViewport(viewport[0], viewport[1], viewport[2],
                               viewport[3]);
 
-    m_StaticMeshSystem.RenderMeshes(projectionMats[i], viewMats[i]);
-    m_DynamicMeshSystem.RenderMeshes(projectionMats[i], viewMats[i]);
-    m_WireframeBoxRenderer.RenderWireframes(projectionMats[i], viewMats[i]);
-    m_WireframeSphereRenderer.RenderWireframes(projectionMats[i], viewMats[i]);
+    const CameraUniforms camera = {projectionMats[i], viewMats[i]};
+    RenderDevice::UpdateUniformBuffer(m_CameraBuffer, sizeof(camera), &camera);
+
+    // Only the meshes inside the camera's view are submitted
+    const Frustum frustum = ExtractFrustum(projectionMats[i], viewMats[i]);
+    m_StaticMeshSystem.SubmitMeshes(m_RenderQueue, frustum);
+    m_DynamicMeshSystem.SubmitMeshes(m_RenderQueue, frustum);
+    m_RenderQueue.Flush();
+
+    m_WireframeBoxRenderer.RenderWireframes();
+    m_WireframeSphereRenderer.RenderWireframes();
   }
 }
 
@@ -104,6 +132,7 @@ bool RenderWorld::OnWindowClose(WindowCloseEvent& event)
   m_MeshLibrary.ClearLibrary();
   m_ShaderLibrary.ClearLibrary();
   m_TextureLibrary.ClearLibrary();
+  RenderDevice::DestroyUniformBuffer(m_CameraBuffer);
 
   return false;
 }
@@ -6,9 +6,10 @@ namespace bge
 {
 
 StaticMeshSystem::StaticMeshSystem()
-    : m_EntityToComponentId()
-    , m_Meshes()
-    , m_Entities()
+    : m_Meshes()
+    , m_Renderer()
+    , m_Culler()
+    , m_VisibleInstances()
     , m_EventCallback()
 {
 }
@@ -19,68 +20,48 @@ void StaticMeshSystem::SetEventCallback(
   m_EventCallback = callback;
 }
 
-void StaticMeshSystem::RenderMeshes(const Mat4f& projection, const Mat4f& view)
+void StaticMeshSystem::SubmitMeshes(RenderQueue& queue, const Frustum& frustum)
 {
-  for (const auto& instance : m_Meshes)
-  {
-    RenderDevice::BindShaderProgram(instance.m_Material.m_Shader);
-
-    RenderDevice::SetUniformMat4(instance.m_Material.m_Shader, "in_Projection",
-                                 projection);
-    RenderDevice::SetUniformMat4(instance.m_Material.m_Shader, "in_View", view);
-    RenderDevice::SetUniformMat4(instance.m_Material.m_Shader, "in_Model",
-                                 instance.m_Transform);
-
-    for (size_t i = 0; i < instance.m_Material.m_Textures.size(); i++)
-    {
-      RenderDevice::BindTexture2D(instance.m_Material.m_Textures[i], i);
-    }
-
-    RenderDevice::Draw(instance.m_Mesh.m_VertexArray,
-                       instance.m_Mesh.m_IndexBuffer,
-                       instance.m_Mesh.m_IndicesCount);
-
-    for (int i = instance.m_Material.m_Textures.size() - 1; i >= 0; i--)
-    {
-      RenderDevice::UnbindTexture2D(i);
-    }
-  }
+  const std::vector<StaticMeshData>& meshes = m_Meshes.GetColumn<0>();
+
+  const auto getTransform = [&meshes](uint32 instance) {
+    return meshes[instance].m_Transform;
+  };
+
+  m_Renderer.UpdateBatches(meshes);
+  m_Culler.UpdateBounds(meshes, getTransform);
+  m_Culler.Cull(frustum, m_VisibleInstances);
+  m_Renderer.Submit(queue, m_VisibleInstances, getTransform);
 }
 
 void StaticMeshSystem::AddComponent(Entity entity, const StaticMeshData& data)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 0,
+  BGE_CORE_ASSERT(!m_Meshes.Contains(entity),
                   "Component already exists for this entity");
 
-  m_Entities.push_back(entity);
-  m_Meshes.push_back(data);
-  m_EntityToComponentId[entity.GetId()] = m_Meshes.size() - 1;
+  m_Meshes.Add(entity, data);
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 }
 
 void StaticMeshSystem::DestroyComponent(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(m_Meshes.Contains(entity),
                   "Component does not exist for this entity");
 
-  uint32 componentIndexToRemove = m_EntityToComponentId[entity.GetId()];
-  uint32 lastComponentIndex = m_Meshes.size() - 1;
-  Entity lastEntity = m_Entities[lastComponentIndex];
-
-  m_Meshes[componentIndexToRemove] = m_Meshes[lastComponentIndex];
-  m_Entities[componentIndexToRemove] = m_Entities[lastComponentIndex];
-
-  m_Meshes.pop_back();
-  m_Entities.pop_back();
-
-  m_EntityToComponentId[lastEntity.GetId()] = componentIndexToRemove;
-  m_EntityToComponentId.erase(entity.GetId());
+  m_Meshes.Remove(entity);
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 }
 
 StaticMeshData* StaticMeshSystem::LookUpComponent(Entity entity)
 {
-  BGE_CORE_ASSERT(m_EntityToComponentId.count(entity.GetId()) == 1,
+  BGE_CORE_ASSERT(m_Meshes.Contains(entity),
                   "Component does not exist for this entity");
-  return &m_Meshes[m_EntityToComponentId[entity.GetId()]];
+  // The caller may change the mesh, the material or the transform
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
+  return &m_Meshes.Get<0>(entity);
 }
 
 void StaticMeshSystem::OnEvent(Event& event)
@@ -93,16 +74,10 @@ void StaticMeshSystem::OnEvent(Event& event)
 
 bool StaticMeshSystem::OnEntitiesDestroyed(EntitiesDestroyedEvent& event)
 {
-  for (auto&& entity : event.GetEntities())
-  {
-    for (auto&& existingEntity : m_Entities)
-    {
-      if (entity == existingEntity)
-      {
-        DestroyComponent(entity);
-      }
-    }
-  }
+  const std::vector<Entity>& entities = event.GetEntities();
+  m_Meshes.RemoveBatch(entities.data(), static_cast<uint32>(entities.size()));
+  m_Renderer.Invalidate();
+  m_Culler.Invalidate();
 
   return false;
 }
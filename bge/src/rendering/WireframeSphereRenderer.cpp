@@ -5,8 +5,10 @@
 namespace bge
 {
 
-void WireframeSphereRenderer::RenderWireframes(const Mat4f& projection,
-                                               const Mat4f& view)
+// Model matrix of the wireframe shader, set per collider
+constexpr UniformId c_ModelUniform("in_Model");
+
+void WireframeSphereRenderer::RenderWireframes()
 {
   if (!m_IsEnabled)
   {
@@ -15,18 +17,16 @@ void WireframeSphereRenderer::RenderWireframes(const Mat4f& projection,
 
   // Set up the render state that's the same for all object
   RenderDevice::BindShaderProgram(m_WireframeShader);
-  RenderDevice::SetUniformMat4(m_WireframeShader, "in_Projection", projection);
-  RenderDevice::SetUniformMat4(m_WireframeShader, "in_View", view);
   RenderDevice::BindVertexArray(m_SphereMesh.m_VertexArray);
   RenderDevice::BindIndexBuffer(m_SphereMesh.m_IndexBuffer);
 
-  std::vector<Mat4f> boxTransforms =
+  LinearVector<Mat4f> boxTransforms =
       PhysicsDevice::GetAllSphereColliderTransforms();
 
   // Draw call for each box with a unique transform
   for (auto&& transform : boxTransforms)
   {
-    RenderDevice::SetUniformMat4(m_WireframeShader, "in_Model", transform,
+    RenderDevice::SetUniformMat4(m_WireframeShader, c_ModelUniform, transform,
                                  false);
     RenderDevice::DrawWireframeLines(m_SphereMesh.m_IndicesCount);
   }
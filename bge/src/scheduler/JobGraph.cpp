@@ -0,0 +1,275 @@
+#include "scheduler/JobGraph.h"
+
+#include "logging/Log.h"
+
+#include <algorithm>
+#include <string>
+
+namespace bge
+{
+
+JobGraph::JobGraph()
+    : m_Jobs()
+    , m_UnfinishedPredecessors()
+    , m_StartNanos()
+    , m_EndNanos()
+    , m_PathNanos()
+    , m_PathPredecessors()
+    , m_StartTime()
+    , m_RootTask(nullptr)
+    , m_IsBuilt(false)
+    , m_Report()
+{
+}
+
+JobId JobGraph::AddJob(const char* name, std::function<void()> function,
+                       std::initializer_list<JobResourceId> reads,
+                       std::initializer_list<JobResourceId> writes,
+                       std::initializer_list<JobId> predecessors)
+{
+  return AddJob(name, std::move(function), std::vector<JobResourceId>(reads),
+                std::vector<JobResourceId>(writes),
+                std::vector<JobId>(predecessors));
+}
+
+JobId JobGraph::AddJob(const char* name, std::function<void()> function,
+                       std::vector<JobResourceId> reads,
+                       std::vector<JobResourceId> writes,
+                       std::vector<JobId> predecessors)
+{
+  BGE_CORE_ASSERT(!m_IsBuilt, "Can't add jobs to a graph which is built");
+
+  const JobId id = static_cast<JobId>(m_Jobs.size());
+
+  for (JobId predecessor : predecessors)
+  {
+    BGE_CORE_ASSERT(predecessor < id,
+                    "Predecessors must be added before their successors");
+  }
+
+  m_Jobs.push_back(Job{name, std::move(function), std::move(reads),
+                       std::move(writes), std::move(predecessors),
+                       std::vector<JobId>()});
+
+  return id;
+}
+
+bool JobGraph::HasConflict(const Job& first, const Job& second)
+{
+  auto contains = [](const std::vector<JobResourceId>& resources,
+                     JobResourceId resource) {
+    return std::find(resources.begin(), resources.end(), resource) !=
+           resources.end();
+  };
+
+  for (JobResourceId resource : second.m_Writes)
+  {
+    if (contains(first.m_Reads, resource) || contains(first.m_Writes, resource))
+    {
+      return true;
+    }
+  }
+
+  for (JobResourceId resource : second.m_Reads)
+  {
+    if (contains(first.m_Writes, resource))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void JobGraph::Build()
+{
+  const uint32 jobCount = GetJobCount();
+
+  for (JobId job = 0; job < jobCount; ++job)
+  {
+    auto& predecessors = m_Jobs[job].m_Predecessors;
+
+    // Jobs are added in their serial order, so a job only ever waits for
+    // earlier jobs and the graph can't have cycles
+    for (JobId earlierJob = 0; earlierJob < job; ++earlierJob)
+    {
+      if (HasConflict(m_Jobs[earlierJob], m_Jobs[job]))
+      {
+        predecessors.push_back(earlierJob);
+      }
+    }
+
+    std::sort(predecessors.begin(), predecessors.end());
+    predecessors.erase(std::unique(predecessors.begin(), predecessors.end()),
+                       predecessors.end());
+
+    for (JobId predecessor : predecessors)
+    {
+      m_Jobs[predecessor].m_Successors.push_back(job);
+    }
+  }
+
+  m_UnfinishedPredecessors.reset(new std::atomic_int32_t[jobCount]);
+  m_StartNanos.assign(jobCount, 0);
+  m_EndNanos.assign(jobCount, 0);
+
+  // The report of every run reuses the memory sized here
+  m_PathNanos.assign(jobCount, 0);
+  m_PathPredecessors.assign(jobCount, jobCount);
+  m_Report.m_CriticalPath.reserve(jobCount);
+
+  m_IsBuilt = true;
+}
+
+TaskHandle JobGraph::Run()
+{
+  BGE_CORE_ASSERT(m_IsBuilt, "Job graph must be built before running it");
+
+  for (JobId job = 0; job < GetJobCount(); ++job)
+  {
+    m_UnfinishedPredecessors[job].store(
+        static_cast<int32>(m_Jobs[job].m_Predecessors.size()),
+        std::memory_order_relaxed);
+  }
+
+  m_StartTime = std::chrono::steady_clock::now();
+
+  JobGraph* graph = this;
+  m_RootTask = Scheduler::CreateTask(RootTask, &graph, sizeof(graph));
+  return Scheduler::Run(m_RootTask);
+}
+
+void JobGraph::Execute()
+{
+  Scheduler::Wait(Run());
+  UpdateReport();
+}
+
+void JobGraph::RootTask(Task*, const void* taskData)
+{
+  JobGraph* graph = *static_cast<JobGraph* const*>(taskData);
+
+  for (JobId job = 0; job < graph->GetJobCount(); ++job)
+  {
+    if (graph->m_Jobs[job].m_Predecessors.empty())
+    {
+      graph->RunJob(job);
+    }
+  }
+}
+
+void JobGraph::JobTask(Task*, const void* taskData)
+{
+  const JobTaskData* data = static_cast<const JobTaskData*>(taskData);
+  JobGraph* graph = data->m_Graph;
+  const Job& job = graph->m_Jobs[data->m_Job];
+
+  graph->m_StartNanos[data->m_Job] = graph->GetNanosSinceStart();
+  job.m_Function();
+  graph->m_EndNanos[data->m_Job] = graph->GetNanosSinceStart();
+
+  for (JobId successor : job.m_Successors)
+  {
+    // The last predecessor to finish starts the successor
+    if (graph->m_UnfinishedPredecessors[successor].fetch_sub(
+            1, std::memory_order_acq_rel) == 1)
+    {
+      graph->RunJob(successor);
+    }
+  }
+}
+
+void JobGraph::RunJob(JobId job)
+{
+  const JobTaskData taskData{this, job};
+
+  // The caller is the root task or another job of this run, so the root task
+  // can't have finished yet
+  Task* task = Scheduler::CreateChildTask(m_RootTask, JobTask, &taskData,
+                                          sizeof(taskData));
+  Scheduler::Run(task);
+}
+
+int64 JobGraph::GetNanosSinceStart() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - m_StartTime)
+      .count();
+}
+
+void JobGraph::UpdateReport()
+{
+  const uint32 jobCount = GetJobCount();
+
+  // Longest path (by duration) ending at each job. Predecessors always have a
+  // lower id, so a single pass in id order visits them first.
+  std::vector<int64>& pathNanos = m_PathNanos;
+  std::vector<JobId>& pathPredecessor = m_PathPredecessors;
+  std::fill(pathNanos.begin(), pathNanos.end(), 0);
+  std::fill(pathPredecessor.begin(), pathPredecessor.end(), jobCount);
+
+  int64 frameNanos = 0;
+  int64 workNanos = 0;
+  JobId pathEnd = jobCount;
+
+  for (JobId job = 0; job < jobCount; ++job)
+  {
+    const int64 duration = m_EndNanos[job] - m_StartNanos[job];
+
+    for (JobId predecessor : m_Jobs[job].m_Predecessors)
+    {
+      if (pathNanos[predecessor] > pathNanos[job])
+      {
+        pathNanos[job] = pathNanos[predecessor];
+        pathPredecessor[job] = predecessor;
+      }
+    }
+
+    pathNanos[job] += duration;
+    workNanos += duration;
+    frameNanos = std::max(frameNanos, m_EndNanos[job]);
+
+    if (pathEnd == jobCount || pathNanos[job] > pathNanos[pathEnd])
+    {
+      pathEnd = job;
+    }
+  }
+
+  m_Report.m_CriticalPath.clear();
+  for (JobId job = pathEnd; job != jobCount; job = pathPredecessor[job])
+  {
+    m_Report.m_CriticalPath.push_back(job);
+  }
+  std::reverse(m_Report.m_CriticalPath.begin(), m_Report.m_CriticalPath.end());
+
+  m_Report.m_FrameMilli = frameNanos / 1000000.0f;
+  m_Report.m_WorkMilli = workNanos / 1000000.0f;
+  m_Report.m_CriticalPathMilli =
+      pathEnd == jobCount ? 0.0f : pathNanos[pathEnd] / 1000000.0f;
+}
+
+void JobGraph::LogReport() const
+{
+  std::string criticalPath;
+
+  for (JobId job : m_Report.m_CriticalPath)
+  {
+    if (!criticalPath.empty())
+    {
+      criticalPath += " -> ";
+    }
+
+    criticalPath += m_Jobs[job].m_Name;
+    criticalPath += " (";
+    criticalPath += std::to_string(
+        (m_EndNanos[job] - m_StartNanos[job]) / 1000000.0f);
+    criticalPath += " ms)";
+  }
+
+  BGE_CORE_INFO("Job graph frame: {0} ms, work: {1} ms, critical path: {2} ms",
+                m_Report.m_FrameMilli, m_Report.m_WorkMilli,
+                m_Report.m_CriticalPathMilli);
+  BGE_CORE_INFO("Critical path: {0}", criticalPath);
+}
+
+} // namespace bge
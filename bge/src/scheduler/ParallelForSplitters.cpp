@@ -0,0 +1,54 @@
+#include "scheduler/ParallelForSplitters.h"
+
+#include <algorithm>
+
+namespace bge
+{
+
+/// weight of a new leaf timing in the moving average
+constexpr float c_LeafTimingSmoothing = 0.1f;
+
+SplitterProfile::SplitterProfile(float leafBudgetMicros,
+                                 uint32 initialGrainSize)
+    : m_LeafBudgetNanos(leafBudgetMicros * 1000.0f)
+    , m_InitialGrainSize(initialGrainSize)
+    , m_NanosPerElement(0.0f)
+{
+  BGE_CORE_ASSERT(m_LeafBudgetNanos > 0.0f, "Leaf budget must be positive");
+  BGE_CORE_ASSERT(m_InitialGrainSize > 0, "Grain size must be higher than 0");
+}
+
+void SplitterProfile::RecordLeaf(uint32 count, int64 nanos)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  const float sample = static_cast<float>(nanos) / count;
+  const float average = m_NanosPerElement.load(std::memory_order_relaxed);
+
+  // Racing updates from other threads may get lost, which only makes the
+  // average adapt a little slower
+  const float newAverage =
+      average == 0.0f ? sample
+                      : average + (sample - average) * c_LeafTimingSmoothing;
+
+  m_NanosPerElement.store(newAverage, std::memory_order_relaxed);
+}
+
+uint32 SplitterProfile::GetGrainSize() const
+{
+  const float nanosPerElement = GetNanosPerElement();
+
+  if (nanosPerElement <= 0.0f)
+  {
+    return m_InitialGrainSize;
+  }
+
+  const float grainSize = m_LeafBudgetNanos / nanosPerElement;
+
+  return static_cast<uint32>(std::max(1.0f, std::min(grainSize, 1.0e9f)));
+}
+
+} // namespace bge
@@ -1,11 +1,15 @@
 #include "scheduler/Scheduler.h"
 
+#include "scheduler/TaskPool.h"
 #include "scheduler/WorkStealingQueue.h"
 #include "util/RandomNumberGenerator.h"
 #include <logging/Log.h>
 
+#include <immintrin.h>
+
+#include <condition_variable>
+#include <mutex>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 namespace bge
@@ -13,45 +17,54 @@ namespace bge
 namespace Scheduler
 {
 
-/// number of tasks the ring buffer stores
-static constexpr int32 c_MaxTaskCount = 1024;
-
-/// ring buffer of tasks for each thread
-static thread_local Task s_TaskAllocator[c_MaxTaskCount];
-
-/// counter to keep count of the number of total allocated tasks
-static thread_local uint32 s_AllocatedTasksCount = 0u;
+/// pool of tasks for each thread, which only recycles finished tasks
+static thread_local TaskPool s_TaskPool;
 
 /// worker threads
 static std::vector<std::unique_ptr<std::thread>> s_Threads;
 /// work stealing queues per thread
 static std::vector<std::unique_ptr<WorkStealingQueue>> s_TaskQueues;
 
-/// thread id to array index
-static std::unordered_map<std::thread::id, uint32> s_ThreadIdToIndex;
+/// index of the calling thread's queue, assigned when the thread starts or
+/// registers with the scheduler
+static thread_local uint32 s_WorkerIndex = c_InvalidWorkerIndex;
+/// random number generator for picking a queue to steal from
+static thread_local RandomNumberGenerator s_RNG;
+
+/// guards registering and unregistering external threads
+static std::mutex s_RegistrationMutex;
+/// which of the external thread queues are in use
+static bool s_IsExternalQueueUsed[c_MaxExternalThreadCount] = {};
 
 /// shutting down flag
 static std::atomic_bool s_IsShuttingDown;
 ///< worker thread count
 static uint32 s_WorkerThreadCount = 0u;
-static RandomNumberGenerator s_RNG;
 
-WorkStealingQueue* GetWorkerThreadQueue()
-{
-  auto threadId = std::this_thread::get_id();
-  auto index = s_ThreadIdToIndex[threadId];
-  return s_TaskQueues[index].get();
-}
+/// number of idle rounds spent spinning before yielding the time slice
+static constexpr uint32 c_IdleSpinRounds = 64u;
+/// number of _mm_pause instructions issued per spinning round
+static constexpr uint32 c_PausesPerSpin = 32u;
+/// number of idle rounds spent yielding before parking the worker
+static constexpr uint32 c_IdleYieldRounds = 64u;
+
+/// guards the parking of idle workers
+static std::mutex s_IdleMutex;
+/// parked workers wait on this until new tasks are run
+static std::condition_variable s_IdleCondition;
+/// number of workers which are parked or about to be
+static std::atomic_uint32_t s_ParkedWorkerCount;
+/// bumped every time parked workers are woken up
+static std::atomic_uint32_t s_WakeEpoch;
 
-Task* AllocateTask()
+WorkStealingQueue* GetWorkerThreadQueue()
 {
-  // Get a task specific for a thread (uses only thread-local vars)
-  const uint32 index = s_AllocatedTasksCount++;
+  if (s_WorkerIndex == c_InvalidWorkerIndex)
+  {
+    return nullptr;
+  }
 
-  // Warning: if more than c_MaxTaskCount tasks are allocated in 1 frame, then
-  // it's possible that the first task may not have finished and will be
-  // overwritten.
-  return &s_TaskAllocator[index & (c_MaxTaskCount - 1)];
+  return s_TaskQueues[s_WorkerIndex].get();
 }
 
 bool HasTaskCompleted(const Task* task) { return task->m_UnfinishedTasks == 0; }
@@ -80,37 +93,111 @@ Task* GetTask()
 
     if (stealQueue == queue)
     {
-      // don't try to steal from ourselves
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      // don't try to steal from ourselves, the caller backs off and retries
       return nullptr;
     }
 
-    // Try to steal a job from the random queue
-    Task* stolenTask = stealQueue->Steal();
+    // Try to steal a job from the random queue. If that fails too the caller
+    // decides how to back off (see Idle)
+    return stealQueue->Steal();
+  }
 
-    if (stolenTask == nullptr)
+  return task;
+}
+
+bool HasQueuedTasks()
+{
+  for (auto&& queue : s_TaskQueues)
+  {
+    if (queue->Size() > 0)
     {
-      // we couldn't steal a job from the other queue either, so we just yield
-      // our time slice for now
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-      return nullptr;
+      return true;
     }
+  }
+
+  return false;
+}
 
-    return stolenTask;
+void WakeWorkers()
+{
+  // Publish the pushed task before checking for parked workers. Pairs with the
+  // fence in Park, so either we see the parked worker or it sees the task.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (s_ParkedWorkerCount.load(std::memory_order_relaxed) == 0)
+  {
+    return;
   }
 
-  return task;
+  {
+    std::lock_guard<std::mutex> lock(s_IdleMutex);
+    s_WakeEpoch.fetch_add(1, std::memory_order_relaxed);
+  }
+  s_IdleCondition.notify_one();
+}
+
+void Park()
+{
+  const uint32 epoch = s_WakeEpoch.load(std::memory_order_relaxed);
+  s_ParkedWorkerCount.fetch_add(1, std::memory_order_relaxed);
+
+  // Announce the parking before the last look for work (pairs with WakeWorkers)
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (!HasQueuedTasks())
+  {
+    std::unique_lock<std::mutex> lock(s_IdleMutex);
+    s_IdleCondition.wait(lock, [epoch]() {
+      return s_WakeEpoch.load(std::memory_order_relaxed) != epoch ||
+             s_IsShuttingDown;
+    });
+  }
+
+  s_ParkedWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+/**
+ * Backs off after failing to find a task: spin, then yield the time slice and
+ * finally park the worker until a new task is run.
+ * @param idleRounds number of consecutive rounds no task was found, reset
+ * after being woken up so the worker spins again before parking
+ */
+void Idle(uint32& idleRounds)
+{
+  ++idleRounds;
+
+  if (idleRounds < c_IdleSpinRounds)
+  {
+    for (uint32 i = 0; i < c_PausesPerSpin; ++i)
+    {
+      _mm_pause();
+    }
+  }
+  else if (idleRounds < c_IdleSpinRounds + c_IdleYieldRounds)
+  {
+    std::this_thread::yield();
+  }
+  else
+  {
+    Park();
+    idleRounds = 0u;
+  }
 }
 
 void Finish(Task* task)
 {
-  --task->m_UnfinishedTasks;
+  // Read the parent first, once the counter reaches 0 the task can be recycled
+  // by the thread which allocated it
+  Task* parent = task->m_Parent;
 
-  assert(task->m_UnfinishedTasks >= 0);
+  const int32 unfinishedTasks =
+      task->m_UnfinishedTasks.fetch_sub(1, std::memory_order_acq_rel) - 1;
 
-  if ((task->m_UnfinishedTasks == 0) && (task->m_Parent))
+  assert(unfinishedTasks >= 0);
+
+  if ((unfinishedTasks == 0) && (parent))
   {
-    Finish(task->m_Parent);
+    Finish(parent);
   }
 }
 
@@ -120,39 +207,87 @@ void Execute(Task* task)
   Finish(task);
 }
 
-void WorkerThreadMain()
+Task* AllocateTask()
 {
+  // Get a task specific for a thread (uses only thread-local vars)
+  Task* task = s_TaskPool.Allocate();
+
+  BGE_CORE_ASSERT(task != nullptr,
+                  "Task pool overflow, too many unfinished tasks in flight");
+
+  while (task == nullptr)
+  {
+    // Help out with other tasks until one of ours finishes and can be reused
+    if (Task* otherTask = GetTask())
+    {
+      Execute(otherTask);
+    }
+
+    task = s_TaskPool.Allocate();
+  }
+
+  return task;
+}
+
+void WorkerThreadMain(uint32 workerIndex)
+{
+  s_WorkerIndex = workerIndex;
+
+  uint32 idleRounds = 0u;
+
   while (!s_IsShuttingDown)
   {
     Task* task = GetTask();
     if (task)
     {
       Execute(task);
+      idleRounds = 0u;
+    }
+    else
+    {
+      Idle(idleRounds);
     }
   }
 }
 
 void Initialize()
 {
-  s_IsShuttingDown.store(false);
-
   // Fetch the number of supported threads and subtract 1, which is the main
   // thread.
-  s_WorkerThreadCount = std::thread::hardware_concurrency() - 1;
+  Initialize(std::thread::hardware_concurrency() - 1);
+}
+
+void Initialize(uint32 workerThreadCount)
+{
+  s_IsShuttingDown.store(false);
+  s_ParkedWorkerCount.store(0u);
+  s_WakeEpoch.store(0u);
+
+  s_WorkerThreadCount = workerThreadCount;
   s_Threads.reserve(s_WorkerThreadCount);
-  s_TaskQueues.reserve(s_WorkerThreadCount + 1);
-  s_ThreadIdToIndex.reserve(s_WorkerThreadCount + 1);
 
-  // Add the worker queue for the main thread
-  s_TaskQueues.emplace_back(std::make_unique<WorkStealingQueue>());
-  s_ThreadIdToIndex[std::this_thread::get_id()] = 0;
+  // Create every queue before any worker starts, so the queues are never
+  // modified while other threads read them. The main thread is at index 0,
+  // followed by the worker threads and the slots for external threads.
+  const uint32 queueCount = GetMaxWorkerCount();
+  s_TaskQueues.reserve(queueCount);
+  for (uint32 i = 0; i < queueCount; ++i)
+  {
+    s_TaskQueues.emplace_back(std::make_unique<WorkStealingQueue>());
+  }
+
+  for (auto&& isUsed : s_IsExternalQueueUsed)
+  {
+    isUsed = false;
+  }
+
+  s_WorkerIndex = 0u;
 
   // Instantiate threads count - 1, because the main thread is already running
-  for (size_t i = 0; i < s_WorkerThreadCount; i++)
+  for (uint32 i = 0; i < s_WorkerThreadCount; i++)
   {
-    s_Threads.emplace_back(std::make_unique<std::thread>(WorkerThreadMain));
-    s_TaskQueues.emplace_back(std::make_unique<WorkStealingQueue>());
-    s_ThreadIdToIndex[s_Threads.back()->get_id()] = i + 1;
+    s_Threads.emplace_back(
+        std::make_unique<std::thread>(WorkerThreadMain, i + 1));
   }
 }
 
@@ -161,11 +296,76 @@ void Shutdown()
   // set shutdown to true
   s_IsShuttingDown.store(true);
 
+  // wake up all parked workers so they can see the flag
+  {
+    std::lock_guard<std::mutex> lock(s_IdleMutex);
+    s_WakeEpoch.fetch_add(1, std::memory_order_relaxed);
+  }
+  s_IdleCondition.notify_all();
+
   // join the threads to not crash
   for (auto&& thread : s_Threads)
   {
     thread->join();
   }
+
+  // Release the threads and queues, so the scheduler can be initialized again
+  s_Threads.clear();
+  s_TaskQueues.clear();
+  s_WorkerIndex = c_InvalidWorkerIndex;
+}
+
+uint32 RegisterThread()
+{
+  BGE_CORE_ASSERT(s_WorkerIndex == c_InvalidWorkerIndex,
+                  "Thread is already registered with the scheduler");
+
+  std::lock_guard<std::mutex> lock(s_RegistrationMutex);
+
+  for (uint32 i = 0; i < c_MaxExternalThreadCount; ++i)
+  {
+    if (!s_IsExternalQueueUsed[i])
+    {
+      s_IsExternalQueueUsed[i] = true;
+      s_WorkerIndex = s_WorkerThreadCount + 1 + i;
+      return s_WorkerIndex;
+    }
+  }
+
+  BGE_CORE_ASSERT(false, "Too many external threads registered");
+  return c_InvalidWorkerIndex;
+}
+
+void UnregisterThread()
+{
+  WorkStealingQueue* queue = GetWorkerThreadQueue();
+
+  BGE_CORE_ASSERT(queue != nullptr && s_WorkerIndex > s_WorkerThreadCount,
+                  "Only registered external threads can be unregistered");
+
+  // Don't leave tasks behind in a queue which nobody owns anymore
+  while (Task* task = queue->Pop())
+  {
+    Execute(task);
+  }
+
+  std::lock_guard<std::mutex> lock(s_RegistrationMutex);
+
+  s_IsExternalQueueUsed[s_WorkerIndex - s_WorkerThreadCount - 1] = false;
+  s_WorkerIndex = c_InvalidWorkerIndex;
+}
+
+uint32 GetWorkerIndex() { return s_WorkerIndex; }
+
+uint32 GetQueuedTaskCount()
+{
+  WorkStealingQueue* queue = GetWorkerThreadQueue();
+  return queue ? queue->Size() : 0u;
+}
+
+uint32 GetMaxWorkerCount()
+{
+  return s_WorkerThreadCount + 1 + c_MaxExternalThreadCount;
 }
 
 Task* CreateTask(TaskFunction function)
@@ -228,24 +428,49 @@ Task* CreateChildTask(Task* parent, TaskFunction function, const void* taskData,
   return task;
 }
 
-void Run(Task* task)
+TaskHandle Run(Task* task)
 {
-  if (WorkStealingQueue* queue = GetWorkerThreadQueue())
+  // Read before the task can run, finish and be recycled
+  const TaskHandle handle{
+      task, task->m_Generation.load(std::memory_order_acquire)};
+
+  WorkStealingQueue* queue = GetWorkerThreadQueue();
+
+  BGE_CORE_ASSERT(queue != nullptr,
+                  "Tasks can only be run from threads known to the scheduler");
+
+  if (queue == nullptr || !queue->Push(task))
   {
-    queue->Push(task);
+    // The queue is full, so nobody can steal this task anyway. Execute it
+    // right away instead of overwriting a queued task.
+    Execute(task);
+    return handle;
   }
+
+  WakeWorkers();
+  return handle;
 }
 
-void Wait(const Task* task)
+void Wait(TaskHandle handle)
 {
+  const Task* task = handle.m_Task;
+
   // wait until the job has completed. in the meantime, work on any other job.
-  while (!HasTaskCompleted(task))
+  // Once finished the task may be recycled by its pool, so stop waiting as soon
+  // as its generation differs from the one it was run with as well
+  while (task->m_Generation.load(std::memory_order_acquire) ==
+             handle.m_Generation &&
+         !HasTaskCompleted(task))
   {
     Task* nextTask = GetTask();
     if (nextTask)
     {
       Execute(nextTask);
     }
+    else
+    {
+      _mm_pause();
+    }
   }
 }
 
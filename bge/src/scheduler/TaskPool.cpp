@@ -0,0 +1,81 @@
+#include "scheduler/TaskPool.h"
+
+#include <immintrin.h>
+#include <new>
+
+namespace bge
+{
+
+TaskPool::TaskPool()
+    : m_Chunks()
+    , m_Cursor(0u)
+{
+  m_Chunks.reserve(c_MaxTaskChunkCount);
+  AddChunk();
+}
+
+TaskPool::~TaskPool()
+{
+  for (auto&& chunk : m_Chunks)
+  {
+    _mm_free(chunk);
+  }
+}
+
+Task* TaskPool::Allocate()
+{
+  const uint32 capacity = GetCapacity();
+
+  // Look for a finished task, starting from where the last search stopped, so
+  // tasks are recycled in roughly the order they were allocated
+  for (uint32 i = 0; i < capacity; ++i)
+  {
+    const uint32 index = m_Cursor;
+    m_Cursor = (m_Cursor + 1 == capacity) ? 0u : m_Cursor + 1;
+
+    Task* task = &m_Chunks[index / c_TaskChunkSize][index & c_TaskChunkMask];
+
+    if (task->m_UnfinishedTasks.load(std::memory_order_acquire) == 0)
+    {
+      task->m_Generation.fetch_add(1, std::memory_order_release);
+      return task;
+    }
+  }
+
+  if (m_Chunks.size() == c_MaxTaskChunkCount)
+  {
+    return nullptr;
+  }
+
+  // Every task is still in flight, grow the pool
+  AddChunk();
+  m_Cursor = capacity + 1;
+
+  Task* task = &m_Chunks.back()[0];
+  task->m_Generation.fetch_add(1, std::memory_order_release);
+  return task;
+}
+
+uint32 TaskPool::GetCapacity() const
+{
+  return static_cast<uint32>(m_Chunks.size()) * c_TaskChunkSize;
+}
+
+void TaskPool::AddChunk()
+{
+  Task* chunk =
+      static_cast<Task*>(_mm_malloc(sizeof(Task) * c_TaskChunkSize, 64));
+
+  for (uint32 i = 0; i < c_TaskChunkSize; ++i)
+  {
+    Task* task = new (&chunk[i]) Task;
+    task->m_Parent = nullptr;
+    task->m_Function = nullptr;
+    task->m_UnfinishedTasks.store(0, std::memory_order_relaxed);
+    task->m_Generation.store(0u, std::memory_order_relaxed);
+  }
+
+  m_Chunks.push_back(chunk);
+}
+
+} // namespace bge
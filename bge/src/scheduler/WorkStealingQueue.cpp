@@ -4,6 +4,109 @@ namespace bge
 {
 
 WorkStealingQueue::WorkStealingQueue()
+    : m_Top(0)
+    , m_Bottom(0)
+{
+  for (auto&& task : m_Tasks)
+  {
+    task.store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+bool WorkStealingQueue::Push(Task* task)
+{
+  const int64 bottom = m_Bottom.load(std::memory_order_relaxed);
+  const int64 top = m_Top.load(std::memory_order_acquire);
+
+  if (bottom - top >= static_cast<int64>(c_NumberOfTasks))
+  {
+    // Ring buffer is full, writing now would overwrite a task which a thief
+    // may still be reading
+    return false;
+  }
+
+  m_Tasks[bottom & c_Mask].store(task, std::memory_order_relaxed);
+
+  // Make sure the task is visible before thieves can see the new bottom
+  std::atomic_thread_fence(std::memory_order_release);
+  m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+  return true;
+}
+
+Task* WorkStealingQueue::Pop()
+{
+  const int64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+  m_Bottom.store(bottom, std::memory_order_relaxed);
+
+  // The bottom store must be globally visible before reading the top,
+  // otherwise a thief and the owner could both take the last task
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  int64 top = m_Top.load(std::memory_order_relaxed);
+
+  if (top > bottom)
+  {
+    // No tasks in queue, restore the bottom
+    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  Task* task = m_Tasks[bottom & c_Mask].load(std::memory_order_relaxed);
+
+  if (top == bottom)
+  {
+    // Last task in the queue, race against thieves for it
+    if (!m_Top.compare_exchange_strong(top, top + 1,
+                                       std::memory_order_seq_cst,
+                                       std::memory_order_relaxed))
+    {
+      // A thief got it first
+      task = nullptr;
+    }
+
+    m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+
+  return task;
+}
+
+Task* WorkStealingQueue::Steal()
+{
+  int64 top = m_Top.load(std::memory_order_acquire);
+
+  // The top must be read before the bottom (pairs with the fence in Pop)
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  const int64 bottom = m_Bottom.load(std::memory_order_acquire);
+
+  if (top >= bottom)
+  {
+    // No tasks in queue
+    return nullptr;
+  }
+
+  Task* task = m_Tasks[top & c_Mask].load(std::memory_order_relaxed);
+
+  if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+  {
+    // Lost the race against another thief or the owner's Pop
+    return nullptr;
+  }
+
+  return task;
+}
+
+uint32 WorkStealingQueue::Size() const
+{
+  const int64 bottom = m_Bottom.load(std::memory_order_relaxed);
+  const int64 top = m_Top.load(std::memory_order_relaxed);
+
+  return bottom > top ? static_cast<uint32>(bottom - top) : 0u;
+}
+
+LockingWorkStealingQueue::LockingWorkStealingQueue()
     : m_Tasks()
     , m_Mutex()
     , m_Bottom(0u)
@@ -11,15 +114,22 @@ WorkStealingQueue::WorkStealingQueue()
 {
 }
 
-void WorkStealingQueue::Push(Task* task)
+bool LockingWorkStealingQueue::Push(Task* task)
 {
   std::lock_guard<std::mutex> lock(m_Mutex);
 
+  if (m_Bottom - m_Top >= c_NumberOfTasks)
+  {
+    return false;
+  }
+
   m_Tasks[m_Bottom & c_Mask] = task;
   ++m_Bottom;
+
+  return true;
 }
 
-Task* WorkStealingQueue::Pop()
+Task* LockingWorkStealingQueue::Pop()
 {
   std::lock_guard<std::mutex> lock(m_Mutex);
 
@@ -35,7 +145,7 @@ Task* WorkStealingQueue::Pop()
   return m_Tasks[m_Bottom & c_Mask];
 }
 
-Task* WorkStealingQueue::Steal()
+Task* LockingWorkStealingQueue::Steal()
 {
   std::lock_guard<std::mutex> lock(m_Mutex);
 
@@ -52,4 +162,4 @@ Task* WorkStealingQueue::Steal()
   return task;
 }
 
-} // namespace bge
\ No newline at end of file
+} // namespace bge
@@ -386,6 +386,11 @@ public:
   // Tick called every frame
   void OnTick()
   {
+    if (!m_NativeWindow)
+    {
+      return;
+    }
+
     glfwPollEvents();
     glfwSwapBuffers(m_NativeWindow);
   }
@@ -397,6 +402,13 @@ public:
   }
   void SetVSync(bool enabled)
   {
+    m_WindowData.m_VSync = enabled;
+
+    if (!m_NativeWindow)
+    {
+      return;
+    }
+
     if (enabled)
     {
       glfwSwapInterval(1);
@@ -405,11 +417,14 @@ public:
     {
       glfwSwapInterval(0);
     }
-
-    m_WindowData.m_VSync = enabled;
   }
   void SetCursor(bool enabled)
   {
+    if (!m_NativeWindow)
+    {
+      return;
+    }
+
     int mode = GLFW_CURSOR_NORMAL;
 
     if (!enabled)
@@ -1,17 +1,18 @@
 #if defined(VS_BUILD)
-uniform mat4 in_Projection;
-uniform mat4 in_View;
-uniform mat4 in_Model;
+#include "camera.glsl"
 
 layout (location = 0) in vec3 in_Position;
 layout (location = 1) in vec3 in_Normal;
 layout (location = 2) in vec2 in_TexCoord;
+// Per instance, row-major so it multiplies from the left
+layout (location = 3) in mat4 in_Model;
 
 out vec2 ex_TexCoord;
 
 void main()
 {
-    gl_Position = in_Projection * in_View * in_Model * vec4(in_Position, 1.0);
+    vec4 worldPosition = vec4(in_Position, 1.0) * in_Model;
+    gl_Position = in_Projection * in_View * worldPosition;
     ex_TexCoord = in_TexCoord;
 }
 
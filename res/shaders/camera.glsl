@@ -0,0 +1,7 @@
+// Matrices of the camera being drawn, shared by all shaders through a uniform
+// buffer. They're stored row-major, like the engine's matrix class.
+layout (std140, row_major) uniform Camera
+{
+    mat4 in_Projection;
+    mat4 in_View;
+};
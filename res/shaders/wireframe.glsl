@@ -1,6 +1,5 @@
 #if defined(VS_BUILD)
-uniform mat4 in_Projection;
-uniform mat4 in_View;
+#include "camera.glsl"
 uniform mat4 in_Model;
 
 layout (location = 0) in vec3 in_Position;
@@ -10,7 +10,6 @@ public:
   explicit BallControlSystem(bge::Entity controlledEntity, float speed);
 
   virtual void Tick(float deltaSeconds) override;
-  virtual void OnEvent(bge::Event& event) override;
 
 private:
   bool OnKeyPressEvent(bge::KeyPressedEvent& event);
@@ -11,7 +11,6 @@ public:
   explicit CameraControlSystem(uint32 trackedCameraId);
 
   virtual void Tick(float deltaSeconds) override;
-  virtual void OnEvent(bge::Event& event) override;
 
 private:
   bool OnKeyPressEvent(bge::KeyPressedEvent& event);
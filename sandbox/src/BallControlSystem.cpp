@@ -42,14 +42,6 @@ void BallControlSystem::Tick(float deltaSeconds)
         m_ControlledEntity, bge::Vec3f(0.0f, m_Speed * deltaSeconds, 0.0f));
   }
 }
-void BallControlSystem::OnEvent(bge::Event& event)
-{
-  // bge::EventDispatcher dispatcher(event);
-
-  // dispatcher.Dispatch<bge::KeyPressedEvent>(
-  //     BGE_BIND_EVENT_FN(BallControlSystem::OnKeyPressEvent));
-}
-
 bool BallControlSystem::OnKeyPressEvent(bge::KeyPressedEvent& event)
 {
   // bge::KeyCode key = event.GetKeyCode();
@@ -8,6 +8,10 @@ CameraControlSystem::CameraControlSystem(uint32 trackedCameraId)
     : m_TrackedCameraId(trackedCameraId)
 {
   bge::Application::Get().GetWindow().SetCursor(false);
+
+  SubscribeEvent<BGE_EVENT_HANDLER(CameraControlSystem::OnKeyPressEvent)>();
+  SubscribeEvent<BGE_EVENT_HANDLER(CameraControlSystem::OnKeyReleaseEvent)>();
+  SubscribeEvent<BGE_EVENT_HANDLER(CameraControlSystem::OnMouseMoveEvent)>();
 }
 
 void CameraControlSystem::Tick(float deltaSeconds)
@@ -36,18 +40,6 @@ void CameraControlSystem::Tick(float deltaSeconds)
                                                               std::move(view));
 }
 
-void CameraControlSystem::OnEvent(bge::Event& event)
-{
-  bge::EventDispatcher dispatcher(event);
-
-  dispatcher.Dispatch<bge::KeyPressedEvent>(
-      BGE_BIND_EVENT_FN(CameraControlSystem::OnKeyPressEvent));
-  dispatcher.Dispatch<bge::KeyReleasedEvent>(
-      BGE_BIND_EVENT_FN(CameraControlSystem::OnKeyReleaseEvent));
-  dispatcher.Dispatch<bge::MouseMovedEvent>(
-      BGE_BIND_EVENT_FN(CameraControlSystem::OnMouseMoveEvent));
-}
-
 bool CameraControlSystem::OnKeyPressEvent(bge::KeyPressedEvent& event)
 {
   bge::KeyCode key = event.GetKeyCode();
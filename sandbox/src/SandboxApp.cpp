@@ -6,6 +6,9 @@
 #include "BallControlSystem.h"
 #include "CameraControlSystem.h"
 
+#include <cstdlib>
+#include <cstring>
+
 bge::Entity AddBall(bge::World& world, bge::PhysicsWorld& physicsWorld,
                     bge::RenderWorld& renderWorld, float mass = 1.0f)
 {
@@ -39,7 +42,8 @@ bge::Entity AddBall(bge::World& world, bge::PhysicsWorld& physicsWorld,
 class Sandbox : public bge::Application
 {
 public:
-  Sandbox()
+  explicit Sandbox(const bge::ApplicationConfig& config)
+      : Application(config)
   {
     auto& world = GetWorld();
     bge::RenderWorld& renderWorld = world.GetRenderWorld();
@@ -136,6 +140,25 @@ int main(int argc, char** argv)
   bge::Log::Init();
   BGE_INFO("Initialized Log!");
 
-  auto app = std::make_unique<Sandbox>();
+  // --headless runs without a window, --frames <count> stops after count
+  // frames, --trace <file> writes the render commands of the last frame
+  bge::ApplicationConfig config;
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--headless") == 0)
+    {
+      config.m_Headless = true;
+    }
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+    {
+      config.m_MaxFrames = std::strtoul(argv[++i], nullptr, 10);
+    }
+    else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+    {
+      config.m_TracePath = argv[++i];
+    }
+  }
+
+  auto app = std::make_unique<Sandbox>(config);
   app->Run();
 }
\ No newline at end of file